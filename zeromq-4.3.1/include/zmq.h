@@ -547,9 +547,23 @@ ZMQ_EXPORT void zmq_threadclose (void *thread_);
 #define ZMQ_METADATA 95
 #define ZMQ_MULTICAST_LOOP 96
 #define ZMQ_ROUTER_NOTIFY 97
+#define ZMQ_LB_POLICY 98
+#define ZMQ_LB_WEIGHT 99
+#define ZMQ_FQ_PRIORITY 100
+#define ZMQ_FQ_WEIGHT 101
+#define ZMQ_COMMAND_DELAY 102
+#define ZMQ_CURVE_TICKET_LIFETIME 103
+#define ZMQ_CURVE_AEAD 104
+#define ZMQ_CURVE_BATCH 105
 
 /*  DRAFT Context options                                                     */
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_COMPACT_SOCKETS 11
+#define ZMQ_CRYPTO_THREADS 12
+#define ZMQ_ZAP_CACHE_TTL 13
+
+/*  DRAFT Send/recv options.                                                  */
+#define ZMQ_DONTFLUSH 4
 
 /*  DRAFT Socket methods.                                                     */
 ZMQ_EXPORT int zmq_join (void *s, const char *group);
@@ -559,6 +573,10 @@ ZMQ_EXPORT int zmq_leave (void *s, const char *group);
 ZMQ_EXPORT int zmq_msg_set_routing_id (zmq_msg_t *msg, uint32_t routing_id);
 ZMQ_EXPORT uint32_t zmq_msg_routing_id (zmq_msg_t *msg);
 ZMQ_EXPORT int zmq_msg_set_group (zmq_msg_t *msg, const char *group);
+ZMQ_EXPORT int
+zmq_msg_recv_multi (zmq_msg_t *msgs, size_t count, void *s, int flags);
+ZMQ_EXPORT int
+zmq_msg_send_multi (zmq_msg_t *msgs, size_t count, void *s, int flags);
 ZMQ_EXPORT const char *zmq_msg_group (zmq_msg_t *msg);
 
 /*  DRAFT Msg property names.                                                 */
@@ -571,6 +589,12 @@ ZMQ_EXPORT const char *zmq_msg_group (zmq_msg_t *msg);
 #define ZMQ_NOTIFY_CONNECT      1
 #define ZMQ_NOTIFY_DISCONNECT   2
 
+/*  Load balancing policies (ZMQ_LB_POLICY)                                   */
+#define ZMQ_LB_ROUND_ROBIN      0
+#define ZMQ_LB_LEAST_QUEUE      1
+#define ZMQ_LB_WEIGHTED         2
+#define ZMQ_LB_POWER_OF_TWO     3
+
 /******************************************************************************/
 /*  Poller polling on sockets,fd and thread-safe sockets                      */
 /******************************************************************************/
@@ -599,6 +623,31 @@ ZMQ_EXPORT int zmq_poller_remove_fd (void *poller, int fd);
 
 ZMQ_EXPORT int zmq_socket_get_peer_state (void *socket, const void *routing_id, size_t routing_id_size);
 
+/******************************************************************************/
+/*  Reactor running handlers in the I/O threads                               */
+/******************************************************************************/
+
+#define ZMQ_HAVE_REACTOR
+
+typedef void(zmq_reactor_fd_fn) (int fd, short events, void *arg);
+typedef void(zmq_reactor_socket_fn) (void *socket, short events, void *arg);
+
+ZMQ_EXPORT void *zmq_reactor_new (void *context);
+ZMQ_EXPORT int zmq_reactor_destroy (void **reactor_p);
+ZMQ_EXPORT int zmq_reactor_add_fd (void *reactor, int fd, short events, zmq_reactor_fd_fn handler, void *arg);
+ZMQ_EXPORT int zmq_reactor_remove_fd (void *reactor, int fd);
+ZMQ_EXPORT int zmq_reactor_add_socket (void *reactor, void *socket, short events, zmq_reactor_socket_fn handler, void *arg);
+ZMQ_EXPORT int zmq_reactor_remove_socket (void *reactor, void *socket);
+ZMQ_EXPORT int zmq_reactor_add_timer (void *reactor, size_t interval, zmq_timer_fn handler, void *arg);
+ZMQ_EXPORT int zmq_reactor_cancel_timer (void *reactor, int timer_id);
+
+/******************************************************************************/
+/*  Cache of ZAP replies (ZMQ_ZAP_CACHE_TTL)                                  */
+/******************************************************************************/
+
+ZMQ_EXPORT int zmq_zap_cache_flush (void *context);
+ZMQ_EXPORT int zmq_zap_cache_invalidate (void *context, const char *domain, const void *credential, size_t size);
+
 #endif // ZMQ_BUILD_DRAFT_API
 
 #undef ZMQ_EXPORT
@@ -0,0 +1,187 @@
+/*
+    Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "platform.hpp"
+
+#if __cplusplus >= 201103L && defined(ZMQ_USE_TWEETNACL)
+
+#include "nacl_fast.hpp"
+#include "tweetnacl.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+const std::size_t sizes[] = {64, 1024, 65536};
+const std::size_t bytes_per_sample = 64 * 1024 * 1024;
+const std::size_t scalarmults = 2000;
+
+//  Secretbox as it is computed by the reference code.
+static void secretbox_ref (unsigned char *c_,
+                           const unsigned char *m_,
+                           std::size_t size_,
+                           const unsigned char *n_,
+                           const unsigned char *k_)
+{
+    crypto_stream_xor_ref (c_, m_, size_, n_, k_);
+    crypto_onetimeauth_ref (c_ + 16, c_ + 32, size_ - 32, c_);
+}
+
+static void secretbox_fast (unsigned char *c_,
+                            const unsigned char *m_,
+                            std::size_t size_,
+                            const unsigned char *n_,
+                            const unsigned char *k_)
+{
+    crypto_secretbox (c_, m_, size_, n_, k_);
+}
+
+template <class F>
+static double secretbox_throughput (F f_, std::size_t size_)
+{
+    std::vector<unsigned char> m (size_ + 32, 0x55);
+    std::vector<unsigned char> c (size_ + 32);
+    unsigned char n[24] = {1};
+    unsigned char k[32] = {2};
+    for (std::size_t i = 0; i < 32; i++)
+        m[i] = 0;
+
+    const std::size_t count = bytes_per_sample / size_;
+    auto start = std::chrono::high_resolution_clock::now ();
+    for (std::size_t i = 0; i < count; i++)
+        f_ (&c[0], &m[0], m.size (), n, k);
+    auto end = std::chrono::high_resolution_clock::now ();
+    const double seconds =
+      std::chrono::duration<double> (end - start).count ();
+    return (double) (count * size_) / seconds / 1000000;
+}
+
+//  The ciphers CURVE messages may be negotiated to, with the tag appended.
+static void chacha20poly1305 (unsigned char *c_,
+                              const unsigned char *m_,
+                              std::size_t size_,
+                              const unsigned char *n_,
+                              const unsigned char *k_)
+{
+    crypto_aead_chacha20poly1305_ietf_encrypt_detached (
+      c_, c_ + size_ - 16, NULL, m_, size_ - 16, NULL, 0, NULL, n_, k_);
+}
+
+static crypto_aead_aes256gcm_state aes256gcm_state;
+
+static void aes256gcm (unsigned char *c_,
+                       const unsigned char *m_,
+                       std::size_t size_,
+                       const unsigned char *n_,
+                       const unsigned char * /* k_ */)
+{
+    crypto_aead_aes256gcm_encrypt_detached_afternm (c_, c_ + size_ - 16,
+                                                    NULL, m_, size_ - 16, NULL,
+                                                    0, NULL, n_,
+                                                    &aes256gcm_state);
+}
+
+template <class F> static double scalarmult_rate (F f_)
+{
+    unsigned char q[32];
+    unsigned char n[32] = {3};
+    unsigned char p[32] = {9};
+    auto start = std::chrono::high_resolution_clock::now ();
+    for (std::size_t i = 0; i < scalarmults; i++)
+        f_ (q, n, p);
+    auto end = std::chrono::high_resolution_clock::now ();
+    const double seconds =
+      std::chrono::duration<double> (end - start).count ();
+    return scalarmults / seconds;
+}
+
+int main ()
+{
+    const char *names[] = {"scalar", "sse2", "avx2"};
+    const zmq::salsa20_impl_t impls[] = {zmq::salsa20_scalar, zmq::salsa20_sse2,
+                                         zmq::salsa20_avx2};
+    const zmq::salsa20_impl_t selected = zmq::salsa20_impl ();
+
+    std::printf ("secretbox throughput [MB/s]\n");
+    std::printf ("%8s %10s", "size", "reference");
+    for (const auto impl : impls)
+        if (zmq::salsa20_impl_available (impl))
+            std::printf (" %10s", names[impl]);
+    std::printf ("\n");
+
+    for (const auto size : sizes) {
+        std::printf ("%8zu %10.1f", size,
+                     secretbox_throughput (secretbox_ref, size));
+        for (const auto impl : impls) {
+            if (!zmq::salsa20_impl_available (impl))
+                continue;
+            zmq::set_salsa20_impl (impl);
+            std::printf (" %10.1f", secretbox_throughput (secretbox_fast, size));
+        }
+        std::printf ("\n");
+    }
+    zmq::set_salsa20_impl (selected);
+    std::printf ("selected implementation: %s\n\n", names[selected]);
+
+    const bool have_aes256gcm = crypto_aead_aes256gcm_is_available () != 0;
+    if (have_aes256gcm) {
+        const unsigned char k[32] = {2};
+        crypto_aead_aes256gcm_beforenm (&aes256gcm_state, k);
+    }
+    std::printf ("message cipher throughput [MB/s]\n");
+    std::printf ("%8s %10s %18s %12s\n", "size", "secretbox",
+                 "chacha20poly1305", "aes256gcm");
+    for (const auto size : sizes) {
+        std::printf ("%8zu %10.1f %18.1f", size,
+                     secretbox_throughput (secretbox_fast, size),
+                     secretbox_throughput (chacha20poly1305, size));
+        if (have_aes256gcm)
+            std::printf (" %12.1f", secretbox_throughput (aes256gcm, size));
+        else
+            std::printf (" %12s", "n/a");
+        std::printf ("\n");
+    }
+    std::printf ("\n");
+
+    std::printf ("scalarmult [ops/s]\n");
+    std::printf ("%10s %10.1f\n", "reference",
+                 scalarmult_rate (crypto_scalarmult_ref));
+    std::printf ("%10s %10.1f\n", "fast", scalarmult_rate (crypto_scalarmult));
+    return 0;
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
@@ -0,0 +1,212 @@
+/*
+    Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "platform.hpp"
+
+#if __cplusplus >= 201103L
+
+#include "blob.hpp"
+#include "../include/zmq.h"
+
+#include <assert.h>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+const std::size_t blob_ops = 10000000;
+const std::size_t peers = 1000;
+const std::size_t routes_per_peer = 200;
+const std::size_t subscriptions = 200000;
+const std::size_t subscription_batch = 100;
+
+//  Keeps the compiler from optimizing the blobs away.
+static volatile unsigned char sink;
+
+static double elapsed_s (std::chrono::high_resolution_clock::time_point start_)
+{
+    return std::chrono::duration<double> (
+             std::chrono::high_resolution_clock::now () - start_)
+      .count ();
+}
+
+//  Creates, moves and deep-copies blobs of a given size.
+static double blob_rate (std::size_t size_)
+{
+    std::vector<unsigned char> data (size_, 0x55);
+
+    auto start = std::chrono::high_resolution_clock::now ();
+    for (std::size_t i = 0; i < blob_ops; i++) {
+        data[0] = static_cast<unsigned char> (i);
+        zmq::blob_t blob (&data[0], size_);
+        zmq::blob_t moved (std::move (blob));
+        zmq::blob_t copy;
+        copy.set_deep_copy (moved);
+        sink = copy.data ()[0];
+    }
+    return blob_ops / elapsed_s (start);
+}
+
+//  Connects DEALERs to a ROUTER, which learns their generated routing IDs,
+//  then routes messages to them by routing ID.
+static void router_rates (void *ctx_, double *connect_rate_, double *route_rate_)
+{
+    const int zero = 0;
+    void *router = zmq_socket (ctx_, ZMQ_ROUTER);
+    assert (router);
+    int rc = zmq_setsockopt (router, ZMQ_SNDHWM, &zero, sizeof zero);
+    assert (rc == 0);
+    rc = zmq_bind (router, "inproc://benchmark_routing");
+    assert (rc == 0);
+
+    auto start = std::chrono::high_resolution_clock::now ();
+    std::vector<void *> dealers;
+    for (std::size_t i = 0; i < peers; i++) {
+        void *dealer = zmq_socket (ctx_, ZMQ_DEALER);
+        assert (dealer);
+        rc = zmq_setsockopt (dealer, ZMQ_RCVHWM, &zero, sizeof zero);
+        assert (rc == 0);
+        rc = zmq_connect (dealer, "inproc://benchmark_routing");
+        assert (rc == 0);
+        rc = zmq_send (dealer, "", 0, 0);
+        assert (rc == 0);
+        dealers.push_back (dealer);
+    }
+
+    std::vector<std::vector<unsigned char> > routing_ids;
+    unsigned char routing_id[256];
+    for (std::size_t i = 0; i < peers; i++) {
+        rc = zmq_recv (router, routing_id, sizeof routing_id, 0);
+        assert (rc > 0);
+        routing_ids.push_back (
+          std::vector<unsigned char> (routing_id, routing_id + rc));
+        rc = zmq_recv (router, NULL, 0, 0);
+        assert (rc == 0);
+    }
+    *connect_rate_ = peers / elapsed_s (start);
+
+    start = std::chrono::high_resolution_clock::now ();
+    for (std::size_t i = 0; i < routes_per_peer; i++)
+        for (const auto &id : routing_ids) {
+            rc = zmq_send (router, &id[0], id.size (), ZMQ_SNDMORE);
+            assert (rc == static_cast<int> (id.size ()));
+            rc = zmq_send (router, "x", 1, 0);
+            assert (rc == 1);
+        }
+    *route_rate_ = peers * routes_per_peer / elapsed_s (start);
+
+    for (auto dealer : dealers) {
+        rc = zmq_close (dealer);
+        assert (rc == 0);
+    }
+    rc = zmq_close (router);
+    assert (rc == 0);
+}
+
+//  Subscribes and unsubscribes a SUB to distinct topics, passing each
+//  through a verbose XPUB.
+static double subscription_rate (void *ctx_)
+{
+    const int one = 1;
+    void *xpub = zmq_socket (ctx_, ZMQ_XPUB);
+    assert (xpub);
+    int rc = zmq_setsockopt (xpub, ZMQ_XPUB_VERBOSER, &one, sizeof one);
+    assert (rc == 0);
+    rc = zmq_bind (xpub, "inproc://benchmark_subscriptions");
+    assert (rc == 0);
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_connect (sub, "inproc://benchmark_subscriptions");
+    assert (rc == 0);
+
+    char topic[16];
+    unsigned char buffer[32];
+    auto start = std::chrono::high_resolution_clock::now ();
+    for (std::size_t i = 0; i < subscriptions; i += subscription_batch) {
+        for (std::size_t j = i; j < i + subscription_batch; j++) {
+            std::sprintf (topic, "topic-%08zu", j);
+            rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, topic, strlen (topic));
+            assert (rc == 0);
+            rc = zmq_setsockopt (sub, ZMQ_UNSUBSCRIBE, topic, strlen (topic));
+            assert (rc == 0);
+        }
+        for (std::size_t j = 0; j < 2 * subscription_batch; j++) {
+            rc = zmq_recv (xpub, buffer, sizeof buffer, 0);
+            assert (rc > 0);
+        }
+
+        //  Let the SUB learn the XPUB has read the subscriptions, which
+        //  are dropped if the pipe is full.
+        int events;
+        size_t events_size = sizeof events;
+        rc = zmq_getsockopt (sub, ZMQ_EVENTS, &events, &events_size);
+        assert (rc == 0);
+    }
+    const double rate = subscriptions / elapsed_s (start);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (xpub);
+    assert (rc == 0);
+    return rate;
+}
+
+int main ()
+{
+    std::printf ("blob create, move and copy [ops/s]\n");
+    const std::size_t sizes[] = {5, 16, 23, 64};
+    for (const auto size : sizes)
+        std::printf ("%8zu %14.1f\n", size, blob_rate (size));
+    std::printf ("\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    double connect_rate;
+    double route_rate;
+    router_rates (ctx, &connect_rate, &route_rate);
+    std::printf ("ROUTER connect [peers/s] %14.1f\n", connect_rate);
+    std::printf ("ROUTER route [msgs/s]    %14.1f\n", route_rate);
+    std::printf ("XPUB subscribe and unsubscribe [topics/s] %14.1f\n",
+                 subscription_rate (ctx));
+
+    const int rc = zmq_ctx_term (ctx);
+    assert (rc == 0);
+    return 0;
+}
+
+#else
+
+int main ()
+{
+}
+
+#endif
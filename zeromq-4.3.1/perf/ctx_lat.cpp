@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures how long a short-lived process spends setting up 0MQ: creating
+//  a context and its first socket, then making the first connection (which
+//  needs an I/O thread), and finally tearing everything down.
+
+int main (int argc, char *argv[])
+{
+    void *ctx;
+    void *s;
+    int rc;
+    int i;
+    int iteration_count;
+    const char *connect_to;
+    void *watch;
+    unsigned long create_us = 0;
+    unsigned long connect_us = 0;
+    unsigned long term_us = 0;
+
+    if (argc != 3) {
+        printf ("usage: ctx_lat <connect-to> <iteration-count>\n");
+        return 1;
+    }
+    connect_to = argv[1];
+    iteration_count = atoi (argv[2]);
+    if (iteration_count <= 0) {
+        printf ("iteration count must be positive\n");
+        return 1;
+    }
+
+    for (i = 0; i != iteration_count; i++) {
+        watch = zmq_stopwatch_start ();
+
+        ctx = zmq_ctx_new ();
+        if (!ctx) {
+            printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        s = zmq_socket (ctx, ZMQ_PUSH);
+        if (!s) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        unsigned long elapsed = zmq_stopwatch_intermediate (watch);
+        create_us += elapsed;
+
+        //  The peer doesn't need to exist; connecting is asynchronous.
+        rc = zmq_connect (s, connect_to);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        connect_us += zmq_stopwatch_intermediate (watch) - elapsed;
+        elapsed = zmq_stopwatch_intermediate (watch);
+
+        int linger = 0;
+        rc = zmq_setsockopt (s, ZMQ_LINGER, &linger, sizeof (linger));
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        rc = zmq_close (s);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        rc = zmq_ctx_term (ctx);
+        if (rc != 0) {
+            printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        term_us += zmq_stopwatch_stop (watch) - elapsed;
+    }
+
+    printf ("iteration count: %d\n", iteration_count);
+    printf ("average context and socket creation: %.3f [us]\n",
+            (double) create_us / iteration_count);
+    printf ("average first connect: %.3f [us]\n",
+            (double) connect_us / iteration_count);
+    printf ("average close and termination: %.3f [us]\n",
+            (double) term_us / iteration_count);
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+/*
+    Copyright (c) 2007-2012 iMatix Corporation
+    Copyright (c) 2009-2011 250bpm s.r.o.
+    Copyright (c) 2007-2011 Other contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+//  Measures the throughput of a TCP connection over the loopback interface
+//  with the NULL mechanism, then with CURVE, and reports both. The sender
+//  runs in a thread of its own.
+
+static int message_count;
+static size_t message_size;
+
+static char server_public[41];
+static char server_secret[41];
+static char client_public[41];
+static char client_secret[41];
+
+struct sender_args_t
+{
+    void *ctx;
+    const char *endpoint;
+    int curve;
+};
+
+static void check (int rc_, const char *what_)
+{
+    if (rc_ < 0) {
+        printf ("error in %s: %s\n", what_, zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+static unsigned int __stdcall sender (void *args_)
+#else
+static void *sender (void *args_)
+#endif
+{
+    sender_args_t *args = (sender_args_t *) args_;
+    zmq_msg_t msg;
+    int rc;
+    int i;
+
+    void *s = zmq_socket (args->ctx, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    if (args->curve) {
+        rc = zmq_setsockopt (s, ZMQ_CURVE_SERVERKEY, server_public, 41);
+        check (rc, "zmq_setsockopt");
+        rc = zmq_setsockopt (s, ZMQ_CURVE_PUBLICKEY, client_public, 41);
+        check (rc, "zmq_setsockopt");
+        rc = zmq_setsockopt (s, ZMQ_CURVE_SECRETKEY, client_secret, 41);
+        check (rc, "zmq_setsockopt");
+    }
+    rc = zmq_connect (s, args->endpoint);
+    check (rc, "zmq_connect");
+
+    for (i = 0; i != message_count; i++) {
+        rc = zmq_msg_init_size (&msg, message_size);
+        check (rc, "zmq_msg_init_size");
+        memset (zmq_msg_data (&msg), 0, message_size);
+        rc = zmq_sendmsg (s, &msg, 0);
+        check (rc, "zmq_sendmsg");
+        rc = zmq_msg_close (&msg);
+        check (rc, "zmq_msg_close");
+    }
+
+    rc = zmq_close (s);
+    check (rc, "zmq_close");
+
+#if defined ZMQ_HAVE_WINDOWS
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+//  Returns the throughput in messages per second.
+static unsigned long run (void *ctx_, int curve_)
+{
+    sender_args_t args;
+    char endpoint[256];
+    size_t endpoint_size = sizeof endpoint;
+    zmq_msg_t msg;
+    void *watch;
+    unsigned long elapsed;
+    int rc;
+    int i;
+
+    void *s = zmq_socket (ctx_, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    if (curve_) {
+        const int as_server = 1;
+        rc = zmq_setsockopt (s, ZMQ_CURVE_SERVER, &as_server, sizeof as_server);
+        check (rc, "zmq_setsockopt");
+        rc = zmq_setsockopt (s, ZMQ_CURVE_SECRETKEY, server_secret, 41);
+        check (rc, "zmq_setsockopt");
+    }
+    rc = zmq_bind (s, "tcp://127.0.0.1:*");
+    check (rc, "zmq_bind");
+    rc = zmq_getsockopt (s, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_size);
+    check (rc, "zmq_getsockopt");
+
+    args.ctx = ctx_;
+    args.endpoint = endpoint;
+    args.curve = curve_;
+
+#if defined ZMQ_HAVE_WINDOWS
+    HANDLE thread = (HANDLE) _beginthreadex (NULL, 0, sender, &args, 0, NULL);
+    if (thread == 0) {
+        printf ("error in _beginthreadex\n");
+        exit (1);
+    }
+#else
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, sender, &args);
+    if (rc != 0) {
+        printf ("error in pthread_create: %s\n", zmq_strerror (rc));
+        exit (1);
+    }
+#endif
+
+    rc = zmq_msg_init (&msg);
+    check (rc, "zmq_msg_init");
+
+    //  The clock starts with the first message, once the connection and
+    //  its handshake are done.
+    rc = zmq_recvmsg (s, &msg, 0);
+    check (rc, "zmq_recvmsg");
+
+    watch = zmq_stopwatch_start ();
+
+    for (i = 0; i != message_count - 1; i++) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        check (rc, "zmq_recvmsg");
+        if (zmq_msg_size (&msg) != message_size) {
+            printf ("message of incorrect size received\n");
+            exit (1);
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    rc = zmq_msg_close (&msg);
+    check (rc, "zmq_msg_close");
+
+#if defined ZMQ_HAVE_WINDOWS
+    WaitForSingleObject (thread, INFINITE);
+    CloseHandle (thread);
+#else
+    pthread_join (thread, NULL);
+#endif
+
+    rc = zmq_close (s);
+    check (rc, "zmq_close");
+
+    return (unsigned long) ((double) (message_count - 1) / (double) elapsed
+                            * 1000000);
+}
+
+int main (int argc, char *argv[])
+{
+    unsigned long null_throughput;
+    unsigned long curve_throughput;
+    int rc;
+
+    if (argc != 3) {
+        printf ("usage: curve_thr <message-size> <message-count>\n");
+        return 1;
+    }
+
+    message_size = atoi (argv[1]);
+    message_count = atoi (argv[2]);
+    if (message_count < 2) {
+        printf ("message count must be at least 2\n");
+        return 1;
+    }
+
+    if (!zmq_has ("curve")) {
+        printf ("CURVE is not available in this build\n");
+        return 1;
+    }
+    rc = zmq_curve_keypair (server_public, server_secret);
+    check (rc, "zmq_curve_keypair");
+    rc = zmq_curve_keypair (client_public, client_secret);
+    check (rc, "zmq_curve_keypair");
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+
+    null_throughput = run (ctx, 0);
+    printf ("NULL throughput: %d [msg/s]\n", (int) null_throughput);
+    printf ("NULL throughput: %.3f [Mb/s]\n",
+            (double) null_throughput * message_size * 8 / 1000000);
+
+    curve_throughput = run (ctx, 1);
+    printf ("CURVE throughput: %d [msg/s]\n", (int) curve_throughput);
+    printf ("CURVE throughput: %.3f [Mb/s]\n",
+            (double) curve_throughput * message_size * 8 / 1000000);
+
+    printf ("CURVE/NULL: %.1f%%\n",
+            (double) curve_throughput * 100 / (double) null_throughput);
+
+    rc = zmq_ctx_term (ctx);
+    check (rc, "zmq_ctx_term");
+
+    return 0;
+}
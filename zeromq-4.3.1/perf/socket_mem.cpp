@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined __linux__
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+//  Measures the memory and file descriptors an idle socket costs: creates
+//  the given number of sockets, none of them bound or connected, and
+//  reports the growth of the process per socket. With "compact" as the
+//  last argument the context runs in compact socket mode.
+
+#if defined __linux__
+static long resident_bytes ()
+{
+    long pages = 0;
+    long resident = 0;
+    FILE *f = fopen ("/proc/self/statm", "r");
+    if (!f)
+        return -1;
+    const int n = fscanf (f, "%ld %ld", &pages, &resident);
+    fclose (f);
+    if (n != 2)
+        return -1;
+    return resident * sysconf (_SC_PAGESIZE);
+}
+
+static long open_fds ()
+{
+    DIR *dir = opendir ("/proc/self/fd");
+    if (!dir)
+        return -1;
+    long count = 0;
+    while (readdir (dir))
+        count++;
+    closedir (dir);
+    return count;
+}
+#else
+static long resident_bytes ()
+{
+    return -1;
+}
+
+static long open_fds ()
+{
+    return -1;
+}
+#endif
+
+int main (int argc, char *argv[])
+{
+    void *ctx;
+    void **sockets;
+    int socket_count;
+    int compact = 0;
+    int rc;
+    int i;
+
+    if (argc != 2 && argc != 3) {
+        printf ("usage: socket_mem <socket-count> [compact]\n");
+        return 1;
+    }
+    socket_count = atoi (argv[1]);
+    if (socket_count <= 0) {
+        printf ("socket count must be positive\n");
+        return 1;
+    }
+    if (argc == 3) {
+        if (strcmp (argv[2], "compact") != 0) {
+            printf ("usage: socket_mem <socket-count> [compact]\n");
+            return 1;
+        }
+        compact = 1;
+    }
+
+    ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, socket_count + 1);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+#ifdef ZMQ_COMPACT_SOCKETS
+    rc = zmq_ctx_set (ctx, ZMQ_COMPACT_SOCKETS, compact);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+#else
+    if (compact) {
+        printf ("compact socket mode requires the draft API\n");
+        return 1;
+    }
+#endif
+
+    sockets = (void **) malloc (socket_count * sizeof (void *));
+    if (!sockets) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+
+    //  Start the context with a first socket so that its own footprint
+    //  is not accounted to the sockets.
+    sockets[0] = zmq_socket (ctx, ZMQ_DEALER);
+    if (!sockets[0]) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    const long bytes_before = resident_bytes ();
+    const long fds_before = open_fds ();
+    void *watch = zmq_stopwatch_start ();
+
+    for (i = 1; i != socket_count; i++) {
+        sockets[i] = zmq_socket (ctx, ZMQ_DEALER);
+        if (!sockets[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    const unsigned long elapsed = zmq_stopwatch_stop (watch);
+    const long bytes_after = resident_bytes ();
+    const long fds_after = open_fds ();
+
+    printf ("socket count: %d\n", socket_count);
+    printf ("compact: %d\n", compact);
+    printf ("average creation: %.3f [us]\n",
+            (double) elapsed / (socket_count > 1 ? socket_count - 1 : 1));
+    if (socket_count > 1 && bytes_before != -1 && bytes_after != -1)
+        printf ("resident memory per socket: %.0f [B]\n",
+                (double) (bytes_after - bytes_before) / (socket_count - 1));
+    if (socket_count > 1 && fds_before != -1 && fds_after != -1)
+        printf ("file descriptors per socket: %.3f\n",
+                (double) (fds_after - fds_before) / (socket_count - 1));
+
+    for (i = 0; i != socket_count; i++) {
+        rc = zmq_close (sockets[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    free (sockets);
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
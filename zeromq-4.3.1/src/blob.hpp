@@ -69,28 +69,27 @@ struct reference_tag_t
 //  On modern compilers, it will be movable but not copyable. Copies
 //  must be explicitly created by set_deep_copy.
 //  On older compilers, it is copyable for syntactical reasons.
+//  Data of up to inline_size bytes, like generated routing IDs and most
+//  subscriptions, is kept in the blob_t itself rather than allocated.
 struct blob_t
 {
+    enum
+    {
+        inline_size = 23
+    };
+
     //  Creates an empty blob_t.
     blob_t () : _data (0), _size (0), _owned (true) {}
 
     //  Creates a blob_t of a given size, with uninitialized content.
-    explicit blob_t (const size_t size_) :
-        _data (static_cast<unsigned char *> (malloc (size_))),
-        _size (size_),
-        _owned (true)
-    {
-        alloc_assert (_data);
-    }
+    explicit blob_t (const size_t size_) : _owned (true) { allocate (size_); }
 
     //  Creates a blob_t of a given size, an initializes content by copying
     // from another buffer.
     blob_t (const unsigned char *const data_, const size_t size_) :
-        _data (static_cast<unsigned char *> (malloc (size_))),
-        _size (size_),
         _owned (true)
     {
-        alloc_assert (_data);
+        allocate (size_);
         memcpy (_data, data_, size_);
     }
 
@@ -125,21 +124,14 @@ struct blob_t
     //  Sets a blob_t to a deep copy of another blob_t.
     void set_deep_copy (blob_t const &other_)
     {
-        clear ();
-        _data = static_cast<unsigned char *> (malloc (other_._size));
-        alloc_assert (_data);
-        _size = other_._size;
-        _owned = true;
-        memcpy (_data, other_._data, _size);
+        set (other_._data, other_._size);
     }
 
     //  Sets a blob_t to a copy of a given buffer.
     void set (const unsigned char *const data_, const size_t size_)
     {
         clear ();
-        _data = static_cast<unsigned char *> (malloc (size_));
-        alloc_assert (_data);
-        _size = size_;
+        allocate (size_);
         _owned = true;
         memcpy (_data, data_, size_);
     }
@@ -147,7 +139,7 @@ struct blob_t
     //  Empties a blob_t.
     void clear ()
     {
-        if (_owned) {
+        if (_owned && _data != _buffer) {
             free (_data);
         }
         _data = 0;
@@ -156,7 +148,7 @@ struct blob_t
 
     ~blob_t ()
     {
-        if (_owned) {
+        if (_owned && _data != _buffer) {
             free (_data);
         }
     }
@@ -165,20 +157,18 @@ struct blob_t
     blob_t (const blob_t &) = delete;
     blob_t &operator= (const blob_t &) = delete;
 
-    blob_t (blob_t &&other_) ZMQ_NOEXCEPT : _data (other_._data),
-                                            _size (other_._size),
+    blob_t (blob_t &&other_) ZMQ_NOEXCEPT : _size (other_._size),
                                             _owned (other_._owned)
     {
-        other_._owned = false;
+        take_data (other_);
     }
     blob_t &operator= (blob_t &&other_) ZMQ_NOEXCEPT
     {
         if (this != &other_) {
             clear ();
-            _data = other_._data;
             _size = other_._size;
             _owned = other_._owned;
-            other_._owned = false;
+            take_data (other_);
         }
         return *this;
     }
@@ -195,9 +185,36 @@ struct blob_t
 #endif
 
   private:
+    //  Points _data to storage for size_ bytes.
+    void allocate (const size_t size_)
+    {
+        if (size_ <= inline_size)
+            _data = _buffer;
+        else {
+            _data = static_cast<unsigned char *> (malloc (size_));
+            alloc_assert (_data);
+        }
+        _size = size_;
+    }
+
+#ifdef ZMQ_HAS_MOVE_SEMANTICS
+    //  Takes over the data of a blob_t being moved from, copying it if
+    //  it is inline.
+    void take_data (blob_t &other_)
+    {
+        if (other_._data == other_._buffer) {
+            memcpy (_buffer, other_._buffer, _size);
+            _data = _buffer;
+        } else
+            _data = other_._data;
+        other_._owned = false;
+    }
+#endif
+
     unsigned char *_data;
     size_t _size;
     bool _owned;
+    unsigned char _buffer[inline_size];
 };
 }
 
@@ -0,0 +1,88 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include <stdlib.h>
+
+#include "buffer_pool.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+zmq::buffer_pool_t::buffer_pool_t ()
+{
+}
+
+zmq::buffer_pool_t::~buffer_pool_t ()
+{
+    for (size_t i = 0; i != _classes.size (); i++)
+        for (size_t j = 0; j != _classes[i].buffers.size (); j++)
+            free (_classes[i].buffers[j]);
+}
+
+void *zmq::buffer_pool_t::allocate (size_t size_)
+{
+    size_class_t &size_class = this->size_class (size_);
+    if (!size_class.buffers.empty ()) {
+        void *buf = size_class.buffers.back ();
+        size_class.buffers.pop_back ();
+        return buf;
+    }
+
+    void *buf = malloc (size_);
+    alloc_assert (buf);
+    return buf;
+}
+
+void zmq::buffer_pool_t::deallocate (void *buf_, size_t size_)
+{
+    size_class_t &size_class = this->size_class (size_);
+    if (size_class.buffers.size () < max_pooled_buffers)
+        size_class.buffers.push_back (buf_);
+    else
+        free (buf_);
+}
+
+size_t zmq::buffer_pool_t::idle () const
+{
+    size_t count = 0;
+    for (size_t i = 0; i != _classes.size (); i++)
+        count += _classes[i].buffers.size ();
+    return count;
+}
+
+zmq::buffer_pool_t::size_class_t &zmq::buffer_pool_t::size_class (size_t size_)
+{
+    for (size_t i = 0; i != _classes.size (); i++)
+        if (_classes[i].size == size_)
+            return _classes[i];
+
+    _classes.push_back (size_class_t ());
+    _classes.back ().size = size_;
+    return _classes.back ();
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_BUFFER_POOL_HPP_INCLUDED__
+#define __ZMQ_BUFFER_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+namespace zmq
+{
+//  Encoder and decoder buffers of the engines of an I/O thread. Engines
+//  borrow buffers while data is flowing and give them back when their
+//  connection goes idle, so that idle connections hold none. Up to
+//  max_pooled_buffers buffers of each size are kept for reuse.
+//
+//  Buffers are allocated with malloc, so a buffer still used by a message
+//  when its engine lets it go can be freed by whoever releases the message
+//  last. The pool itself is only used from the I/O thread.
+
+class buffer_pool_t
+{
+  public:
+    buffer_pool_t ();
+    ~buffer_pool_t ();
+
+    //  Returns a buffer of size_ bytes.
+    void *allocate (size_t size_);
+
+    //  Takes back a buffer of size_ bytes got from allocate.
+    void deallocate (void *buf_, size_t size_);
+
+    //  Number of idle buffers held.
+    size_t idle () const;
+
+  private:
+    struct size_class_t
+    {
+        size_t size;
+        std::vector<void *> buffers;
+    };
+
+    size_class_t &size_class (size_t size_);
+
+    //  There are only a few distinct sizes, one per batch size in use.
+    std::vector<size_class_t> _classes;
+
+    buffer_pool_t (const buffer_pool_t &);
+    const buffer_pool_t &operator= (const buffer_pool_t &);
+};
+}
+
+#endif
@@ -3,8 +3,10 @@
 #include "likely.hpp"
 #include "config.hpp"
 #include "err.hpp"
+#include "atomic_ptr.hpp"
 #include "mutex.hpp"
 
+#include <limits.h>
 #include <stddef.h>
 #include <sys/time.h>
 #include <time.h>
@@ -13,6 +15,16 @@ const uint64_t usecs_per_msec = 1000;
 const uint64_t usecs_per_sec  = 1000000;
 const uint64_t nsecs_per_usec = 1000;
 
+//  Time between the two samples the rate of the TSC is measured from.
+const uint64_t calibration_usecs = 10000;
+
+static zmq::mutex_t calibration_sync;
+static uint64_t calibration_tsc = 0;
+static uint64_t calibration_us = 0;
+
+//  Set once, so it is read without taking calibration_sync.
+static zmq::atomic_value_t tsc_per_msec (0);
+
 zmq::clock_t::clock_t() : _last_tsc(rdtsc()), _last_time(now_us()/usecs_per_msec)
 {
 
@@ -87,3 +99,40 @@ uint64_t zmq::clock_t::rdtsc()
     return static_cast<uint64_t> (ts.tv_sec) * nsecs_per_usec * usecs_per_sec + ts.tv_nsec;
 #endif
 }
+
+uint64_t zmq::clock_t::rdtsc_per_ms ()
+{
+    const int calibrated = tsc_per_msec.load ();
+    if (likely (calibrated))
+        return calibrated;
+
+    scoped_lock_t lock (calibration_sync);
+
+    if (tsc_per_msec.load ())
+        return tsc_per_msec.load ();
+
+    const uint64_t tsc = rdtsc ();
+    if (!tsc)
+        return 0;
+    const uint64_t us = now_us ();
+
+    //  Rather than wait, take a sample now and measure against it once
+    //  enough time has passed.
+    if (!calibration_tsc || tsc < calibration_tsc) {
+        calibration_tsc = tsc;
+        calibration_us = us;
+        return 0;
+    }
+    const uint64_t elapsed_us = us - calibration_us;
+    if (elapsed_us < calibration_usecs)
+        return 0;
+
+    uint64_t rate = (tsc - calibration_tsc) * usecs_per_msec / elapsed_us;
+    if (!rate)
+        rate = 1;
+    else if (rate > INT_MAX)
+        rate = INT_MAX;
+    tsc_per_msec.store (static_cast<int> (rate));
+
+    return rate;
+}
@@ -14,6 +14,12 @@ public:
     //  CPU's timestamp counter. Returns 0 if it's not available.
     static uint64_t rdtsc();
 
+    //  Number of rdtsc() ticks per millisecond, measured against the high
+    //  precision timestamp between two calls some milliseconds apart.
+    //  Returns 0 if the counter is not available or not measured yet. Does
+    //  not block.
+    static uint64_t rdtsc_per_ms ();
+
     //  High precision timestamp.
     static uint64_t now_us();
 
@@ -8,6 +8,7 @@ namespace zmq
 {
 class object_t;
 class own_t;
+class io_job_t;
 struct i_engine;
 class pipe_t;
 class socket_base_t;
@@ -39,6 +40,8 @@ struct command_t
         reaped              = 16,
         inproc_connected    = 17,
         done                = 18,
+        reactor             = 19,
+        job_done            = 20,
     } type;
 
     union args_t
@@ -164,6 +167,21 @@ struct command_t
         {
 
         } done;
+
+        //  Sent to a reactor to have its I/O thread carry out a request.
+        //  The parameter is actually of type reactor_t::request_t, however,
+        //  its definition is private so we'll have to do with void*.
+        struct
+        {
+            void *request;
+        } reactor;
+
+        //  Sent by a worker, e.g. of the crypto pool or the DNS resolver,
+        //  to the I/O thread that submitted the job once it was done.
+        struct
+        {
+            zmq::io_job_t *job;
+        } job_done;
     } args;
 } __attribute__ ((aligned(64)));
 
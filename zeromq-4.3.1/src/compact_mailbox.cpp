@@ -0,0 +1,150 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "compact_mailbox.hpp"
+#include "err.hpp"
+
+zmq::compact_mailbox_t::compact_mailbox_t (shared_signaler_t *shared_) :
+    _shared (shared_),
+    _signaler (&shared_->signaler),
+    _seen (shared_->wakeups)
+{
+    //  Get the pipe into passive state, as mailbox_t does.
+    const bool ok = _cpipe.check_read ();
+    zmq_assert (!ok);
+    _active = false;
+}
+
+zmq::compact_mailbox_t::~compact_mailbox_t ()
+{
+    //  Work around problem that other threads might still be in our
+    //  send() method, by waiting on the mutex before disappearing.
+    _sync.lock ();
+    _sync.unlock ();
+
+    if (!_shared)
+        LIBZMQ_DELETE (_signaler);
+}
+
+zmq::fd_t zmq::compact_mailbox_t::get_fd () const
+{
+    return _signaler->get_fd ();
+}
+
+void zmq::compact_mailbox_t::send (const command_t &cmd_)
+{
+    _sync.lock ();
+    _cpipe.write (cmd_, false);
+    const bool ok = _cpipe.flush ();
+    if (!ok)
+        _signaler->send ();
+    _sync.unlock ();
+}
+
+int zmq::compact_mailbox_t::recv (command_t *cmd_, int timeout_)
+{
+    while (true) {
+        //  Try to get the command straight away. The count of wakeups is
+        //  taken before reading, a signal received by another mailbox
+        //  after the pipe went passive changes it.
+        if (_active) {
+            if (_shared)
+                _seen = _shared->wakeups;
+            if (_cpipe.read (cmd_))
+                return 0;
+            _active = false;
+        }
+
+        //  Another mailbox may have received our signal in the meantime.
+        if (_shared && _shared->wakeups != _seen) {
+            _active = true;
+            continue;
+        }
+        break;
+    }
+
+    //  Wait for signal from the command sender.
+    int rc = _signaler->wait (timeout_);
+    if (rc == -1) {
+        errno_assert (errno == EAGAIN || errno == EINTR);
+        return -1;
+    }
+
+    //  Receive the signal.
+    rc = _signaler->recv_failable ();
+    if (rc == -1) {
+        errno_assert (errno == EAGAIN);
+        return -1;
+    }
+    if (_shared) {
+        _shared->wakeups++;
+        _seen = _shared->wakeups;
+    }
+
+    //  Switch into active state and get a command. The signal may have
+    //  been meant for another mailbox, in which case there is none.
+    _active = true;
+    if (_cpipe.read (cmd_))
+        return 0;
+    _active = false;
+    errno = EAGAIN;
+    return -1;
+}
+
+bool zmq::compact_mailbox_t::valid () const
+{
+    return _signaler->valid ();
+}
+
+void zmq::compact_mailbox_t::forked ()
+{
+    _signaler->forked ();
+}
+
+zmq::shared_signaler_t *zmq::compact_mailbox_t::unshare ()
+{
+    if (!_shared)
+        return NULL;
+
+    signaler_t *signaler = new (std::nothrow) signaler_t ();
+    alloc_assert (signaler);
+
+    _sync.lock ();
+    shared_signaler_t *shared = _shared;
+    _shared = NULL;
+    _signaler = signaler;
+
+    //  The commands already in the pipe may have been signalled through
+    //  the shared signaler. Make sure they are looked for.
+    _signaler->send ();
+    _sync.unlock ();
+
+    return shared;
+}
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_COMPACT_MAILBOX_HPP_INCLUDED__
+#define __ZMQ_COMPACT_MAILBOX_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "signaler.hpp"
+#include "fd.hpp"
+#include "config.hpp"
+#include "command.hpp"
+#include "ypipe.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "i_mailbox.hpp"
+
+namespace zmq
+{
+//  Signaler shared by the mailboxes of the sockets an application thread
+//  creates in a context in compact mode. It is only waited on by that
+//  thread.
+
+struct shared_signaler_t
+{
+    shared_signaler_t () : wakeups (0), refs (0) {}
+
+    signaler_t signaler;
+
+    //  Number of signals received from the signaler so far. A mailbox
+    //  that finds it changed since it last looked at its pipe checks the
+    //  pipe again, the signal meant for it may have been received by
+    //  another mailbox.
+    uint32_t wakeups;
+
+    //  Number of mailboxes using the signaler, maintained by the context.
+    int refs;
+};
+
+//  Mailbox of a socket in a context in compact mode. It works like
+//  mailbox_t, but the signaler is shared by the sockets of the thread that
+//  created the socket, and commands are stored in smaller chunks. The
+//  mailbox gets a signaler of its own when the socket is handed over to
+//  the reaper thread.
+
+class compact_mailbox_t : public i_mailbox
+{
+  public:
+    explicit compact_mailbox_t (shared_signaler_t *shared_);
+    ~compact_mailbox_t ();
+
+    fd_t get_fd () const;
+    void send (const command_t &cmd_);
+    int recv (command_t *cmd_, int timeout_);
+    bool valid () const;
+
+    void forked ();
+
+    //  Switches the mailbox to a signaler of its own and returns the
+    //  shared one, which the mailbox doesn't use anymore, or NULL if it
+    //  was switched already.
+    shared_signaler_t *unshare ();
+
+  private:
+    typedef ypipe_t<command_t, compact_command_pipe_granularity> cpipe_t;
+    cpipe_t _cpipe;
+
+    //  Signaler shared with the other sockets of the thread, or NULL once
+    //  the mailbox has its own.
+    shared_signaler_t *_shared;
+    signaler_t *_signaler;
+
+    //  Value of _shared->wakeups when the pipe was last read.
+    uint32_t _seen;
+
+    //  Synchronises the sending side, as in mailbox_t. Signals are sent
+    //  under the lock, so that the signaler can be switched safely.
+    mutex_t _sync;
+
+    //  True if the underlying pipe is active, ie. when we are allowed to
+    //  read commands from it.
+    bool _active;
+
+    compact_mailbox_t (const compact_mailbox_t &);
+    const compact_mailbox_t &operator= (const compact_mailbox_t &);
+};
+}
+
+#endif
@@ -14,6 +14,11 @@ enum
     //  Commands in pipe per allocation event.
     command_pipe_granularity = 16,
 
+    //  Commands in pipe per allocation event for the sockets of a context
+    //  in compact mode. Idle sockets receive few commands, so a smaller
+    //  chunk trades a few more allocations for less memory per socket.
+    compact_command_pipe_granularity = 4,
+
     //  Determines how often does socket poll for new commands when it
     //  still has unprocessed messages to handle. Thus, if it is set to 100,
     //  socket will process 100 inbound messages before doing the poll.
@@ -34,17 +39,50 @@ enum
     //  unnecessary network stack traversals.
     out_batch_size = 8192,
 
+    //  Maximal number of idle encoder and decoder buffers of each size an
+    //  I/O thread keeps for reuse. Buffers returned beyond that are freed.
+    max_pooled_buffers = 64,
+
+    //  Maximal number of ZAP replies a context caches. Once reached, new
+    //  replies are only cached as older ones expire.
+    max_zap_cache_entries = 10000,
+
+    //  Maximal number of unexpired CURVE resumption tickets a context
+    //  remembers as redeemed. Once reached, tickets are refused until
+    //  some of those expire.
+    max_redeemed_curve_tickets = 100000,
+
+    //  Maximal number of distinct connection metadata a context shares
+    //  between connections, and the number at which it first drops those
+    //  no longer in use.
+    max_interned_metadata = 10000,
+    min_metadata_sweep = 64,
+
+    //  Time in milliseconds host names resolved for TCP connecters are
+    //  cached by a context, and time failures to resolve them are. At
+    //  most max_dns_cache_entries names are cached.
+    dns_cache_ttl = 30000,
+    dns_negative_cache_ttl = 1000,
+    max_dns_cache_entries = 1000,
+
     //  Maximal delta between high and low watermark.
     max_wm_delta = 1024,
 
     //  Maximum number of events the I/O thread can process in one go.
     max_io_events = 256,
 
-    //  Maximal delay to process command in API thread (in CPU ticks).
-    //  3,000,000 ticks equals to 1 - 2 milliseconds on current CPUs.
-    //  Note that delay is only applied when there is continuous stream of
-    //  messages to process. If not so, commands are processed immediately.
-    max_command_delay = 3000000,
+    //  Bounds of the delay to process commands in API thread (in
+    //  microseconds). The delay adapts to the rate commands arrive at
+    //  within these bounds, unless set with ZMQ_COMMAND_DELAY. Note that
+    //  delay is only applied when there is continuous stream of messages
+    //  to process. If not so, commands are processed immediately.
+    max_command_delay = 1000,
+    min_command_delay = 50,
+
+    //  Delay to process commands in API thread (in CPU ticks) until the
+    //  rate of the ticks has been measured. 3,000,000 ticks equals to
+    //  1 - 2 milliseconds on current CPUs.
+    uncalibrated_command_delay = 3000000,
 
     //  Low-precision clock precision in CPU ticks. 1ms. Value of 1000000
     //  should be OK for CPU frequencies above 1GHz. If should work
@@ -0,0 +1,106 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "crypto_pool.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+#include "macros.hpp"
+
+zmq::crypto_pool_t::crypto_pool_t (ctx_t *ctx_, int workers_) :
+    _ctx (ctx_),
+    _max_workers (workers_),
+    _idle (0),
+    _stopping (false)
+{
+    zmq_assert (_max_workers > 0);
+}
+
+zmq::crypto_pool_t::~crypto_pool_t ()
+{
+    _sync.lock ();
+    _stopping = true;
+    _cond.broadcast ();
+    _sync.unlock ();
+
+    for (workers_t::size_type i = 0; i != _workers.size (); i++) {
+        _workers[i]->stop ();
+        LIBZMQ_DELETE (_workers[i]);
+    }
+    zmq_assert (_jobs.empty ());
+}
+
+void zmq::crypto_pool_t::submit (crypto_job_t *job_, io_thread_t *io_thread_)
+{
+    job_->set_io_thread (io_thread_);
+
+    scoped_lock_t locker (_sync);
+    zmq_assert (!_stopping);
+    _jobs.push_back (job_);
+
+    //  Start another worker if all of them are busy.
+    if (_idle == 0 && _workers.size () < static_cast<size_t> (_max_workers)) {
+        thread_t *worker = new (std::nothrow) thread_t;
+        alloc_assert (worker);
+        _workers.push_back (worker);
+        _ctx->start_thread (*worker, worker_routine, this);
+    } else
+        _cond.broadcast ();
+}
+
+void zmq::crypto_pool_t::worker_routine (void *arg_)
+{
+    static_cast<crypto_pool_t *> (arg_)->loop ();
+}
+
+void zmq::crypto_pool_t::loop ()
+{
+    _sync.lock ();
+    while (true) {
+        if (_jobs.empty ()) {
+            if (_stopping)
+                break;
+            _idle++;
+            const int rc = _cond.wait (&_sync, -1);
+            errno_assert (rc == 0);
+            _idle--;
+            continue;
+        }
+
+        crypto_job_t *job = _jobs.front ();
+        _jobs.pop_front ();
+        _sync.unlock ();
+
+        job->execute ();
+        job->send_done (_ctx);
+
+        _sync.lock ();
+    }
+    _sync.unlock ();
+}
@@ -0,0 +1,100 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_CRYPTO_POOL_HPP_INCLUDED__
+#define __ZMQ_CRYPTO_POOL_HPP_INCLUDED__
+
+#include <deque>
+#include <vector>
+
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+#include "io_job.hpp"
+#include "thread.hpp"
+
+namespace zmq
+{
+class ctx_t;
+class io_thread_t;
+
+//  Expensive cryptographic work taken off an I/O thread, e.g. the key
+//  exchanges of a CURVE handshake.
+
+class crypto_job_t : public io_job_t
+{
+  public:
+    //  Does the work. Runs on a worker of the pool, so it must only touch
+    //  the data of the job itself.
+    virtual void execute () = 0;
+};
+
+//  Bounded set of worker threads shared by the I/O threads of a context.
+//  Finished jobs are posted back through the mailbox of the I/O thread
+//  that submitted them, so connections sharing that thread keep flowing
+//  while jobs wait for a worker.
+
+class crypto_pool_t
+{
+  public:
+    crypto_pool_t (ctx_t *ctx_, int workers_);
+
+    //  Waits for the queued jobs to be done and stops the workers. Must be
+    //  called before the I/O threads stop.
+    ~crypto_pool_t ();
+
+    //  Queues the job. It is handed back to io_thread_ once executed.
+    //  Workers are started as jobs arrive, up to the configured count.
+    void submit (crypto_job_t *job_, io_thread_t *io_thread_);
+
+  private:
+    static void worker_routine (void *arg_);
+    void loop ();
+
+    ctx_t *const _ctx;
+    const int _max_workers;
+
+    typedef std::vector<thread_t *> workers_t;
+    workers_t _workers;
+
+    //  Number of workers waiting for a job.
+    int _idle;
+
+    typedef std::deque<crypto_job_t *> jobs_t;
+    jobs_t _jobs;
+    bool _stopping;
+
+    mutex_t _sync;
+    condition_variable_t _cond;
+
+    crypto_pool_t (const crypto_pool_t &);
+    const crypto_pool_t &operator= (const crypto_pool_t &);
+};
+}
+
+#endif
@@ -6,10 +6,14 @@
 #include <new>
 #include <sstream>
 #include <string.h>
+#include <stdlib.h>
 
 #include "ctx.hpp"
 #include "socket_base.hpp"
+#include "compact_mailbox.hpp"
 #include "io_thread.hpp"
+#include "crypto_pool.hpp"
+#include "dns_resolver.hpp"
 #include "reaper.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
@@ -35,12 +39,18 @@ zmq::ctx_t::ctx_t () :
     _starting (true),
     _terminating (false),
     _reaper (NULL),
+    _crypto_pool (NULL),
+    _dns_resolver (NULL),
+    _slot_count (0),
+    _slots_used (0),
     _max_sockets(clipped_maxsocket(ZMQ_MAX_SOCKETS_DFLT)),
     _max_msgsz(INT_MAX),
     _io_thread_count(ZMQ_IO_THREADS_DFLT),
+    _crypto_thread_count (1),
     _blocky (true),
     _ipv6 (false),
-    _zero_copy (true)
+    _zero_copy (true),
+    _compact_sockets (false)
 {
     _pid = getpid ();
 
@@ -57,12 +67,23 @@ zmq::ctx_t::~ctx_t ()
 {
     //  Check that there are no remaining _sockets.
     zmq_assert (_sockets.empty ());
+    zmq_assert (_shared_signalers.empty ());
+
+    //  Finish the pending crypto jobs and DNS requests while the I/O
+    //  threads can still take them back. A lookup in progress is not
+    //  waited for, the resolver deletes itself once it is over.
+    LIBZMQ_DELETE (_crypto_pool);
+    if (_dns_resolver) {
+        _dns_resolver->stop ();
+        _dns_resolver = NULL;
+    }
 
     //  Ask I/O threads to terminate. If stop signal wasn't sent to I/O
     //  thread subsequent invocation of destructor would hang-up.
     for (io_threads_t::size_type i = 0; i != _io_threads.size (); i++) 
     {
-        _io_threads[i]->stop();
+        if (_io_threads[i])
+            _io_threads[i]->stop();
     }
 
     //  Wait till I/O threads actually terminate.
@@ -74,8 +95,10 @@ zmq::ctx_t::~ctx_t ()
     //  Deallocate the reaper thread object.
     LIBZMQ_DELETE (_reaper);
 
-    //  The mailboxes in _slots themselves were deallocated with their
+    //  The mailboxes in the slots themselves were deallocated with their
     //  corresponding io_thread/socket objects.
+    for (slot_chunks_t::size_type i = 0; i != _slot_chunks.size (); i++)
+        free (_slot_chunks[i]);
 
     //  De-initialise crypto library, if needed.
     zmq::random_close();
@@ -218,6 +241,20 @@ int zmq::ctx_t::set(int option_, int optval_)
         scoped_lock_t locker (_opt_sync);
         _zero_copy = (optval_ != 0);
     } 
+    else if (option_ == ZMQ_COMPACT_SOCKETS && optval_ >= 0)
+    {
+        scoped_lock_t locker (_opt_sync);
+        _compact_sockets = (optval_ != 0);
+    }
+    else if (option_ == ZMQ_CRYPTO_THREADS && optval_ >= 0)
+    {
+        scoped_lock_t locker (_opt_sync);
+        _crypto_thread_count = optval_;
+    }
+    else if (option_ == ZMQ_ZAP_CACHE_TTL && optval_ >= 0)
+    {
+        _zap_cache.set_ttl (optval_);
+    }
     else 
     {
         rc = thread_ctx_t::set (option_, optval_);
@@ -262,6 +299,18 @@ int zmq::ctx_t::get (int option_)
     {
         rc = _zero_copy;
     }
+    else if (option_ == ZMQ_COMPACT_SOCKETS)
+    {
+        rc = _compact_sockets;
+    }
+    else if (option_ == ZMQ_CRYPTO_THREADS)
+    {
+        rc = _crypto_thread_count;
+    }
+    else if (option_ == ZMQ_ZAP_CACHE_TTL)
+    {
+        rc = _zap_cache.get_ttl ();
+    }
     else 
     {
         rc = thread_ctx_t::get(option_);
@@ -272,30 +321,38 @@ int zmq::ctx_t::get (int option_)
 
 bool zmq::ctx_t::start()
 {
-    //  Initialise the array of mailboxes. Additional two slots are for
-    //  zmq_ctx_term thread and reaper thread.
+    //  Size the array of mailboxes. Additional two slots are for
+    //  zmq_ctx_term thread and reaper thread. Only the chunks holding
+    //  these and the I/O threads' slots are allocated now; the others
+    //  are allocated as sockets are created.
     _opt_sync.lock ();
     const int term_and_reaper_threads_count = 2;
     const int mazmq = _max_sockets;
     const int ios   = _io_thread_count;
     _opt_sync.unlock ();
 
-    int slot_count = mazmq + ios + term_and_reaper_threads_count;
+    _slot_count = mazmq + ios + term_and_reaper_threads_count;
+    _slots_used = ios + term_and_reaper_threads_count;
 
     try 
     {
-        _slots.reserve(slot_count);
-        _empty_slots.reserve(slot_count - term_and_reaper_threads_count);
+        _slot_chunks.resize((_slot_count + slot_chunk_size - 1) / slot_chunk_size, NULL);
+        _io_threads.resize(ios, NULL);
     }
     catch (const std::bad_alloc &)
     {
         errno = ENOMEM;
         return false;
     }
-    _slots.resize(term_and_reaper_threads_count);
+
+    for (uint32_t i = 0; i < _slots_used; i += slot_chunk_size)
+    {
+        if (!alloc_slot_chunk (i))
+            goto fail_cleanup_slots;
+    }
 
     //  Initialise the infrastructure for zmq_ctx_term thread.
-    _slots[term_tid] = &_term_mailbox;
+    slot(term_tid) = &_term_mailbox;
 
     //  Create the reaper thread.
     _reaper = new (std::nothrow) reaper_t(this, reaper_tid);
@@ -310,39 +367,10 @@ bool zmq::ctx_t::start()
         goto fail_cleanup_reaper;
     }
 
-    _slots[reaper_tid] = _reaper->get_mailbox();
+    slot(reaper_tid) = _reaper->get_mailbox();
     _reaper->start();
 
-    //  Create I/O thread objects and launch them.
-    _slots.resize(slot_count, NULL);
-
-    // ʼIỌ߳
-    for (int i = term_and_reaper_threads_count; i != ios + term_and_reaper_threads_count; i++) 
-    {
-        io_thread_t *io_thread = new (std::nothrow) io_thread_t(this, i);
-        if (!io_thread)
-        {
-            errno = ENOMEM;
-            goto fail_cleanup_reaper;
-        }
-
-        if (!io_thread->get_mailbox()->valid ()) 
-        {
-            delete io_thread;
-            goto fail_cleanup_reaper;
-        }
-
-        _io_threads.push_back(io_thread);
-        _slots[i] = io_thread->get_mailbox();
-        io_thread->start();
-    }
-
-    //  In the unused part of the slot array, create a list of empty slots.
-    for (int32_t i = static_cast<int32_t>(_slots.size()) - 1; i >= static_cast<int32_t>(ios) + term_and_reaper_threads_count; i--) 
-    {
-        _empty_slots.push_back (i);
-    }
-
+    //  I/O threads are launched when first chosen.
     _starting = false;
     return true;
 
@@ -352,10 +380,28 @@ fail_cleanup_reaper:
     _reaper = NULL;
 
 fail_cleanup_slots:
-    _slots.clear ();
+    for (slot_chunks_t::size_type i = 0; i != _slot_chunks.size (); i++)
+        free (_slot_chunks[i]);
+    _slot_chunks.clear ();
+    _io_threads.clear ();
     return false;
 }
 
+bool zmq::ctx_t::alloc_slot_chunk (uint32_t tid_)
+{
+    i_mailbox **&chunk = _slot_chunks[tid_ / slot_chunk_size];
+    if (!chunk)
+    {
+        chunk = static_cast<i_mailbox **> (calloc (slot_chunk_size, sizeof (i_mailbox *)));
+        if (!chunk)
+        {
+            errno = ENOMEM;
+            return false;
+        }
+    }
+    return true;
+}
+
 zmq::socket_base_t *zmq::ctx_t::create_socket(int type_)
 {
     scoped_lock_t locker(_slot_sync);
@@ -374,17 +420,26 @@ zmq::socket_base_t *zmq::ctx_t::create_socket(int type_)
         return NULL;
     }
 
-    //  If max_sockets limit was reached, return error.
-    if (_empty_slots.empty()) 
+    //  Choose a slot for the socket, reusing the slots of closed sockets
+    //  first. If max_sockets limit was reached, return error.
+    uint32_t slot;
+    if (!_empty_slots.empty())
+    {
+        slot = _empty_slots.back ();
+        _empty_slots.pop_back();
+    }
+    else if (_slots_used < _slot_count)
+    {
+        if (!alloc_slot_chunk (_slots_used))
+            return NULL;
+        slot = _slots_used++;
+    }
+    else
     {
         errno = EMFILE;
         return NULL;
     }
 
-    //  Choose a slot for the socket.
-    uint32_t slot = _empty_slots.back ();
-    _empty_slots.pop_back();
-
     //  Generate new unique socket ID.
     int sid = (static_cast<int>(max_socket_id.add(1))) + 1;
 
@@ -396,7 +451,7 @@ zmq::socket_base_t *zmq::ctx_t::create_socket(int type_)
         return NULL;
     }
     _sockets.push_back(s);
-    _slots[slot] = s->get_mailbox();
+    this->slot(slot) = s->get_mailbox();
 
     return s;
 }
@@ -408,7 +463,7 @@ void zmq::ctx_t::destroy_socket(class socket_base_t *socket_)
     //  Free the associated thread slot.
     uint32_t tid = socket_->get_tid ();
     _empty_slots.push_back (tid);
-    _slots[tid] = NULL;
+    slot(tid) = NULL;
 
     //  Remove the socket from the list of sockets.
     _sockets.erase(socket_);
@@ -424,6 +479,44 @@ zmq::object_t *zmq::ctx_t::get_reaper ()
     return _reaper;
 }
 
+zmq::shared_signaler_t *zmq::ctx_t::acquire_shared_signaler ()
+{
+    scoped_lock_t locker (_slot_sync);
+
+    const thread_t::id_t self = thread_t::current_id ();
+    for (shared_signalers_t::size_type i = 0; i != _shared_signalers.size ();
+         i++)
+        if (thread_t::same_id (_shared_signalers[i].first, self)) {
+            _shared_signalers[i].second->refs++;
+            return _shared_signalers[i].second;
+        }
+
+    shared_signaler_t *signaler = new (std::nothrow) shared_signaler_t ();
+    alloc_assert (signaler);
+    if (!signaler->signaler.valid ()) {
+        LIBZMQ_DELETE (signaler);
+        return NULL;
+    }
+    signaler->refs = 1;
+    _shared_signalers.push_back (std::make_pair (self, signaler));
+    return signaler;
+}
+
+void zmq::ctx_t::release_shared_signaler (shared_signaler_t *signaler_)
+{
+    scoped_lock_t locker (_slot_sync);
+
+    if (--signaler_->refs)
+        return;
+    for (shared_signalers_t::iterator it = _shared_signalers.begin ();
+         it != _shared_signalers.end (); ++it)
+        if (it->second == signaler_) {
+            _shared_signalers.erase (it);
+            break;
+        }
+    LIBZMQ_DELETE (signaler_);
+}
+
 zmq::thread_ctx_t::thread_ctx_t() : _thread_priority(ZMQ_THREAD_PRIORITY_DFLT), _thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT)
 {
 
@@ -518,22 +611,32 @@ int zmq::thread_ctx_t::get(int option_)
 
 void zmq::ctx_t::send_command(uint32_t tid_, const command_t & command_)
 {
-    _slots[tid_]->send(command_);
+    slot(tid_)->send(command_);
 }
 
 zmq::io_thread_t *zmq::ctx_t::choose_io_thread(uint64_t affinity_)
 {
-    if (_io_threads.empty ())
-        return NULL;
+    scoped_lock_t locker (_io_threads_sync);
 
-    //  Find the I/O thread with minimum load.
+    //  Find the I/O thread with minimum load. An idle thread is taken
+    //  straight away; otherwise the first eligible thread not launched yet
+    //  is preferred, so threads are only started once the running ones
+    //  have work.
     int min_load = -1;
     io_thread_t *selected_io_thread = NULL;
+    int unstarted = -1;
 
     for (io_threads_t::size_type i = 0; i != _io_threads.size (); i++) 
     {
         if (!affinity_ || (affinity_ & (uint64_t (1) << i)))
         {
+            if (!_io_threads[i])
+            {
+                if (unstarted == -1)
+                    unstarted = static_cast<int> (i);
+                continue;
+            }
+
             int load = _io_threads[i]->get_load();
             if (selected_io_thread == NULL || load < min_load) 
             {
@@ -543,9 +646,105 @@ zmq::io_thread_t *zmq::ctx_t::choose_io_thread(uint64_t affinity_)
         }
     }
 
+    if (unstarted != -1 && (selected_io_thread == NULL || min_load > 0))
+    {
+        io_thread_t *io_thread = start_io_thread (unstarted);
+        if (io_thread)
+            selected_io_thread = io_thread;
+    }
+
     return selected_io_thread;
 }
 
+zmq::io_thread_t *zmq::ctx_t::start_io_thread (int index_)
+{
+    const uint32_t tid = index_ + reaper_tid + 1;
+
+    io_thread_t *io_thread = new (std::nothrow) io_thread_t(this, tid);
+    if (!io_thread)
+    {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    if (!io_thread->get_mailbox()->valid ()) 
+    {
+        delete io_thread;
+        return NULL;
+    }
+
+    slot(tid) = io_thread->get_mailbox();
+    _io_threads[index_] = io_thread;
+    io_thread->start();
+
+    return io_thread;
+}
+
+zmq::io_thread_t *zmq::ctx_t::reactor_io_thread ()
+{
+    scoped_lock_t locker (_slot_sync);
+
+    if (unlikely (_starting)) {
+        if (!start ())
+            return NULL;
+    }
+
+    //  Once zmq_ctx_term() was called, we can't create new reactors.
+    if (_terminating) {
+        errno = ETERM;
+        return NULL;
+    }
+
+    io_thread_t *io_thread = choose_io_thread (0);
+    if (!io_thread)
+        errno = EMTHREAD;
+    return io_thread;
+}
+
+zmq::crypto_pool_t *zmq::ctx_t::get_crypto_pool ()
+{
+    scoped_lock_t locker (_io_threads_sync);
+
+    if (!_crypto_pool) {
+        _opt_sync.lock ();
+        const int workers = _crypto_thread_count;
+        _opt_sync.unlock ();
+
+        if (workers > 0) {
+            _crypto_pool = new (std::nothrow) crypto_pool_t (this, workers);
+            alloc_assert (_crypto_pool);
+        }
+    }
+    return _crypto_pool;
+}
+
+zmq::dns_resolver_t *zmq::ctx_t::get_dns_resolver ()
+{
+    scoped_lock_t locker (_io_threads_sync);
+
+    if (!_dns_resolver) {
+        _dns_resolver = new (std::nothrow)
+          dns_resolver_t (this, dns_cache_ttl, dns_negative_cache_ttl);
+        alloc_assert (_dns_resolver);
+    }
+    return _dns_resolver;
+}
+
+zmq::zap_cache_t *zmq::ctx_t::get_zap_cache ()
+{
+    return &_zap_cache;
+}
+
+zmq::curve_tickets_t *zmq::ctx_t::get_curve_tickets ()
+{
+    return &_curve_tickets;
+}
+
+zmq::metadata_registry_t *zmq::ctx_t::get_metadata_registry ()
+{
+    return &_metadata_registry;
+}
+
 int zmq::ctx_t::register_endpoint(const char * addr_, const endpoint_t & endpoint_)
 {
     scoped_lock_t locker (_endpoints_sync);
@@ -676,6 +875,10 @@ void zmq::ctx_t::connect_inproc_sockets(zmq::socket_base_t *bind_socket_, option
         pending_connection_.bind_pipe->set_hwms(-1, -1);
     }
 
+    pending_connection_.bind_pipe->set_lb_weight (bind_options_.lb_weight);
+    pending_connection_.bind_pipe->set_fq_priority (bind_options_.fq_priority);
+    pending_connection_.bind_pipe->set_fq_weight (bind_options_.fq_weight);
+
     if (side_ == bind_side) 
     {
         command_t cmd;
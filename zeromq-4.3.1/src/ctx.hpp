@@ -14,6 +14,9 @@
 #include "options.hpp"
 #include "atomic_counter.hpp"
 #include "thread.hpp"
+#include "zap_cache.hpp"
+#include "curve_tickets.hpp"
+#include "metadata.hpp"
 
 namespace zmq
 {
@@ -21,7 +24,10 @@ class object_t;
 class io_thread_t;
 class socket_base_t;
 class reaper_t;
+class crypto_pool_t;
+class dns_resolver_t;
 class pipe_t;
+struct shared_signaler_t;
 
 //  Information associated with inproc endpoint. Note that endpoint options
 //  are registered as well so that the peer can access them without a need
@@ -96,9 +102,35 @@ public:
     //  Returns NULL if no I/O thread is available.
     zmq::io_thread_t *choose_io_thread (uint64_t affinity_);
 
+    //  Returns the I/O thread to host a new reactor, starting the
+    //  infrastructure if needed. Returns NULL and sets errno on failure.
+    zmq::io_thread_t *reactor_io_thread ();
+
+    //  Returns the pool running the CURVE key exchanges of the I/O threads,
+    //  creating it if needed, or NULL if they are done inline.
+    crypto_pool_t *get_crypto_pool ();
+
+    //  Returns the resolver of host names, creating it if needed.
+    dns_resolver_t *get_dns_resolver ();
+
+    //  Returns the ZAP replies cached for the sockets of this context.
+    zap_cache_t *get_zap_cache ();
+
+    //  Returns the keeper of the CURVE resumption tickets of this context.
+    curve_tickets_t *get_curve_tickets ();
+
+    //  Returns the metadata shared by the connections of this context.
+    metadata_registry_t *get_metadata_registry ();
+
     //  Returns reaper thread object.
     zmq::object_t *get_reaper ();
 
+    //  Returns the signaler shared by the sockets the calling thread
+    //  creates in compact mode, or NULL if it could not be created.
+    //  Each call must be matched by a release_shared_signaler.
+    shared_signaler_t *acquire_shared_signaler ();
+    void release_shared_signaler (shared_signaler_t *signaler_);
+
     //  Management of inproc endpoints.
     int register_endpoint (const char *addr_, const endpoint_t &endpoint_);
     int unregister_endpoint (const std::string &addr_, socket_base_t *socket_);
@@ -120,6 +152,13 @@ public:
 private:
     bool start ();
 
+    //  Makes sure the chunk holding the slot tid_ is allocated.
+    bool alloc_slot_chunk (uint32_t tid_);
+
+    //  Launches the I/O thread of the given index. Returns NULL and sets
+    //  errno on failure.
+    zmq::io_thread_t *start_io_thread (int index_);
+
     struct pending_connection_t
     {
         endpoint_t   endpoint;
@@ -148,7 +187,7 @@ private:
     bool _terminating;
 
     //  Synchronisation of accesses to global slot-related data:
-    //  sockets, empty_slots, terminating. It also synchronises
+    //  sockets, empty_slots, terminating, shared signalers. It also synchronises
     //  access to zombie sockets as such (as opposed to slots) and provides
     //  a memory barrier to ensure that all CPU cores see the same data.
     mutex_t _slot_sync;
@@ -156,16 +195,51 @@ private:
     //  The reaper thread.
     zmq::reaper_t *_reaper;
 
-    //  I/O threads.
+    //  I/O threads. Entries are NULL until the thread is first chosen.
     typedef std::vector<zmq::io_thread_t *> io_threads_t;
     io_threads_t _io_threads;
 
+    //  Synchronisation of the launch of I/O threads and of the creation
+    //  of the crypto pool and DNS resolver.
+    mutex_t _io_threads_sync;
+
+    //  Workers doing handshake cryptography, created on first use.
+    crypto_pool_t *_crypto_pool;
+
+    //  Resolver of the host names TCP connecters connect to, created on
+    //  first use.
+    dns_resolver_t *_dns_resolver;
+
     //  Array of pointers to mailboxes for both application and I/O threads.
-    std::vector<i_mailbox *> _slots;
+    //  It is allocated in chunks as slots get used. Slots never move once
+    //  allocated, so they are read without locking.
+    enum
+    {
+        slot_chunk_size = 256
+    };
+    typedef std::vector<i_mailbox **> slot_chunks_t;
+    slot_chunks_t _slot_chunks;
+
+    i_mailbox *&slot (uint32_t tid_)
+    {
+        return _slot_chunks[tid_ / slot_chunk_size][tid_ % slot_chunk_size];
+    }
+
+    //  Total number of slots and number of slots handed out so far. Slots
+    //  of closed sockets go to _empty_slots for reuse.
+    uint32_t _slot_count;
+    uint32_t _slots_used;
 
     //  Mailbox for zmq_ctx_term thread.
     mailbox_t _term_mailbox;
 
+    //  Signalers shared by the sockets of each application thread in
+    //  compact mode. There are as many as threads creating sockets, so
+    //  they are simply looked up in a list.
+    typedef std::vector<std::pair<thread_t::id_t, shared_signaler_t *> >
+      shared_signalers_t;
+    shared_signalers_t _shared_signalers;
+
     //  List of inproc endpoints within this context.
     typedef std::map<std::string, endpoint_t> endpoints_t;
     endpoints_t _endpoints;
@@ -189,6 +263,9 @@ private:
     //  Number of I/O threads to launch.
     int _io_thread_count;
 
+    //  Maximum number of crypto pool workers, 0 for none.
+    int _crypto_thread_count;
+
     //  Does context wait (possibly forever) on termination?
     bool _blocky;
 
@@ -198,6 +275,18 @@ private:
     // Should we use zero copy message decoding in this context?
     bool _zero_copy;
 
+    //  Do sockets share signalers per thread and save memory?
+    bool _compact_sockets;
+
+    //  ZAP replies cached for reconnecting peers.
+    zap_cache_t _zap_cache;
+
+    //  CURVE resumption tickets issued by the sockets of this context.
+    curve_tickets_t _curve_tickets;
+
+    //  Metadata of the connections of this context.
+    metadata_registry_t _metadata_registry;
+
     ctx_t (const ctx_t &);
     const ctx_t &operator= (const ctx_t &);
 
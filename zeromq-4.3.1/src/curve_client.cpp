@@ -38,6 +38,7 @@
 #include "curve_client.hpp"
 #include "wire.hpp"
 #include "curve_client_tools.hpp"
+#include "clock.hpp"
 
 zmq::curve_client_t::curve_client_t (session_base_t *session_,
                                      const options_t &options_) :
@@ -49,6 +50,8 @@ zmq::curve_client_t::curve_client_t (session_base_t *session_,
             options_.curve_secret_key,
             options_.curve_server_key)
 {
+    if (options_.curve_ticket_lifetime > 0 && take_ticket ())
+        _state = send_resume;
 }
 
 zmq::curve_client_t::~curve_client_t ()
@@ -70,6 +73,11 @@ int zmq::curve_client_t::next_handshake_command (msg_t *msg_)
             if (rc == 0)
                 _state = expect_ready;
             break;
+        case send_resume:
+            rc = produce_resume (msg_);
+            if (rc == 0)
+                _state = expect_resumed;
+            break;
         default:
             errno = EAGAIN;
             rc = -1;
@@ -89,6 +97,8 @@ int zmq::curve_client_t::process_handshake_command (msg_t *msg_)
     else if (curve_client_tools_t::is_handshake_command_ready (msg_data,
                                                                msg_size))
         rc = process_ready (msg_data, msg_size);
+    else if (msg_size >= 8 && !memcmp (msg_data, "\x07RESUMED", 8))
+        rc = process_resumed (msg_data, msg_size);
     else if (curve_client_tools_t::is_handshake_command_error (msg_data,
                                                                msg_size))
         rc = process_error (msg_data, msg_size);
@@ -174,12 +184,22 @@ int zmq::curve_client_t::process_welcome (const uint8_t *msg_data_,
 
 int zmq::curve_client_t::produce_initiate (msg_t *msg_)
 {
-    const size_t metadata_length = basic_properties_len ();
+    const bool request_ticket = options.curve_ticket_lifetime > 0;
+    const size_t metadata_length =
+      basic_properties_len ()
+      + (request_ticket ? property_len (resume_property, 0) : 0)
+      + extension_properties_len ();
     unsigned char *metadata_plaintext =
       static_cast<unsigned char *> (malloc (metadata_length));
     alloc_assert (metadata_plaintext);
 
-    add_basic_properties (metadata_plaintext, metadata_length);
+    unsigned char *ptr = metadata_plaintext;
+    ptr += add_basic_properties (ptr, metadata_length);
+    if (request_ticket)
+        ptr += add_property (ptr, metadata_length - (ptr - metadata_plaintext),
+                             resume_property, "", 0);
+    add_extension_properties (ptr,
+                              metadata_length - (ptr - metadata_plaintext));
 
     size_t msg_size = 113 + 128 + crypto_box_BOXZEROBYTES + metadata_length;
     int rc = msg_->init_size (msg_size);
@@ -258,10 +278,196 @@ int zmq::curve_client_t::process_ready (const uint8_t *msg_data_,
     return rc;
 }
 
+int zmq::curve_client_t::produce_resume (msg_t *msg_)
+{
+    const size_t metadata_length =
+      basic_properties_len () + extension_properties_len ();
+    std::vector<uint8_t> resume_plaintext (crypto_box_ZEROBYTES
+                                           + metadata_length);
+    std::vector<uint8_t> resume_box (crypto_box_ZEROBYTES + metadata_length);
+
+    //  Create Box [metadata](secret) with a key of its own
+    uint8_t *ptr = &resume_plaintext[crypto_box_ZEROBYTES];
+    ptr += add_basic_properties (ptr, metadata_length);
+    add_extension_properties (
+      ptr, &resume_plaintext[0] + resume_plaintext.size () - ptr);
+
+    randombytes (_resume_nonce, crypto_box_NONCEBYTES);
+    uint8_t resume_key[crypto_box_BEFORENMBYTES];
+    derive_resumption_key (resume_key, _ticket_secret, _resume_nonce, NULL);
+
+    int rc = crypto_box_afternm (&resume_box[0], &resume_plaintext[0],
+                                 resume_plaintext.size (), _resume_nonce,
+                                 resume_key);
+    zmq_assert (rc == 0);
+
+    rc = msg_->init_size (7 + crypto_box_NONCEBYTES
+                          + curve_tickets_t::ticket_size + resume_box.size ()
+                          - crypto_box_BOXZEROBYTES);
+    errno_assert (rc == 0);
+
+    uint8_t *resume = static_cast<uint8_t *> (msg_->data ());
+
+    memcpy (resume, "\x06RESUME", 7);
+    memcpy (resume + 7, _resume_nonce, crypto_box_NONCEBYTES);
+    memcpy (resume + 7 + crypto_box_NONCEBYTES, _ticket, sizeof _ticket);
+    memcpy (resume + 7 + crypto_box_NONCEBYTES + sizeof _ticket,
+            &resume_box[crypto_box_BOXZEROBYTES],
+            resume_box.size () - crypto_box_BOXZEROBYTES);
+
+    cn_nonce++;
+
+    return 0;
+}
+
+int zmq::curve_client_t::process_resumed (const uint8_t *msg_data_,
+                                          size_t msg_size_)
+{
+    if (_state != expect_resumed) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_UNEXPECTED_COMMAND);
+        errno = EPROTO;
+        return -1;
+    }
+    if (msg_size_ < 8 + crypto_box_NONCEBYTES + crypto_box_BOXZEROBYTES) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_UNSPECIFIED);
+        errno = EPROTO;
+        return -1;
+    }
+
+    const uint8_t *resumed_nonce = msg_data_ + 8;
+    const size_t clen =
+      msg_size_ - 8 - crypto_box_NONCEBYTES + crypto_box_BOXZEROBYTES;
+
+    std::vector<uint8_t> resumed_box (clen);
+    std::vector<uint8_t> resumed_plaintext (clen);
+    memcpy (&resumed_box[crypto_box_BOXZEROBYTES],
+            resumed_nonce + crypto_box_NONCEBYTES,
+            clen - crypto_box_BOXZEROBYTES);
+
+    //  Open Box [metadata + ticket](secret) with the keys of the resumed
+    //  session, which proves that the server could open the ticket
+    derive_resumption_key (cn_precom, _ticket_secret, _resume_nonce,
+                           resumed_nonce);
+    memset (_ticket_secret, 0, sizeof _ticket_secret);
+
+    int rc = crypto_box_open_afternm (&resumed_plaintext[0], &resumed_box[0],
+                                      clen, resumed_nonce, cn_precom);
+    if (rc != 0) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+        errno = EPROTO;
+        return -1;
+    }
+
+    rc = parse_metadata (&resumed_plaintext[crypto_box_ZEROBYTES],
+                         clen - crypto_box_ZEROBYTES);
+    if (rc == 0)
+        _state = connected;
+    else {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_INVALID_METADATA);
+        errno = EPROTO;
+    }
+
+    return rc;
+}
+
+bool zmq::curve_client_t::take_ticket ()
+{
+    //  The session keeps the expiry, secret and ticket. A ticket is only
+    //  ever presented once.
+    std::string &state = session->mechanism_state ();
+    const size_t state_size =
+      8 + curve_tickets_t::secret_size + curve_tickets_t::ticket_size;
+
+    bool taken = false;
+    if (state.size () == state_size) {
+        const uint8_t *ptr = reinterpret_cast<const uint8_t *> (state.data ());
+        clock_t clock;
+        if (get_uint64 (ptr) > clock.now_ms ()) {
+            memcpy (_ticket_secret, ptr + 8, sizeof _ticket_secret);
+            memcpy (_ticket, ptr + 8 + sizeof _ticket_secret, sizeof _ticket);
+            taken = true;
+        }
+    }
+    state.clear ();
+    return taken;
+}
+
+size_t zmq::curve_client_t::extension_properties_len () const
+{
+    return (options.curve_aead
+              ? property_len (cipher_property, supported_ciphers ().size ())
+              : 0)
+           + (options.curve_batch ? property_len (batch_property, 0) : 0);
+}
+
+size_t zmq::curve_client_t::add_extension_properties (uint8_t *ptr_,
+                                                      size_t ptr_capacity_)
+{
+    size_t size = 0;
+    if (options.curve_aead) {
+        const std::string ciphers = supported_ciphers ();
+        size += add_property (ptr_, ptr_capacity_, cipher_property,
+                              ciphers.data (), ciphers.size ());
+    }
+    if (options.curve_batch)
+        size += add_property (ptr_ + size, ptr_capacity_ - size,
+                              batch_property, "", 0);
+    return size;
+}
+
+int zmq::curve_client_t::property (const std::string &name_,
+                                   const void *value_,
+                                   size_t length_)
+{
+    //  The server must pick one of the ciphers offered.
+    if (name_ == cipher_property) {
+        const cipher_t cipher = select_cipher (value_, length_);
+        if (!options.curve_aead || cipher == cipher_box
+            || length_ != strlen (cipher_name (cipher)))
+            return -1;
+        set_cipher (cipher);
+        return 1;
+    }
+
+    //  The server only agrees to batches asked for.
+    if (name_ == batch_property) {
+        if (!options.curve_batch)
+            return -1;
+        set_batching ();
+        return 1;
+    }
+
+    if (name_ != ticket_property)
+        return 0;
+
+    if (length_ == curve_tickets_t::ticket_size
+        && options.curve_ticket_lifetime > 0) {
+        uint8_t secret[curve_tickets_t::secret_size];
+        derive_ticket_secret (secret);
+
+        uint8_t expiry[8];
+        clock_t clock;
+        put_uint64 (expiry, clock.now_ms () + options.curve_ticket_lifetime);
+
+        std::string &state = session->mechanism_state ();
+        state.assign (reinterpret_cast<const char *> (expiry), sizeof expiry);
+        state.append (reinterpret_cast<const char *> (secret), sizeof secret);
+        state.append (static_cast<const char *> (value_), length_);
+        memset (secret, 0, sizeof secret);
+    }
+    return 1;
+}
+
 int zmq::curve_client_t::process_error (const uint8_t *msg_data_,
                                         size_t msg_size_)
 {
-    if (_state != expect_welcome && _state != expect_ready) {
+    if (_state != expect_welcome && _state != expect_ready
+        && _state != expect_resumed) {
         session->get_socket ()->event_handshake_failed_protocol (
           session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_UNEXPECTED_COMMAND);
         errno = EPROTO;
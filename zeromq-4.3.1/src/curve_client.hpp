@@ -35,6 +35,7 @@
 #include "curve_mechanism_base.hpp"
 #include "options.hpp"
 #include "curve_client_tools.hpp"
+#include "curve_tickets.hpp"
 
 namespace zmq
 {
@@ -61,6 +62,8 @@ class curve_client_t : public curve_mechanism_base_t
         expect_welcome,
         send_initiate,
         expect_ready,
+        send_resume,
+        expect_resumed,
         error_received,
         connected
     };
@@ -71,11 +74,30 @@ class curve_client_t : public curve_mechanism_base_t
     //  CURVE protocol tools
     curve_client_tools_t _tools;
 
+    //  Ticket the session is resumed with, its secret and the nonce of
+    //  RESUME.
+    uint8_t _ticket[curve_tickets_t::ticket_size];
+    uint8_t _ticket_secret[curve_tickets_t::secret_size];
+    uint8_t _resume_nonce[crypto_box_NONCEBYTES];
+
     int produce_hello (msg_t *msg_);
     int process_welcome (const uint8_t *cmd_data_, size_t data_size_);
     int produce_initiate (msg_t *msg_);
     int process_ready (const uint8_t *cmd_data_, size_t data_size_);
+    int produce_resume (msg_t *msg_);
+    int process_resumed (const uint8_t *cmd_data_, size_t data_size_);
     int process_error (const uint8_t *cmd_data_, size_t data_size_);
+
+    //  Takes the ticket kept by the session, if it has not expired.
+    bool take_ticket ();
+
+    //  Offers the ciphers and batches asked for in metadata.
+    size_t extension_properties_len () const;
+    size_t add_extension_properties (uint8_t *ptr_, size_t ptr_capacity_);
+
+    //  Keeps the ticket of the ticket property for the next connection,
+    //  and switches to the cipher and batches the server agreed to.
+    int property (const std::string &name_, const void *value_, size_t length_);
 };
 }
 
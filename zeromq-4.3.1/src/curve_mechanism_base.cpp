@@ -33,6 +33,7 @@
 #include "msg.hpp"
 #include "wire.hpp"
 #include "session_base.hpp"
+#include "config.hpp"
 
 #ifdef ZMQ_HAVE_CURVE
 
@@ -45,54 +46,341 @@ zmq::curve_mechanism_base_t::curve_mechanism_base_t (
     encode_nonce_prefix (encode_nonce_prefix_),
     decode_nonce_prefix (decode_nonce_prefix_),
     cn_nonce (1),
-    cn_peer_nonce (1)
+    cn_peer_nonce (1),
+    cipher (cipher_box),
+    _encode_state (NULL),
+    _decode_state (NULL),
+    _encode_counter (0),
+    _decode_counter (0),
+    _batching (false),
+    _batch_size (0),
+    _decoded (NULL)
 {
 }
 
-int zmq::curve_mechanism_base_t::encode (msg_t *msg_)
+zmq::curve_mechanism_base_t::~curve_mechanism_base_t ()
 {
-    const size_t mlen = crypto_box_ZEROBYTES + 1 + msg_->size ();
+    memset (_encode_key, 0, sizeof _encode_key);
+    memset (_decode_key, 0, sizeof _decode_key);
+    if (_encode_state) {
+        memset (_encode_state, 0, sizeof *_encode_state);
+        delete _encode_state;
+    }
+    if (_decode_state) {
+        memset (_decode_state, 0, sizeof *_decode_state);
+        delete _decode_state;
+    }
+    for (std::vector<msg_t>::iterator it = _batch.begin ();
+         it != _batch.end (); ++it) {
+        const int rc = it->close ();
+        errno_assert (rc == 0);
+    }
+    if (_decoded)
+        release_batch (NULL, _decoded);
+}
 
-    uint8_t message_nonce[crypto_box_NONCEBYTES];
-    memcpy (message_nonce, encode_nonce_prefix, 16);
-    put_uint64 (message_nonce + 16, cn_nonce);
+const char zmq::curve_mechanism_base_t::resume_property[] = "X-Curve-Resume";
+const char zmq::curve_mechanism_base_t::ticket_property[] = "X-Curve-Ticket";
+const char zmq::curve_mechanism_base_t::cipher_property[] = "X-Curve-Cipher";
+const char zmq::curve_mechanism_base_t::batch_property[] = "X-Curve-Batch";
+
+static const char aes256gcm_name[] = "AES-256-GCM";
+static const char chacha20poly1305_name[] = "ChaCha20-Poly1305";
+
+void zmq::curve_mechanism_base_t::derive_resumption_key (
+  uint8_t *key_,
+  const uint8_t *secret_,
+  const uint8_t *client_nonce_,
+  const uint8_t *server_nonce_)
+{
+    uint8_t input[16 + 32 + 2 * crypto_box_NONCEBYTES];
+    size_t size = 16 + 32 + crypto_box_NONCEBYTES;
+
+    memcpy (input, server_nonce_ ? "CurveZMQRESUMED-" : "CurveZMQRESUME--",
+            16);
+    memcpy (input + 16, secret_, 32);
+    memcpy (input + 48, client_nonce_, crypto_box_NONCEBYTES);
+    if (server_nonce_) {
+        memcpy (input + size, server_nonce_, crypto_box_NONCEBYTES);
+        size += crypto_box_NONCEBYTES;
+    }
+
+    uint8_t hash[crypto_hash_BYTES];
+    crypto_hash (hash, input, size);
+    memcpy (key_, hash, crypto_box_BEFORENMBYTES);
+    memset (input, 0, sizeof input);
+    memset (hash, 0, sizeof hash);
+}
+
+void zmq::curve_mechanism_base_t::derive_ticket_secret (uint8_t *secret_) const
+{
+    uint8_t input[16 + crypto_box_BEFORENMBYTES];
+    memcpy (input, "CurveZMQTICKET--", 16);
+    memcpy (input + 16, cn_precom, crypto_box_BEFORENMBYTES);
+
+    uint8_t hash[crypto_hash_BYTES];
+    crypto_hash (hash, input, sizeof input);
+    memcpy (secret_, hash, 32);
+    memset (input, 0, sizeof input);
+    memset (hash, 0, sizeof hash);
+}
+
+std::string zmq::curve_mechanism_base_t::supported_ciphers ()
+{
+    std::string ciphers;
+    if (crypto_aead_aes256gcm_is_available ()) {
+        ciphers = aes256gcm_name;
+        ciphers += ' ';
+    }
+    ciphers += chacha20poly1305_name;
+    return ciphers;
+}
 
+zmq::curve_mechanism_base_t::cipher_t
+zmq::curve_mechanism_base_t::select_cipher (const void *list_, size_t length_)
+{
+    const char *ptr = static_cast<const char *> (list_);
+    const char *const end = ptr + length_;
+    while (ptr < end) {
+        const char *name_end =
+          static_cast<const char *> (memchr (ptr, ' ', end - ptr));
+        if (!name_end)
+            name_end = end;
+        const std::string name (ptr, name_end);
+        if (name == aes256gcm_name && crypto_aead_aes256gcm_is_available ())
+            return cipher_aes256gcm;
+        if (name == chacha20poly1305_name)
+            return cipher_chacha20poly1305;
+        ptr = name_end + 1;
+    }
+    return cipher_box;
+}
+
+const char *zmq::curve_mechanism_base_t::cipher_name (cipher_t cipher_)
+{
+    switch (cipher_) {
+        case cipher_aes256gcm:
+            return aes256gcm_name;
+        case cipher_chacha20poly1305:
+            return chacha20poly1305_name;
+        default:
+            return NULL;
+    }
+}
+
+//  The key of each direction is derived from the key of the connection and
+//  the nonce prefix of the direction's messages.
+static void derive_aead_key (uint8_t *key_,
+                             const char *nonce_prefix_,
+                             const uint8_t *precom_)
+{
+    uint8_t input[16 + crypto_box_BEFORENMBYTES];
+    memcpy (input, nonce_prefix_, 16);
+    memcpy (input + 16, precom_, crypto_box_BEFORENMBYTES);
+
+    uint8_t hash[crypto_hash_BYTES];
+    crypto_hash (hash, input, sizeof input);
+    memcpy (key_, hash, crypto_aead_chacha20poly1305_ietf_KEYBYTES);
+    memset (input, 0, sizeof input);
+    memset (hash, 0, sizeof hash);
+}
+
+void zmq::curve_mechanism_base_t::set_cipher (cipher_t cipher_)
+{
+    zmq_assert (cipher == cipher_box);
+    cipher = cipher_;
+    if (cipher == cipher_box)
+        return;
+
+    derive_aead_key (_encode_key, encode_nonce_prefix, cn_precom);
+    derive_aead_key (_decode_key, decode_nonce_prefix, cn_precom);
+
+    if (cipher == cipher_aes256gcm) {
+        _encode_state = new (std::nothrow) crypto_aead_aes256gcm_state;
+        alloc_assert (_encode_state);
+        _decode_state = new (std::nothrow) crypto_aead_aes256gcm_state;
+        alloc_assert (_decode_state);
+        int rc = crypto_aead_aes256gcm_beforenm (_encode_state, _encode_key);
+        zmq_assert (rc == 0);
+        rc = crypto_aead_aes256gcm_beforenm (_decode_state, _decode_key);
+        zmq_assert (rc == 0);
+    }
+}
+
+//  Flags of a message in the plaintext. A batch carries the messages taken
+//  together, each with its flags and size.
+static const uint8_t flag_more = 0x01;
+static const uint8_t flag_command = 0x02;
+static const uint8_t flag_batch = 0x04;
+
+static const size_t batch_entry_header_size = 5;
+
+static uint8_t message_flags (const zmq::msg_t *msg_)
+{
     uint8_t flags = 0;
-    if (msg_->flags () & msg_t::more)
-        flags |= 0x01;
-    if (msg_->flags () & msg_t::command)
-        flags |= 0x02;
+    if (msg_->flags () & zmq::msg_t::more)
+        flags |= flag_more;
+    if (msg_->flags () & zmq::msg_t::command)
+        flags |= flag_command;
+    return flags;
+}
 
-    uint8_t *message_plaintext = static_cast<uint8_t *> (malloc (mlen));
-    alloc_assert (message_plaintext);
+static void set_message_flags (zmq::msg_t *msg_, uint8_t flags_)
+{
+    msg_->reset_flags (zmq::msg_t::more | zmq::msg_t::command);
+    if (flags_ & flag_more)
+        msg_->set_flags (zmq::msg_t::more);
+    if (flags_ & flag_command)
+        msg_->set_flags (zmq::msg_t::command);
+}
 
-    memset (message_plaintext, 0, crypto_box_ZEROBYTES);
-    message_plaintext[crypto_box_ZEROBYTES] = flags;
-    memcpy (message_plaintext + crypto_box_ZEROBYTES + 1, msg_->data (),
-            msg_->size ());
+//  A batch being handed out. Messages too large to be copied around refer
+//  to its data, each through a content of its own, and it is released
+//  when the last of them is closed.
+struct zmq::curve_mechanism_base_t::decoded_batch_t
+{
+    msg_t msg;
+    atomic_counter_t refs;
+    size_t pos;
+    size_t end;
+    size_t next_content;
+    msg_t::content_t contents[1];
+};
+
+void zmq::curve_mechanism_base_t::release_batch (void * /* data_ */,
+                                                 void *hint_)
+{
+    decoded_batch_t *batch = static_cast<decoded_batch_t *> (hint_);
+    if (!batch->refs.sub (1)) {
+        const int rc = batch->msg.close ();
+        errno_assert (rc == 0);
+        batch->refs.~atomic_counter_t ();
+        free (batch);
+    }
+}
 
-    uint8_t *message_box = static_cast<uint8_t *> (malloc (mlen));
-    alloc_assert (message_box);
+bool zmq::curve_mechanism_base_t::batching () const
+{
+    return _batching;
+}
 
-    int rc = crypto_box_afternm (message_box, message_plaintext, mlen,
-                                 message_nonce, cn_precom);
-    zmq_assert (rc == 0);
+void zmq::curve_mechanism_base_t::set_batching ()
+{
+    _batching = true;
+}
 
-    rc = msg_->close ();
-    zmq_assert (rc == 0);
+int zmq::curve_mechanism_base_t::batch (msg_t *msg_)
+{
+    //  Batches are cut at the size of a write to the network.
+    const size_t size = batch_entry_header_size + msg_->size ();
+    const bool full =
+      !_batch.empty () && _batch_size + size > out_batch_size;
+
+    msg_t encoded;
+    int rc = encoded.init ();
+    errno_assert (rc == 0);
+    if (full) {
+        rc = flush_batch (&encoded);
+        zmq_assert (rc == 0);
+    }
+
+    msg_t msg;
+    rc = msg.init ();
+    errno_assert (rc == 0);
+    rc = msg.move (*msg_);
+    errno_assert (rc == 0);
+    _batch.push_back (msg);
+    _batch_size += size;
+
+    rc = msg_->move (encoded);
+    errno_assert (rc == 0);
+    return full ? 1 : 0;
+}
+
+int zmq::curve_mechanism_base_t::flush_batch (msg_t *msg_)
+{
+    if (_batch.empty ()) {
+        errno = EAGAIN;
+        return -1;
+    }
 
-    rc = msg_->init_size (16 + mlen - crypto_box_BOXZEROBYTES);
+    //  A message on its own is encoded as usual.
+    if (_batch.size () == 1) {
+        const int rc = msg_->move (_batch[0]);
+        errno_assert (rc == 0);
+        _batch.clear ();
+        _batch_size = 0;
+        return encode (msg_);
+    }
+
+    return cipher != cipher_box ? encode_aead (msg_, true)
+                                : encode_box (msg_, true);
+}
+
+size_t zmq::curve_mechanism_base_t::plaintext_size (msg_t *msg_,
+                                                    bool batch_) const
+{
+    return 1 + (batch_ ? _batch_size : msg_->size ());
+}
+
+void zmq::curve_mechanism_base_t::write_plaintext (uint8_t *ptr_,
+                                                   msg_t *msg_,
+                                                   bool batch_)
+{
+    if (!batch_) {
+        ptr_[0] = message_flags (msg_);
+        memcpy (ptr_ + 1, msg_->data (), msg_->size ());
+        return;
+    }
+
+    *ptr_++ = flag_batch;
+    for (std::vector<msg_t>::iterator it = _batch.begin ();
+         it != _batch.end (); ++it) {
+        ptr_[0] = message_flags (&*it);
+        put_uint32 (ptr_ + 1, static_cast<uint32_t> (it->size ()));
+        memcpy (ptr_ + batch_entry_header_size, it->data (), it->size ());
+        ptr_ += batch_entry_header_size + it->size ();
+        const int rc = it->close ();
+        errno_assert (rc == 0);
+    }
+    _batch.clear ();
+    _batch_size = 0;
+}
+
+int zmq::curve_mechanism_base_t::encode (msg_t *msg_)
+{
+    return cipher != cipher_box ? encode_aead (msg_, false)
+                                : encode_box (msg_, false);
+}
+
+int zmq::curve_mechanism_base_t::encode_box (msg_t *msg_, bool batch_)
+{
+    const size_t mlen = crypto_box_ZEROBYTES + plaintext_size (msg_, batch_);
+
+    uint8_t message_nonce[crypto_box_NONCEBYTES];
+    memcpy (message_nonce, encode_nonce_prefix, 16);
+    put_uint64 (message_nonce + 16, cn_nonce);
+
+    //  The box is built in place in the MESSAGE command. Its leading
+    //  crypto_box_BOXZEROBYTES zero bytes are then overwritten by the
+    //  command name and the nonce.
+    msg_t msg;
+    int rc = msg.init_size (16 + mlen - crypto_box_BOXZEROBYTES);
     zmq_assert (rc == 0);
 
-    uint8_t *message = static_cast<uint8_t *> (msg_->data ());
+    uint8_t *message = static_cast<uint8_t *> (msg.data ());
+
+    memset (message, 0, crypto_box_ZEROBYTES);
+    write_plaintext (message + crypto_box_ZEROBYTES, msg_, batch_);
+
+    rc = crypto_box_afternm (message, message, mlen, message_nonce, cn_precom);
+    zmq_assert (rc == 0);
 
     memcpy (message, "\x07MESSAGE", 8);
     memcpy (message + 8, message_nonce + 16, 8);
-    memcpy (message + 16, message_box + crypto_box_BOXZEROBYTES,
-            mlen - crypto_box_BOXZEROBYTES);
 
-    free (message_plaintext);
-    free (message_box);
+    rc = msg_->move (msg);
+    zmq_assert (rc == 0);
 
     cn_nonce++;
 
@@ -101,6 +389,9 @@ int zmq::curve_mechanism_base_t::encode (msg_t *msg_)
 
 int zmq::curve_mechanism_base_t::decode (msg_t *msg_)
 {
+    if (cipher != cipher_box)
+        return decode_aead (msg_);
+
     int rc = check_basic_command_structure (msg_);
     if (rc == -1)
         return -1;
@@ -135,45 +426,238 @@ int zmq::curve_mechanism_base_t::decode (msg_t *msg_)
     }
     cn_peer_nonce = nonce;
 
-    const size_t clen = crypto_box_BOXZEROBYTES + msg_->size () - 16;
-
-    uint8_t *message_plaintext = static_cast<uint8_t *> (malloc (clen));
-    alloc_assert (message_plaintext);
-
-    uint8_t *message_box = static_cast<uint8_t *> (malloc (clen));
-    alloc_assert (message_box);
+    //  The box is opened in place, which needs the message data for
+    //  ourselves.
+    if ((msg_->flags () & msg_t::shared) || msg_->is_cmsg ()) {
+        msg_t msg;
+        rc = msg.init_size (size);
+        zmq_assert (rc == 0);
+        memcpy (msg.data (), message, size);
+        rc = msg_->move (msg);
+        zmq_assert (rc == 0);
+    }
+    uint8_t *message_box = static_cast<uint8_t *> (msg_->data ());
 
+    //  The command name and the nonce take the place of the leading zero
+    //  bytes of the box.
+    const size_t clen = size;
     memset (message_box, 0, crypto_box_BOXZEROBYTES);
-    memcpy (message_box + crypto_box_BOXZEROBYTES, message + 16,
-            msg_->size () - 16);
 
-    rc = crypto_box_open_afternm (message_plaintext, message_box, clen,
+    rc = crypto_box_open_afternm (message_box, message_box, clen,
                                   message_nonce, cn_precom);
-    if (rc == 0) {
-        rc = msg_->close ();
-        zmq_assert (rc == 0);
+    if (rc != 0) {
+        // CURVE I : connection key used for MESSAGE is wrong
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+        errno = EPROTO;
+        return -1;
+    }
 
-        rc = msg_->init_size (clen - 1 - crypto_box_ZEROBYTES);
+    return unpack (msg_, crypto_box_ZEROBYTES, clen - crypto_box_ZEROBYTES);
+}
+
+int zmq::curve_mechanism_base_t::unpack (msg_t *msg_,
+                                         size_t offset_,
+                                         size_t size_)
+{
+    uint8_t *plaintext = static_cast<uint8_t *> (msg_->data ()) + offset_;
+    const uint8_t flags = plaintext[0];
+    if (flags & flag_batch)
+        return unpack_batch (msg_, offset_ + 1, size_ - 1);
+
+    const size_t payload_size = size_ - 1;
+
+    //  A message received in place in the decoder's buffer would keep the
+    //  buffer from being reused, copy the payload out of it. Otherwise
+    //  move the payload to the start of the message.
+    if (msg_->is_zcmsg ()) {
+        msg_t msg;
+        int rc = msg.init_size (payload_size);
         zmq_assert (rc == 0);
+        memcpy (msg.data (), plaintext + 1, payload_size);
+        rc = msg_->move (msg);
+        zmq_assert (rc == 0);
+    } else {
+        memmove (msg_->data (), plaintext + 1, payload_size);
+        msg_->shrink (payload_size);
+    }
 
-        const uint8_t flags = message_plaintext[crypto_box_ZEROBYTES];
-        if (flags & 0x01)
-            msg_->set_flags (msg_t::more);
-        if (flags & 0x02)
-            msg_->set_flags (msg_t::command);
+    set_message_flags (msg_, flags);
+    return 0;
+}
 
-        memcpy (msg_->data (), message_plaintext + crypto_box_ZEROBYTES + 1,
-                msg_->size ());
-    } else {
-        // CURVE I : connection key used for MESSAGE is wrong
+int zmq::curve_mechanism_base_t::unpack_batch (msg_t *msg_,
+                                               size_t offset_,
+                                               size_t size_)
+{
+    //  The whole batch is checked before any of its messages is handed
+    //  out.
+    const uint8_t *ptr = static_cast<uint8_t *> (msg_->data ()) + offset_;
+    size_t left = size_;
+    size_t count = 0;
+    size_t large = 0;
+    while (left >= batch_entry_header_size) {
+        const size_t size = get_uint32 (ptr + 1);
+        if (size > left - batch_entry_header_size)
+            break;
+        if (size > msg_t::max_vsm_size)
+            large++;
+        count++;
+        ptr += batch_entry_header_size + size;
+        left -= batch_entry_header_size + size;
+    }
+    if (!_batching || left != 0 || count < 2) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_MESSAGE);
+        errno = EPROTO;
+        return -1;
+    }
+
+    zmq_assert (!_decoded);
+    _decoded = static_cast<decoded_batch_t *> (
+      malloc (sizeof (decoded_batch_t)
+              + (large ? large - 1 : 0) * sizeof (msg_t::content_t)));
+    alloc_assert (_decoded);
+
+    int rc = _decoded->msg.init ();
+    errno_assert (rc == 0);
+    rc = _decoded->msg.move (*msg_);
+    errno_assert (rc == 0);
+
+    //  One reference per large message, and one until all are handed out.
+    new (&_decoded->refs)
+      atomic_counter_t (static_cast<atomic_counter_t::integer_t> (large + 1));
+    _decoded->pos = offset_;
+    _decoded->end = offset_ + size_;
+    _decoded->next_content = 0;
+
+    return next_decoded (msg_);
+}
+
+int zmq::curve_mechanism_base_t::next_decoded (msg_t *msg_)
+{
+    if (!_decoded) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    uint8_t *ptr = static_cast<uint8_t *> (_decoded->msg.data ()) + _decoded->pos;
+    const uint8_t flags = ptr[0];
+    const size_t size = get_uint32 (ptr + 1);
+    ptr += batch_entry_header_size;
+
+    msg_t msg;
+    int rc;
+    if (size > msg_t::max_vsm_size)
+        rc = msg.init_external_storage (
+          &_decoded->contents[_decoded->next_content++], ptr, size,
+          release_batch, _decoded);
+    else {
+        rc = msg.init_size (size);
+        if (rc == 0)
+            memcpy (msg.data (), ptr, size);
+    }
+    errno_assert (rc == 0);
+    rc = msg_->move (msg);
+    errno_assert (rc == 0);
+    set_message_flags (msg_, flags);
+
+    _decoded->pos += batch_entry_header_size + size;
+    if (_decoded->pos == _decoded->end) {
+        release_batch (NULL, _decoded);
+        _decoded = NULL;
+    }
+    return 0;
+}
+
+static void make_aead_nonce (uint8_t *nonce_, uint64_t counter_)
+{
+    memset (nonce_, 0, 4);
+    zmq::put_uint64 (nonce_ + 4, counter_);
+}
+
+int zmq::curve_mechanism_base_t::encode_aead (msg_t *msg_, bool batch_)
+{
+    const size_t size = plaintext_size (msg_, batch_);
+
+    //  The flags and the payload are encrypted in place, followed by the
+    //  tag. There is neither a command name nor a nonce.
+    msg_t msg;
+    int rc = msg.init_size (size + crypto_aead_chacha20poly1305_ietf_ABYTES);
+    zmq_assert (rc == 0);
+
+    uint8_t *message = static_cast<uint8_t *> (msg.data ());
+    write_plaintext (message, msg_, batch_);
+
+    uint8_t nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    make_aead_nonce (nonce, _encode_counter);
+
+    if (cipher == cipher_aes256gcm)
+        rc = crypto_aead_aes256gcm_encrypt_detached_afternm (
+          message, message + size, NULL, message, size, NULL, 0, NULL, nonce,
+          _encode_state);
+    else
+        rc = crypto_aead_chacha20poly1305_ietf_encrypt_detached (
+          message, message + size, NULL, message, size, NULL, 0, NULL, nonce,
+          _encode_key);
+    zmq_assert (rc == 0);
+
+    rc = msg_->move (msg);
+    zmq_assert (rc == 0);
+
+    _encode_counter++;
+
+    return 0;
+}
+
+int zmq::curve_mechanism_base_t::decode_aead (msg_t *msg_)
+{
+    const size_t size = msg_->size ();
+    if (size < 1 + crypto_aead_chacha20poly1305_ietf_ABYTES) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_MESSAGE);
+        errno = EPROTO;
+        return -1;
+    }
+
+    //  The message is decrypted in place, which needs the message data for
+    //  ourselves.
+    int rc;
+    if ((msg_->flags () & msg_t::shared) || msg_->is_cmsg ()) {
+        msg_t msg;
+        rc = msg.init_size (size);
+        zmq_assert (rc == 0);
+        memcpy (msg.data (), msg_->data (), size);
+        rc = msg_->move (msg);
+        zmq_assert (rc == 0);
+    }
+    uint8_t *message = static_cast<uint8_t *> (msg_->data ());
+    const size_t clen = size - crypto_aead_chacha20poly1305_ietf_ABYTES;
+
+    //  A message that was dropped, replayed or reordered gets the wrong
+    //  nonce and fails to decrypt.
+    uint8_t nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    make_aead_nonce (nonce, _decode_counter);
+
+    if (cipher == cipher_aes256gcm)
+        rc = crypto_aead_aes256gcm_decrypt_detached_afternm (
+          message, NULL, message, clen, message + clen, NULL, 0, nonce,
+          _decode_state);
+    else
+        rc = crypto_aead_chacha20poly1305_ietf_decrypt_detached (
+          message, NULL, message, clen, message + clen, NULL, 0, nonce,
+          _decode_key);
+    if (rc != 0) {
         session->get_socket ()->event_handshake_failed_protocol (
           session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
         errno = EPROTO;
+        return -1;
     }
-    free (message_plaintext);
-    free (message_box);
+    _decode_counter++;
 
-    return rc;
+    return unpack (msg_, 0, clen);
 }
 
 #endif
@@ -45,7 +45,10 @@
 #error "CURVE library not built properly"
 #endif
 
+#include <vector>
+
 #include "mechanism_base.hpp"
+#include "msg.hpp"
 #include "options.hpp"
 
 namespace zmq
@@ -57,12 +60,65 @@ class curve_mechanism_base_t : public virtual mechanism_base_t
                             const options_t &options_,
                             const char *encode_nonce_prefix_,
                             const char *decode_nonce_prefix_);
+    virtual ~curve_mechanism_base_t ();
 
     // mechanism implementation
     virtual int encode (msg_t *msg_);
     virtual int decode (msg_t *msg_);
+    virtual bool batching () const;
+    virtual int batch (msg_t *msg_);
+    virtual int flush_batch (msg_t *msg_);
+    virtual int next_decoded (msg_t *msg_);
 
   protected:
+    //  Session resumption: a client sets the resume property in INITIATE
+    //  to ask for a ticket, which the server hands out in the ticket
+    //  property of READY, or of RESUMED once the session was resumed.
+    static const char resume_property[];
+    static const char ticket_property[];
+
+    //  Derives the key of a session resumed with the secret of a ticket,
+    //  from the nonces of RESUME and RESUMED. Without the server nonce it
+    //  derives the key of the box in RESUME.
+    static void derive_resumption_key (uint8_t *key_,
+                                       const uint8_t *secret_,
+                                       const uint8_t *client_nonce_,
+                                       const uint8_t *server_nonce_);
+
+    //  Derives the secret of the ticket issued for this session.
+    void derive_ticket_secret (uint8_t *secret_) const;
+
+    //  Ciphers of messages. A client that sets ZMQ_CURVE_AEAD lists the
+    //  ciphers it supports in the cipher property of INITIATE or RESUME,
+    //  the server names the one it picked in READY or RESUMED. Otherwise
+    //  each message is a box.
+    enum cipher_t
+    {
+        cipher_box,
+        cipher_aes256gcm,
+        cipher_chacha20poly1305
+    };
+    static const char cipher_property[];
+
+    //  Space separated names of the ciphers supported on this CPU, most
+    //  preferred first.
+    static std::string supported_ciphers ();
+
+    //  Returns the first cipher of a list that is supported, or cipher_box.
+    static cipher_t select_cipher (const void *list_, size_t length_);
+
+    static const char *cipher_name (cipher_t cipher_);
+
+    //  Switches messages to an AEAD cipher, with keys derived from
+    //  cn_precom.
+    void set_cipher (cipher_t cipher_);
+
+    //  A client that sets ZMQ_CURVE_BATCH sets the batch property in
+    //  INITIATE or RESUME, the server sets it in READY or RESUMED if it
+    //  agrees. Then the messages sent at once may be encoded as one.
+    static const char batch_property[];
+    void set_batching ();
+
     const char *encode_nonce_prefix;
     const char *decode_nonce_prefix;
 
@@ -71,6 +127,48 @@ class curve_mechanism_base_t : public virtual mechanism_base_t
 
     //  Intermediary buffer used to speed up boxing and unboxing.
     uint8_t cn_precom[crypto_box_BEFORENMBYTES];
+
+    cipher_t cipher;
+
+  private:
+    struct decoded_batch_t;
+
+    int encode_box (msg_t *msg_, bool batch_);
+    int encode_aead (msg_t *msg_, bool batch_);
+    int decode_aead (msg_t *msg_);
+
+    //  The plaintext of a message is its flags, then its payload or the
+    //  messages of the batch, each with its flags and size.
+    size_t plaintext_size (msg_t *msg_, bool batch_) const;
+    void write_plaintext (uint8_t *ptr_, msg_t *msg_, bool batch_);
+
+    //  Turns a decoded plaintext at offset_ in msg_ into the message, or
+    //  the first message of a batch.
+    int unpack (msg_t *msg_, size_t offset_, size_t size_);
+    int unpack_batch (msg_t *msg_, size_t offset_, size_t size_);
+
+    static void release_batch (void *data_, void *hint_);
+
+    //  Keys of each direction under an AEAD cipher. Nonces are not sent,
+    //  they count the messages sent and received.
+    uint8_t _encode_key[crypto_aead_chacha20poly1305_ietf_KEYBYTES];
+    uint8_t _decode_key[crypto_aead_chacha20poly1305_ietf_KEYBYTES];
+    crypto_aead_aes256gcm_state *_encode_state;
+    crypto_aead_aes256gcm_state *_decode_state;
+    uint64_t _encode_counter;
+    uint64_t _decode_counter;
+
+    bool _batching;
+
+    //  Messages taken to be encoded together, and their encoded size.
+    std::vector<msg_t> _batch;
+    size_t _batch_size;
+
+    //  Batch whose messages are being handed out.
+    decoded_batch_t *_decoded;
+
+    curve_mechanism_base_t (const curve_mechanism_base_t &);
+    const curve_mechanism_base_t &operator= (const curve_mechanism_base_t &);
 };
 }
 
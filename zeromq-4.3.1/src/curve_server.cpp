@@ -37,6 +37,7 @@
 #include "err.hpp"
 #include "curve_server.hpp"
 #include "wire.hpp"
+#include "ctx.hpp"
 
 zmq::curve_server_t::curve_server_t (session_base_t *session_,
                                      const std::string &peer_address_,
@@ -45,19 +46,24 @@ zmq::curve_server_t::curve_server_t (session_base_t *session_,
     zap_client_common_handshake_t (
       session_, peer_address_, options_, sending_ready),
     curve_mechanism_base_t (
-      session_, options_, "CurveZMQMESSAGES", "CurveZMQMESSAGEC")
+      session_, options_, "CurveZMQMESSAGES", "CurveZMQMESSAGEC"),
+    _ticket_requested (false),
+    _resumed (false),
+    _job (NULL)
 {
-    int rc;
     //  Fetch our secret key from socket options
-    memcpy (_secret_key, options_.curve_secret_key, crypto_box_SECRETKEYBYTES);
-
-    //  Generate short-term key pair
-    rc = crypto_box_keypair (_cn_public, _cn_secret);
-    zmq_assert (rc == 0);
+    memcpy (_keys.secret_key, options_.curve_secret_key,
+            crypto_box_SECRETKEYBYTES);
 }
 
 zmq::curve_server_t::~curve_server_t ()
 {
+    if (_job) {
+        if (_job->done) {
+            LIBZMQ_DELETE (_job);
+        } else
+            _job->abandon ();
+    }
 }
 
 int zmq::curve_server_t::next_handshake_command (msg_t *msg_)
@@ -71,7 +77,7 @@ int zmq::curve_server_t::next_handshake_command (msg_t *msg_)
                 state = waiting_for_initiate;
             break;
         case sending_ready:
-            rc = produce_ready (msg_);
+            rc = _resumed ? produce_resumed (msg_) : produce_ready (msg_);
             if (rc == 0)
                 state = ready;
             break;
@@ -94,7 +100,10 @@ int zmq::curve_server_t::process_handshake_command (msg_t *msg_)
 
     switch (state) {
         case waiting_for_hello:
-            rc = process_hello (msg_);
+            if (msg_->size () >= 7 && !memcmp (msg_->data (), "\x06RESUME", 7))
+                rc = process_resume (msg_);
+            else
+                rc = process_hello (msg_);
             break;
         case waiting_for_initiate:
             rc = process_initiate (msg_);
@@ -134,6 +143,28 @@ int zmq::curve_server_t::decode (msg_t *msg_)
     return curve_mechanism_base_t::decode (msg_);
 }
 
+zmq::curve_server_t::key_exchange_t *
+zmq::curve_server_t::exchange_keys (const msg_t *msg_)
+{
+    if (!_job) {
+        _job = new (std::nothrow) key_exchange_t (this, msg_);
+        alloc_assert (_job);
+        if (!session->submit_crypto_job (_job)) {
+            _job->execute ();
+            _job->done = true;
+        }
+    }
+
+    if (!_job->done) {
+        errno = EAGAIN;
+        return NULL;
+    }
+
+    key_exchange_t *job = _job;
+    _job = NULL;
+    return job;
+}
+
 int zmq::curve_server_t::process_hello (msg_t *msg_)
 {
     int rc = check_basic_command_structure (msg_);
@@ -170,98 +201,32 @@ int zmq::curve_server_t::process_hello (msg_t *msg_)
         return -1;
     }
 
-    //  Save client's short-term public key (C')
-    memcpy (_cn_client, hello + 80, 32);
-
-    uint8_t hello_nonce[crypto_box_NONCEBYTES];
-    uint8_t hello_plaintext[crypto_box_ZEROBYTES + 64];
-    uint8_t hello_box[crypto_box_BOXZEROBYTES + 80];
-
-    memcpy (hello_nonce, "CurveZMQHELLO---", 16);
-    memcpy (hello_nonce + 16, hello + 112, 8);
-    cn_peer_nonce = get_uint64 (hello + 112);
-
-    memset (hello_box, 0, crypto_box_BOXZEROBYTES);
-    memcpy (hello_box + crypto_box_BOXZEROBYTES, hello + 120, 80);
+    key_exchange_t *job = exchange_keys (msg_);
+    if (!job)
+        return -1;
 
-    //  Open Box [64 * %x0](C'->S)
-    rc = crypto_box_open (hello_plaintext, hello_box, sizeof hello_box,
-                          hello_nonce, _cn_client, _secret_key);
-    if (rc != 0) {
-        // CURVE I: cannot open client HELLO -- wrong server key?
+    if (job->error) {
         session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+          session->get_endpoint (), job->error);
+        LIBZMQ_DELETE (job);
         errno = EPROTO;
         return -1;
     }
 
+    _keys = job->keys;
+    memcpy (_welcome, job->welcome, sizeof _welcome);
+    cn_peer_nonce = get_uint64 (hello + 112);
+    LIBZMQ_DELETE (job);
+
     state = sending_welcome;
-    return rc;
+    return 0;
 }
 
 int zmq::curve_server_t::produce_welcome (msg_t *msg_)
 {
-    uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
-    uint8_t cookie_plaintext[crypto_secretbox_ZEROBYTES + 64];
-    uint8_t cookie_ciphertext[crypto_secretbox_BOXZEROBYTES + 80];
-
-    //  Create full nonce for encryption
-    //  8-byte prefix plus 16-byte random nonce
-    memcpy (cookie_nonce, "COOKIE--", 8);
-    randombytes (cookie_nonce + 8, 16);
-
-    //  Generate cookie = Box [C' + s'](t)
-    memset (cookie_plaintext, 0, crypto_secretbox_ZEROBYTES);
-    memcpy (cookie_plaintext + crypto_secretbox_ZEROBYTES, _cn_client, 32);
-    memcpy (cookie_plaintext + crypto_secretbox_ZEROBYTES + 32, _cn_secret, 32);
-
-    //  Generate fresh cookie key
-    randombytes (_cookie_key, crypto_secretbox_KEYBYTES);
-
-    //  Encrypt using symmetric cookie key
-    int rc =
-      crypto_secretbox (cookie_ciphertext, cookie_plaintext,
-                        sizeof cookie_plaintext, cookie_nonce, _cookie_key);
-    zmq_assert (rc == 0);
-
-    uint8_t welcome_nonce[crypto_box_NONCEBYTES];
-    uint8_t welcome_plaintext[crypto_box_ZEROBYTES + 128];
-    uint8_t welcome_ciphertext[crypto_box_BOXZEROBYTES + 144];
-
-    //  Create full nonce for encryption
-    //  8-byte prefix plus 16-byte random nonce
-    memcpy (welcome_nonce, "WELCOME-", 8);
-    randombytes (welcome_nonce + 8, crypto_box_NONCEBYTES - 8);
-
-    //  Create 144-byte Box [S' + cookie](S->C')
-    memset (welcome_plaintext, 0, crypto_box_ZEROBYTES);
-    memcpy (welcome_plaintext + crypto_box_ZEROBYTES, _cn_public, 32);
-    memcpy (welcome_plaintext + crypto_box_ZEROBYTES + 32, cookie_nonce + 8,
-            16);
-    memcpy (welcome_plaintext + crypto_box_ZEROBYTES + 48,
-            cookie_ciphertext + crypto_secretbox_BOXZEROBYTES, 80);
-
-    rc = crypto_box (welcome_ciphertext, welcome_plaintext,
-                     sizeof welcome_plaintext, welcome_nonce, _cn_client,
-                     _secret_key);
-
-    //  TODO I think we should change this back to zmq_assert (rc == 0);
-    //  as it was before https://github.com/zeromq/libzmq/pull/1832
-    //  The reason given there was that secret_key might be 0ed.
-    //  But if it were, we would never get this far, since we could
-    //  not have opened the client's hello box with a 0ed key.
-
-    if (rc == -1)
-        return -1;
-
-    rc = msg_->init_size (168);
+    const int rc = msg_->init_size (sizeof _welcome);
     errno_assert (rc == 0);
-
-    uint8_t *const welcome = static_cast<uint8_t *> (msg_->data ());
-    memcpy (welcome, "\x07WELCOME", 8);
-    memcpy (welcome + 8, welcome_nonce + 8, 16);
-    memcpy (welcome + 24, welcome_ciphertext + crypto_box_BOXZEROBYTES, 144);
-
+    memcpy (msg_->data (), _welcome, sizeof _welcome);
     return 0;
 }
 
@@ -289,114 +254,43 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         return -1;
     }
 
-    uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
-    uint8_t cookie_plaintext[crypto_secretbox_ZEROBYTES + 64];
-    uint8_t cookie_box[crypto_secretbox_BOXZEROBYTES + 80];
-
-    //  Open Box [C' + s'](t)
-    memset (cookie_box, 0, crypto_secretbox_BOXZEROBYTES);
-    memcpy (cookie_box + crypto_secretbox_BOXZEROBYTES, initiate + 25, 80);
-
-    memcpy (cookie_nonce, "COOKIE--", 8);
-    memcpy (cookie_nonce + 8, initiate + 9, 16);
-
-    rc = crypto_secretbox_open (cookie_plaintext, cookie_box, sizeof cookie_box,
-                                cookie_nonce, _cookie_key);
-    if (rc != 0) {
-        // CURVE I: cannot open client INITIATE cookie
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
+    key_exchange_t *job = exchange_keys (msg_);
+    if (!job)
         return -1;
-    }
-
-    //  Check cookie plain text is as expected [C' + s']
-    if (memcmp (cookie_plaintext + crypto_secretbox_ZEROBYTES, _cn_client, 32)
-        || memcmp (cookie_plaintext + crypto_secretbox_ZEROBYTES + 32,
-                   _cn_secret, 32)) {
-        // TODO this case is very hard to test, as it would require a modified
-        //  client that knows the server's secret temporary cookie key
 
-        // CURVE I: client INITIATE cookie is not valid
+    if (job->error) {
         session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+          session->get_endpoint (), job->error);
+        LIBZMQ_DELETE (job);
         errno = EPROTO;
         return -1;
     }
 
-    const size_t clen = (size - 113) + crypto_box_BOXZEROBYTES;
-
-    uint8_t initiate_nonce[crypto_box_NONCEBYTES];
-    uint8_t initiate_plaintext[crypto_box_ZEROBYTES + 128 + 256];
-    uint8_t initiate_box[crypto_box_BOXZEROBYTES + 144 + 256];
-
-    //  Open Box [C + vouch + metadata](C'->S')
-    memset (initiate_box, 0, crypto_box_BOXZEROBYTES);
-    memcpy (initiate_box + crypto_box_BOXZEROBYTES, initiate + 113,
-            clen - crypto_box_BOXZEROBYTES);
-
-    memcpy (initiate_nonce, "CurveZMQINITIATE", 16);
-    memcpy (initiate_nonce + 16, initiate + 105, 8);
     cn_peer_nonce = get_uint64 (initiate + 105);
+    memcpy (cn_precom, job->keys.cn_precom, crypto_box_BEFORENMBYTES);
+
+    const uint8_t *initiate_plaintext = &job->initiate_plaintext[0];
+    const size_t plaintext_size = job->initiate_plaintext.size ();
+    memcpy (_client_key, initiate_plaintext + crypto_box_ZEROBYTES,
+            crypto_box_PUBLICKEYBYTES);
+
+    rc = authenticate ();
+    if (rc == 0)
+        rc = parse_metadata (initiate_plaintext + crypto_box_ZEROBYTES + 128,
+                             plaintext_size - crypto_box_ZEROBYTES - 128);
+    LIBZMQ_DELETE (job);
+    return rc;
+}
 
-    rc = crypto_box_open (initiate_plaintext, initiate_box, clen,
-                          initiate_nonce, _cn_client, _cn_secret);
-    if (rc != 0) {
-        // CURVE I: cannot open client INITIATE
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
-    }
-
-    const uint8_t *client_key = initiate_plaintext + crypto_box_ZEROBYTES;
-
-    uint8_t vouch_nonce[crypto_box_NONCEBYTES];
-    uint8_t vouch_plaintext[crypto_box_ZEROBYTES + 64];
-    uint8_t vouch_box[crypto_box_BOXZEROBYTES + 80];
-
-    //  Open Box Box [C',S](C->S') and check contents
-    memset (vouch_box, 0, crypto_box_BOXZEROBYTES);
-    memcpy (vouch_box + crypto_box_BOXZEROBYTES,
-            initiate_plaintext + crypto_box_ZEROBYTES + 48, 80);
-
-    memcpy (vouch_nonce, "VOUCH---", 8);
-    memcpy (vouch_nonce + 8, initiate_plaintext + crypto_box_ZEROBYTES + 32,
-            16);
-
-    rc = crypto_box_open (vouch_plaintext, vouch_box, sizeof vouch_box,
-                          vouch_nonce, client_key, _cn_secret);
-    if (rc != 0) {
-        // CURVE I: cannot open client INITIATE vouch
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
-        errno = EPROTO;
-        return -1;
-    }
-
-    //  What we decrypted must be the client's short-term public key
-    if (memcmp (vouch_plaintext + crypto_box_ZEROBYTES, _cn_client, 32)) {
-        // TODO this case is very hard to test, as it would require a modified
-        //  client that knows the server's secret short-term key
-
-        // CURVE I: invalid handshake from client (public key)
-        session->get_socket ()->event_handshake_failed_protocol (
-          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_KEY_EXCHANGE);
-        errno = EPROTO;
-        return -1;
-    }
-
-    //  Precompute connection secret from client key
-    rc = crypto_box_beforenm (cn_precom, _cn_client, _cn_secret);
-    zmq_assert (rc == 0);
-
+int zmq::curve_server_t::authenticate ()
+{
     //  Given this is a backward-incompatible change, it's behind a socket
     //  option disabled by default.
     if (zap_required () || !options.zap_enforce_domain) {
         //  Use ZAP protocol (RFC 27) to authenticate the user.
-        rc = session->zap_connect ();
+        int rc = session->zap_connect ();
         if (rc == 0) {
-            send_zap_request (client_key);
+            send_zap_request (_client_key);
             state = waiting_for_zap_reply;
 
             //  TODO actually, it is quite unlikely that we can read the ZAP
@@ -419,14 +313,19 @@ int zmq::curve_server_t::process_initiate (msg_t *msg_)
         //  This supports the Stonehouse pattern (encryption without authentication).
         state = sending_ready;
     }
-
-    return parse_metadata (initiate_plaintext + crypto_box_ZEROBYTES + 128,
-                           clen - crypto_box_ZEROBYTES - 128);
+    return 0;
 }
 
 int zmq::curve_server_t::produce_ready (msg_t *msg_)
 {
-    const size_t metadata_length = basic_properties_len ();
+    const bool issue_ticket =
+      _ticket_requested && options.curve_ticket_lifetime > 0;
+    const size_t metadata_length =
+      basic_properties_len ()
+      + (issue_ticket
+           ? property_len (ticket_property, curve_tickets_t::ticket_size)
+           : 0)
+      + extension_properties_len ();
     uint8_t ready_nonce[crypto_box_NONCEBYTES];
 
     uint8_t *ready_plaintext =
@@ -438,6 +337,11 @@ int zmq::curve_server_t::produce_ready (msg_t *msg_)
     uint8_t *ptr = ready_plaintext + crypto_box_ZEROBYTES;
 
     ptr += add_basic_properties (ptr, metadata_length);
+    if (issue_ticket)
+        ptr += add_ticket (ptr, crypto_box_ZEROBYTES + metadata_length
+                                  - (ptr - ready_plaintext));
+    ptr += add_extension_properties (
+      ptr, crypto_box_ZEROBYTES + metadata_length - (ptr - ready_plaintext));
     const size_t mlen = ptr - ready_plaintext;
 
     memcpy (ready_nonce, "CurveZMQREADY---", 16);
@@ -471,6 +375,194 @@ int zmq::curve_server_t::produce_ready (msg_t *msg_)
     return 0;
 }
 
+int zmq::curve_server_t::process_resume (msg_t *msg_)
+{
+    int rc = check_basic_command_structure (msg_);
+    if (rc == -1)
+        return -1;
+
+    const size_t size = msg_->size ();
+    const uint8_t *resume = static_cast<uint8_t *> (msg_->data ());
+
+    if (options.curve_ticket_lifetime == 0) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_UNEXPECTED_COMMAND);
+        errno = EPROTO;
+        return -1;
+    }
+
+    const size_t header_size =
+      7 + crypto_box_NONCEBYTES + curve_tickets_t::ticket_size;
+    if (size < header_size + crypto_box_BOXZEROBYTES) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (),
+          ZMQ_PROTOCOL_ERROR_ZMTP_MALFORMED_COMMAND_UNSPECIFIED);
+        errno = EPROTO;
+        return -1;
+    }
+
+    const uint8_t *client_nonce = resume + 7;
+    const uint8_t *ticket = client_nonce + crypto_box_NONCEBYTES;
+
+    //  A ticket that cannot be used fails the handshake. The client does a
+    //  full handshake when it reconnects.
+    curve_tickets_t *tickets = session->get_ctx ()->get_curve_tickets ();
+    uint8_t tag[curve_tickets_t::tag_size];
+    server_tag (tag);
+    uint64_t expiry;
+    uint8_t secret[curve_tickets_t::secret_size];
+    rc = tickets->open (ticket, tag, &expiry, _client_key, secret);
+    if (rc == -1) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+        errno = EPROTO;
+        return -1;
+    }
+
+    //  Open Box [metadata](secret), which proves that the client holds
+    //  the secret of the ticket
+    uint8_t resume_key[crypto_box_BEFORENMBYTES];
+    derive_resumption_key (resume_key, secret, client_nonce, NULL);
+
+    const size_t clen = size - header_size + crypto_box_BOXZEROBYTES;
+    std::vector<uint8_t> resume_box (clen);
+    std::vector<uint8_t> resume_plaintext (clen);
+
+    memcpy (&resume_box[crypto_box_BOXZEROBYTES], resume + header_size,
+            clen - crypto_box_BOXZEROBYTES);
+
+    rc = crypto_box_open_afternm (&resume_plaintext[0], &resume_box[0], clen,
+                                  client_nonce, resume_key);
+    if (rc != 0 || tickets->redeem (ticket, expiry) == -1) {
+        session->get_socket ()->event_handshake_failed_protocol (
+          session->get_endpoint (), ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC);
+        errno = EPROTO;
+        return -1;
+    }
+
+    //  The resumed session gets keys of its own
+    randombytes (_resumed_nonce, crypto_box_NONCEBYTES);
+    derive_resumption_key (cn_precom, secret, client_nonce, _resumed_nonce);
+    memset (secret, 0, sizeof secret);
+    _resumed = true;
+
+    rc = authenticate ();
+    if (rc == 0)
+        rc = parse_metadata (&resume_plaintext[crypto_box_ZEROBYTES],
+                             clen - crypto_box_ZEROBYTES);
+    return rc;
+}
+
+int zmq::curve_server_t::produce_resumed (msg_t *msg_)
+{
+    const size_t metadata_length =
+      basic_properties_len ()
+      + property_len (ticket_property, curve_tickets_t::ticket_size)
+      + extension_properties_len ();
+
+    std::vector<uint8_t> resumed_plaintext (crypto_box_ZEROBYTES
+                                            + metadata_length);
+    std::vector<uint8_t> resumed_box (crypto_box_ZEROBYTES + metadata_length);
+
+    //  Create Box [metadata + ticket](secret)
+    uint8_t *ptr = &resumed_plaintext[crypto_box_ZEROBYTES];
+    ptr += add_basic_properties (ptr, metadata_length);
+    ptr +=
+      add_ticket (ptr, &resumed_plaintext[0] + resumed_plaintext.size () - ptr);
+    add_extension_properties (
+      ptr, &resumed_plaintext[0] + resumed_plaintext.size () - ptr);
+
+    int rc = crypto_box_afternm (&resumed_box[0], &resumed_plaintext[0],
+                                 resumed_plaintext.size (), _resumed_nonce,
+                                 cn_precom);
+    zmq_assert (rc == 0);
+
+    rc = msg_->init_size (8 + crypto_box_NONCEBYTES + resumed_box.size ()
+                          - crypto_box_BOXZEROBYTES);
+    errno_assert (rc == 0);
+
+    uint8_t *resumed = static_cast<uint8_t *> (msg_->data ());
+
+    memcpy (resumed, "\x07RESUMED", 8);
+    memcpy (resumed + 8, _resumed_nonce, crypto_box_NONCEBYTES);
+    memcpy (resumed + 8 + crypto_box_NONCEBYTES,
+            &resumed_box[crypto_box_BOXZEROBYTES],
+            resumed_box.size () - crypto_box_BOXZEROBYTES);
+
+    cn_nonce++;
+
+    return 0;
+}
+
+void zmq::curve_server_t::server_tag (uint8_t *tag_) const
+{
+    uint8_t hash[crypto_hash_BYTES];
+    crypto_hash (hash, _keys.secret_key, crypto_box_SECRETKEYBYTES);
+    memcpy (tag_, hash, curve_tickets_t::tag_size);
+}
+
+size_t zmq::curve_server_t::add_ticket (uint8_t *ptr_, size_t ptr_capacity_)
+{
+    uint8_t tag[curve_tickets_t::tag_size];
+    server_tag (tag);
+    uint8_t secret[curve_tickets_t::secret_size];
+    derive_ticket_secret (secret);
+
+    uint8_t ticket[curve_tickets_t::ticket_size];
+    session->get_ctx ()->get_curve_tickets ()->issue (
+      tag, _client_key, secret, options.curve_ticket_lifetime, ticket);
+    memset (secret, 0, sizeof secret);
+
+    return add_property (ptr_, ptr_capacity_, ticket_property, ticket,
+                         sizeof ticket);
+}
+
+size_t zmq::curve_server_t::extension_properties_len () const
+{
+    return (cipher == cipher_box ? 0 : property_len (
+                                         cipher_property,
+                                         strlen (cipher_name (cipher))))
+           + (batching () ? property_len (batch_property, 0) : 0);
+}
+
+size_t zmq::curve_server_t::add_extension_properties (uint8_t *ptr_,
+                                                      size_t ptr_capacity_)
+{
+    size_t size = 0;
+    if (cipher != cipher_box) {
+        const char *name = cipher_name (cipher);
+        size += add_property (ptr_, ptr_capacity_, cipher_property, name,
+                              strlen (name));
+    }
+    if (batching ())
+        size += add_property (ptr_ + size, ptr_capacity_ - size,
+                              batch_property, "", 0);
+    return size;
+}
+
+int zmq::curve_server_t::property (const std::string &name_,
+                                   const void *value_,
+                                   size_t length_)
+{
+    if (name_ == resume_property) {
+        _ticket_requested = true;
+        return 1;
+    }
+    if (name_ == cipher_property) {
+        //  Without ZMQ_CURVE_AEAD the offer is ignored, and the client
+        //  keeps boxing messages since READY names no cipher.
+        if (options.curve_aead && cipher == cipher_box)
+            set_cipher (select_cipher (value_, length_));
+        return 1;
+    }
+    if (name_ == batch_property) {
+        if (options.curve_batch)
+            set_batching ();
+        return 1;
+    }
+    return 0;
+}
+
 int zmq::curve_server_t::produce_error (msg_t *msg_) const
 {
     const size_t expected_status_code_length = 3;
@@ -490,4 +582,221 @@ void zmq::curve_server_t::send_zap_request (const uint8_t *key_)
                                     crypto_box_PUBLICKEYBYTES);
 }
 
+zmq::curve_server_t::key_exchange_t::key_exchange_t (curve_server_t *server_,
+                                                     const msg_t *command_) :
+    server (server_),
+    hello (server_->state == waiting_for_hello),
+    command (static_cast<const uint8_t *> (
+               const_cast<msg_t *> (command_)->data ()),
+             static_cast<const uint8_t *> (
+               const_cast<msg_t *> (command_)->data ())
+               + const_cast<msg_t *> (command_)->size ()),
+    keys (server_->_keys),
+    done (false),
+    error (0)
+{
+}
+
+void zmq::curve_server_t::key_exchange_t::execute ()
+{
+    if (hello)
+        exchange_hello ();
+    else
+        exchange_initiate ();
+}
+
+void zmq::curve_server_t::key_exchange_t::completed ()
+{
+    done = true;
+
+    //  Last thing, the server may take the results and delete the job.
+    server->session->crypto_job_done ();
+}
+
+void zmq::curve_server_t::key_exchange_t::exchange_hello ()
+{
+    const uint8_t *const hello_command = &command[0];
+
+    //  Generate short-term key pair
+    int rc = crypto_box_keypair (keys.cn_public, keys.cn_secret);
+    zmq_assert (rc == 0);
+
+    //  Save client's short-term public key (C')
+    memcpy (keys.cn_client, hello_command + 80, 32);
+
+    //  HELLO and WELCOME are both boxed between C' and S, the secret they
+    //  share is computed once.
+    uint8_t hello_precom[crypto_box_BEFORENMBYTES];
+    rc = crypto_box_beforenm (hello_precom, keys.cn_client, keys.secret_key);
+    zmq_assert (rc == 0);
+
+    uint8_t hello_nonce[crypto_box_NONCEBYTES];
+    uint8_t hello_plaintext[crypto_box_ZEROBYTES + 64];
+    uint8_t hello_box[crypto_box_BOXZEROBYTES + 80];
+
+    memcpy (hello_nonce, "CurveZMQHELLO---", 16);
+    memcpy (hello_nonce + 16, hello_command + 112, 8);
+
+    memset (hello_box, 0, crypto_box_BOXZEROBYTES);
+    memcpy (hello_box + crypto_box_BOXZEROBYTES, hello_command + 120, 80);
+
+    //  Open Box [64 * %x0](C'->S)
+    rc = crypto_box_open_afternm (hello_plaintext, hello_box,
+                                  sizeof hello_box, hello_nonce, hello_precom);
+    if (rc != 0) {
+        // CURVE I: cannot open client HELLO -- wrong server key?
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        return;
+    }
+
+    uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
+    uint8_t cookie_plaintext[crypto_secretbox_ZEROBYTES + 64];
+    uint8_t cookie_ciphertext[crypto_secretbox_BOXZEROBYTES + 80];
+
+    //  Create full nonce for encryption
+    //  8-byte prefix plus 16-byte random nonce
+    memcpy (cookie_nonce, "COOKIE--", 8);
+    randombytes (cookie_nonce + 8, 16);
+
+    //  Generate cookie = Box [C' + s'](t)
+    memset (cookie_plaintext, 0, crypto_secretbox_ZEROBYTES);
+    memcpy (cookie_plaintext + crypto_secretbox_ZEROBYTES, keys.cn_client,
+            32);
+    memcpy (cookie_plaintext + crypto_secretbox_ZEROBYTES + 32,
+            keys.cn_secret, 32);
+
+    //  Generate fresh cookie key
+    randombytes (keys.cookie_key, crypto_secretbox_KEYBYTES);
+
+    //  Encrypt using symmetric cookie key
+    rc = crypto_secretbox (cookie_ciphertext, cookie_plaintext,
+                           sizeof cookie_plaintext, cookie_nonce,
+                           keys.cookie_key);
+    zmq_assert (rc == 0);
+
+    uint8_t welcome_nonce[crypto_box_NONCEBYTES];
+    uint8_t welcome_plaintext[crypto_box_ZEROBYTES + 128];
+    uint8_t welcome_ciphertext[crypto_box_BOXZEROBYTES + 144];
+
+    //  Create full nonce for encryption
+    //  8-byte prefix plus 16-byte random nonce
+    memcpy (welcome_nonce, "WELCOME-", 8);
+    randombytes (welcome_nonce + 8, crypto_box_NONCEBYTES - 8);
+
+    //  Create 144-byte Box [S' + cookie](S->C')
+    memset (welcome_plaintext, 0, crypto_box_ZEROBYTES);
+    memcpy (welcome_plaintext + crypto_box_ZEROBYTES, keys.cn_public, 32);
+    memcpy (welcome_plaintext + crypto_box_ZEROBYTES + 32, cookie_nonce + 8,
+            16);
+    memcpy (welcome_plaintext + crypto_box_ZEROBYTES + 48,
+            cookie_ciphertext + crypto_secretbox_BOXZEROBYTES, 80);
+
+    rc = crypto_box_afternm (welcome_ciphertext, welcome_plaintext,
+                             sizeof welcome_plaintext, welcome_nonce,
+                             hello_precom);
+    zmq_assert (rc == 0);
+
+    memcpy (welcome, "\x07WELCOME", 8);
+    memcpy (welcome + 8, welcome_nonce + 8, 16);
+    memcpy (welcome + 24, welcome_ciphertext + crypto_box_BOXZEROBYTES, 144);
+}
+
+void zmq::curve_server_t::key_exchange_t::exchange_initiate ()
+{
+    const size_t size = command.size ();
+    const uint8_t *initiate = &command[0];
+
+    uint8_t cookie_nonce[crypto_secretbox_NONCEBYTES];
+    uint8_t cookie_plaintext[crypto_secretbox_ZEROBYTES + 64];
+    uint8_t cookie_box[crypto_secretbox_BOXZEROBYTES + 80];
+
+    //  Open Box [C' + s'](t)
+    memset (cookie_box, 0, crypto_secretbox_BOXZEROBYTES);
+    memcpy (cookie_box + crypto_secretbox_BOXZEROBYTES, initiate + 25, 80);
+
+    memcpy (cookie_nonce, "COOKIE--", 8);
+    memcpy (cookie_nonce + 8, initiate + 9, 16);
+
+    int rc = crypto_secretbox_open (cookie_plaintext, cookie_box,
+                                    sizeof cookie_box, cookie_nonce,
+                                    keys.cookie_key);
+    if (rc != 0) {
+        // CURVE I: cannot open client INITIATE cookie
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        return;
+    }
+
+    //  Check cookie plain text is as expected [C' + s']
+    if (memcmp (cookie_plaintext + crypto_secretbox_ZEROBYTES, keys.cn_client,
+                32)
+        || memcmp (cookie_plaintext + crypto_secretbox_ZEROBYTES + 32,
+                   keys.cn_secret, 32)) {
+        // TODO this case is very hard to test, as it would require a modified
+        //  client that knows the server's secret temporary cookie key
+
+        // CURVE I: client INITIATE cookie is not valid
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        return;
+    }
+
+    //  Precompute connection secret from client key, INITIATE is the
+    //  first box it opens.
+    rc = crypto_box_beforenm (keys.cn_precom, keys.cn_client, keys.cn_secret);
+    zmq_assert (rc == 0);
+
+    const size_t clen = (size - 113) + crypto_box_BOXZEROBYTES;
+
+    uint8_t initiate_nonce[crypto_box_NONCEBYTES];
+    std::vector<uint8_t> initiate_box (clen);
+    initiate_plaintext.resize (clen);
+
+    //  Open Box [C + vouch + metadata](C'->S')
+    memcpy (&initiate_box[crypto_box_BOXZEROBYTES], initiate + 113,
+            clen - crypto_box_BOXZEROBYTES);
+
+    memcpy (initiate_nonce, "CurveZMQINITIATE", 16);
+    memcpy (initiate_nonce + 16, initiate + 105, 8);
+
+    rc = crypto_box_open_afternm (&initiate_plaintext[0], &initiate_box[0],
+                                  clen, initiate_nonce, keys.cn_precom);
+    if (rc != 0) {
+        // CURVE I: cannot open client INITIATE
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        return;
+    }
+
+    const uint8_t *client_key = &initiate_plaintext[crypto_box_ZEROBYTES];
+
+    uint8_t vouch_nonce[crypto_box_NONCEBYTES];
+    uint8_t vouch_plaintext[crypto_box_ZEROBYTES + 64];
+    uint8_t vouch_box[crypto_box_BOXZEROBYTES + 80];
+
+    //  Open Box Box [C',S](C->S') and check contents
+    memset (vouch_box, 0, crypto_box_BOXZEROBYTES);
+    memcpy (vouch_box + crypto_box_BOXZEROBYTES,
+            &initiate_plaintext[crypto_box_ZEROBYTES + 48], 80);
+
+    memcpy (vouch_nonce, "VOUCH---", 8);
+    memcpy (vouch_nonce + 8, &initiate_plaintext[crypto_box_ZEROBYTES + 32],
+            16);
+
+    rc = crypto_box_open (vouch_plaintext, vouch_box, sizeof vouch_box,
+                          vouch_nonce, client_key, keys.cn_secret);
+    if (rc != 0) {
+        // CURVE I: cannot open client INITIATE vouch
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC;
+        return;
+    }
+
+    //  What we decrypted must be the client's short-term public key
+    if (memcmp (vouch_plaintext + crypto_box_ZEROBYTES, keys.cn_client, 32)) {
+        // TODO this case is very hard to test, as it would require a modified
+        //  client that knows the server's secret short-term key
+
+        // CURVE I: invalid handshake from client (public key)
+        error = ZMQ_PROTOCOL_ERROR_ZMTP_KEY_EXCHANGE;
+        return;
+    }
+}
+
 #endif
@@ -32,7 +32,10 @@
 
 #ifdef ZMQ_HAVE_CURVE
 
+#include <vector>
+
 #include "curve_mechanism_base.hpp"
+#include "crypto_pool.hpp"
 #include "options.hpp"
 #include "zap_client.hpp"
 
@@ -58,27 +61,111 @@ class curve_server_t : public zap_client_common_handshake_t,
     virtual int decode (msg_t *msg_);
 
   private:
-    //  Our secret key (s)
-    uint8_t _secret_key[crypto_box_SECRETKEYBYTES];
+    struct keys_t
+    {
+        //  Our secret key (s)
+        uint8_t secret_key[crypto_box_SECRETKEYBYTES];
+
+        //  Our short-term public key (S')
+        uint8_t cn_public[crypto_box_PUBLICKEYBYTES];
+
+        //  Our short-term secret key (s')
+        uint8_t cn_secret[crypto_box_SECRETKEYBYTES];
+
+        //  Client's short-term public key (C')
+        uint8_t cn_client[crypto_box_PUBLICKEYBYTES];
+
+        //  Key used to produce cookie
+        uint8_t cookie_key[crypto_secretbox_KEYBYTES];
+
+        //  Connection secret shared with the client
+        uint8_t cn_precom[crypto_box_BEFORENMBYTES];
+    };
+
+    //  The cryptography of a HELLO or INITIATE command. It works on copies
+    //  of the command and of the keys, so that it can run on the crypto
+    //  pool of the context while the server waits for it or goes away.
+    class key_exchange_t : public crypto_job_t
+    {
+      public:
+        key_exchange_t (curve_server_t *server_, const msg_t *command_);
+
+        void execute ();
+        void completed ();
+
+        curve_server_t *const server;
+        const bool hello;
+        std::vector<uint8_t> command;
+        keys_t keys;
+
+        //  Set once the results below are available.
+        bool done;
+
+        //  0 on success, otherwise the ZMQ_PROTOCOL_ERROR_ZMTP_* code
+        //  the handshake fails with.
+        int error;
 
-    //  Our short-term public key (S')
-    uint8_t _cn_public[crypto_box_PUBLICKEYBYTES];
+        //  The WELCOME command answering a HELLO.
+        uint8_t welcome[168];
 
-    //  Our short-term secret key (s')
-    uint8_t _cn_secret[crypto_box_SECRETKEYBYTES];
+        //  Box [C + vouch + metadata] of an INITIATE.
+        std::vector<uint8_t> initiate_plaintext;
 
-    //  Client's short-term public key (C')
-    uint8_t _cn_client[crypto_box_PUBLICKEYBYTES];
+      private:
+        void exchange_hello ();
+        void exchange_initiate ();
+    };
 
-    //  Key used to produce cookie
-    uint8_t _cookie_key[crypto_secretbox_KEYBYTES];
+    keys_t _keys;
+
+    //  Produced along with the HELLO key exchange.
+    uint8_t _welcome[168];
+
+    //  Client's long-term public key (C)
+    uint8_t _client_key[crypto_box_PUBLICKEYBYTES];
+
+    //  Whether the client asked for a resumption ticket.
+    bool _ticket_requested;
+
+    //  Whether the client resumed a session with a ticket, answered with
+    //  RESUMED instead of WELCOME and READY, and its nonce.
+    bool _resumed;
+    uint8_t _resumed_nonce[crypto_box_NONCEBYTES];
+
+    //  Key exchange in progress, or whose results are to be taken.
+    key_exchange_t *_job;
+
+    //  Runs the key exchange of the command, on the crypto pool if there is
+    //  one. Returns the finished job, which the caller takes ownership of,
+    //  or NULL with errno set to EAGAIN while the job is running.
+    key_exchange_t *exchange_keys (const msg_t *msg_);
 
     int process_hello (msg_t *msg_);
     int produce_welcome (msg_t *msg_);
     int process_initiate (msg_t *msg_);
     int produce_ready (msg_t *msg_);
+    int process_resume (msg_t *msg_);
+    int produce_resumed (msg_t *msg_);
     int produce_error (msg_t *msg_) const;
 
+    //  Lets the client in, asking the ZAP handler first if there is one.
+    int authenticate ();
+
+    //  Identifies this server in the tickets it issues.
+    void server_tag (uint8_t *tag_) const;
+
+    //  Adds a fresh resumption ticket property to metadata.
+    size_t add_ticket (uint8_t *ptr_, size_t ptr_capacity_);
+
+    //  Names the cipher picked for messages in metadata, if any, and
+    //  whether messages are batched.
+    size_t extension_properties_len () const;
+    size_t add_extension_properties (uint8_t *ptr_, size_t ptr_capacity_);
+
+    //  Picks up the resume and batch properties, and a cipher from the
+    //  cipher property.
+    int property (const std::string &name_, const void *value_, size_t length_);
+
     void send_zap_request (const uint8_t *key_);
 };
 #ifdef _MSC_VER
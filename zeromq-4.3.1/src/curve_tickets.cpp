@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "curve_tickets.hpp"
+#include "config.hpp"
+#include "err.hpp"
+#include "wire.hpp"
+
+#ifdef ZMQ_HAVE_CURVE
+#if defined(ZMQ_USE_TWEETNACL)
+#include "tweetnacl.h"
+#elif defined(ZMQ_USE_LIBSODIUM)
+#include "sodium.h"
+#endif
+#endif
+
+zmq::curve_tickets_t::curve_tickets_t () : _has_key (false)
+{
+}
+
+zmq::curve_tickets_t::~curve_tickets_t ()
+{
+    memset (_key, 0, sizeof _key);
+}
+
+#ifdef ZMQ_HAVE_CURVE
+
+//  Size of the sealed part of a ticket.
+static const size_t ticket_plaintext_size =
+  zmq::curve_tickets_t::ticket_size - crypto_secretbox_NONCEBYTES
+  - crypto_secretbox_BOXZEROBYTES;
+
+void zmq::curve_tickets_t::issue (const uint8_t *server_tag_,
+                                  const uint8_t *client_key_,
+                                  const uint8_t *secret_,
+                                  int lifetime_,
+                                  uint8_t *ticket_)
+{
+    uint8_t plaintext[crypto_secretbox_ZEROBYTES + ticket_plaintext_size];
+    uint8_t box[crypto_secretbox_ZEROBYTES + ticket_plaintext_size];
+    uint8_t nonce[crypto_secretbox_NONCEBYTES];
+
+    memset (plaintext, 0, crypto_secretbox_ZEROBYTES);
+    uint8_t *ptr = plaintext + crypto_secretbox_ZEROBYTES;
+
+    scoped_lock_t locker (_sync);
+
+    if (!_has_key) {
+        randombytes (_key, sizeof _key);
+        _has_key = true;
+    }
+
+    put_uint64 (ptr, _clock.now_ms () + lifetime_);
+    ptr += 8;
+    memcpy (ptr, server_tag_, tag_size);
+    ptr += tag_size;
+    memcpy (ptr, client_key_, 32);
+    ptr += 32;
+    memcpy (ptr, secret_, secret_size);
+
+    randombytes (nonce, sizeof nonce);
+    const int rc =
+      crypto_secretbox (box, plaintext, sizeof plaintext, nonce, _key);
+    zmq_assert (rc == 0);
+
+    memcpy (ticket_, nonce, sizeof nonce);
+    memcpy (ticket_ + sizeof nonce, box + crypto_secretbox_BOXZEROBYTES,
+            sizeof box - crypto_secretbox_BOXZEROBYTES);
+    memset (plaintext, 0, sizeof plaintext);
+}
+
+int zmq::curve_tickets_t::open (const uint8_t *ticket_,
+                                const uint8_t *server_tag_,
+                                uint64_t *expiry_,
+                                uint8_t *client_key_,
+                                uint8_t *secret_)
+{
+    uint8_t plaintext[crypto_secretbox_ZEROBYTES + ticket_plaintext_size];
+    uint8_t box[crypto_secretbox_ZEROBYTES + ticket_plaintext_size];
+
+    memset (box, 0, crypto_secretbox_BOXZEROBYTES);
+    memcpy (box + crypto_secretbox_BOXZEROBYTES,
+            ticket_ + crypto_secretbox_NONCEBYTES,
+            sizeof box - crypto_secretbox_BOXZEROBYTES);
+
+    scoped_lock_t locker (_sync);
+
+    int rc = -1;
+    if (_has_key
+        && crypto_secretbox_open (plaintext, box, sizeof box, ticket_, _key)
+             == 0) {
+        const uint8_t *ptr = plaintext + crypto_secretbox_ZEROBYTES;
+        *expiry_ = get_uint64 (ptr);
+        if (*expiry_ > _clock.now_ms ()
+            && memcmp (ptr + 8, server_tag_, tag_size) == 0) {
+            memcpy (client_key_, ptr + 8 + tag_size, 32);
+            memcpy (secret_, ptr + 8 + tag_size + 32, secret_size);
+            rc = 0;
+        }
+    }
+
+    //  Whatever the outcome, the client key and the resumption secret
+    //  are not left behind on the stack.
+    memset (plaintext, 0, sizeof plaintext);
+    memset (box, 0, sizeof box);
+    return rc;
+}
+
+int zmq::curve_tickets_t::redeem (const uint8_t *ticket_, uint64_t expiry_)
+{
+    const std::string nonce (reinterpret_cast<const char *> (ticket_),
+                             crypto_secretbox_NONCEBYTES);
+
+    scoped_lock_t locker (_sync);
+
+    //  If too many tickets are outstanding, refuse to resume rather than
+    //  forget about redeemed ones.
+    if (_redeemed.size () >= max_redeemed_curve_tickets)
+        purge_expired (_clock.now_ms ());
+    if (_redeemed.size () >= max_redeemed_curve_tickets)
+        return -1;
+
+    return _redeemed.insert (redeemed_t::value_type (nonce, expiry_)).second
+             ? 0
+             : -1;
+}
+
+void zmq::curve_tickets_t::purge_expired (uint64_t now_)
+{
+    for (redeemed_t::iterator it = _redeemed.begin (); it != _redeemed.end ();) {
+        if (it->second <= now_)
+            _redeemed.erase (it++);
+        else
+            ++it;
+    }
+}
+
+#endif
@@ -0,0 +1,105 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_CURVE_TICKETS_HPP_INCLUDED__
+#define __ZMQ_CURVE_TICKETS_HPP_INCLUDED__
+
+#include <map>
+#include <string>
+
+#include "clock.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Resumption tickets issued by the CURVE servers of a context. A ticket
+//  holds the long-term key of the client and the secret it resumes its
+//  session with, sealed with a key only the context knows, so servers
+//  keep no state per ticket until it is redeemed. A ticket is redeemed at
+//  most once: its nonce is remembered until it expires.
+
+class curve_tickets_t
+{
+  public:
+    enum
+    {
+        tag_size = 16,
+        secret_size = 32,
+
+        //  Nonce and MAC, then the sealed expiry, server tag, client key
+        //  and secret.
+        ticket_size = 24 + 16 + 8 + tag_size + 32 + secret_size
+    };
+
+    curve_tickets_t ();
+    ~curve_tickets_t ();
+
+    //  Seals a ticket valid for lifetime_ milliseconds. The tag identifies
+    //  the server, tickets are only redeemed by servers with the same tag.
+    void issue (const uint8_t *server_tag_,
+                const uint8_t *client_key_,
+                const uint8_t *secret_,
+                int lifetime_,
+                uint8_t *ticket_);
+
+    //  Opens a ticket and copies out its expiry, client key and secret.
+    //  Returns -1 if the ticket is forged, was issued to another server or
+    //  has expired.
+    int open (const uint8_t *ticket_,
+              const uint8_t *server_tag_,
+              uint64_t *expiry_,
+              uint8_t *client_key_,
+              uint8_t *secret_);
+
+    //  Marks an opened ticket as used, once the client proved it knows
+    //  the secret. Returns -1 if it was used before.
+    int redeem (const uint8_t *ticket_, uint64_t expiry_);
+
+  private:
+    void purge_expired (uint64_t now_);
+
+    //  Key tickets are sealed with, generated on first use.
+    uint8_t _key[32];
+    bool _has_key;
+
+    //  Nonces of the tickets redeemed, with their expiry.
+    typedef std::map<std::string, uint64_t> redeemed_t;
+    redeemed_t _redeemed;
+
+    clock_t _clock;
+
+    mutex_t _sync;
+
+    curve_tickets_t (const curve_tickets_t &);
+    const curve_tickets_t &operator= (const curve_tickets_t &);
+};
+}
+
+#endif
@@ -4,7 +4,7 @@
 #include "err.hpp"
 #include "msg.hpp"
 
-zmq::dealer_t::dealer_t (class ctx_t * parent_, uint32_t tid_, int sid_) : socket_base_t (parent_, tid_, sid_), _probe_router (false)
+zmq::dealer_t::dealer_t (class ctx_t * parent_, uint32_t tid_, int sid_) : socket_base_t (parent_, tid_, sid_), _lb (options), _probe_router (false)
 {
     options.type = ZMQ_DEALER;
 }
@@ -28,9 +28,8 @@ template <typename T, typename A = c_single_allocator>
 class decoder_base_t : public i_decoder
 {
 public:
-    explicit decoder_base_t (const size_t buf_size_) : _next (NULL), _read_pos (NULL), _to_read (0), _allocator(buf_size_)
+    explicit decoder_base_t (const size_t buf_size_) : _next (NULL), _read_pos (NULL), _to_read (0), _allocator(buf_size_), _buf (NULL)
     {
-        _buf = _allocator.allocate();
     }
 
     //  The destructor doesn't have to be virtual. It is made virtual
@@ -128,6 +127,19 @@ public:
         _allocator.resize(new_size_);
     }
 
+    virtual void set_buffer_pool (buffer_pool_t *pool_)
+    {
+        _allocator.set_pool (pool_);
+    }
+
+    //  Derived classes holding data in the buffer must move it out before
+    //  calling this.
+    virtual void release_buffer ()
+    {
+        _allocator.return_buffer ();
+        _buf = NULL;
+    }
+
 protected:
     //  Prototype of state machine action. Action should return false if
     //  it is unable to push the data to the system.
@@ -144,6 +156,8 @@ protected:
 
     A &get_allocator () { return _allocator; }
 
+    std::size_t to_read () const { return _to_read; }
+
 private:
     //  Next step. If set to NULL, it means that associated data stream
     //  is dead. Note that there can be still data in the process in such
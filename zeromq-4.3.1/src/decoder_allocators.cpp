@@ -10,7 +10,8 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator(std::size_
     _buf_size(0),
     _max_size(bufsize_),
     _msg_content(NULL),
-    _max_counters(static_cast<size_t>(std::ceil(static_cast<double>(_max_size)/static_cast<double>(msg_t::max_vsm_size))))
+    _max_counters(static_cast<size_t>(std::ceil(static_cast<double>(_max_size)/static_cast<double>(msg_t::max_vsm_size)))),
+    _pool(NULL)
 {
 
 }
@@ -20,14 +21,15 @@ zmq::shared_message_memory_allocator::shared_message_memory_allocator(std::size_
     _buf_size(0),
     _max_size(bufsize_),
     _msg_content(NULL),
-    _max_counters(max_messages_)
+    _max_counters(max_messages_),
+    _pool(NULL)
 {
 
 }
 
 zmq::shared_message_memory_allocator::~shared_message_memory_allocator ()
 {
-    deallocate();
+    return_buffer();
 }
 
 unsigned char * zmq::shared_message_memory_allocator::allocate()
@@ -52,9 +54,9 @@ unsigned char * zmq::shared_message_memory_allocator::allocate()
     if (_buf == NULL) 
     {
         // allocate memory for reference counters together with reception buffer
-        std::size_t const allocationsize = _max_size + sizeof(zmq::atomic_counter_t) + _max_counters * sizeof (zmq::msg_t::content_t);
+        std::size_t const allocationsize = allocation_size();
 
-        _buf = static_cast<unsigned char *>(std::malloc(allocationsize));
+        _buf = static_cast<unsigned char *>(_pool ? _pool->allocate(allocationsize) : std::malloc(allocationsize));
         alloc_assert(_buf);
 
         new (_buf)atomic_counter_t(1);
@@ -81,6 +83,24 @@ void zmq::shared_message_memory_allocator::deallocate()
     clear();
 }
 
+void zmq::shared_message_memory_allocator::return_buffer()
+{
+    if (!_buf)
+        return;
+
+    // Only the messages decoded in the I/O thread take references, so a
+    // count of 1 means that no message can use the buffer anymore.
+    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *>(_buf);
+    if (_pool && c->get() == 1)
+    {
+        c->~atomic_counter_t ();
+        _pool->deallocate(_buf, allocation_size());
+        clear();
+        return;
+    }
+    deallocate();
+}
+
 unsigned char *zmq::shared_message_memory_allocator::release()
 {
     unsigned char *b = _buf;
@@ -114,6 +134,11 @@ void zmq::shared_message_memory_allocator::call_dec_ref(void *, void *hint_)
     }
 }
 
+std::size_t zmq::shared_message_memory_allocator::allocation_size() const
+{
+    return _max_size + sizeof(zmq::atomic_counter_t) + _max_counters * sizeof (zmq::msg_t::content_t);
+}
+
 std::size_t zmq::shared_message_memory_allocator::size() const
 {
     return _buf_size;
@@ -5,33 +5,58 @@
 #include <cstdlib>
 
 #include "atomic_counter.hpp"
+#include "buffer_pool.hpp"
 #include "msg.hpp"
 #include "err.hpp"
 
 namespace zmq
 {
-// Static buffer policy.
+// Static buffer policy. The buffer is allocated when first needed and kept
+// until it is given back with return_buffer.
 class c_single_allocator
 {
 public:
-    explicit c_single_allocator (std::size_t bufsize_) : _buf_size (bufsize_), _buf (static_cast<unsigned char *> (std::malloc (_buf_size)))
+    explicit c_single_allocator (std::size_t bufsize_) : _buf_size (bufsize_), _max_size (bufsize_), _buf (NULL), _pool (NULL)
     {
-        alloc_assert (_buf);
     }
 
-    ~c_single_allocator () { std::free (_buf); }
+    ~c_single_allocator () { return_buffer (); }
 
-    unsigned char *allocate () { return _buf; }
+    unsigned char *allocate ()
+    {
+        if (!_buf) {
+            _buf = static_cast<unsigned char *> (_pool ? _pool->allocate (_max_size) : std::malloc (_max_size));
+            alloc_assert (_buf);
+        }
+        _buf_size = _max_size;
+        return _buf;
+    }
 
     void deallocate () {}
 
+    // Give the buffer back to the pool, or free it without one.
+    void return_buffer ()
+    {
+        if (!_buf)
+            return;
+        if (_pool)
+            _pool->deallocate (_buf, _max_size);
+        else
+            std::free (_buf);
+        _buf = NULL;
+    }
+
+    void set_pool (buffer_pool_t *pool_) { _pool = pool_; }
+
     std::size_t size () const { return _buf_size; }
 
     void resize (std::size_t new_size_) { _buf_size = new_size_; }
 
 private:
     std::size_t _buf_size;
+    const std::size_t _max_size;
     unsigned char *_buf;
+    buffer_pool_t *_pool;
 
     c_single_allocator (c_single_allocator const &);
     c_single_allocator &operator= (c_single_allocator const &);
@@ -65,6 +90,13 @@ public:
     // force deallocation of buffer.
     void deallocate ();
 
+    // Give the buffer back to the pool if no message uses it, otherwise
+    // leave it to the messages. A new buffer is allocated next time.
+    void return_buffer ();
+
+    // Borrow buffers from pool_ rather than from the heap.
+    void set_pool (buffer_pool_t *pool_) { _pool = pool_; }
+
     // Give up ownership of the buffer. The buffer's lifetime is now coupled to
     // the messages constructed on top of it.
     unsigned char * release();
@@ -96,12 +128,15 @@ public:
 private:
     void clear ();
 
+    std::size_t allocation_size () const;
+
 private:
     unsigned char         * _buf;
     std::size_t             _buf_size;
     const std::size_t       _max_size;
     zmq::msg_t::content_t * _msg_content;
     std::size_t             _max_counters;
+    buffer_pool_t         * _pool;
 };
 }
 
@@ -93,15 +93,15 @@ void zmq::dish_t::xhiccuped (pipe_t *pipe_)
 
 int zmq::dish_t::xjoin (const char *group_)
 {
-    std::string group = std::string (group_);
-
-    if (group.length () > ZMQ_GROUP_MAX_LENGTH) {
+    if (strlen (group_) > ZMQ_GROUP_MAX_LENGTH) {
         errno = EINVAL;
         return -1;
     }
 
     //  User cannot join same group twice
-    if (!_subscriptions.insert (group).second) {
+    bool inserted;
+    _subscriptions.insert (group_key_t (group_), &inserted) = true;
+    if (!inserted) {
         errno = EINVAL;
         return -1;
     }
@@ -126,14 +126,12 @@ int zmq::dish_t::xjoin (const char *group_)
 
 int zmq::dish_t::xleave (const char *group_)
 {
-    std::string group = std::string (group_);
-
-    if (group.length () > ZMQ_GROUP_MAX_LENGTH) {
+    if (strlen (group_) > ZMQ_GROUP_MAX_LENGTH) {
         errno = EINVAL;
         return -1;
     }
 
-    if (0 == _subscriptions.erase (group)) {
+    if (!_subscriptions.erase (group_key_t (group_))) {
         errno = EINVAL;
         return -1;
     }
@@ -195,7 +193,7 @@ int zmq::dish_t::xxrecv (msg_t *msg_)
             return -1;
 
         //  Skip non matching messages
-    } while (0 == _subscriptions.count (std::string (msg_->group ())));
+    } while (!_subscriptions.find (group_key_t (msg_->group ())));
 
     //  Found a matching message
     return 0;
@@ -221,14 +219,16 @@ bool zmq::dish_t::xhas_in ()
 
 void zmq::dish_t::send_subscriptions (pipe_t *pipe_)
 {
-    for (subscriptions_t::iterator it = _subscriptions.begin (),
-                                   end = _subscriptions.end ();
-         it != end; ++it) {
+    for (subscriptions_t::size_type i = 0, n = _subscriptions.capacity ();
+         i != n; ++i) {
+        if (!_subscriptions.occupied (i))
+            continue;
+
         msg_t msg;
         int rc = msg.init_join ();
         errno_assert (rc == 0);
 
-        rc = msg.set_group (it->c_str ());
+        rc = msg.set_group (_subscriptions.key (i).c_str ());
         errno_assert (rc == 0);
 
         //  Send it to the pipe.
@@ -30,13 +30,12 @@
 #ifndef __ZMQ_DISH_HPP_INCLUDED__
 #define __ZMQ_DISH_HPP_INCLUDED__
 
-#include <string>
-
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "dist.hpp"
 #include "fq.hpp"
 #include "msg.hpp"
+#include "group_table.hpp"
 
 namespace zmq
 {
@@ -78,8 +77,9 @@ class dish_t : public socket_base_t
     //  Object for distributing the subscriptions upstream.
     dist_t _dist;
 
-    //  The repository of subscriptions.
-    typedef std::set<std::string> subscriptions_t;
+    //  The repository of subscriptions. Only the keys are used, a joined
+    //  group is any group present in the table.
+    typedef group_table_t<bool> subscriptions_t;
     subscriptions_t _subscriptions;
 
     //  If true, 'message' contains a matching message to return on the
@@ -0,0 +1,243 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "dns_resolver.hpp"
+#include "config.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+#include "macros.hpp"
+
+zmq::dns_request_t::dns_request_t (const std::string &name_, bool ipv6_) :
+    name (name_),
+    ipv6 (ipv6_),
+    rc (-1),
+    error (0)
+{
+}
+
+zmq::dns_resolver_t::dns_resolver_t (ctx_t *ctx_, int ttl_, int negative_ttl_) :
+    _ctx (ctx_),
+    _ttl (ttl_),
+    _negative_ttl (negative_ttl_),
+    _started (false),
+    _stopping (false),
+    _busy (false),
+    _detached (false)
+{
+}
+
+zmq::dns_resolver_t::~dns_resolver_t ()
+{
+    zmq_assert (_requests.empty ());
+}
+
+void zmq::dns_resolver_t::stop ()
+{
+    _sync.lock ();
+    _stopping = true;
+
+    //  The requests left were abandoned by connecters that are gone, there
+    //  is no point looking them up.
+    while (!_requests.empty ()) {
+        dns_request_t *request = _requests.front ();
+        _requests.pop_front ();
+        request->error = ETERM;
+        request->send_done (_ctx);
+    }
+
+    //  A lookup can take as long as the name servers take to time out.
+    //  Rather than hold up the termination of the context, leave the
+    //  worker to clean up once it returns.
+    if (_busy) {
+        _detached = true;
+        _worker.detach ();
+        _sync.unlock ();
+        return;
+    }
+
+    _cond.broadcast ();
+    _sync.unlock ();
+
+    if (_started)
+        _worker.stop ();
+    delete this;
+}
+
+int zmq::dns_resolver_t::lookup (const std::string &name_,
+                                 bool ipv6_,
+                                 tcp_address_t *address_)
+{
+    //  Numeric addresses are resolved without a name server.
+    if (address_->resolve (name_.c_str (), false, ipv6_, false) == 0)
+        return 0;
+
+    scoped_lock_t locker (_sync);
+
+    const entry_t *entry = find (name_, ipv6_);
+    if (!entry) {
+        errno = EAGAIN;
+        return -1;
+    }
+    if (entry->rc != 0) {
+        errno = entry->error;
+        return -1;
+    }
+    *address_ = entry->address;
+    return 0;
+}
+
+void zmq::dns_resolver_t::submit (dns_request_t *request_,
+                                  io_thread_t *io_thread_)
+{
+    request_->set_io_thread (io_thread_);
+
+    scoped_lock_t locker (_sync);
+    zmq_assert (!_stopping);
+    _requests.push_back (request_);
+
+    //  Start the worker on the first request.
+    if (!_started) {
+        _ctx->start_thread (_worker, worker_routine, this);
+        _started = true;
+    } else
+        _cond.broadcast ();
+}
+
+void zmq::dns_resolver_t::resolve (dns_request_t *request_)
+{
+    {
+        scoped_lock_t locker (_sync);
+
+        //  Names asked for several times while queued are only looked up
+        //  once.
+        const entry_t *entry = find (request_->name, request_->ipv6);
+        if (entry) {
+            request_->rc = entry->rc;
+            request_->error = entry->error;
+            request_->address = entry->address;
+            return;
+        }
+    }
+
+    tcp_address_t address;
+    const int rc = do_resolve (request_->name, request_->ipv6, &address);
+    const int error = rc == 0 ? 0 : errno;
+
+    request_->rc = rc;
+    request_->error = error;
+    if (rc == 0)
+        request_->address = address;
+
+    scoped_lock_t locker (_sync);
+
+    const uint64_t now = _clock.now_ms ();
+    if (_entries.size () >= max_dns_cache_entries)
+        purge_expired (now);
+    if (_entries.size () >= max_dns_cache_entries)
+        return;
+
+    entry_t &entry = _entries[key (request_->name, request_->ipv6)];
+    entry.rc = rc;
+    entry.error = error;
+    entry.address = address;
+    entry.expiry = now + (rc == 0 ? _ttl : _negative_ttl);
+}
+
+int zmq::dns_resolver_t::do_resolve (const std::string &name_,
+                                     bool ipv6_,
+                                     tcp_address_t *address_)
+{
+    return address_->resolve (name_.c_str (), false, ipv6_);
+}
+
+std::string zmq::dns_resolver_t::key (const std::string &name_, bool ipv6_)
+{
+    return (ipv6_ ? "6" : "4") + name_;
+}
+
+const zmq::dns_resolver_t::entry_t *
+zmq::dns_resolver_t::find (const std::string &name_, bool ipv6_)
+{
+    const entries_t::const_iterator it = _entries.find (key (name_, ipv6_));
+    if (it == _entries.end () || it->second.expiry <= _clock.now_ms ())
+        return NULL;
+    return &it->second;
+}
+
+void zmq::dns_resolver_t::purge_expired (uint64_t now_)
+{
+    for (entries_t::iterator it = _entries.begin (); it != _entries.end ();) {
+        if (it->second.expiry <= now_)
+            _entries.erase (it++);
+        else
+            ++it;
+    }
+}
+
+void zmq::dns_resolver_t::worker_routine (void *arg_)
+{
+    static_cast<dns_resolver_t *> (arg_)->loop ();
+}
+
+void zmq::dns_resolver_t::loop ()
+{
+    _sync.lock ();
+    while (true) {
+        if (_requests.empty ()) {
+            if (_stopping)
+                break;
+            const int rc = _cond.wait (&_sync, -1);
+            errno_assert (rc == 0);
+            continue;
+        }
+
+        dns_request_t *request = _requests.front ();
+        _requests.pop_front ();
+        _busy = true;
+        _sync.unlock ();
+
+        resolve (request);
+
+        _sync.lock ();
+        _busy = false;
+
+        //  The context is gone, and so are the I/O threads.
+        if (_detached) {
+            zmq_assert (request->is_abandoned ());
+            LIBZMQ_DELETE (request);
+            _sync.unlock ();
+            delete this;
+            return;
+        }
+
+        request->send_done (_ctx);
+    }
+    _sync.unlock ();
+}
@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_DNS_RESOLVER_HPP_INCLUDED__
+#define __ZMQ_DNS_RESOLVER_HPP_INCLUDED__
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include "clock.hpp"
+#include "condition_variable.hpp"
+#include "io_job.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "tcp_address.hpp"
+#include "thread.hpp"
+
+namespace zmq
+{
+class ctx_t;
+class io_thread_t;
+
+//  A host name to be resolved off an I/O thread. Once completed, rc is 0
+//  and address holds the result, or rc is -1 and error holds the errno of
+//  the failure.
+
+class dns_request_t : public io_job_t
+{
+  public:
+    dns_request_t (const std::string &name_, bool ipv6_);
+
+    const std::string name;
+    const bool ipv6;
+
+    int rc;
+    int error;
+    tcp_address_t address;
+};
+
+//  Resolves the host names TCP connecters connect to on a worker thread
+//  of its own, so a slow name server does not stall the other
+//  connections of an I/O thread. Answers are cached for the context:
+//  successful ones for dns_cache_ttl, failures for dns_negative_cache_ttl.
+
+class dns_resolver_t
+{
+  public:
+    dns_resolver_t (ctx_t *ctx_, int ttl_, int negative_ttl_);
+    virtual ~dns_resolver_t ();
+
+    //  Hands the queued requests back unresolved and deletes the resolver.
+    //  A lookup in progress is not waited for: its worker is left to
+    //  delete the resolver once the lookup returns. Must be called before
+    //  the I/O threads stop.
+    void stop ();
+
+    //  Resolves a name without blocking: numeric addresses, and names
+    //  with an unexpired answer in the cache. Returns -1 with EAGAIN if
+    //  the name has to be looked up.
+    int lookup (const std::string &name_, bool ipv6_, tcp_address_t *address_);
+
+    //  Queues the request. It is handed back to io_thread_ once resolved.
+    void submit (dns_request_t *request_, io_thread_t *io_thread_);
+
+    //  Resolves the request, from the cache if possible, and caches the
+    //  answer. This is what the worker does with each request.
+    void resolve (dns_request_t *request_);
+
+  protected:
+    //  Looks the name up. Overridden to resolve without a name server.
+    virtual int do_resolve (const std::string &name_,
+                            bool ipv6_,
+                            tcp_address_t *address_);
+
+  private:
+    struct entry_t
+    {
+        int rc;
+        int error;
+        tcp_address_t address;
+        uint64_t expiry;
+    };
+
+    //  Key of the answers for a name, which differ with IPv6 enabled.
+    static std::string key (const std::string &name_, bool ipv6_);
+
+    //  Returns the unexpired answer cached for a name, or NULL. Must be
+    //  called with _sync held.
+    const entry_t *find (const std::string &name_, bool ipv6_);
+
+    void purge_expired (uint64_t now_);
+
+    static void worker_routine (void *arg_);
+    void loop ();
+
+    ctx_t *const _ctx;
+    const int _ttl;
+    const int _negative_ttl;
+
+    typedef std::map<std::string, entry_t> entries_t;
+    entries_t _entries;
+
+    clock_t _clock;
+
+    typedef std::deque<dns_request_t *> requests_t;
+    requests_t _requests;
+
+    thread_t _worker;
+    bool _started;
+    bool _stopping;
+
+    //  Whether the worker is looking a name up, and whether it was left
+    //  to finish it on its own by stop.
+    bool _busy;
+    bool _detached;
+
+    mutex_t _sync;
+    condition_variable_t _cond;
+
+    dns_resolver_t (const dns_resolver_t &);
+    const dns_resolver_t &operator= (const dns_resolver_t &);
+};
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <algorithm>
 
+#include "buffer_pool.hpp"
 #include "err.hpp"
 #include "i_encoder.hpp"
 #include "msg.hpp"
@@ -24,27 +25,34 @@ public:
         _next(NULL),
         _new_msg_flag(false),
         _buf_size(bufsize_),
-        _buf(static_cast<unsigned char *>(malloc(bufsize_))),
+        _buf(NULL),
+        _pool(NULL),
         _in_progress(NULL)
     {
-        alloc_assert(_buf);
     }
 
     //  The destructor doesn't have to be virtual. It is made virtual
     //  just to keep ICC and code checking tools from complaining.
-    inline virtual ~encoder_base_t () { free (_buf); }
+    inline virtual ~encoder_base_t () { release_buffer (); }
 
     //  The function returns a batch of binary data. The data
     //  are filled to a supplied buffer. If no buffer is supplied (data_
     //  points to NULL) decoder object will provide buffer of its own.
     inline size_t encode(unsigned char **data_, size_t size_)
     {
-        unsigned char *buffer = !*data_ ? _buf      : *data_;
-        size_t buffersize     = !*data_ ? _buf_size : size_;
-
         if (in_progress() == NULL)
             return 0;
 
+        //  The buffer is borrowed when there is something to encode.
+        if (!*data_ && !_buf)
+        {
+            _buf = static_cast<unsigned char *>(_pool ? _pool->allocate(_buf_size) : malloc(_buf_size));
+            alloc_assert(_buf);
+        }
+
+        unsigned char *buffer = !*data_ ? _buf      : *data_;
+        size_t buffersize     = !*data_ ? _buf_size : size_;
+
         size_t pos = 0;
         while (pos < buffersize)
         {
@@ -106,6 +114,19 @@ public:
         (static_cast<T *>(this)->*_next)();
     }
 
+    void set_buffer_pool (buffer_pool_t *pool_) { _pool = pool_; }
+
+    void release_buffer ()
+    {
+        if (!_buf)
+            return;
+        if (_pool)
+            _pool->deallocate (_buf, _buf_size);
+        else
+            free (_buf);
+        _buf = NULL;
+    }
+
 protected:
     //  Prototype of state machine action.
     typedef void (T::*step_t) ();
@@ -137,7 +158,10 @@ private:
 
     //  The buffer for encoded data.
     const size_t _buf_size;
-    unsigned char *const _buf;
+    unsigned char *_buf;
+
+    //  Where to borrow the buffer from, or NULL to use the heap.
+    buffer_pool_t *_pool;
 
     encoder_base_t (const encoder_base_t &);
     void operator= (const encoder_base_t &);
@@ -40,6 +40,14 @@ zmq::epoll_t::~epoll_t ()
 }
 
 zmq::epoll_t::handle_t zmq::epoll_t::add_fd(fd_t fd_, i_poll_events *events_)
+{
+    handle_t handle;
+    int rc = try_add_fd(fd_, events_, handle);
+    errno_assert (rc != -1);
+    return handle;
+}
+
+int zmq::epoll_t::try_add_fd(fd_t fd_, i_poll_events *events_, handle_t &handle_)
 {
     check_thread ();
     poll_entry_t *pe = new (std::nothrow) poll_entry_t;
@@ -55,25 +63,42 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd(fd_t fd_, i_poll_events *events_)
     pe->events      = events_;
 
     int rc = epoll_ctl(_epoll_fd, EPOLL_CTL_ADD, fd_, &pe->ev);
-    errno_assert (rc != -1);
+    if (rc == -1) {
+        const int err = errno;
+        delete pe;
+        errno = err;
+        return -1;
+    }
 
     //  Increase the load metric of the thread.
     adjust_load(1);
 
-    return pe;
+    handle_ = pe;
+    return 0;
 }
 
 void zmq::epoll_t::rm_fd(handle_t handle_)
+{
+    int rc = try_rm_fd(handle_);
+    errno_assert(rc != -1);
+}
+
+int zmq::epoll_t::try_rm_fd(handle_t handle_)
 {
     check_thread();
     poll_entry_t *pe = static_cast<poll_entry_t *> (handle_);
+
+    //  A closed fd has left the epoll set already.
     int rc = epoll_ctl(_epoll_fd, EPOLL_CTL_DEL, pe->fd, &pe->ev);
-    errno_assert(rc != -1);
+    const int err = errno;
     pe->fd = retired_fd;
     _retired.push_back(pe);
 
     //  Decrease the load metric of the thread.
     adjust_load (-1);
+
+    errno = err;
+    return rc == -1 ? -1 : 0;
 }
 
 void zmq::epoll_t::set_pollin(handle_t handle_)
@@ -1,43 +1,71 @@
 #include "precompiled.hpp"
+#include "macros.hpp"
 #include "fq.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
 
-zmq::fq_t::fq_t () : _active (0), _last_in (NULL), _current (0), _more (false)
+zmq::fq_t::class_t::class_t (int priority_) :
+    priority (priority_),
+    active (0),
+    current (0),
+    received (0)
+{
+}
+
+zmq::fq_t::fq_t () : _last_in (NULL), _more (false), _more_class (NULL)
 {
 
 }
 
 zmq::fq_t::~fq_t ()
 {
-    zmq_assert (_pipes.empty());
+    for (classes_t::size_type i = 0; i != _classes.size (); i++) {
+        zmq_assert (_classes[i]->pipes.empty ());
+        LIBZMQ_DELETE (_classes[i]);
+    }
 }
 
-void zmq::fq_t::attach(pipe_t * pipe_)
+zmq::fq_t::class_t *zmq::fq_t::get_class (int priority_)
 {
-    _pipes.push_back(pipe_);
-    _pipes.swap(_active, _pipes.size() - 1);
-    _active++;
+    classes_t::iterator it = _classes.begin ();
+    while (it != _classes.end () && (*it)->priority > priority_)
+        ++it;
+    if (it != _classes.end () && (*it)->priority == priority_)
+        return *it;
+
+    class_t *class_ = new (std::nothrow) class_t (priority_);
+    alloc_assert (class_);
+    _classes.insert (it, class_);
+    return class_;
+}
 
-    printf("%s %s %d BBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBBB%d\n", __FILE__, __FUNCTION__, __LINE__, (int)_active);
+void zmq::fq_t::attach(pipe_t * pipe_)
+{
+    class_t *class_ = get_class (pipe_->get_fq_priority ());
+    class_->pipes.push_back(pipe_);
+    class_->pipes.swap(class_->active, class_->pipes.size() - 1);
+    class_->active++;
 }
 
 void zmq::fq_t::pipe_terminated(pipe_t *pipe_)
 {
-    const pipes_t::size_type index = _pipes.index(pipe_);
+    class_t *class_ = get_class (pipe_->get_fq_priority ());
+    const pipes_t::size_type index = class_->pipes.index(pipe_);
 
     //  Remove the pipe from the list; adjust number of active pipes accordingly.
-    if (index < _active) 
+    if (index < class_->active)
     {
-        _active--;
-        _pipes.swap(index, _active);
-        if (_current == _active)
-            _current = 0;
+        if (index == class_->current)
+            class_->received = 0;
+        class_->active--;
+        class_->pipes.swap(index, class_->active);
+        if (class_->current == class_->active)
+            class_->current = 0;
     }
-    _pipes.erase (pipe_);
+    class_->pipes.erase (pipe_);
 
-    if (_last_in == pipe_) 
+    if (_last_in == pipe_)
     {
         _last_in = NULL;
     }
@@ -45,11 +73,11 @@ void zmq::fq_t::pipe_terminated(pipe_t *pipe_)
 
 void zmq::fq_t::activated(pipe_t *pipe_)
 {
-    printf("%s %s %d aaaaaaaaaaaaaaaaaaaaaaaaa:size:%d %d %d %d\n", __FILE__, __FUNCTION__, __LINE__, (int)_pipes.size(), (int)_pipes.index(pipe_), (int)_active, (int)_current);
+    class_t *class_ = get_class (pipe_->get_fq_priority ());
 
     //  Move the pipe to the list of active pipes.
-    _pipes.swap(_pipes.index(pipe_), _active);
-    _active++;
+    class_->pipes.swap(class_->pipes.index(pipe_), class_->active);
+    class_->active++;
 }
 
 int zmq::fq_t::recv(msg_t * msg_)
@@ -63,35 +91,69 @@ int zmq::fq_t::recvpipe(msg_t *msg_, pipe_t **pipe_)
     int rc = msg_->close();
     errno_assert (rc == 0);
 
-    printf("%s %s %d ccccccccccccccccccccccccccccccc%d %d\n", __FILE__, __FUNCTION__, __LINE__, (int)_active, (int)_current);
+    //  The remaining parts of a multipart message come from the pipe
+    //  the first part was read from, whatever its priority.
+    if (_more)
+    {
+        const bool fetched = recv_from (_more_class, msg_, pipe_);
+        zmq_assert (fetched);
+        return 0;
+    }
+
+    //  Take the message from the highest priority class that has one.
+    for (classes_t::size_type i = 0; i != _classes.size (); i++)
+    {
+        if (recv_from (_classes[i], msg_, pipe_))
+            return 0;
+    }
+
+    //  No message is available. Initialise the output parameter
+    //  to be a 0-byte message.
+    rc = msg_->init();
+    errno_assert (rc == 0);
+    errno = EAGAIN;
+    return -1;
+}
 
+bool zmq::fq_t::recv_from (class_t *class_, msg_t *msg_, pipe_t **pipe_)
+{
     //  Round-robin over the pipes to get the next message.
-    while (_active > 0) 
+    while (class_->active > 0)
     {
         //  Try to fetch new message. If we've already read part of the message
         //  subsequent part should be immediately available.
-
-        bool fetched = _pipes[_current]->read(msg_);
+        pipe_t *pipe = class_->pipes[class_->current];
+        bool fetched = pipe->read(msg_);
 
         //  Note that when message is not fetched, current pipe is deactivated
         //  and replaced by another active pipe. Thus we don't have to increase
         //  the 'current' pointer.
-        if (fetched) 
+        if (fetched)
         {
             if (pipe_)
             {
-                *pipe_ = _pipes[_current];
+                *pipe_ = pipe;
             }
 
             _more = (msg_->flags() & msg_t::more) != 0;
 
-            if (!_more) 
+            if (_more)
             {
-                _last_in = _pipes[_current];
-                _current = (_current + 1) % _active;
+                _more_class = class_;
+            }
+            else
+            {
+                _last_in = pipe;
+
+                //  The pipe keeps its turn for as many messages as its weight.
+                if (++class_->received >= pipe->get_fq_weight ())
+                {
+                    class_->received = 0;
+                    class_->current = (class_->current + 1) % class_->active;
+                }
             }
 
-            return 0;
+            return true;
         }
 
         //  Check the atomicity of the message.
@@ -99,21 +161,19 @@ int zmq::fq_t::recvpipe(msg_t *msg_, pipe_t **pipe_)
         //  we should get the remaining parts without blocking.
         zmq_assert (!_more);
 
-        _active--;
-        _pipes.swap(_current, _active);
-        if (_current == _active)
-            _current = 0;
-
-
-        printf("%s %s %d ##############################%d %d\n", __FILE__, __FUNCTION__, __LINE__, (int)_active, (int)_current);
+        deactivate_current (class_);
     }
 
-    //  No message is available. Initialise the output parameter
-    //  to be a 0-byte message.
-    rc = msg_->init();
-    errno_assert (rc == 0);
-    errno = EAGAIN;
-    return -1;
+    return false;
+}
+
+void zmq::fq_t::deactivate_current (class_t *class_)
+{
+    class_->active--;
+    class_->pipes.swap(class_->current, class_->active);
+    if (class_->current == class_->active)
+        class_->current = 0;
+    class_->received = 0;
 }
 
 bool zmq::fq_t::has_in()
@@ -126,16 +186,17 @@ bool zmq::fq_t::has_in()
     //  queueing algorithm. If there are no messages available current will
     //  get back to its original value. Otherwise it'll point to the first
     //  pipe holding messages, skipping only pipes with no messages available.
-    while (_active > 0) 
+    for (classes_t::size_type i = 0; i != _classes.size (); i++)
     {
-        if (_pipes[_current]->check_read())
-            return true;
+        class_t *class_ = _classes[i];
+        while (class_->active > 0)
+        {
+            if (class_->pipes[class_->current]->check_read())
+                return true;
 
-        //  Deactivate the pipe.
-        _active--;
-        _pipes.swap(_current, _active);
-        if (_current == _active)
-            _current = 0;
+            //  Deactivate the pipe.
+            deactivate_current (class_);
+        }
     }
 
     return false;
@@ -1,6 +1,8 @@
 #ifndef __ZMQ_FQ_HPP_INCLUDED__
 #define __ZMQ_FQ_HPP_INCLUDED__
 
+#include <vector>
+
 #include "array.hpp"
 #include "blob.hpp"
 
@@ -12,6 +14,11 @@ class pipe_t;
 //  Class manages a set of inbound pipes. On receive it performs fair
 //  queueing so that senders gone berserk won't cause denial of
 //  service for decent senders.
+//
+//  Pipes are grouped into strict priority classes by their ZMQ_FQ_PRIORITY:
+//  a class is only read from when all the classes with a higher priority
+//  have nothing to deliver. Within a class pipes are served round-robin,
+//  each getting as many consecutive messages as its ZMQ_FQ_WEIGHT.
 
 class fq_t
 {
@@ -32,23 +39,53 @@ public:
 private:
     //  Inbound pipes.
     typedef array_t<pipe_t, 1> pipes_t;
-    pipes_t _pipes;
 
-    //  Number of active pipes. All the active pipes are located at the beginning of the pipes array.
-    pipes_t::size_type _active;
+    //  Pipes sharing the same priority.
+    struct class_t
+    {
+        explicit class_t (int priority_);
+
+        int priority;
+        pipes_t pipes;
+
+        //  Number of active pipes. All the active pipes are located at the beginning of the pipes array.
+        pipes_t::size_type active;
+
+        //  Index of the next bound pipe to read a message from.
+        pipes_t::size_type current;
+
+        //  Number of messages read from the current pipe in its turn.
+        int received;
+    };
+
+    //  Returns the class for the priority, creating it if needed.
+    class_t *get_class (int priority_);
+
+    //  Reads the next message from the active pipes of the class.
+    //  Returns false if none of them has a message.
+    bool recv_from (class_t *class_, msg_t *msg_, pipe_t **pipe_);
+
+    //  Deactivates the current pipe of the class.
+    static void deactivate_current (class_t *class_);
+
+    //  Priority classes, the highest priority first. There are at most
+    //  as many as there are distinct priority values, so walking them is
+    //  bounded regardless of the number of pipes.
+    typedef std::vector<class_t *> classes_t;
+    classes_t _classes;
 
     //  Pointer to the last pipe we received message from.
     //  NULL when no message has been received or the pipe
     //  has terminated.
     pipe_t *_last_in;
 
-    //  Index of the next bound pipe to read a message from.
-    pipes_t::size_type _current;
-
     //  If true, part of a multipart message was already received, but
     //  there are following parts still waiting in the current pipe.
     bool _more;
 
+    //  Class holding the pipe of the multipart message in progress.
+    class_t *_more_class;
+
 private:
     fq_t (const fq_t &);
     const fq_t &operator= (const fq_t &);
@@ -0,0 +1,241 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_GROUP_TABLE_HPP_INCLUDED__
+#define __ZMQ_GROUP_TABLE_HPP_INCLUDED__
+
+#include <string.h>
+#include <vector>
+#include <algorithm>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  RADIO/DISH group name in its canonical form: the 16-byte group field of
+//  msg_t, zero padded after the terminating NUL so that two groups can be
+//  compared and hashed as a pair of 64-bit words.
+
+class group_key_t
+{
+  public:
+    inline group_key_t () { _words[0] = _words[1] = 0; }
+
+    //  Builds the key from a NUL-terminated group name, at most
+    //  ZMQ_GROUP_MAX_LENGTH characters long. Bytes following the terminator
+    //  in msg_t's group field are not guaranteed to be zero, so they are
+    //  never copied.
+    inline explicit group_key_t (const char *group_)
+    {
+        _words[0] = _words[1] = 0;
+        size_t length = 0;
+        while (length < sizeof _words - 1 && group_[length])
+            length++;
+        memcpy (_words, group_, length);
+    }
+
+    inline const char *c_str () const
+    {
+        return reinterpret_cast<const char *> (_words);
+    }
+
+    inline bool operator== (const group_key_t &other_) const
+    {
+        return _words[0] == other_._words[0] && _words[1] == other_._words[1];
+    }
+
+    inline bool operator!= (const group_key_t &other_) const
+    {
+        return !(*this == other_);
+    }
+
+    //  64-bit mix of both words (splitmix64 finalizer). The table indexes
+    //  by the low bits, so they must depend on every byte of the group.
+    inline uint64_t hash () const
+    {
+        uint64_t z = _words[0] ^ (_words[1] * 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+  private:
+    uint64_t _words[2];
+};
+
+//  Flat open-addressing hash table keyed by group_key_t. Linear probing
+//  over a power-of-two sized slot vector, with backward-shift deletion so
+//  that lookups never have to skip tombstones. The table grows when half
+//  full, which keeps probe sequences short for the typical handful to few
+//  thousands of groups per socket.
+//
+//  Slots can be walked by index (0 .. capacity () - 1), which is how
+//  callers enumerate all groups. Erasing while walking may move entries
+//  backwards, so such callers have to collect the keys first.
+
+template <typename T> class group_table_t
+{
+  public:
+    typedef size_t size_type;
+
+    inline group_table_t () : _size (0) {}
+
+    inline size_type size () const { return _size; }
+
+    inline bool empty () const { return _size == 0; }
+
+    inline size_type capacity () const { return _slots.size (); }
+
+    inline bool occupied (size_type index_) const
+    {
+        return _slots[index_].used;
+    }
+
+    inline const group_key_t &key (size_type index_) const
+    {
+        return _slots[index_].key;
+    }
+
+    inline T &value (size_type index_) { return _slots[index_].value; }
+
+    //  Returns the value stored for the key or NULL if there is none.
+    inline T *find (const group_key_t &key_)
+    {
+        if (_size == 0)
+            return NULL;
+        const size_type mask = _slots.size () - 1;
+        for (size_type i = home (key_); _slots[i].used; i = (i + 1) & mask)
+            if (_slots[i].key == key_)
+                return &_slots[i].value;
+        return NULL;
+    }
+
+    //  Returns the value stored for the key, inserting a default constructed
+    //  one if there is none. If inserted_ is not NULL it is set to whether
+    //  the key was newly added.
+    T &insert (const group_key_t &key_, bool *inserted_ = NULL)
+    {
+        if ((_size + 1) * 2 > _slots.size ())
+            grow ();
+
+        const size_type mask = _slots.size () - 1;
+        size_type i = home (key_);
+        for (; _slots[i].used; i = (i + 1) & mask)
+            if (_slots[i].key == key_) {
+                if (inserted_)
+                    *inserted_ = false;
+                return _slots[i].value;
+            }
+
+        _slots[i].used = true;
+        _slots[i].key = key_;
+        _size++;
+        if (inserted_)
+            *inserted_ = true;
+        return _slots[i].value;
+    }
+
+    //  Removes the key from the table. Returns false if it was not there.
+    bool erase (const group_key_t &key_)
+    {
+        if (_size == 0)
+            return false;
+
+        const size_type mask = _slots.size () - 1;
+        size_type i = home (key_);
+        for (; _slots[i].used; i = (i + 1) & mask)
+            if (_slots[i].key == key_)
+                break;
+        if (!_slots[i].used)
+            return false;
+
+        //  Shift the following entries of the cluster back into the hole
+        //  unless their home slot lies cyclically within (hole, entry].
+        for (size_type j = (i + 1) & mask; _slots[j].used; j = (j + 1) & mask) {
+            const size_type k = home (_slots[j].key);
+            const bool in_place =
+              i <= j ? (i < k && k <= j) : (i < k || k <= j);
+            if (in_place)
+                continue;
+            _slots[i].key = _slots[j].key;
+            std::swap (_slots[i].value, _slots[j].value);
+            i = j;
+        }
+
+        _slots[i].used = false;
+        _slots[i].value = T ();
+        _size--;
+        return true;
+    }
+
+  private:
+    struct slot_t
+    {
+        slot_t () : used (false), value () {}
+
+        bool used;
+        group_key_t key;
+        T value;
+    };
+
+    inline size_type home (const group_key_t &key_) const
+    {
+        return static_cast<size_type> (key_.hash ()) & (_slots.size () - 1);
+    }
+
+    void grow ()
+    {
+        std::vector<slot_t> old;
+        old.swap (_slots);
+        _slots.resize (old.empty () ? 8 : old.size () * 2);
+
+        const size_type mask = _slots.size () - 1;
+        for (typename std::vector<slot_t>::iterator it = old.begin (),
+                                                    end = old.end ();
+             it != end; ++it) {
+            if (!it->used)
+                continue;
+            size_type i = home (it->key);
+            while (_slots[i].used)
+                i = (i + 1) & mask;
+            _slots[i].used = true;
+            _slots[i].key = it->key;
+            std::swap (_slots[i].value, it->value);
+        }
+    }
+
+    std::vector<slot_t> _slots;
+    size_type _size;
+
+    group_table_t (const group_table_t &);
+    const group_table_t &operator= (const group_table_t &);
+};
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "macros.hpp"
+#include "heartbeat_scheduler.hpp"
+#include "i_heartbeat_events.hpp"
+#include "err.hpp"
+
+zmq::heartbeat_scheduler_t::heartbeat_scheduler_t (poller_t *poller_) :
+    _poller (poller_)
+{
+}
+
+zmq::heartbeat_scheduler_t::~heartbeat_scheduler_t ()
+{
+    for (size_t i = 0; i != _buckets.size (); i++) {
+        zmq_assert (_buckets[i]->count == 0);
+        LIBZMQ_DELETE (_buckets[i]);
+    }
+}
+
+zmq::heartbeat_scheduler_t::handle_t
+zmq::heartbeat_scheduler_t::add (i_heartbeat_events *sink_,
+                                 int period_,
+                                 int interval_,
+                                 int timeout_)
+{
+    zmq_assert (sink_);
+    zmq_assert (period_ > 0);
+
+    uint32_t index = 0;
+    while (index != _buckets.size () && _buckets[index]->period != period_)
+        index++;
+    if (index == _buckets.size ()) {
+        bucket_t *bucket = new (std::nothrow) bucket_t;
+        alloc_assert (bucket);
+        bucket->period = period_;
+        bucket->free = npos;
+        bucket->count = 0;
+        bucket->armed = false;
+        bucket->sweeping = false;
+        bucket->timer = 0;
+        _buckets.push_back (bucket);
+    }
+    bucket_t *bucket = _buckets[index];
+
+    uint32_t slot = bucket->free;
+    if (slot != npos)
+        bucket->free = bucket->entries[slot].free_next;
+    else {
+        slot = static_cast<uint32_t> (bucket->entries.size ());
+        bucket->entries.push_back (entry_t ());
+    }
+
+    entry_t &e = bucket->entries[slot];
+    e.sink = sink_;
+    e.received = e.seen = e.ttl_mark = 0;
+    e.interval = interval_;
+    e.timeout = timeout_;
+    e.next_ping = interval_ > 0 ? _clock.now_ms () + interval_ : 0;
+    e.timeout_at = 0;
+    e.ttl_at = 0;
+    e.free_next = npos;
+    bucket->count++;
+
+    //  A bucket being swept is re-armed when the sweep is over.
+    if (!bucket->armed && !bucket->sweeping) {
+        bucket->timer = _poller->add_timer (period_, this, index);
+        bucket->armed = true;
+    }
+
+    return (static_cast<handle_t> (index) << 32) | slot;
+}
+
+void zmq::heartbeat_scheduler_t::rm (handle_t handle_)
+{
+    bucket_t *bucket = _buckets[bucket_of (handle_)];
+    const uint32_t slot = entry_of (handle_);
+    zmq_assert (bucket->entries[slot].sink);
+
+    bucket->entries[slot].sink = NULL;
+    bucket->entries[slot].free_next = bucket->free;
+    bucket->free = slot;
+    bucket->count--;
+
+    //  An idle timer would keep the I/O thread from shutting down.
+    if (bucket->count == 0 && bucket->armed) {
+        _poller->cancel_timer (bucket->timer);
+        bucket->armed = false;
+    }
+}
+
+void zmq::heartbeat_scheduler_t::ping_sent (handle_t handle_)
+{
+    entry_t &e = entry (handle_);
+    if (e.timeout > 0 && e.timeout_at == 0) {
+        e.timeout_at = _clock.now_ms () + e.timeout;
+        //  Only what arrives after the PING answers it.
+        e.seen = e.received;
+    }
+}
+
+void zmq::heartbeat_scheduler_t::set_ttl (handle_t handle_, int ttl_)
+{
+    entry_t &e = entry (handle_);
+    e.ttl_at = _clock.now_ms () + ttl_;
+    e.ttl_mark = e.received;
+}
+
+void zmq::heartbeat_scheduler_t::in_event ()
+{
+    //  We are not polling for any file descriptor. This function is
+    //  never called.
+    zmq_assert (false);
+}
+
+void zmq::heartbeat_scheduler_t::out_event ()
+{
+    //  We are not polling for any file descriptor. This function is
+    //  never called.
+    zmq_assert (false);
+}
+
+void zmq::heartbeat_scheduler_t::timer_event (int id_)
+{
+    const uint32_t index = static_cast<uint32_t> (id_);
+    zmq_assert (index < _buckets.size ());
+    _buckets[index]->armed = false;
+    sweep (index);
+}
+
+void zmq::heartbeat_scheduler_t::sweep (uint32_t index_)
+{
+    bucket_t *bucket = _buckets[index_];
+    const uint64_t now = _clock.now_ms ();
+    bucket->sweeping = true;
+
+    //  Callbacks may add or remove connections, so entries are accessed by
+    //  index and the deadlines updated before calling them. Connections
+    //  added during the sweep are only checked from the next one.
+    const size_t size = bucket->entries.size ();
+    for (size_t i = 0; i != size; i++) {
+        entry_t &e = bucket->entries[i];
+        i_heartbeat_events *sink = e.sink;
+        if (!sink)
+            continue;
+
+        //  Any traffic answers an outstanding PING, and any traffic after
+        //  the PING carrying the peer's TTL cancels that TTL.
+        if (e.received != e.seen) {
+            e.seen = e.received;
+            e.timeout_at = 0;
+        }
+        if (e.ttl_at && e.received != e.ttl_mark)
+            e.ttl_at = 0;
+
+        if ((e.timeout_at && now >= e.timeout_at)
+            || (e.ttl_at && now >= e.ttl_at)) {
+            e.timeout_at = e.ttl_at = 0;
+            sink->heartbeat_expired ();
+            continue;
+        }
+
+        if (e.interval > 0 && now >= e.next_ping) {
+            e.next_ping = now + e.interval;
+            sink->heartbeat_ping ();
+        }
+    }
+
+    bucket->sweeping = false;
+    if (bucket->count > 0 && !bucket->armed) {
+        bucket->timer = _poller->add_timer (bucket->period, this, index_);
+        bucket->armed = true;
+    }
+}
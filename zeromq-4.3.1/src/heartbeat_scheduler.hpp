@@ -0,0 +1,160 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_HEARTBEAT_SCHEDULER_HPP_INCLUDED__
+#define __ZMQ_HEARTBEAT_SCHEDULER_HPP_INCLUDED__
+
+#include <vector>
+
+#include "stdint.hpp"
+#include "clock.hpp"
+#include "poller.hpp"
+#include "i_poll_events.hpp"
+
+namespace zmq
+{
+struct i_heartbeat_events;
+
+//  Drives the ZMTP heartbeats of all the connections of an I/O thread.
+//
+//  Instead of each connection arming timers for its PING interval, PING
+//  timeout and the TTL of its peer, connections are grouped into buckets
+//  sharing the same sweep period. Each bucket owns a single poller timer;
+//  when it fires the bucket's entries are scanned in one go, emitting the
+//  PINGs that are due and expiring the connections that stayed silent.
+//  Connections only count the messages they receive, so the data path
+//  never touches the poller's timers.
+//
+//  Deadlines are checked when the bucket is swept, so they are met with
+//  the granularity of its period.
+
+class heartbeat_scheduler_t : public i_poll_events
+{
+  public:
+    typedef uint64_t handle_t;
+
+    explicit heartbeat_scheduler_t (poller_t *poller_);
+    ~heartbeat_scheduler_t ();
+
+    //  Registers a connection swept every period_ ms. It is sent PINGs
+    //  every interval_ ms (never if 0) and expires if nothing is received
+    //  within timeout_ ms of a PING (never if 0).
+    handle_t add (i_heartbeat_events *sink_,
+                  int period_,
+                  int interval_,
+                  int timeout_);
+
+    //  Unregisters a connection. May be called from its callbacks.
+    void rm (handle_t handle_);
+
+    //  Records that the connection received a message.
+    void received (handle_t handle_)
+    {
+        _buckets[bucket_of (handle_)]->entries[entry_of (handle_)].received++;
+    }
+
+    //  Records that the connection sent a PING, starting its timeout
+    //  unless one is already running.
+    void ping_sent (handle_t handle_);
+
+    //  Expires the connection if nothing more is received within ttl_ ms.
+    void set_ttl (handle_t handle_, int ttl_);
+
+    //  i_poll_events implementation.
+    void in_event ();
+    void out_event ();
+    void timer_event (int id_);
+
+  private:
+    struct entry_t
+    {
+        //  NULL for free entries.
+        i_heartbeat_events *sink;
+
+        //  Number of messages received, and its value at the last sweep.
+        uint32_t received;
+        uint32_t seen;
+
+        //  Number of messages received when the TTL was set.
+        uint32_t ttl_mark;
+
+        int interval;
+        int timeout;
+
+        //  Deadlines in ms, 0 when not running. free_next links the free
+        //  entries.
+        uint64_t next_ping;
+        uint64_t timeout_at;
+        uint64_t ttl_at;
+        uint32_t free_next;
+    };
+
+    struct bucket_t
+    {
+        int period;
+        std::vector<entry_t> entries;
+        uint32_t free;
+        size_t count;
+        bool armed;
+        bool sweeping;
+        poller_t::timer_handle_t timer;
+    };
+
+    static const uint32_t npos = 0xffffffff;
+
+    static uint32_t bucket_of (handle_t handle_)
+    {
+        return static_cast<uint32_t> (handle_ >> 32);
+    }
+    static uint32_t entry_of (handle_t handle_)
+    {
+        return static_cast<uint32_t> (handle_);
+    }
+
+    entry_t &entry (handle_t handle_)
+    {
+        return _buckets[bucket_of (handle_)]->entries[entry_of (handle_)];
+    }
+
+    void sweep (uint32_t index_);
+
+    poller_t *_poller;
+
+    //  Buckets by period. They are few and kept once created, so a
+    //  bucket's index is stable and used as the id of its timer.
+    std::vector<bucket_t *> _buckets;
+
+    clock_t _clock;
+
+    heartbeat_scheduler_t (const heartbeat_scheduler_t &);
+    const heartbeat_scheduler_t &operator= (const heartbeat_scheduler_t &);
+};
+}
+
+#endif
@@ -6,6 +6,7 @@
 namespace zmq
 {
 class msg_t;
+class buffer_pool_t;
 
 //  Interface to be implemented by message decoder.
 
@@ -25,6 +26,14 @@ class i_decoder
     decode (const unsigned char *data_, size_t size_, size_t &processed_) = 0;
 
     virtual msg_t *msg () = 0;
+
+    //  Makes the decoder borrow its buffer from pool_.
+    virtual void set_buffer_pool (buffer_pool_t *pool_) = 0;
+
+    //  Gives the buffer back while there is no undecoded data in it. A
+    //  partially decoded message is moved to memory of its own. The next
+    //  get_buffer borrows a buffer again.
+    virtual void release_buffer () = 0;
 };
 }
 
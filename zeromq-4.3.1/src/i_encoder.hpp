@@ -7,6 +7,7 @@ namespace zmq
 {
 //  Forward declaration
 class msg_t;
+class buffer_pool_t;
 
 //  Interface to be implemented by message encoder.
 
@@ -22,6 +23,13 @@ struct i_encoder
 
     //  Load a new message into encoder.
     virtual void load_msg (msg_t *msg_) = 0;
+
+    //  Makes the encoder borrow its buffer from pool_.
+    virtual void set_buffer_pool (buffer_pool_t *pool_) = 0;
+
+    //  Gives the buffer back while the data it holds is not needed
+    //  anymore. The next encode borrows a buffer again.
+    virtual void release_buffer () = 0;
 };
 }
 
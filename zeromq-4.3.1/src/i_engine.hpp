@@ -31,6 +31,9 @@ struct i_engine
 
     virtual void zap_msg_available () = 0;
 
+    //  The crypto job of the handshake mechanism has completed.
+    virtual void crypto_job_done () = 0;
+
     virtual const char *get_endpoint () const = 0;
 };
 
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "io_job.hpp"
+#include "command.hpp"
+#include "ctx.hpp"
+#include "io_thread.hpp"
+#include "err.hpp"
+
+zmq::io_job_t::io_job_t () : _io_thread (NULL), _abandoned (false)
+{
+}
+
+zmq::io_job_t::~io_job_t ()
+{
+}
+
+void zmq::io_job_t::abandon ()
+{
+    zmq_assert (!_abandoned);
+    _abandoned = true;
+}
+
+bool zmq::io_job_t::is_abandoned () const
+{
+    return _abandoned;
+}
+
+void zmq::io_job_t::set_io_thread (io_thread_t *io_thread_)
+{
+    _io_thread = io_thread_;
+}
+
+void zmq::io_job_t::send_done (ctx_t *ctx_)
+{
+    command_t cmd;
+    cmd.destination = _io_thread;
+    cmd.type = command_t::job_done;
+    cmd.args.job_done.job = this;
+    ctx_->send_command (_io_thread->get_tid (), cmd);
+}
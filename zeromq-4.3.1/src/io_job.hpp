@@ -0,0 +1,73 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_IO_JOB_HPP_INCLUDED__
+#define __ZMQ_IO_JOB_HPP_INCLUDED__
+
+namespace zmq
+{
+class ctx_t;
+class io_thread_t;
+
+//  Work taken off an I/O thread, e.g. by the crypto pool or the DNS
+//  resolver, and handed back to it with a job_done command once done.
+
+class io_job_t
+{
+  public:
+    io_job_t ();
+    virtual ~io_job_t ();
+
+    //  Called on the I/O thread that submitted the job once it is done.
+    virtual void completed () = 0;
+
+    //  The owner of the job goes away. The job is deleted by the I/O
+    //  thread when it comes back instead of being completed. Must be
+    //  called from the I/O thread that submitted the job.
+    void abandon ();
+
+    bool is_abandoned () const;
+
+    //  Used by the workers: records the I/O thread submitting the job,
+    //  and hands the job back to it.
+    void set_io_thread (io_thread_t *io_thread_);
+    void send_done (ctx_t *ctx_);
+
+  private:
+    io_thread_t *_io_thread;
+    bool _abandoned;
+
+    friend class io_thread_t;
+
+    io_job_t (const io_job_t &);
+    const io_job_t &operator= (const io_job_t &);
+};
+}
+
+#endif
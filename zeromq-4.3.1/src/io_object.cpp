@@ -63,12 +63,33 @@ void zmq::io_object_t::reset_pollout(handle_t handle_)
 
 void zmq::io_object_t::add_timer(int timeout_, int id_)
 {
-    _poller->add_timer(timeout_, this, id_);
+    const poller_t::timer_handle_t handle = _poller->add_timer(timeout_, this, id_);
+    for (timers_t::iterator it = _timers.begin(); it != _timers.end(); ++it)
+    {
+        if (it->first == id_)
+        {
+            it->second = handle;
+            return;
+        }
+    }
+    _timers.push_back(timer_t(id_, handle));
 }
 
 void zmq::io_object_t::cancel_timer(int id_)
 {
-    _poller->cancel_timer(this, id_);
+    for (timers_t::iterator it = _timers.begin(); it != _timers.end(); ++it)
+    {
+        if (it->first == id_)
+        {
+            _poller->cancel_timer(it->second);
+            *it = _timers.back();
+            _timers.pop_back();
+            return;
+        }
+    }
+
+    //  Timer not found.
+    zmq_assert(false);
 }
 
 void zmq::io_object_t::in_event ()
@@ -2,6 +2,7 @@
 #define __ZMQ_IO_OBJECT_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <vector>
 
 #include "stdint.hpp"
 #include "poller.hpp"
@@ -49,6 +50,12 @@ public:
 private:
     poller_t *_poller;
 
+    //  Handles of the timers added by this object, by timer id. Entries of
+    //  timers that have fired are left in place until the id is reused.
+    typedef std::pair<int, poller_t::timer_handle_t> timer_t;
+    typedef std::vector<timer_t> timers_t;
+    timers_t _timers;
+
 private:
     io_object_t (const io_object_t &);
     const io_object_t &operator= (const io_object_t &);
@@ -10,6 +10,12 @@ zmq::io_thread_t::io_thread_t(ctx_t *ctx_, uint32_t tid_) : object_t(ctx_, tid_)
     _poller = new (std::nothrow) poller_t (*ctx_);
     alloc_assert (_poller);
 
+    _heartbeats = new (std::nothrow) heartbeat_scheduler_t (_poller);
+    alloc_assert (_heartbeats);
+
+    _buffer_pool = new (std::nothrow) buffer_pool_t ();
+    alloc_assert (_buffer_pool);
+
     if (_mailbox.get_fd () != retired_fd) 
     {
         _mailbox_handle = _poller->add_fd(_mailbox.get_fd(), this);
@@ -21,7 +27,11 @@ zmq::io_thread_t::io_thread_t(ctx_t *ctx_, uint32_t tid_) : object_t(ctx_, tid_)
 
 zmq::io_thread_t::~io_thread_t ()
 {
+    //  Deleting the poller joins the thread, which may still be using the
+    //  scheduler until then.
     LIBZMQ_DELETE (_poller);
+    LIBZMQ_DELETE (_heartbeats);
+    LIBZMQ_DELETE (_buffer_pool);
 }
 
 void zmq::io_thread_t::start()
@@ -82,6 +92,35 @@ zmq::poller_t *zmq::io_thread_t::get_poller()
     return _poller;
 }
 
+zmq::heartbeat_scheduler_t *zmq::io_thread_t::get_heartbeat_scheduler ()
+{
+    return _heartbeats;
+}
+
+zmq::buffer_pool_t *zmq::io_thread_t::get_buffer_pool ()
+{
+    return _buffer_pool;
+}
+
+zmq::crypto_pool_t *zmq::io_thread_t::get_crypto_pool ()
+{
+    return get_ctx ()->get_crypto_pool ();
+}
+
+zmq::dns_resolver_t *zmq::io_thread_t::get_dns_resolver ()
+{
+    return get_ctx ()->get_dns_resolver ();
+}
+
+void zmq::io_thread_t::process_job_done (io_job_t *job_)
+{
+    zmq_assert (job_->_io_thread == this);
+    if (job_->_abandoned) {
+        LIBZMQ_DELETE (job_);
+    } else
+        job_->completed ();
+}
+
 void zmq::io_thread_t::process_stop()
 {
     zmq_assert (_mailbox_handle);
@@ -6,6 +6,11 @@
 #include "poller.hpp"
 #include "i_poll_events.hpp"
 #include "mailbox.hpp"
+#include "heartbeat_scheduler.hpp"
+#include "buffer_pool.hpp"
+#include "crypto_pool.hpp"
+#include "dns_resolver.hpp"
+#include "io_job.hpp"
 
 namespace zmq
 {
@@ -40,8 +45,22 @@ public:
     //  Used by io_objects to retrieve the associated poller object.
     poller_t *get_poller ();
 
+    //  Used by engines to register their heartbeats.
+    heartbeat_scheduler_t *get_heartbeat_scheduler ();
+
+    //  Used by engines to borrow their encoder and decoder buffers.
+    buffer_pool_t *get_buffer_pool ();
+
+    //  Used by CURVE servers to run their key exchanges off the thread.
+    //  Returns NULL if the context does the work inline.
+    crypto_pool_t *get_crypto_pool ();
+
+    //  Used by TCP connecters to resolve host names off the thread.
+    dns_resolver_t *get_dns_resolver ();
+
     //  Command handlers.
     void process_stop ();
+    void process_job_done (io_job_t *job_);
 
     //  Returns load experienced by the I/O thread.
     int get_load ();
@@ -56,6 +75,12 @@ private:
     //  I/O multiplexing is performed using a poller object.
     poller_t *_poller;
 
+    //  Heartbeats of the connections handled by the thread.
+    heartbeat_scheduler_t *_heartbeats;
+
+    //  Buffers of the idle connections handled by the thread.
+    buffer_pool_t *_buffer_pool;
+
 private:
     io_thread_t (const io_thread_t &);
 
@@ -59,7 +59,9 @@ class kqueue_t : public worker_poller_base_t
 
     //  "poller" concept.
     handle_t add_fd (fd_t fd_, zmq::i_poll_events *events_);
+    int try_add_fd (fd_t fd_, zmq::i_poll_events *events_, handle_t &handle_);
     void rm_fd (handle_t handle_);
+    int try_rm_fd (handle_t handle_);
     void set_pollin (handle_t handle_);
     void reset_pollin (handle_t handle_);
     void set_pollout (handle_t handle_);
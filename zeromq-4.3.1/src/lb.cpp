@@ -3,8 +3,17 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
-
-zmq::lb_t::lb_t() : _active(0), _current(0), _more(false), _dropping(false)
+#include "options.hpp"
+#include "random.hpp"
+
+zmq::lb_t::lb_t(const options_t &options_) :
+    _options (options_),
+    _active (0),
+    _current (0),
+    _sent_to_current (0),
+    _random (generate_random () | 1),
+    _more (false),
+    _dropping (false)
 {
 
 }
@@ -37,6 +46,7 @@ void zmq::lb_t::pipe_terminated(pipe_t *pipe_)
         _pipes.swap (index, _active);
         if (_current == _active)
             _current = 0;
+        _sent_to_current = 0;
     }
 
     _pipes.erase(pipe_);
@@ -72,6 +82,11 @@ int zmq::lb_t::sendpipe(msg_t *msg_, pipe_t **pipe_)
 
     while (_active > 0) 
     {
+        //  Pick the pipe at the start of each message only, the remaining
+        //  frames follow the first one.
+        if (!_more)
+            select_pipe ();
+
         if (_pipes[_current]->write(msg_)) 
         {
             if (pipe_)
@@ -113,6 +128,7 @@ int zmq::lb_t::sendpipe(msg_t *msg_, pipe_t **pipe_)
             _pipes.swap(_current, _active);
         else
             _current = 0;
+        _sent_to_current = 0;
     }
 
     //  If there are no pipes we cannot send the message.
@@ -129,8 +145,15 @@ int zmq::lb_t::sendpipe(msg_t *msg_, pipe_t **pipe_)
     {
         _pipes[_current]->flush();
 
-        if (++_current >= _active)
-            _current = 0;
+        //  Under ZMQ_LB_WEIGHTED a pipe keeps its turn for as many
+        //  messages as its weight.
+        if (_options.lb_policy != ZMQ_LB_WEIGHTED
+            || ++_sent_to_current >= _pipes[_current]->get_lb_weight ())
+        {
+            _sent_to_current = 0;
+            if (++_current >= _active)
+                _current = 0;
+        }
     }
 
     //  Detach the message from the data buffer.
@@ -158,7 +181,66 @@ bool zmq::lb_t::has_out()
         _pipes.swap(_current, _active);
         if (_current == _active)
             _current = 0;
+        _sent_to_current = 0;
     }
 
     return false;
 }
+
+void zmq::lb_t::select_pipe()
+{
+    switch (_options.lb_policy)
+    {
+        case ZMQ_LB_LEAST_QUEUE:
+        {
+            //  Ties go to the pipe round-robin would pick, so that idle
+            //  peers still share the load evenly.
+            pipes_t::size_type best = _current < _active ? _current : 0;
+            uint64_t best_depth = _pipes[best]->get_queue_depth ();
+            for (pipes_t::size_type i = 0; i != _active && best_depth; ++i)
+            {
+                const uint64_t depth = _pipes[i]->get_queue_depth ();
+                if (depth < best_depth)
+                {
+                    best = i;
+                    best_depth = depth;
+                }
+            }
+            _current = best;
+            break;
+        }
+
+        case ZMQ_LB_POWER_OF_TWO:
+        {
+            if (_active < 2)
+            {
+                _current = 0;
+                break;
+            }
+
+            //  Two distinct random candidates, the less loaded one wins.
+            const pipes_t::size_type first = next_random () % _active;
+            pipes_t::size_type second = next_random () % (_active - 1);
+            if (second >= first)
+                second++;
+            _current = _pipes[second]->get_queue_depth ()
+                           < _pipes[first]->get_queue_depth ()
+                         ? second
+                         : first;
+            break;
+        }
+
+        default:
+            //  Round-robin and weighted round-robin advance _current after
+            //  each message has been sent.
+            break;
+    }
+}
+
+uint32_t zmq::lb_t::next_random()
+{
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+    return _random;
+}
@@ -2,19 +2,25 @@
 #define __ZMQ_LB_HPP_INCLUDED__
 
 #include "array.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
 class msg_t;
 class pipe_t;
+struct options_t;
 
 //  This class manages a set of outbound pipes. On send it load balances
-//  messages fairly among the pipes.
+//  messages among the pipes. By default messages are spread fairly
+//  (round-robin); the owning socket's ZMQ_LB_POLICY option can switch to
+//  picking the pipe with the shortest queue, weighted round-robin or the
+//  shorter queue of two randomly chosen pipes. The policy is applied at
+//  the first frame of each message.
 
 class lb_t
 {
 public:
-    lb_t ();
+    explicit lb_t (const options_t &options_);
     ~lb_t ();
 
     void attach(pipe_t *pipe_);
@@ -32,6 +38,16 @@ public:
     bool has_out ();
 
 private:
+    //  Chooses the active pipe the next message goes to according to the
+    //  load balancing policy and stores its index in _current.
+    void select_pipe ();
+
+    //  Returns a pseudo-random number (xorshift32).
+    uint32_t next_random ();
+
+    //  Options of the owning socket, ZMQ_LB_POLICY is read from here.
+    const options_t &_options;
+
     //  List of outbound pipes.
     typedef array_t<pipe_t, 2> pipes_t;
     pipes_t _pipes;
@@ -43,6 +59,13 @@ private:
     //  Points to the last pipe that the most recent message was sent to.
     pipes_t::size_type _current;
 
+    //  Number of messages sent to the current pipe in its ZMQ_LB_WEIGHTED
+    //  turn. The turn ends when it reaches the pipe's weight.
+    int _sent_to_current;
+
+    //  State of the random generator for ZMQ_LB_POWER_OF_TWO.
+    uint32_t _random;
+
     //  True if last we are in the middle of a multipart message.
     bool _more;
 
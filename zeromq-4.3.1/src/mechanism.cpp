@@ -227,6 +227,8 @@ int zmq::mechanism_t::parse_metadata(const unsigned char *ptr_, size_t length_,
             const int rc = property (name, value, value_length);
             if (rc == -1)
                 return -1;
+            if (rc == 1)
+                continue;
         }
         (zap_flag_ ? _zap_properties : _zmtp_properties)
           .ZMQ_MAP_INSERT_OR_EMPLACE (
@@ -240,6 +242,25 @@ int zmq::mechanism_t::parse_metadata(const unsigned char *ptr_, size_t length_,
     return 0;
 }
 
+int zmq::mechanism_t::batch (msg_t * /* msg_ */)
+{
+    //  Only called if batching is supported.
+    zmq_assert (false);
+    return -1;
+}
+
+int zmq::mechanism_t::flush_batch (msg_t * /* msg_ */)
+{
+    errno = EAGAIN;
+    return -1;
+}
+
+int zmq::mechanism_t::next_decoded (msg_t * /* msg_ */)
+{
+    errno = EAGAIN;
+    return -1;
+}
+
 int zmq::mechanism_t::property (const std::string & /* name_ */,
                                 const void * /* value_ */,
                                 size_t /* length_ */)
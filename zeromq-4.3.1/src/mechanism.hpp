@@ -38,6 +38,19 @@ class mechanism_t
 
     virtual int decode (msg_t *) { return 0; }
 
+    //  Mechanisms may encode the messages waiting to be sent as one, once
+    //  the handshake is done. batch takes a message into the batch and
+    //  returns 0, or returns 1 if the message does not fit: then msg_
+    //  holds the encoded batch, and the message starts the next one.
+    //  flush_batch encodes the messages taken so far.
+    virtual bool batching () const { return false; }
+    virtual int batch (msg_t *msg_);
+    virtual int flush_batch (msg_t *msg_);
+
+    //  Once decode returned the first message of a batch, returns the
+    //  other ones, then fails with EAGAIN.
+    virtual int next_decoded (msg_t *msg_);
+
     //  Notifies mechanism about availability of ZAP message.
     virtual int zap_msg_available () { return 0; }
 
@@ -91,7 +104,9 @@ class mechanism_t
     //  parses a new property. The function should return 0
     //  on success and -1 on error, in which case it should
     //  set errno. Signaling error prevents parser from
-    //  parsing remaining data.
+    //  parsing remaining data. Returning 1 means the property
+    //  is part of the mechanism and is not made available to
+    //  the application.
     //  Derived classes are supposed to override this
     //  method to handle custom processing.
     virtual int
@@ -29,22 +29,124 @@
 
 #include "precompiled.hpp"
 #include "metadata.hpp"
+#include "config.hpp"
+#include "err.hpp"
 
-zmq::metadata_t::metadata_t (const dict_t &dict_) : _ref_cnt (1), _dict (dict_)
+#include <algorithm>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+zmq::metadata_t *zmq::metadata_t::create (const dict_t &dict_)
+{
+    size_t strings_size = 0;
+    for (dict_t::const_iterator it = dict_.begin (); it != dict_.end (); ++it)
+        strings_size += it->first.size () + 1 + it->second.size () + 1;
+    const size_t size = dict_.size () * sizeof (entry_t) + strings_size;
+
+    void *ptr = malloc (sizeof (metadata_t) + size);
+    alloc_assert (ptr);
+    metadata_t *metadata = new (ptr) metadata_t (dict_.size (), size);
+
+    entry_t *entry = const_cast<entry_t *> (metadata->entries ());
+    char *const strings = const_cast<char *> (metadata->strings ());
+    char *pos = strings;
+    for (dict_t::const_iterator it = dict_.begin (); it != dict_.end ();
+         ++it, ++entry) {
+        entry->name = static_cast<uint32_t> (pos - strings);
+        memcpy (pos, it->first.c_str (), it->first.size () + 1);
+        pos += it->first.size () + 1;
+        entry->value = static_cast<uint32_t> (pos - strings);
+        entry->value_size = static_cast<uint32_t> (it->second.size ());
+        memcpy (pos, it->second.c_str (), it->second.size () + 1);
+        pos += it->second.size () + 1;
+
+        const int index = slot (it->first.c_str ());
+        if (index != -1)
+            metadata->_slots[index] = strings + entry->value;
+    }
+    return metadata;
+}
+
+zmq::metadata_t::metadata_t (size_t count_, size_t size_) :
+    _ref_cnt (1),
+    _count (count_),
+    _size (size_)
+{
+    for (int i = 0; i != slot_count; i++)
+        _slots[i] = NULL;
+}
+
+zmq::metadata_t::~metadata_t ()
+{
+}
+
+void zmq::metadata_t::operator delete (void *ptr_)
 {
+    free (ptr_);
 }
 
-const char *zmq::metadata_t::get (const std::string &property_) const
+int zmq::metadata_t::slot (const char *property_)
 {
-    dict_t::const_iterator it = _dict.find (property_);
-    if (it == _dict.end ()) {
-        /** \todo remove this when support for the deprecated name "Identity" is dropped */
-        if (property_ == "Identity")
-            return get (ZMQ_MSG_PROPERTY_ROUTING_ID);
+    //  The standard names differ in their first letter.
+    switch (property_[0]) {
+        case 'R':
+            if (strcmp (property_, ZMQ_MSG_PROPERTY_ROUTING_ID) == 0)
+                return routing_id_slot;
+            break;
+        case 'I':
+            /** \todo remove this when support for the deprecated name "Identity" is dropped */
+            if (strcmp (property_, "Identity") == 0)
+                return routing_id_slot;
+            break;
+        case 'S':
+            if (strcmp (property_, ZMQ_MSG_PROPERTY_SOCKET_TYPE) == 0)
+                return socket_type_slot;
+            break;
+        case 'U':
+            if (strcmp (property_, ZMQ_MSG_PROPERTY_USER_ID) == 0)
+                return user_id_slot;
+            break;
+        case 'P':
+            if (strcmp (property_, ZMQ_MSG_PROPERTY_PEER_ADDRESS) == 0)
+                return peer_address_slot;
+            break;
+    }
+    return -1;
+}
 
-        return NULL;
+const zmq::metadata_t::entry_t *zmq::metadata_t::entries () const
+{
+    return reinterpret_cast<const entry_t *> (this + 1);
+}
+
+const char *zmq::metadata_t::strings () const
+{
+    return reinterpret_cast<const char *> (entries () + _count);
+}
+
+const char *zmq::metadata_t::get (const char *property_) const
+{
+    const int index = slot (property_);
+    if (index != -1)
+        return _slots[index];
+
+    //  Entries are sorted by name, as they come from a map.
+    const entry_t *const entries_ = entries ();
+    const char *const strings_ = strings ();
+    size_t low = 0;
+    size_t high = _count;
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        const int rc = strcmp (property_, strings_ + entries_[middle].name);
+        if (rc == 0)
+            return strings_ + entries_[middle].value;
+        if (rc < 0)
+            high = middle;
+        else
+            low = middle + 1;
     }
-    return it->second.c_str ();
+    return NULL;
 }
 
 void zmq::metadata_t::add_ref ()
@@ -56,3 +158,78 @@ bool zmq::metadata_t::drop_ref ()
 {
     return !_ref_cnt.sub (1);
 }
+
+bool zmq::metadata_t::unique () const
+{
+    return _ref_cnt.get () == 1;
+}
+
+//  The block holds offsets rather than pointers, so ordering by its bytes
+//  orders by the properties, value sizes included.
+
+bool zmq::metadata_t::less (const metadata_t &other_) const
+{
+    if (_size != other_._size)
+        return _size < other_._size;
+    if (_count != other_._count)
+        return _count < other_._count;
+    return memcmp (this + 1, &other_ + 1, _size) < 0;
+}
+
+zmq::metadata_registry_t::metadata_registry_t () :
+    _sweep_size (min_metadata_sweep)
+{
+}
+
+zmq::metadata_registry_t::~metadata_registry_t ()
+{
+    for (metadata_set_t::iterator it = _metadata.begin ();
+         it != _metadata.end (); ++it) {
+        metadata_t *metadata = *it;
+        if (metadata->drop_ref ())
+            LIBZMQ_DELETE (metadata);
+    }
+}
+
+zmq::metadata_t *zmq::metadata_registry_t::intern (const dict_t &dict_)
+{
+    metadata_t *metadata = metadata_t::create (dict_);
+
+    scoped_lock_t locker (_sync);
+
+    const metadata_set_t::iterator it = _metadata.find (metadata);
+    if (it != _metadata.end ()) {
+        LIBZMQ_DELETE (metadata);
+        (*it)->add_ref ();
+        return *it;
+    }
+
+    if (_metadata.size () >= _sweep_size) {
+        drop_unused ();
+        _sweep_size = std::max (static_cast<size_t> (min_metadata_sweep),
+                                2 * _metadata.size ());
+    }
+
+    //  Beyond the limit the connection keeps a copy of its own.
+    if (_metadata.size () < max_interned_metadata) {
+        metadata->add_ref ();
+        _metadata.insert (metadata);
+    }
+    return metadata;
+}
+
+void zmq::metadata_registry_t::drop_unused ()
+{
+    //  Only messages and engines holding a reference can copy it, so
+    //  metadata the registry alone refers to cannot be revived.
+    for (metadata_set_t::iterator it = _metadata.begin ();
+         it != _metadata.end ();) {
+        metadata_t *metadata = *it;
+        if (metadata->unique ()) {
+            _metadata.erase (it++);
+            metadata->drop_ref ();
+            LIBZMQ_DELETE (metadata);
+        } else
+            ++it;
+    }
+}
@@ -31,22 +31,37 @@
 #define __ZMQ_METADATA_HPP_INCLUDED__
 
 #include <map>
+#include <set>
 #include <string>
 
 #include "atomic_counter.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
+//  Immutable set of properties of a connection, shared by all the messages
+//  received on it. The properties are laid out in a single block right
+//  after the object: an index of entries sorted by name, then the names
+//  and values themselves. The standard properties have a slot each, so
+//  looking them up does not search the index.
+
 class metadata_t
 {
   public:
     typedef std::map<std::string, std::string> dict_t;
 
-    metadata_t (const dict_t &dict_);
+    //  Allocates metadata holding a copy of the dictionary, with a
+    //  reference count of 1.
+    static metadata_t *create (const dict_t &dict_);
+
+    ~metadata_t ();
+
+    static void operator delete (void *ptr_);
 
     //  Returns pointer to property value or NULL if
     //  property is not found.
-    const char *get (const std::string &property_) const;
+    const char *get (const char *property_) const;
 
     void add_ref ();
 
@@ -54,15 +69,90 @@ class metadata_t
     //  counter drops to zero.
     bool drop_ref ();
 
+    //  Returns true if there is no other reference than the caller's.
+    bool unique () const;
+
+    //  Orders metadata by their properties.
+    bool less (const metadata_t &other_) const;
+
   private:
-    metadata_t (const metadata_t &);
-    metadata_t &operator= (const metadata_t &);
+    enum
+    {
+        routing_id_slot,
+        socket_type_slot,
+        user_id_slot,
+        peer_address_slot,
+        slot_count
+    };
+
+    //  Position of a property in the block.
+    struct entry_t
+    {
+        uint32_t name;
+        uint32_t value;
+        uint32_t value_size;
+    };
+
+    metadata_t (size_t count_, size_t size_);
+
+    //  Returns the slot of a standard property, or -1.
+    static int slot (const char *property_);
+
+    const entry_t *entries () const;
+    const char *strings () const;
 
     //  Reference counter.
     atomic_counter_t _ref_cnt;
 
-    //  Dictionary holding metadata.
-    const dict_t _dict;
+    //  Number of entries and size of the block after the object.
+    size_t _count;
+    size_t _size;
+
+    //  Values of the standard properties, or NULL.
+    const char *_slots[slot_count];
+
+    metadata_t (const metadata_t &);
+    metadata_t &operator= (const metadata_t &);
+};
+
+//  Metadata in use by the connections of a context, so that connections
+//  with identical properties share one copy. The registry holds a
+//  reference to each; metadata only it refers to are dropped as more are
+//  registered.
+
+class metadata_registry_t
+{
+  public:
+    typedef metadata_t::dict_t dict_t;
+
+    metadata_registry_t ();
+    ~metadata_registry_t ();
+
+    //  Returns metadata holding the properties, with a reference for the
+    //  caller.
+    metadata_t *intern (const dict_t &dict_);
+
+  private:
+    struct less_t
+    {
+        bool operator() (const metadata_t *a_, const metadata_t *b_) const
+        {
+            return a_->less (*b_);
+        }
+    };
+
+    void drop_unused ();
+
+    typedef std::set<metadata_t *, less_t> metadata_set_t;
+    metadata_set_t _metadata;
+
+    //  Number of metadata at which unused ones are dropped next.
+    size_t _sweep_size;
+
+    mutex_t _sync;
+
+    metadata_registry_t (const metadata_registry_t &);
+    const metadata_registry_t &operator= (const metadata_registry_t &);
 };
 }
 
@@ -76,6 +76,8 @@ public:
     int copy (msg_t &src_);
     void *data ();
     size_t size () const;
+    //  Shortens the message to its first new_size_ bytes.
+    void shrink (size_t new_size_);
     unsigned char flags () const;
     void set_flags (unsigned char flags_);
     void reset_flags (unsigned char flags_);
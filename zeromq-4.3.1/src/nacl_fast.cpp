@@ -0,0 +1,1694 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "nacl_fast.hpp"
+
+#if defined(ZMQ_USE_TWEETNACL)
+
+#include <string.h>
+#include <vector>
+
+#include "err.hpp"
+#include "stdint.hpp"
+#include "tweetnacl.h"
+
+#if (defined __x86_64__ || defined __i386__ || defined _M_X64                 \
+     || defined _M_IX86)                                                       \
+  && (defined _MSC_VER || defined __clang__                                    \
+      || (defined __GNUC__ && __GNUC__ >= 5))
+#define ZMQ_NACL_HAVE_X86_SIMD
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined _MSC_VER
+#include <intrin.h>
+#define ZMQ_NACL_TARGET_SSE2
+#define ZMQ_NACL_TARGET_AVX2
+#define ZMQ_NACL_TARGET_AESNI
+#else
+#define ZMQ_NACL_TARGET_SSE2 __attribute__ ((target ("sse2")))
+#define ZMQ_NACL_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#define ZMQ_NACL_TARGET_AESNI __attribute__ ((target ("aes,pclmul,ssse3")))
+#endif
+#endif
+
+#if defined __SIZEOF_INT128__
+#define ZMQ_NACL_HAVE_UINT128
+__extension__ typedef unsigned __int128 nacl_uint128_t;
+#endif
+
+static inline uint32_t load32_le (const unsigned char *p_)
+{
+    return static_cast<uint32_t> (p_[0])
+           | (static_cast<uint32_t> (p_[1]) << 8)
+           | (static_cast<uint32_t> (p_[2]) << 16)
+           | (static_cast<uint32_t> (p_[3]) << 24);
+}
+
+static inline void store32_le (unsigned char *p_, uint32_t v_)
+{
+    p_[0] = static_cast<unsigned char> (v_);
+    p_[1] = static_cast<unsigned char> (v_ >> 8);
+    p_[2] = static_cast<unsigned char> (v_ >> 16);
+    p_[3] = static_cast<unsigned char> (v_ >> 24);
+}
+
+static inline uint64_t load64_le (const unsigned char *p_)
+{
+    return static_cast<uint64_t> (load32_le (p_))
+           | (static_cast<uint64_t> (load32_le (p_ + 4)) << 32);
+}
+
+static inline void store64_le (unsigned char *p_, uint64_t v_)
+{
+    store32_le (p_, static_cast<uint32_t> (v_));
+    store32_le (p_ + 4, static_cast<uint32_t> (v_ >> 32));
+}
+
+static inline uint32_t rotl32 (uint32_t x_, int n_)
+{
+    return (x_ << n_) | (x_ >> (32 - n_));
+}
+
+//  "expand 32-byte k"
+static const uint32_t sigma[4] = {0x61707865, 0x3320646e, 0x79622d32,
+                                  0x6b206574};
+
+//  The Salsa20 double round, in terms of a quarter round QR operating on
+//  four state words.
+#define SALSA20_DOUBLE_ROUND(QR)                                               \
+    QR (x0, x4, x8, x12);                                                      \
+    QR (x5, x9, x13, x1);                                                      \
+    QR (x10, x14, x2, x6);                                                     \
+    QR (x15, x3, x7, x11);                                                     \
+    QR (x0, x1, x2, x3);                                                       \
+    QR (x5, x6, x7, x4);                                                       \
+    QR (x10, x11, x8, x9);                                                     \
+    QR (x15, x12, x13, x14);
+
+#define SALSA20_QR(a, b, c, d)                                                 \
+    b ^= rotl32 (a + d, 7);                                                    \
+    c ^= rotl32 (b + a, 9);                                                    \
+    d ^= rotl32 (c + b, 13);                                                   \
+    a ^= rotl32 (d + c, 18)
+
+//  Salsa20 state: constants, key, nonce and 64-bit block counter.
+static void salsa20_init (uint32_t *input_,
+                          const unsigned char *n_,
+                          const unsigned char *k_)
+{
+    input_[0] = sigma[0];
+    for (int i = 0; i != 4; i++)
+        input_[1 + i] = load32_le (k_ + 4 * i);
+    input_[5] = sigma[1];
+    input_[6] = load32_le (n_);
+    input_[7] = load32_le (n_ + 4);
+    input_[8] = 0;
+    input_[9] = 0;
+    input_[10] = sigma[2];
+    for (int i = 0; i != 4; i++)
+        input_[11 + i] = load32_le (k_ + 16 + 4 * i);
+    input_[15] = sigma[3];
+}
+
+static inline void salsa20_advance (uint32_t *input_, uint32_t blocks_)
+{
+    const uint32_t low = input_[8];
+    input_[8] = low + blocks_;
+    if (input_[8] < low)
+        input_[9]++;
+}
+
+static void salsa20_block (unsigned char *out_, const uint32_t *input_)
+{
+    uint32_t x0 = input_[0], x1 = input_[1], x2 = input_[2], x3 = input_[3],
+             x4 = input_[4], x5 = input_[5], x6 = input_[6], x7 = input_[7],
+             x8 = input_[8], x9 = input_[9], x10 = input_[10],
+             x11 = input_[11], x12 = input_[12], x13 = input_[13],
+             x14 = input_[14], x15 = input_[15];
+
+    for (int i = 0; i != 10; i++) {
+        SALSA20_DOUBLE_ROUND (SALSA20_QR)
+    }
+
+    store32_le (out_, x0 + input_[0]);
+    store32_le (out_ + 4, x1 + input_[1]);
+    store32_le (out_ + 8, x2 + input_[2]);
+    store32_le (out_ + 12, x3 + input_[3]);
+    store32_le (out_ + 16, x4 + input_[4]);
+    store32_le (out_ + 20, x5 + input_[5]);
+    store32_le (out_ + 24, x6 + input_[6]);
+    store32_le (out_ + 28, x7 + input_[7]);
+    store32_le (out_ + 32, x8 + input_[8]);
+    store32_le (out_ + 36, x9 + input_[9]);
+    store32_le (out_ + 40, x10 + input_[10]);
+    store32_le (out_ + 44, x11 + input_[11]);
+    store32_le (out_ + 48, x12 + input_[12]);
+    store32_le (out_ + 52, x13 + input_[13]);
+    store32_le (out_ + 56, x14 + input_[14]);
+    store32_le (out_ + 60, x15 + input_[15]);
+}
+
+//  Derives the XSalsa20 subkey from the key and the first 16 bytes of the
+//  nonce.
+static void hsalsa20 (unsigned char *out_,
+                      const unsigned char *n_,
+                      const unsigned char *k_)
+{
+    uint32_t x0 = sigma[0], x1 = load32_le (k_), x2 = load32_le (k_ + 4),
+             x3 = load32_le (k_ + 8), x4 = load32_le (k_ + 12), x5 = sigma[1],
+             x6 = load32_le (n_), x7 = load32_le (n_ + 4),
+             x8 = load32_le (n_ + 8), x9 = load32_le (n_ + 12),
+             x10 = sigma[2], x11 = load32_le (k_ + 16),
+             x12 = load32_le (k_ + 20), x13 = load32_le (k_ + 24),
+             x14 = load32_le (k_ + 28), x15 = sigma[3];
+
+    for (int i = 0; i != 10; i++) {
+        SALSA20_DOUBLE_ROUND (SALSA20_QR)
+    }
+
+    store32_le (out_, x0);
+    store32_le (out_ + 4, x5);
+    store32_le (out_ + 8, x10);
+    store32_le (out_ + 12, x15);
+    store32_le (out_ + 16, x6);
+    store32_le (out_ + 20, x7);
+    store32_le (out_ + 24, x8);
+    store32_le (out_ + 28, x9);
+}
+
+//  Each implementation encrypts as many whole groups of blocks as it
+//  handles at once, advances the counter and returns the number of bytes
+//  done. The message may be NULL to get the key stream itself.
+
+static size_t salsa20_blocks_scalar (unsigned char *c_,
+                                     const unsigned char *m_,
+                                     size_t len_,
+                                     uint32_t *input_)
+{
+    unsigned char block[64];
+    size_t done = 0;
+    while (len_ - done >= 64) {
+        salsa20_block (block, input_);
+        if (m_)
+            for (int i = 0; i != 64; i++)
+                c_[done + i] = m_[done + i] ^ block[i];
+        else
+            memcpy (c_ + done, block, 64);
+        salsa20_advance (input_, 1);
+        done += 64;
+    }
+    return done;
+}
+
+//  ChaCha20 as in RFC 8439, with a 32-bit block counter and a 96-bit
+//  nonce. The state words are laid out as for Salsa20 so that the double
+//  round works on the same variables.
+#define CHACHA20_DOUBLE_ROUND(QR)                                              \
+    QR (x0, x4, x8, x12);                                                      \
+    QR (x1, x5, x9, x13);                                                      \
+    QR (x2, x6, x10, x14);                                                     \
+    QR (x3, x7, x11, x15);                                                     \
+    QR (x0, x5, x10, x15);                                                     \
+    QR (x1, x6, x11, x12);                                                     \
+    QR (x2, x7, x8, x13);                                                      \
+    QR (x3, x4, x9, x14);
+
+#define CHACHA20_QR(a, b, c, d)                                                \
+    a += b;                                                                    \
+    d = rotl32 (d ^ a, 16);                                                    \
+    c += d;                                                                    \
+    b = rotl32 (b ^ c, 12);                                                    \
+    a += b;                                                                    \
+    d = rotl32 (d ^ a, 8);                                                     \
+    c += d;                                                                    \
+    b = rotl32 (b ^ c, 7)
+
+//  ChaCha20 state: constants, key, block counter and nonce.
+static void chacha20_init (uint32_t *input_,
+                           const unsigned char *n_,
+                           const unsigned char *k_,
+                           uint32_t counter_)
+{
+    for (int i = 0; i != 4; i++)
+        input_[i] = sigma[i];
+    for (int i = 0; i != 8; i++)
+        input_[4 + i] = load32_le (k_ + 4 * i);
+    input_[12] = counter_;
+    for (int i = 0; i != 3; i++)
+        input_[13 + i] = load32_le (n_ + 4 * i);
+}
+
+static void chacha20_block (unsigned char *out_, const uint32_t *input_)
+{
+    uint32_t x0 = input_[0], x1 = input_[1], x2 = input_[2], x3 = input_[3],
+             x4 = input_[4], x5 = input_[5], x6 = input_[6], x7 = input_[7],
+             x8 = input_[8], x9 = input_[9], x10 = input_[10],
+             x11 = input_[11], x12 = input_[12], x13 = input_[13],
+             x14 = input_[14], x15 = input_[15];
+
+    for (int i = 0; i != 10; i++) {
+        CHACHA20_DOUBLE_ROUND (CHACHA20_QR)
+    }
+
+    const uint32_t x[16] = {x0, x1, x2,  x3,  x4,  x5,  x6,  x7,
+                            x8, x9, x10, x11, x12, x13, x14, x15};
+    for (int i = 0; i != 16; i++)
+        store32_le (out_ + 4 * i, x[i] + input_[i]);
+}
+
+static size_t chacha20_blocks_scalar (unsigned char *c_,
+                                      const unsigned char *m_,
+                                      size_t len_,
+                                      uint32_t *input_)
+{
+    unsigned char block[64];
+    size_t done = 0;
+    while (len_ - done >= 64) {
+        chacha20_block (block, input_);
+        for (int i = 0; i != 64; i++)
+            c_[done + i] = m_[done + i] ^ block[i];
+        input_[12]++;
+        done += 64;
+    }
+    return done;
+}
+
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+
+//  The vectorized implementations run the blocks side by side, lane j of
+//  the vector for a state word holding that word of block j. The blocks
+//  are transposed back four words at a time.
+
+#define SALSA20_ROTL_SSE2(v, n)                                                \
+    _mm_or_si128 (_mm_slli_epi32 (v, n), _mm_srli_epi32 (v, 32 - (n)))
+
+#define SALSA20_QR_SSE2(a, b, c, d)                                            \
+    b = _mm_xor_si128 (b, SALSA20_ROTL_SSE2 (_mm_add_epi32 (a, d), 7));        \
+    c = _mm_xor_si128 (c, SALSA20_ROTL_SSE2 (_mm_add_epi32 (b, a), 9));        \
+    d = _mm_xor_si128 (d, SALSA20_ROTL_SSE2 (_mm_add_epi32 (c, b), 13));       \
+    a = _mm_xor_si128 (a, SALSA20_ROTL_SSE2 (_mm_add_epi32 (d, c), 18))
+
+ZMQ_NACL_TARGET_SSE2 static inline void
+salsa20_store_sse2 (unsigned char *c_,
+                    const unsigned char *m_,
+                    __m128i a_,
+                    __m128i b_,
+                    __m128i c,
+                    __m128i d_)
+{
+    const __m128i t0 = _mm_unpacklo_epi32 (a_, b_);
+    const __m128i t1 = _mm_unpacklo_epi32 (c, d_);
+    const __m128i t2 = _mm_unpackhi_epi32 (a_, b_);
+    const __m128i t3 = _mm_unpackhi_epi32 (c, d_);
+    __m128i blocks[4];
+    blocks[0] = _mm_unpacklo_epi64 (t0, t1);
+    blocks[1] = _mm_unpackhi_epi64 (t0, t1);
+    blocks[2] = _mm_unpacklo_epi64 (t2, t3);
+    blocks[3] = _mm_unpackhi_epi64 (t2, t3);
+    for (int j = 0; j != 4; j++) {
+        __m128i v = blocks[j];
+        if (m_)
+            v = _mm_xor_si128 (
+              v, _mm_loadu_si128 (
+                   reinterpret_cast<const __m128i *> (m_ + 64 * j)));
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (c_ + 64 * j), v);
+    }
+}
+
+ZMQ_NACL_TARGET_SSE2 static size_t salsa20_blocks_sse2 (
+  unsigned char *c_, const unsigned char *m_, size_t len_, uint32_t *input_)
+{
+    size_t done = 0;
+    while (len_ - done >= 256) {
+        const uint64_t counter =
+          input_[8] | (static_cast<uint64_t> (input_[9]) << 32);
+        const uint64_t c1 = counter + 1, c2 = counter + 2, c3 = counter + 3;
+
+        __m128i in[16];
+        for (int i = 0; i != 16; i++)
+            in[i] = _mm_set1_epi32 (static_cast<int> (input_[i]));
+        in[8] = _mm_set_epi32 (static_cast<int> (c3), static_cast<int> (c2),
+                               static_cast<int> (c1),
+                               static_cast<int> (counter));
+        in[9] = _mm_set_epi32 (
+          static_cast<int> (c3 >> 32), static_cast<int> (c2 >> 32),
+          static_cast<int> (c1 >> 32), static_cast<int> (counter >> 32));
+
+        __m128i x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3], x4 = in[4],
+                x5 = in[5], x6 = in[6], x7 = in[7], x8 = in[8], x9 = in[9],
+                x10 = in[10], x11 = in[11], x12 = in[12], x13 = in[13],
+                x14 = in[14], x15 = in[15];
+
+        for (int i = 0; i != 10; i++) {
+            SALSA20_DOUBLE_ROUND (SALSA20_QR_SSE2)
+        }
+
+        const unsigned char *m = m_ ? m_ + done : NULL;
+        unsigned char *c = c_ + done;
+        salsa20_store_sse2 (
+          c, m, _mm_add_epi32 (x0, in[0]), _mm_add_epi32 (x1, in[1]),
+          _mm_add_epi32 (x2, in[2]), _mm_add_epi32 (x3, in[3]));
+        salsa20_store_sse2 (
+          c + 16, m ? m + 16 : NULL, _mm_add_epi32 (x4, in[4]),
+          _mm_add_epi32 (x5, in[5]), _mm_add_epi32 (x6, in[6]),
+          _mm_add_epi32 (x7, in[7]));
+        salsa20_store_sse2 (
+          c + 32, m ? m + 32 : NULL, _mm_add_epi32 (x8, in[8]),
+          _mm_add_epi32 (x9, in[9]), _mm_add_epi32 (x10, in[10]),
+          _mm_add_epi32 (x11, in[11]));
+        salsa20_store_sse2 (
+          c + 48, m ? m + 48 : NULL, _mm_add_epi32 (x12, in[12]),
+          _mm_add_epi32 (x13, in[13]), _mm_add_epi32 (x14, in[14]),
+          _mm_add_epi32 (x15, in[15]));
+
+        salsa20_advance (input_, 4);
+        done += 256;
+    }
+    return done;
+}
+
+#define SALSA20_ROTL_AVX2(v, n)                                                \
+    _mm256_or_si256 (_mm256_slli_epi32 (v, n), _mm256_srli_epi32 (v, 32 - (n)))
+
+#define SALSA20_QR_AVX2(a, b, c, d)                                            \
+    b = _mm256_xor_si256 (b, SALSA20_ROTL_AVX2 (_mm256_add_epi32 (a, d), 7));  \
+    c = _mm256_xor_si256 (c, SALSA20_ROTL_AVX2 (_mm256_add_epi32 (b, a), 9));  \
+    d = _mm256_xor_si256 (d, SALSA20_ROTL_AVX2 (_mm256_add_epi32 (c, b), 13)); \
+    a = _mm256_xor_si256 (a, SALSA20_ROTL_AVX2 (_mm256_add_epi32 (d, c), 18))
+
+//  Like salsa20_store_sse2, each 128-bit lane holding four blocks.
+ZMQ_NACL_TARGET_AVX2 static inline void
+salsa20_store_avx2 (unsigned char *c_,
+                    const unsigned char *m_,
+                    __m256i a_,
+                    __m256i b_,
+                    __m256i c,
+                    __m256i d_)
+{
+    const __m256i t0 = _mm256_unpacklo_epi32 (a_, b_);
+    const __m256i t1 = _mm256_unpacklo_epi32 (c, d_);
+    const __m256i t2 = _mm256_unpackhi_epi32 (a_, b_);
+    const __m256i t3 = _mm256_unpackhi_epi32 (c, d_);
+    __m256i blocks[4];
+    blocks[0] = _mm256_unpacklo_epi64 (t0, t1);
+    blocks[1] = _mm256_unpackhi_epi64 (t0, t1);
+    blocks[2] = _mm256_unpacklo_epi64 (t2, t3);
+    blocks[3] = _mm256_unpackhi_epi64 (t2, t3);
+    for (int j = 0; j != 4; j++) {
+        __m128i lo = _mm256_castsi256_si128 (blocks[j]);
+        __m128i hi = _mm256_extracti128_si256 (blocks[j], 1);
+        if (m_) {
+            lo = _mm_xor_si128 (
+              lo, _mm_loadu_si128 (
+                    reinterpret_cast<const __m128i *> (m_ + 64 * j)));
+            hi = _mm_xor_si128 (
+              hi, _mm_loadu_si128 (
+                    reinterpret_cast<const __m128i *> (m_ + 64 * (j + 4))));
+        }
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (c_ + 64 * j), lo);
+        _mm_storeu_si128 (reinterpret_cast<__m128i *> (c_ + 64 * (j + 4)),
+                          hi);
+    }
+}
+
+ZMQ_NACL_TARGET_AVX2 static size_t salsa20_blocks_avx2 (
+  unsigned char *c_, const unsigned char *m_, size_t len_, uint32_t *input_)
+{
+    size_t done = 0;
+    while (len_ - done >= 512) {
+        const uint64_t counter =
+          input_[8] | (static_cast<uint64_t> (input_[9]) << 32);
+        uint64_t counters[8];
+        for (int j = 0; j != 8; j++)
+            counters[j] = counter + j;
+
+        __m256i in[16];
+        for (int i = 0; i != 16; i++)
+            in[i] = _mm256_set1_epi32 (static_cast<int> (input_[i]));
+        in[8] = _mm256_set_epi32 (
+          static_cast<int> (counters[7]), static_cast<int> (counters[6]),
+          static_cast<int> (counters[5]), static_cast<int> (counters[4]),
+          static_cast<int> (counters[3]), static_cast<int> (counters[2]),
+          static_cast<int> (counters[1]), static_cast<int> (counters[0]));
+        in[9] = _mm256_set_epi32 (static_cast<int> (counters[7] >> 32),
+                                  static_cast<int> (counters[6] >> 32),
+                                  static_cast<int> (counters[5] >> 32),
+                                  static_cast<int> (counters[4] >> 32),
+                                  static_cast<int> (counters[3] >> 32),
+                                  static_cast<int> (counters[2] >> 32),
+                                  static_cast<int> (counters[1] >> 32),
+                                  static_cast<int> (counters[0] >> 32));
+
+        __m256i x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3], x4 = in[4],
+                x5 = in[5], x6 = in[6], x7 = in[7], x8 = in[8], x9 = in[9],
+                x10 = in[10], x11 = in[11], x12 = in[12], x13 = in[13],
+                x14 = in[14], x15 = in[15];
+
+        for (int i = 0; i != 10; i++) {
+            SALSA20_DOUBLE_ROUND (SALSA20_QR_AVX2)
+        }
+
+        const unsigned char *m = m_ ? m_ + done : NULL;
+        unsigned char *c = c_ + done;
+        salsa20_store_avx2 (
+          c, m, _mm256_add_epi32 (x0, in[0]), _mm256_add_epi32 (x1, in[1]),
+          _mm256_add_epi32 (x2, in[2]), _mm256_add_epi32 (x3, in[3]));
+        salsa20_store_avx2 (
+          c + 16, m ? m + 16 : NULL, _mm256_add_epi32 (x4, in[4]),
+          _mm256_add_epi32 (x5, in[5]), _mm256_add_epi32 (x6, in[6]),
+          _mm256_add_epi32 (x7, in[7]));
+        salsa20_store_avx2 (
+          c + 32, m ? m + 32 : NULL, _mm256_add_epi32 (x8, in[8]),
+          _mm256_add_epi32 (x9, in[9]), _mm256_add_epi32 (x10, in[10]),
+          _mm256_add_epi32 (x11, in[11]));
+        salsa20_store_avx2 (
+          c + 48, m ? m + 48 : NULL, _mm256_add_epi32 (x12, in[12]),
+          _mm256_add_epi32 (x13, in[13]), _mm256_add_epi32 (x14, in[14]),
+          _mm256_add_epi32 (x15, in[15]));
+
+        salsa20_advance (input_, 8);
+        done += 512;
+    }
+    return done;
+}
+
+#define CHACHA20_QR_SSE2(a, b, c, d)                                           \
+    a = _mm_add_epi32 (a, b);                                                  \
+    d = SALSA20_ROTL_SSE2 (_mm_xor_si128 (d, a), 16);                          \
+    c = _mm_add_epi32 (c, d);                                                  \
+    b = SALSA20_ROTL_SSE2 (_mm_xor_si128 (b, c), 12);                          \
+    a = _mm_add_epi32 (a, b);                                                  \
+    d = SALSA20_ROTL_SSE2 (_mm_xor_si128 (d, a), 8);                           \
+    c = _mm_add_epi32 (c, d);                                                  \
+    b = SALSA20_ROTL_SSE2 (_mm_xor_si128 (b, c), 7)
+
+//  ChaCha20 with the Salsa20 store functions, which only transpose and
+//  xor the state.
+ZMQ_NACL_TARGET_SSE2 static size_t chacha20_blocks_sse2 (
+  unsigned char *c_, const unsigned char *m_, size_t len_, uint32_t *input_)
+{
+    size_t done = 0;
+    while (len_ - done >= 256) {
+        __m128i in[16];
+        for (int i = 0; i != 16; i++)
+            in[i] = _mm_set1_epi32 (static_cast<int> (input_[i]));
+        in[12] = _mm_add_epi32 (in[12], _mm_set_epi32 (3, 2, 1, 0));
+
+        __m128i x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3], x4 = in[4],
+                x5 = in[5], x6 = in[6], x7 = in[7], x8 = in[8], x9 = in[9],
+                x10 = in[10], x11 = in[11], x12 = in[12], x13 = in[13],
+                x14 = in[14], x15 = in[15];
+
+        for (int i = 0; i != 10; i++) {
+            CHACHA20_DOUBLE_ROUND (CHACHA20_QR_SSE2)
+        }
+
+        const unsigned char *m = m_ + done;
+        unsigned char *c = c_ + done;
+        salsa20_store_sse2 (
+          c, m, _mm_add_epi32 (x0, in[0]), _mm_add_epi32 (x1, in[1]),
+          _mm_add_epi32 (x2, in[2]), _mm_add_epi32 (x3, in[3]));
+        salsa20_store_sse2 (c + 16, m + 16, _mm_add_epi32 (x4, in[4]),
+                            _mm_add_epi32 (x5, in[5]),
+                            _mm_add_epi32 (x6, in[6]),
+                            _mm_add_epi32 (x7, in[7]));
+        salsa20_store_sse2 (c + 32, m + 32, _mm_add_epi32 (x8, in[8]),
+                            _mm_add_epi32 (x9, in[9]),
+                            _mm_add_epi32 (x10, in[10]),
+                            _mm_add_epi32 (x11, in[11]));
+        salsa20_store_sse2 (c + 48, m + 48, _mm_add_epi32 (x12, in[12]),
+                            _mm_add_epi32 (x13, in[13]),
+                            _mm_add_epi32 (x14, in[14]),
+                            _mm_add_epi32 (x15, in[15]));
+
+        input_[12] += 4;
+        done += 256;
+    }
+    return done;
+}
+
+#define CHACHA20_QR_AVX2(a, b, c, d)                                           \
+    a = _mm256_add_epi32 (a, b);                                               \
+    d = SALSA20_ROTL_AVX2 (_mm256_xor_si256 (d, a), 16);                       \
+    c = _mm256_add_epi32 (c, d);                                               \
+    b = SALSA20_ROTL_AVX2 (_mm256_xor_si256 (b, c), 12);                       \
+    a = _mm256_add_epi32 (a, b);                                               \
+    d = SALSA20_ROTL_AVX2 (_mm256_xor_si256 (d, a), 8);                        \
+    c = _mm256_add_epi32 (c, d);                                               \
+    b = SALSA20_ROTL_AVX2 (_mm256_xor_si256 (b, c), 7)
+
+ZMQ_NACL_TARGET_AVX2 static size_t chacha20_blocks_avx2 (
+  unsigned char *c_, const unsigned char *m_, size_t len_, uint32_t *input_)
+{
+    size_t done = 0;
+    while (len_ - done >= 512) {
+        __m256i in[16];
+        for (int i = 0; i != 16; i++)
+            in[i] = _mm256_set1_epi32 (static_cast<int> (input_[i]));
+        in[12] =
+          _mm256_add_epi32 (in[12], _mm256_set_epi32 (7, 6, 5, 4, 3, 2, 1, 0));
+
+        __m256i x0 = in[0], x1 = in[1], x2 = in[2], x3 = in[3], x4 = in[4],
+                x5 = in[5], x6 = in[6], x7 = in[7], x8 = in[8], x9 = in[9],
+                x10 = in[10], x11 = in[11], x12 = in[12], x13 = in[13],
+                x14 = in[14], x15 = in[15];
+
+        for (int i = 0; i != 10; i++) {
+            CHACHA20_DOUBLE_ROUND (CHACHA20_QR_AVX2)
+        }
+
+        const unsigned char *m = m_ + done;
+        unsigned char *c = c_ + done;
+        salsa20_store_avx2 (
+          c, m, _mm256_add_epi32 (x0, in[0]), _mm256_add_epi32 (x1, in[1]),
+          _mm256_add_epi32 (x2, in[2]), _mm256_add_epi32 (x3, in[3]));
+        salsa20_store_avx2 (c + 16, m + 16, _mm256_add_epi32 (x4, in[4]),
+                            _mm256_add_epi32 (x5, in[5]),
+                            _mm256_add_epi32 (x6, in[6]),
+                            _mm256_add_epi32 (x7, in[7]));
+        salsa20_store_avx2 (c + 32, m + 32, _mm256_add_epi32 (x8, in[8]),
+                            _mm256_add_epi32 (x9, in[9]),
+                            _mm256_add_epi32 (x10, in[10]),
+                            _mm256_add_epi32 (x11, in[11]));
+        salsa20_store_avx2 (c + 48, m + 48, _mm256_add_epi32 (x12, in[12]),
+                            _mm256_add_epi32 (x13, in[13]),
+                            _mm256_add_epi32 (x14, in[14]),
+                            _mm256_add_epi32 (x15, in[15]));
+
+        input_[12] += 8;
+        done += 512;
+    }
+    return done;
+}
+
+//  AES-256 in counter mode and GHASH, with AES-NI and PCLMULQDQ. GHASH
+//  works on byte-reversed blocks, after the Intel carry-less
+//  multiplication white paper.
+
+static const size_t aes256_rounds = 14;
+
+ZMQ_NACL_TARGET_AESNI static inline __m128i aes256_expand_even (__m128i a_,
+                                                                __m128i t_)
+{
+    a_ = _mm_xor_si128 (a_, _mm_slli_si128 (a_, 4));
+    a_ = _mm_xor_si128 (a_, _mm_slli_si128 (a_, 8));
+    return _mm_xor_si128 (a_, _mm_shuffle_epi32 (t_, 0xff));
+}
+
+ZMQ_NACL_TARGET_AESNI static inline __m128i aes256_expand_odd (__m128i a_,
+                                                               __m128i b_)
+{
+    const __m128i t = _mm_aeskeygenassist_si128 (b_, 0);
+    a_ = _mm_xor_si128 (a_, _mm_slli_si128 (a_, 4));
+    a_ = _mm_xor_si128 (a_, _mm_slli_si128 (a_, 8));
+    return _mm_xor_si128 (a_, _mm_shuffle_epi32 (t, 0xaa));
+}
+
+#define AES256_EXPAND(i, rcon)                                                 \
+    rk_[i] = aes256_expand_even (                                              \
+      rk_[i - 2], _mm_aeskeygenassist_si128 (rk_[i - 1], rcon));               \
+    rk_[i + 1] = aes256_expand_odd (rk_[i - 1], rk_[i])
+
+ZMQ_NACL_TARGET_AESNI static void aes256_expand (__m128i *rk_,
+                                                 const unsigned char *k_)
+{
+    rk_[0] = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (k_));
+    rk_[1] = _mm_loadu_si128 (reinterpret_cast<const __m128i *> (k_ + 16));
+    AES256_EXPAND (2, 0x01);
+    AES256_EXPAND (4, 0x02);
+    AES256_EXPAND (6, 0x04);
+    AES256_EXPAND (8, 0x08);
+    AES256_EXPAND (10, 0x10);
+    AES256_EXPAND (12, 0x20);
+    rk_[14] = aes256_expand_even (rk_[12],
+                                  _mm_aeskeygenassist_si128 (rk_[13], 0x40));
+}
+
+ZMQ_NACL_TARGET_AESNI static inline __m128i aes256_encrypt (__m128i x_,
+                                                            const __m128i *rk_)
+{
+    x_ = _mm_xor_si128 (x_, rk_[0]);
+    for (size_t i = 1; i != aes256_rounds; i++)
+        x_ = _mm_aesenc_si128 (x_, rk_[i]);
+    return _mm_aesenclast_si128 (x_, rk_[aes256_rounds]);
+}
+
+//  Counter block i of a 96-bit nonce, the counter being big endian.
+ZMQ_NACL_TARGET_AESNI static inline __m128i aes256_counter (__m128i nonce_,
+                                                            uint32_t i_)
+{
+    const uint32_t be = (i_ >> 24) | ((i_ >> 8) & 0xff00)
+                        | ((i_ << 8) & 0xff0000) | (i_ << 24);
+    return _mm_or_si128 (nonce_,
+                         _mm_set_epi32 (static_cast<int> (be), 0, 0, 0));
+}
+
+//  Encrypts len_ bytes in counter mode from counter block counter_ on,
+//  eight blocks at a time.
+ZMQ_NACL_TARGET_AESNI static void aes256_ctr (unsigned char *c_,
+                                              const unsigned char *m_,
+                                              size_t len_,
+                                              const __m128i *rk_,
+                                              __m128i nonce_,
+                                              uint32_t counter_)
+{
+    size_t done = 0;
+    while (len_ - done >= 128) {
+        __m128i x[8];
+        for (int j = 0; j != 8; j++)
+            x[j] = _mm_xor_si128 (aes256_counter (nonce_, counter_ + j),
+                                  rk_[0]);
+        for (size_t i = 1; i != aes256_rounds; i++)
+            for (int j = 0; j != 8; j++)
+                x[j] = _mm_aesenc_si128 (x[j], rk_[i]);
+        for (int j = 0; j != 8; j++) {
+            x[j] = _mm_aesenclast_si128 (x[j], rk_[aes256_rounds]);
+            const __m128i m = _mm_loadu_si128 (
+              reinterpret_cast<const __m128i *> (m_ + done + 16 * j));
+            _mm_storeu_si128 (reinterpret_cast<__m128i *> (c_ + done + 16 * j),
+                              _mm_xor_si128 (x[j], m));
+        }
+        counter_ += 8;
+        done += 128;
+    }
+    while (done < len_) {
+        unsigned char block[16];
+        _mm_storeu_si128 (
+          reinterpret_cast<__m128i *> (block),
+          aes256_encrypt (aes256_counter (nonce_, counter_), rk_));
+        for (size_t i = 0; i != 16 && done + i < len_; i++)
+            c_[done + i] = m_[done + i] ^ block[i];
+        counter_++;
+        done += 16;
+    }
+}
+
+//  Carry-less product of two 128-bit values, low and high halves.
+ZMQ_NACL_TARGET_AESNI static inline void
+gf128_clmul (__m128i a_, __m128i b_, __m128i *lo_, __m128i *hi_)
+{
+    const __m128i mid =
+      _mm_xor_si128 (_mm_clmulepi64_si128 (a_, b_, 0x10),
+                     _mm_clmulepi64_si128 (a_, b_, 0x01));
+    *lo_ = _mm_xor_si128 (*lo_, _mm_xor_si128 (_mm_clmulepi64_si128 (a_, b_, 0x00),
+                                               _mm_slli_si128 (mid, 8)));
+    *hi_ = _mm_xor_si128 (*hi_, _mm_xor_si128 (_mm_clmulepi64_si128 (a_, b_, 0x11),
+                                               _mm_srli_si128 (mid, 8)));
+}
+
+//  Reduces a product of byte-reversed operands modulo the GCM polynomial.
+//  As the reduction is linear, several products can be summed first.
+ZMQ_NACL_TARGET_AESNI static inline __m128i gf128_reduce (__m128i lo_,
+                                                          __m128i hi_)
+{
+    //  Shift the product left by one bit, the operands being bit-reflected.
+    __m128i t7 = _mm_srli_epi32 (lo_, 31);
+    __m128i t8 = _mm_srli_epi32 (hi_, 31);
+    lo_ = _mm_slli_epi32 (lo_, 1);
+    hi_ = _mm_slli_epi32 (hi_, 1);
+    const __m128i t9 = _mm_srli_si128 (t7, 12);
+    t8 = _mm_slli_si128 (t8, 4);
+    t7 = _mm_slli_si128 (t7, 4);
+    lo_ = _mm_or_si128 (lo_, t7);
+    hi_ = _mm_or_si128 (_mm_or_si128 (hi_, t8), t9);
+
+    t7 = _mm_xor_si128 (
+      _mm_xor_si128 (_mm_slli_epi32 (lo_, 31), _mm_slli_epi32 (lo_, 30)),
+      _mm_slli_epi32 (lo_, 25));
+    t8 = _mm_srli_si128 (t7, 4);
+    lo_ = _mm_xor_si128 (lo_, _mm_slli_si128 (t7, 12));
+    const __m128i t2 = _mm_xor_si128 (
+      _mm_xor_si128 (_mm_srli_epi32 (lo_, 1), _mm_srli_epi32 (lo_, 2)),
+      _mm_xor_si128 (_mm_srli_epi32 (lo_, 7), t8));
+    return _mm_xor_si128 (hi_, _mm_xor_si128 (lo_, t2));
+}
+
+ZMQ_NACL_TARGET_AESNI static inline __m128i gf128_mul (__m128i a_, __m128i b_)
+{
+    __m128i lo = _mm_setzero_si128 ();
+    __m128i hi = _mm_setzero_si128 ();
+    gf128_clmul (a_, b_, &lo, &hi);
+    return gf128_reduce (lo, hi);
+}
+
+ZMQ_NACL_TARGET_AESNI static inline __m128i gf128_load (const unsigned char *p_)
+{
+    return _mm_shuffle_epi8 (
+      _mm_loadu_si128 (reinterpret_cast<const __m128i *> (p_)),
+      _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+//  Absorbs len_ bytes into the GHASH accumulator y_, four blocks at a
+//  time with the powers H, H^2, H^3 and H^4 of the hash key. A last partial
+//  block is padded with zeros.
+ZMQ_NACL_TARGET_AESNI static __m128i ghash (__m128i y_,
+                                            const __m128i *h_,
+                                            const unsigned char *m_,
+                                            size_t len_)
+{
+    while (len_ >= 64) {
+        __m128i lo = _mm_setzero_si128 ();
+        __m128i hi = _mm_setzero_si128 ();
+        gf128_clmul (_mm_xor_si128 (y_, gf128_load (m_)), h_[3], &lo, &hi);
+        gf128_clmul (gf128_load (m_ + 16), h_[2], &lo, &hi);
+        gf128_clmul (gf128_load (m_ + 32), h_[1], &lo, &hi);
+        gf128_clmul (gf128_load (m_ + 48), h_[0], &lo, &hi);
+        y_ = gf128_reduce (lo, hi);
+        m_ += 64;
+        len_ -= 64;
+    }
+    while (len_ > 0) {
+        unsigned char block[16];
+        const unsigned char *p = m_;
+        if (len_ < 16) {
+            memset (block, 0, sizeof block);
+            memcpy (block, m_, len_);
+            p = block;
+        }
+        y_ = gf128_mul (_mm_xor_si128 (y_, gf128_load (p)), h_[0]);
+        m_ += 16;
+        len_ = len_ < 16 ? 0 : len_ - 16;
+    }
+    return y_;
+}
+
+//  The state of AES-256-GCM for a key: the round keys, then the powers of
+//  the hash key. It is kept unaligned in the opaque state of the API.
+struct aes256gcm_keys_t
+{
+    __m128i rk[aes256_rounds + 1];
+    __m128i h[4];
+};
+
+ZMQ_NACL_TARGET_AESNI static void
+aes256gcm_beforenm (unsigned char *state_, const unsigned char *k_)
+{
+    aes256gcm_keys_t keys;
+    aes256_expand (keys.rk, k_);
+    unsigned char zero[16];
+    memset (zero, 0, sizeof zero);
+    unsigned char h[16];
+    _mm_storeu_si128 (
+      reinterpret_cast<__m128i *> (h),
+      aes256_encrypt (_mm_loadu_si128 (reinterpret_cast<const __m128i *> (zero)),
+                      keys.rk));
+    keys.h[0] = gf128_load (h);
+    for (int i = 1; i != 4; i++)
+        keys.h[i] = gf128_mul (keys.h[i - 1], keys.h[0]);
+    memcpy (state_, &keys, sizeof keys);
+    memset (&keys, 0, sizeof keys);
+}
+
+//  Absorbs the lengths of the additional data and the ciphertext into
+//  the GHASH accumulator and computes the tag.
+ZMQ_NACL_TARGET_AESNI static void aes256gcm_finish (unsigned char *tag_,
+                                                    const aes256gcm_keys_t *keys_,
+                                                    __m128i y_,
+                                                    size_t adlen_,
+                                                    size_t clen_,
+                                                    __m128i nonce_)
+{
+    unsigned char lengths[16];
+    const uint64_t adbits = static_cast<uint64_t> (adlen_) * 8;
+    const uint64_t cbits = static_cast<uint64_t> (clen_) * 8;
+    for (int i = 0; i != 8; i++) {
+        lengths[i] = static_cast<unsigned char> (adbits >> (56 - 8 * i));
+        lengths[8 + i] = static_cast<unsigned char> (cbits >> (56 - 8 * i));
+    }
+    y_ = ghash (y_, keys_->h, lengths, sizeof lengths);
+
+    y_ = _mm_shuffle_epi8 (
+      y_, _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+    y_ = _mm_xor_si128 (
+      y_, aes256_encrypt (aes256_counter (nonce_, 1), keys_->rk));
+    _mm_storeu_si128 (reinterpret_cast<__m128i *> (tag_), y_);
+}
+
+//  The nonce in a counter block, the counter being 1 for the tag and
+//  starting from 2 for the data.
+ZMQ_NACL_TARGET_AESNI static __m128i
+aes256gcm_nonce (const unsigned char *npub_)
+{
+    unsigned char block[16];
+    memcpy (block, npub_, 12);
+    memset (block + 12, 0, 4);
+    return _mm_loadu_si128 (reinterpret_cast<const __m128i *> (block));
+}
+
+//  Data is encrypted then hashed in chunks that stay in the cache.
+static const size_t aes256gcm_chunk = 4096;
+
+ZMQ_NACL_TARGET_AESNI static void
+aes256gcm_encrypt (unsigned char *c_,
+                   unsigned char *tag_,
+                   const unsigned char *m_,
+                   size_t mlen_,
+                   const unsigned char *ad_,
+                   size_t adlen_,
+                   const unsigned char *npub_,
+                   const unsigned char *state_)
+{
+    aes256gcm_keys_t keys;
+    memcpy (&keys, state_, sizeof keys);
+    const __m128i nonce = aes256gcm_nonce (npub_);
+
+    __m128i y = ghash (_mm_setzero_si128 (), keys.h, ad_, adlen_);
+    for (size_t done = 0; done < mlen_; done += aes256gcm_chunk) {
+        const size_t len =
+          mlen_ - done < aes256gcm_chunk ? mlen_ - done : aes256gcm_chunk;
+        aes256_ctr (c_ + done, m_ + done, len, keys.rk, nonce,
+                    static_cast<uint32_t> (2 + done / 16));
+        y = ghash (y, keys.h, c_ + done, len);
+    }
+    aes256gcm_finish (tag_, &keys, y, adlen_, mlen_, nonce);
+    memset (&keys, 0, sizeof keys);
+}
+
+//  Checks the tag before decrypting anything.
+ZMQ_NACL_TARGET_AESNI static int
+aes256gcm_decrypt (unsigned char *m_,
+                   const unsigned char *c_,
+                   size_t clen_,
+                   const unsigned char *tag_,
+                   const unsigned char *ad_,
+                   size_t adlen_,
+                   const unsigned char *npub_,
+                   const unsigned char *state_)
+{
+    aes256gcm_keys_t keys;
+    memcpy (&keys, state_, sizeof keys);
+    const __m128i nonce = aes256gcm_nonce (npub_);
+
+    __m128i y = ghash (_mm_setzero_si128 (), keys.h, ad_, adlen_);
+    y = ghash (y, keys.h, c_, clen_);
+    unsigned char tag[16];
+    aes256gcm_finish (tag, &keys, y, adlen_, clen_, nonce);
+
+    int rc = crypto_verify_16 (tag, tag_);
+    if (rc == 0 && m_)
+        aes256_ctr (m_, c_, clen_, keys.rk, nonce, 2);
+    memset (&keys, 0, sizeof keys);
+    return rc;
+}
+
+static bool cpu_has_sse2 ()
+{
+#if defined __x86_64__ || defined _M_X64
+    return true;
+#elif defined _MSC_VER
+    int info[4];
+    __cpuid (info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("sse2") != 0;
+#endif
+}
+
+static bool cpu_has_avx2 ()
+{
+#if defined _MSC_VER
+    int info[4];
+    __cpuid (info, 0);
+    if (info[0] < 7)
+        return false;
+    //  The OS must save the YMM registers.
+    __cpuid (info, 1);
+    const int osxsave_avx = (1 << 27) | (1 << 28);
+    if ((info[2] & osxsave_avx) != osxsave_avx)
+        return false;
+    if ((_xgetbv (0) & 6) != 6)
+        return false;
+    __cpuidex (info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx2") != 0;
+#endif
+}
+
+static bool cpu_has_aesni ()
+{
+#if defined _MSC_VER
+    int info[4];
+    __cpuid (info, 1);
+    //  AES, PCLMULQDQ and SSSE3.
+    const int features = (1 << 25) | (1 << 1) | (1 << 9);
+    return (info[2] & features) == features;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("aes") && __builtin_cpu_supports ("pclmul")
+           && __builtin_cpu_supports ("ssse3");
+#endif
+}
+
+#endif
+
+bool zmq::salsa20_impl_available (salsa20_impl_t impl_)
+{
+    switch (impl_) {
+        case salsa20_scalar:
+            return true;
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+        case salsa20_sse2:
+            return cpu_has_sse2 ();
+        case salsa20_avx2:
+            return cpu_has_avx2 ();
+#endif
+        default:
+            return false;
+    }
+}
+
+static zmq::salsa20_impl_t best_salsa20_impl ()
+{
+    if (zmq::salsa20_impl_available (zmq::salsa20_avx2))
+        return zmq::salsa20_avx2;
+    if (zmq::salsa20_impl_available (zmq::salsa20_sse2))
+        return zmq::salsa20_sse2;
+    return zmq::salsa20_scalar;
+}
+
+static zmq::salsa20_impl_t selected_salsa20_impl = best_salsa20_impl ();
+
+zmq::salsa20_impl_t zmq::salsa20_impl ()
+{
+    return selected_salsa20_impl;
+}
+
+void zmq::set_salsa20_impl (salsa20_impl_t impl_)
+{
+    zmq_assert (salsa20_impl_available (impl_));
+    selected_salsa20_impl = impl_;
+}
+
+static void xsalsa20_xor (unsigned char *c_,
+                          const unsigned char *m_,
+                          size_t len_,
+                          const unsigned char *n_,
+                          const unsigned char *k_)
+{
+    unsigned char subkey[32];
+    hsalsa20 (subkey, n_, k_);
+    uint32_t input[16];
+    salsa20_init (input, n_ + 16, subkey);
+
+    size_t done = 0;
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    if (selected_salsa20_impl == zmq::salsa20_avx2)
+        done += salsa20_blocks_avx2 (c_, m_, len_, input);
+    if (selected_salsa20_impl != zmq::salsa20_scalar)
+        done += salsa20_blocks_sse2 (c_ + done, m_ ? m_ + done : NULL,
+                                     len_ - done, input);
+#endif
+    done +=
+      salsa20_blocks_scalar (c_ + done, m_ ? m_ + done : NULL, len_ - done, input);
+
+    //  Last partial block.
+    if (done < len_) {
+        unsigned char block[64];
+        salsa20_block (block, input);
+        for (size_t i = 0; done + i < len_; i++)
+            c_[done + i] = (m_ ? m_[done + i] : 0) ^ block[i];
+    }
+}
+
+//  ChaCha20 runs on the implementation selected for Salsa20.
+static void chacha20_xor (unsigned char *c_,
+                          const unsigned char *m_,
+                          size_t len_,
+                          const unsigned char *n_,
+                          const unsigned char *k_,
+                          uint32_t counter_)
+{
+    uint32_t input[16];
+    chacha20_init (input, n_, k_, counter_);
+
+    size_t done = 0;
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    if (selected_salsa20_impl == zmq::salsa20_avx2)
+        done += chacha20_blocks_avx2 (c_, m_, len_, input);
+    if (selected_salsa20_impl != zmq::salsa20_scalar)
+        done += chacha20_blocks_sse2 (c_ + done, m_ + done, len_ - done, input);
+#endif
+    done += chacha20_blocks_scalar (c_ + done, m_ + done, len_ - done, input);
+
+    if (done < len_) {
+        unsigned char block[64];
+        chacha20_block (block, input);
+        for (size_t i = 0; done + i < len_; i++)
+            c_[done + i] = m_[done + i] ^ block[i];
+    }
+}
+
+#if defined ZMQ_NACL_HAVE_UINT128
+
+//  Poly1305 with 44, 44 and 42-bit limbs, after poly1305-donna. The
+//  message is absorbed a number of whole blocks at a time.
+static const uint64_t mask44 = (static_cast<uint64_t> (1) << 44) - 1;
+static const uint64_t mask42 = (static_cast<uint64_t> (1) << 42) - 1;
+
+struct poly1305_state_t
+{
+    uint64_t r0, r1, r2;
+    uint64_t h0, h1, h2;
+    const unsigned char *k;
+};
+
+static void poly1305_init (poly1305_state_t *st_, const unsigned char *k_)
+{
+    const uint64_t t0 = load64_le (k_);
+    const uint64_t t1 = load64_le (k_ + 8);
+    st_->r0 = t0 & 0xffc0fffffffu;
+    st_->r1 = ((t0 >> 44) | (t1 << 20)) & 0xfffffc0ffffu;
+    st_->r2 = (t1 >> 24) & 0x00ffffffc0fu;
+    st_->h0 = st_->h1 = st_->h2 = 0;
+    st_->k = k_;
+}
+
+//  Whole blocks get a 1 bit past their end, the padded last block of a
+//  one-shot MAC does not.
+static void poly1305_blocks (poly1305_state_t *st_,
+                             const unsigned char *m_,
+                             size_t len_,
+                             uint64_t hibit_ = static_cast<uint64_t> (1) << 40)
+{
+    const uint64_t r0 = st_->r0, r1 = st_->r1, r2 = st_->r2;
+    const uint64_t s1 = r1 * (5 << 2);
+    const uint64_t s2 = r2 * (5 << 2);
+    uint64_t h0 = st_->h0, h1 = st_->h1, h2 = st_->h2;
+
+    for (; len_ >= 16; m_ += 16, len_ -= 16) {
+        const uint64_t t0 = load64_le (m_);
+        const uint64_t t1 = load64_le (m_ + 8);
+        h0 += t0 & mask44;
+        h1 += ((t0 >> 44) | (t1 << 20)) & mask44;
+        h2 += ((t1 >> 24) & mask42) | hibit_;
+
+        nacl_uint128_t d0 = static_cast<nacl_uint128_t> (h0) * r0
+                            + static_cast<nacl_uint128_t> (h1) * s2
+                            + static_cast<nacl_uint128_t> (h2) * s1;
+        nacl_uint128_t d1 = static_cast<nacl_uint128_t> (h0) * r1
+                            + static_cast<nacl_uint128_t> (h1) * r0
+                            + static_cast<nacl_uint128_t> (h2) * s2;
+        nacl_uint128_t d2 = static_cast<nacl_uint128_t> (h0) * r2
+                            + static_cast<nacl_uint128_t> (h1) * r1
+                            + static_cast<nacl_uint128_t> (h2) * r0;
+
+        uint64_t c = static_cast<uint64_t> (d0 >> 44);
+        h0 = static_cast<uint64_t> (d0) & mask44;
+        d1 += c;
+        c = static_cast<uint64_t> (d1 >> 44);
+        h1 = static_cast<uint64_t> (d1) & mask44;
+        d2 += c;
+        c = static_cast<uint64_t> (d2 >> 42);
+        h2 = static_cast<uint64_t> (d2) & mask42;
+        h0 += c * 5;
+        c = h0 >> 44;
+        h0 &= mask44;
+        h1 += c;
+    }
+
+    st_->h0 = h0;
+    st_->h1 = h1;
+    st_->h2 = h2;
+}
+
+static void poly1305_finish (poly1305_state_t *st_, unsigned char *out_)
+{
+    uint64_t h0 = st_->h0, h1 = st_->h1, h2 = st_->h2;
+
+    //  Fully carry h.
+    uint64_t c = h1 >> 44;
+    h1 &= mask44;
+    h2 += c;
+    c = h2 >> 42;
+    h2 &= mask42;
+    h0 += c * 5;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += c;
+    c = h1 >> 44;
+    h1 &= mask44;
+    h2 += c;
+    c = h2 >> 42;
+    h2 &= mask42;
+    h0 += c * 5;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += c;
+
+    //  Compute h - p and select it if it isn't negative.
+    uint64_t g0 = h0 + 5;
+    c = g0 >> 44;
+    g0 &= mask44;
+    uint64_t g1 = h1 + c;
+    c = g1 >> 44;
+    g1 &= mask44;
+    uint64_t g2 = h2 + c - (static_cast<uint64_t> (1) << 42);
+
+    c = (g2 >> 63) - 1;
+    g0 &= c;
+    g1 &= c;
+    g2 &= c;
+    c = ~c;
+    h0 = (h0 & c) | g0;
+    h1 = (h1 & c) | g1;
+    h2 = (h2 & c) | g2;
+
+    //  h = (h + s) % 2^128
+    const uint64_t t0 = load64_le (st_->k + 16);
+    const uint64_t t1 = load64_le (st_->k + 24);
+    h0 += t0 & mask44;
+    c = h0 >> 44;
+    h0 &= mask44;
+    h1 += (((t0 >> 44) | (t1 << 20)) & mask44) + c;
+    c = h1 >> 44;
+    h1 &= mask44;
+    h2 += ((t1 >> 24) & mask42) + c;
+    h2 &= mask42;
+
+    store64_le (out_, h0 | (h1 << 44));
+    store64_le (out_ + 8, (h1 >> 20) | (h2 << 24));
+}
+
+static void poly1305 (unsigned char *out_,
+                      const unsigned char *m_,
+                      size_t len_,
+                      const unsigned char *k_)
+{
+    poly1305_state_t st;
+    poly1305_init (&st, k_);
+    poly1305_blocks (&st, m_, len_);
+
+    //  The last partial block is padded with 1 then zeros.
+    const size_t rest = len_ % 16;
+    if (rest) {
+        unsigned char last[16];
+        memset (last, 0, sizeof last);
+        memcpy (last, m_ + len_ - rest, rest);
+        last[rest] = 1;
+        poly1305_blocks (&st, last, sizeof last, 0);
+    }
+    poly1305_finish (&st, out_);
+}
+
+//  Absorbs data padded with zeros to a whole number of blocks.
+static void poly1305_padded (poly1305_state_t *st_,
+                             const unsigned char *m_,
+                             size_t len_)
+{
+    poly1305_blocks (st_, m_, len_);
+    const size_t rest = len_ % 16;
+    if (rest) {
+        unsigned char last[16];
+        memset (last, 0, sizeof last);
+        memcpy (last, m_ + len_ - rest, rest);
+        poly1305_blocks (st_, last, sizeof last);
+    }
+}
+
+//  Field arithmetic modulo 2^255 - 19 with 51-bit limbs, and the X25519
+//  Montgomery ladder of RFC 7748, after curve25519-donna-c64.
+typedef uint64_t fe25519[5];
+
+static const uint64_t mask51 = (static_cast<uint64_t> (1) << 51) - 1;
+
+static void fe_expand (fe25519 out_, const unsigned char *in_)
+{
+    out_[0] = load64_le (in_) & mask51;
+    out_[1] = (load64_le (in_ + 6) >> 3) & mask51;
+    out_[2] = (load64_le (in_ + 12) >> 6) & mask51;
+    out_[3] = (load64_le (in_ + 19) >> 1) & mask51;
+    out_[4] = (load64_le (in_ + 24) >> 12) & mask51;
+}
+
+static inline void fe_carry (uint64_t *t_)
+{
+    t_[1] += t_[0] >> 51;
+    t_[0] &= mask51;
+    t_[2] += t_[1] >> 51;
+    t_[1] &= mask51;
+    t_[3] += t_[2] >> 51;
+    t_[2] &= mask51;
+    t_[4] += t_[3] >> 51;
+    t_[3] &= mask51;
+    t_[0] += 19 * (t_[4] >> 51);
+    t_[4] &= mask51;
+}
+
+static void fe_contract (unsigned char *out_, const fe25519 in_)
+{
+    uint64_t t[5];
+    memcpy (t, in_, sizeof t);
+    fe_carry (t);
+    fe_carry (t);
+
+    //  t is now below 2^255. Subtract p if it is p or more: add 19 and
+    //  let the carries tell.
+    t[0] += 19;
+    fe_carry (t);
+    t[0] += (static_cast<uint64_t> (1) << 51) - 19;
+    t[1] += (static_cast<uint64_t> (1) << 51) - 1;
+    t[2] += (static_cast<uint64_t> (1) << 51) - 1;
+    t[3] += (static_cast<uint64_t> (1) << 51) - 1;
+    t[4] += (static_cast<uint64_t> (1) << 51) - 1;
+    t[1] += t[0] >> 51;
+    t[0] &= mask51;
+    t[2] += t[1] >> 51;
+    t[1] &= mask51;
+    t[3] += t[2] >> 51;
+    t[2] &= mask51;
+    t[4] += t[3] >> 51;
+    t[3] &= mask51;
+    t[4] &= mask51;
+
+    store64_le (out_, t[0] | (t[1] << 51));
+    store64_le (out_ + 8, (t[1] >> 13) | (t[2] << 38));
+    store64_le (out_ + 16, (t[2] >> 26) | (t[3] << 25));
+    store64_le (out_ + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+static inline void fe_add (fe25519 out_, const fe25519 a_, const fe25519 b_)
+{
+    for (int i = 0; i != 5; i++)
+        out_[i] = a_[i] + b_[i];
+}
+
+//  a - b, computed as a + 2p - b so that it stays positive.
+static inline void fe_sub (fe25519 out_, const fe25519 a_, const fe25519 b_)
+{
+    out_[0] = a_[0] + 0xfffffffffffdau - b_[0];
+    for (int i = 1; i != 5; i++)
+        out_[i] = a_[i] + 0xffffffffffffeu - b_[i];
+}
+
+static void fe_mul (fe25519 out_, const fe25519 a_, const fe25519 b_)
+{
+    uint64_t r0 = a_[0], r1 = a_[1], r2 = a_[2], r3 = a_[3], r4 = a_[4];
+    const uint64_t s0 = b_[0], s1 = b_[1], s2 = b_[2], s3 = b_[3],
+                   s4 = b_[4];
+
+    nacl_uint128_t t0 = static_cast<nacl_uint128_t> (r0) * s0;
+    nacl_uint128_t t1 = static_cast<nacl_uint128_t> (r0) * s1
+                        + static_cast<nacl_uint128_t> (r1) * s0;
+    nacl_uint128_t t2 = static_cast<nacl_uint128_t> (r0) * s2
+                        + static_cast<nacl_uint128_t> (r2) * s0
+                        + static_cast<nacl_uint128_t> (r1) * s1;
+    nacl_uint128_t t3 = static_cast<nacl_uint128_t> (r0) * s3
+                        + static_cast<nacl_uint128_t> (r3) * s0
+                        + static_cast<nacl_uint128_t> (r1) * s2
+                        + static_cast<nacl_uint128_t> (r2) * s1;
+    nacl_uint128_t t4 = static_cast<nacl_uint128_t> (r0) * s4
+                        + static_cast<nacl_uint128_t> (r4) * s0
+                        + static_cast<nacl_uint128_t> (r3) * s1
+                        + static_cast<nacl_uint128_t> (r1) * s3
+                        + static_cast<nacl_uint128_t> (r2) * s2;
+
+    //  Products beyond 2^255 wrap around multiplied by 19.
+    r1 *= 19;
+    r2 *= 19;
+    r3 *= 19;
+    r4 *= 19;
+    t0 += static_cast<nacl_uint128_t> (r4) * s1
+          + static_cast<nacl_uint128_t> (r1) * s4
+          + static_cast<nacl_uint128_t> (r2) * s3
+          + static_cast<nacl_uint128_t> (r3) * s2;
+    t1 += static_cast<nacl_uint128_t> (r4) * s2
+          + static_cast<nacl_uint128_t> (r2) * s4
+          + static_cast<nacl_uint128_t> (r3) * s3;
+    t2 += static_cast<nacl_uint128_t> (r4) * s3
+          + static_cast<nacl_uint128_t> (r3) * s4;
+    t3 += static_cast<nacl_uint128_t> (r4) * s4;
+
+    r0 = static_cast<uint64_t> (t0) & mask51;
+    t1 += static_cast<uint64_t> (t0 >> 51);
+    r1 = static_cast<uint64_t> (t1) & mask51;
+    t2 += static_cast<uint64_t> (t1 >> 51);
+    r2 = static_cast<uint64_t> (t2) & mask51;
+    t3 += static_cast<uint64_t> (t2 >> 51);
+    r3 = static_cast<uint64_t> (t3) & mask51;
+    t4 += static_cast<uint64_t> (t3 >> 51);
+    r4 = static_cast<uint64_t> (t4) & mask51;
+    r0 += static_cast<uint64_t> (t4 >> 51) * 19;
+    r1 += r0 >> 51;
+    r0 &= mask51;
+
+    out_[0] = r0;
+    out_[1] = r1;
+    out_[2] = r2;
+    out_[3] = r3;
+    out_[4] = r4;
+}
+
+static inline void fe_square (fe25519 out_, const fe25519 a_, int times_ = 1)
+{
+    fe_mul (out_, a_, a_);
+    for (int i = 1; i < times_; i++)
+        fe_mul (out_, out_, out_);
+}
+
+static void fe_mul121665 (fe25519 out_, const fe25519 a_)
+{
+    uint64_t carry = 0;
+    for (int i = 0; i != 5; i++) {
+        const nacl_uint128_t t =
+          static_cast<nacl_uint128_t> (a_[i]) * 121665 + carry;
+        out_[i] = static_cast<uint64_t> (t) & mask51;
+        carry = static_cast<uint64_t> (t >> 51);
+    }
+    out_[0] += carry * 19;
+    out_[1] += out_[0] >> 51;
+    out_[0] &= mask51;
+}
+
+//  z^(p - 2) = 1/z
+static void fe_invert (fe25519 out_, const fe25519 z_)
+{
+    fe25519 z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+    fe_square (z2, z_);
+    fe_square (t, z2, 2);
+    fe_mul (z9, t, z_);
+    fe_mul (z11, z9, z2);
+    fe_square (t, z11);
+    fe_mul (z2_5_0, t, z9);
+    fe_square (t, z2_5_0, 5);
+    fe_mul (z2_10_0, t, z2_5_0);
+    fe_square (t, z2_10_0, 10);
+    fe_mul (z2_20_0, t, z2_10_0);
+    fe_square (t, z2_20_0, 20);
+    fe_mul (t, t, z2_20_0);
+    fe_square (t, t, 10);
+    fe_mul (z2_50_0, t, z2_10_0);
+    fe_square (t, z2_50_0, 50);
+    fe_mul (z2_100_0, t, z2_50_0);
+    fe_square (t, z2_100_0, 100);
+    fe_mul (t, t, z2_100_0);
+    fe_square (t, t, 50);
+    fe_mul (t, t, z2_50_0);
+    fe_square (t, t, 5);
+    fe_mul (out_, t, z11);
+}
+
+static inline void fe_cswap (fe25519 a_, fe25519 b_, uint64_t swap_)
+{
+    const uint64_t mask = 0 - swap_;
+    for (int i = 0; i != 5; i++) {
+        const uint64_t x = mask & (a_[i] ^ b_[i]);
+        a_[i] ^= x;
+        b_[i] ^= x;
+    }
+}
+
+static void x25519 (unsigned char *q_,
+                    const unsigned char *n_,
+                    const unsigned char *p_)
+{
+    unsigned char e[32];
+    memcpy (e, n_, 32);
+    e[0] &= 248;
+    e[31] &= 127;
+    e[31] |= 64;
+
+    fe25519 x1, x2, z2, x3, z3;
+    fe_expand (x1, p_);
+    memset (x2, 0, sizeof x2);
+    x2[0] = 1;
+    memset (z2, 0, sizeof z2);
+    memcpy (x3, x1, sizeof x3);
+    memset (z3, 0, sizeof z3);
+    z3[0] = 1;
+
+    uint64_t swap = 0;
+    for (int pos = 254; pos >= 0; pos--) {
+        const uint64_t bit = (e[pos / 8] >> (pos & 7)) & 1;
+        swap ^= bit;
+        fe_cswap (x2, x3, swap);
+        fe_cswap (z2, z3, swap);
+        swap = bit;
+
+        fe25519 a, aa, b, bb, ee, c, d, da, cb, t;
+        fe_add (a, x2, z2);
+        fe_square (aa, a);
+        fe_sub (b, x2, z2);
+        fe_square (bb, b);
+        fe_sub (ee, aa, bb);
+        fe_add (c, x3, z3);
+        fe_sub (d, x3, z3);
+        fe_mul (da, d, a);
+        fe_mul (cb, c, b);
+        fe_add (t, da, cb);
+        fe_square (x3, t);
+        fe_sub (t, da, cb);
+        fe_square (t, t);
+        fe_mul (z3, x1, t);
+        fe_mul (x2, aa, bb);
+        fe_mul121665 (t, ee);
+        fe_add (t, aa, t);
+        fe_mul (z2, ee, t);
+    }
+    fe_cswap (x2, x3, swap);
+    fe_cswap (z2, z3, swap);
+
+    fe25519 zinv;
+    fe_invert (zinv, z2);
+    fe_mul (x2, x2, zinv);
+    fe_contract (q_, x2);
+}
+
+#endif
+
+//  The Poly1305 tag of RFC 8439: the additional data and the ciphertext,
+//  each padded to whole blocks, then their lengths.
+static void poly1305_aead (unsigned char *out_,
+                           const unsigned char *ad_,
+                           size_t adlen_,
+                           const unsigned char *c_,
+                           size_t clen_,
+                           const unsigned char *k_)
+{
+    unsigned char lengths[16];
+    store64_le (lengths, adlen_);
+    store64_le (lengths + 8, clen_);
+#if defined ZMQ_NACL_HAVE_UINT128
+    poly1305_state_t st;
+    poly1305_init (&st, k_);
+    poly1305_padded (&st, ad_, adlen_);
+    poly1305_padded (&st, c_, clen_);
+    poly1305_blocks (&st, lengths, sizeof lengths);
+    poly1305_finish (&st, out_);
+#else
+    const size_t adpadded = (adlen_ + 15) & ~static_cast<size_t> (15);
+    const size_t cpadded = (clen_ + 15) & ~static_cast<size_t> (15);
+    std::vector<unsigned char> m (adpadded + cpadded + sizeof lengths);
+    if (adlen_)
+        memcpy (&m[0], ad_, adlen_);
+    if (clen_)
+        memcpy (&m[adpadded], c_, clen_);
+    memcpy (&m[adpadded + cpadded], lengths, sizeof lengths);
+    crypto_onetimeauth_ref (out_, &m[0], m.size (), k_);
+#endif
+}
+
+//  The Poly1305 key of a ChaCha20-Poly1305 message is the beginning of
+//  the key stream block 0, the data is encrypted from block 1 on.
+static void chacha20poly1305_key (unsigned char *key_,
+                                  const unsigned char *npub_,
+                                  const unsigned char *k_)
+{
+    uint32_t input[16];
+    chacha20_init (input, npub_, k_, 0);
+    unsigned char block[64];
+    chacha20_block (block, input);
+    memcpy (key_, block, 32);
+    memset (block, 0, sizeof block);
+}
+
+extern "C" {
+int crypto_stream_xor (u8 *c_, const u8 *m_, u64 d_, const u8 *n_, const u8 *k_)
+{
+    xsalsa20_xor (c_, m_, static_cast<size_t> (d_), n_, k_);
+    return 0;
+}
+
+int crypto_stream (u8 *c_, u64 d_, const u8 *n_, const u8 *k_)
+{
+    xsalsa20_xor (c_, NULL, static_cast<size_t> (d_), n_, k_);
+    return 0;
+}
+
+int crypto_onetimeauth (u8 *out_, const u8 *m_, u64 n_, const u8 *k_)
+{
+#if defined ZMQ_NACL_HAVE_UINT128
+    poly1305 (out_, m_, static_cast<size_t> (n_), k_);
+    return 0;
+#else
+    return crypto_onetimeauth_ref (out_, m_, n_, k_);
+#endif
+}
+
+int crypto_onetimeauth_verify (const u8 *h_,
+                               const u8 *m_,
+                               u64 n_,
+                               const u8 *k_)
+{
+    u8 x[16];
+    crypto_onetimeauth (x, m_, n_, k_);
+    unsigned int d = 0;
+    for (int i = 0; i != 16; i++)
+        d |= h_[i] ^ x[i];
+    return (1 & ((d - 1) >> 8)) - 1;
+}
+
+int crypto_scalarmult (u8 *q_, const u8 *n_, const u8 *p_)
+{
+#if defined ZMQ_NACL_HAVE_UINT128
+    x25519 (q_, n_, p_);
+    return 0;
+#else
+    return crypto_scalarmult_ref (q_, n_, p_);
+#endif
+}
+
+int crypto_aead_chacha20poly1305_ietf_encrypt_detached (u8 *c_,
+                                                        u8 *mac_,
+                                                        u64 *maclen_p_,
+                                                        const u8 *m_,
+                                                        u64 mlen_,
+                                                        const u8 *ad_,
+                                                        u64 adlen_,
+                                                        const u8 * /* nsec_ */,
+                                                        const u8 *npub_,
+                                                        const u8 *k_)
+{
+    unsigned char key[32];
+    chacha20poly1305_key (key, npub_, k_);
+    chacha20_xor (c_, m_, static_cast<size_t> (mlen_), npub_, k_, 1);
+    poly1305_aead (mac_, ad_, static_cast<size_t> (adlen_), c_,
+                   static_cast<size_t> (mlen_), key);
+    memset (key, 0, sizeof key);
+    if (maclen_p_)
+        *maclen_p_ = crypto_aead_chacha20poly1305_ietf_ABYTES;
+    return 0;
+}
+
+int crypto_aead_chacha20poly1305_ietf_decrypt_detached (u8 *m_,
+                                                        u8 * /* nsec_ */,
+                                                        const u8 *c_,
+                                                        u64 clen_,
+                                                        const u8 *mac_,
+                                                        const u8 *ad_,
+                                                        u64 adlen_,
+                                                        const u8 *npub_,
+                                                        const u8 *k_)
+{
+    unsigned char key[32];
+    chacha20poly1305_key (key, npub_, k_);
+    unsigned char mac[16];
+    poly1305_aead (mac, ad_, static_cast<size_t> (adlen_), c_,
+                   static_cast<size_t> (clen_), key);
+    memset (key, 0, sizeof key);
+
+    const int rc = crypto_verify_16 (mac, mac_);
+    if (rc == 0 && m_)
+        chacha20_xor (m_, c_, static_cast<size_t> (clen_), npub_, k_, 1);
+    return rc;
+}
+
+int crypto_aead_aes256gcm_is_available (void)
+{
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    static const bool available = cpu_has_aesni ();
+    return available ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+int crypto_aead_aes256gcm_beforenm (crypto_aead_aes256gcm_state *state_,
+                                    const u8 *k_)
+{
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    if (crypto_aead_aes256gcm_is_available ()) {
+        aes256gcm_beforenm (state_->opaque, k_);
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+int crypto_aead_aes256gcm_encrypt_detached_afternm (
+  u8 *c_,
+  u8 *mac_,
+  u64 *maclen_p_,
+  const u8 *m_,
+  u64 mlen_,
+  const u8 *ad_,
+  u64 adlen_,
+  const u8 * /* nsec_ */,
+  const u8 *npub_,
+  const crypto_aead_aes256gcm_state *state_)
+{
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    if (crypto_aead_aes256gcm_is_available ()) {
+        aes256gcm_encrypt (c_, mac_, m_, static_cast<size_t> (mlen_), ad_,
+                           static_cast<size_t> (adlen_), npub_,
+                           state_->opaque);
+        if (maclen_p_)
+            *maclen_p_ = crypto_aead_aes256gcm_ABYTES;
+        return 0;
+    }
+#endif
+    return -1;
+}
+
+int crypto_aead_aes256gcm_decrypt_detached_afternm (
+  u8 *m_,
+  u8 * /* nsec_ */,
+  const u8 *c_,
+  u64 clen_,
+  const u8 *mac_,
+  const u8 *ad_,
+  u64 adlen_,
+  const u8 *npub_,
+  const crypto_aead_aes256gcm_state *state_)
+{
+#if defined ZMQ_NACL_HAVE_X86_SIMD
+    if (crypto_aead_aes256gcm_is_available ())
+        return aes256gcm_decrypt (m_, c_, static_cast<size_t> (clen_), mac_,
+                                  ad_, static_cast<size_t> (adlen_), npub_,
+                                  state_->opaque);
+#endif
+    return -1;
+}
+}
+
+#endif
@@ -0,0 +1,70 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_NACL_FAST_HPP_INCLUDED__
+#define __ZMQ_NACL_FAST_HPP_INCLUDED__
+
+#if defined(ZMQ_USE_TWEETNACL)
+
+namespace zmq
+{
+//  Optimized implementations of the primitives crypto_box and
+//  crypto_secretbox are made of, used by tweetnacl.c in place of its
+//  reference code: XSalsa20, Poly1305 and X25519.
+//
+//  Salsa20 computes several blocks at once with SSE2 or AVX2 when the CPU
+//  has them, the implementation is chosen when the library is loaded.
+//  Poly1305 and X25519 use 64-bit arithmetic where the compiler provides
+//  128-bit products, and the reference code otherwise.
+//
+//  The AEAD ciphers CURVE messages may be negotiated to live here as well.
+//  ChaCha20 uses the same implementation choice as Salsa20, AES-256-GCM is
+//  only available with AES-NI and PCLMULQDQ.
+
+enum salsa20_impl_t
+{
+    salsa20_scalar,
+    salsa20_sse2,
+    salsa20_avx2
+};
+
+//  Returns true if the implementation can run on this CPU.
+bool salsa20_impl_available (salsa20_impl_t impl_);
+
+//  Implementation in use, by default the fastest one available.
+salsa20_impl_t salsa20_impl ();
+
+//  Switches to another available implementation. Meant for tests and
+//  benchmarks, must not be called while CURVE is in use.
+void set_salsa20_impl (salsa20_impl_t impl_);
+}
+
+#endif
+
+#endif
@@ -47,6 +47,8 @@ class norm_engine_t : public io_object_t, public i_engine
 
     virtual void zap_msg_available (){};
 
+    virtual void crypto_job_done (){};
+
     virtual const char *get_endpoint () const;
 
     // i_poll_events interface implementation.
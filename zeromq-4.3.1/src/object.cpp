@@ -120,6 +120,14 @@ void zmq::object_t::process_command(command_t &cmd_)
             process_seqnum ();
             break;
 
+        case command_t::reactor:
+            process_reactor (cmd_.args.reactor.request);
+            break;
+
+        case command_t::job_done:
+            process_job_done (cmd_.args.job_done.job);
+            break;
+
         case command_t::done:
         default:
             zmq_assert (false);
@@ -341,6 +349,15 @@ void zmq::object_t::send_done ()
     _ctx->send_command (ctx_t::term_tid, cmd);
 }
 
+void zmq::object_t::send_reactor (zmq::object_t *destination_, void *request_)
+{
+    command_t cmd;
+    cmd.destination = destination_;
+    cmd.type = command_t::reactor;
+    cmd.args.reactor.request = request_;
+    send_command (cmd);
+}
+
 void zmq::object_t::process_stop ()
 {
     zmq_assert (false);
@@ -426,6 +443,16 @@ void zmq::object_t::process_reaped()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_reactor (void *)
+{
+    zmq_assert (false);
+}
+
+void zmq::object_t::process_job_done (io_job_t *)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_seqnum()
 {
     zmq_assert (false);
@@ -16,6 +16,7 @@ class socket_base_t;
 class session_base_t;
 class io_thread_t;
 class own_t;
+class io_job_t;
 
 //  Base class for all objects that participate in inter-thread communication.
 
@@ -70,6 +71,7 @@ protected:
     void send_reap (zmq::socket_base_t *socket_);
     void send_reaped ();
     void send_done ();
+    void send_reactor (zmq::object_t *destination_, void *request_);
 
     //  These handlers can be overridden by the derived objects. They are called when command arrives from another thread.
     virtual void process_stop ();
@@ -89,6 +91,8 @@ protected:
     virtual void process_term_endpoint (std::string *endpoint_);
     virtual void process_reap (zmq::socket_base_t *socket_);
     virtual void process_reaped ();
+    virtual void process_reactor (void *request_);
+    virtual void process_job_done (zmq::io_job_t *job_);
 
     //  Special handler called after a command that requires a seqnum
     //  was processed. The implementation should catch up with its counter
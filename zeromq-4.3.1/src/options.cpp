@@ -211,7 +211,15 @@ zmq::options_t::options_t () :
     loopback_fastpath (false),
     multicast_loop (true),
     zero_copy (true),
-    router_notify (0)
+    router_notify (0),
+    lb_policy (ZMQ_LB_ROUND_ROBIN),
+    lb_weight (1),
+    fq_priority (0),
+    fq_weight (1),
+    command_delay (-1),
+    curve_ticket_lifetime (0),
+    curve_aead (false),
+    curve_batch (false)
 {
     memset (curve_public_key, 0, CURVE_KEYSIZE);
     memset (curve_secret_key, 0, CURVE_KEYSIZE);
@@ -710,6 +718,69 @@ int zmq::options_t::setsockopt (int option_,
             return do_setsockopt_int_as_bool_relaxed (optval_, optvallen_,
                                                       &multicast_loop);
 
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_LB_POLICY:
+            if (is_int && value >= ZMQ_LB_ROUND_ROBIN
+                && value <= ZMQ_LB_POWER_OF_TWO) {
+                lb_policy = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int && value > 0) {
+                lb_weight = value;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_FQ_PRIORITY:
+            if (is_int && value >= 0 && value <= FQ_PRIORITY_MAX) {
+                fq_priority = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_FQ_WEIGHT:
+            if (is_int && value > 0) {
+                fq_weight = value;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_COMMAND_DELAY:
+            if (is_int && value >= -1) {
+                command_delay = value;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_TICKET_LIFETIME:
+            if (is_int && value >= 0) {
+                curve_ticket_lifetime = value;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_AEAD:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &curve_aead);
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_BATCH:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &curve_batch);
+#endif
+
         default:
 #if defined(ZMQ_ACT_MILITANT)
             //  There are valid scenarios for probing with unknown socket option
@@ -1111,6 +1182,74 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_LB_POLICY:
+            if (is_int) {
+                *value = lb_policy;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int) {
+                *value = lb_weight;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_FQ_PRIORITY:
+            if (is_int) {
+                *value = fq_priority;
+                return 0;
+            }
+            break;
+
+        case ZMQ_FQ_WEIGHT:
+            if (is_int) {
+                *value = fq_weight;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_COMMAND_DELAY:
+            if (is_int) {
+                *value = command_delay;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_TICKET_LIFETIME:
+            if (is_int) {
+                *value = curve_ticket_lifetime;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_AEAD:
+            if (is_int) {
+                *value = curve_aead;
+                return 0;
+            }
+            break;
+#endif
+
+#ifdef ZMQ_BUILD_DRAFT_API
+        case ZMQ_CURVE_BATCH:
+            if (is_int) {
+                *value = curve_batch;
+                return 0;
+            }
+            break;
+#endif
+
 #ifdef ZMQ_BUILD_DRAFT_API
         case ZMQ_ROUTER_NOTIFY:
             if (is_int) {
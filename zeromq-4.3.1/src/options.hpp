@@ -29,6 +29,9 @@
 //  Key encoded using Z85 is 40 bytes
 #define CURVE_KEYSIZE_Z85 40
 
+//  Highest ZMQ_FQ_PRIORITY, bounds the number of fair queueing classes
+#define FQ_PRIORITY_MAX   7
+
 namespace zmq
 {
 
@@ -230,6 +233,33 @@ struct options_t
     // Router socket ZMQ_NOTIFY_CONNECT/ZMQ_NOTIFY_DISCONNECT notifications
     int router_notify;
 
+    //  Policy used to pick the outbound pipe for the next message
+    //  (ZMQ_LB_ROUND_ROBIN, ZMQ_LB_LEAST_QUEUE, ...).
+    int lb_policy;
+
+    //  Weight of connections set up from now on under ZMQ_LB_WEIGHTED.
+    int lb_weight;
+
+    //  Priority class and weight of inbound connections set up from now on.
+    int fq_priority;
+    int fq_weight;
+
+    //  Delay between checks for commands while messages keep being sent,
+    //  in microseconds. -1 adapts it to the rate commands arrive at.
+    int command_delay;
+
+    //  Lifetime of CURVE resumption tickets in milliseconds, 0 to always
+    //  do a full handshake.
+    int curve_ticket_lifetime;
+
+    //  If true, CURVE offers or accepts AES-256-GCM and ChaCha20-Poly1305
+    //  for messages, in place of a box per message.
+    bool curve_aead;
+
+    //  If true, CURVE offers or accepts to encode the messages sent at
+    //  once as one.
+    bool curve_batch;
+
     // Application metadata
     std::map<std::string, std::string> app_metadata;
 };
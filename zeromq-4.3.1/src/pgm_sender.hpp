@@ -59,6 +59,7 @@ class pgm_sender_t : public io_object_t, public i_engine
     bool restart_input ();
     void restart_output ();
     void zap_msg_available () {}
+    void crypto_job_done () {}
     const char *get_endpoint () const;
 
     //  i_poll_events interface implementation.
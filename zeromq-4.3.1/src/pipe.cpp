@@ -72,6 +72,10 @@ zmq::pipe_t::pipe_t (object_t * parent_, upipe_t *inpipe_, upipe_t *outpipe_, in
     _state (active),
     _delay (true),
     _server_socket_routing_id (0),
+    _lb_weight (1),
+    _fq_priority (0),
+    _fq_weight (1),
+    _flush_deferred (false),
     _conflate (conflate_)
 {
 
@@ -246,6 +250,9 @@ void zmq::pipe_t::flush()
     if (_state == term_ack_sent)
         return;
 
+    if (_flush_deferred)
+        return;
+
     if (_out_pipe && (_out_pipe->flush() == false))
     {
         printf("%s %s %d >>>>>>>>>>>>>>>>>>>>> %d\n", __FILE__, __FUNCTION__, __LINE__, iFlag);
@@ -254,6 +261,13 @@ void zmq::pipe_t::flush()
     }
 }
 
+void zmq::pipe_t::set_flush_deferred (bool deferred_)
+{
+    _flush_deferred = deferred_;
+    if (!deferred_)
+        flush ();
+}
+
 void zmq::pipe_t::process_activate_read()
 {
     if (!_in_active && (_state == active || _state == waiting_for_delimiter)) 
@@ -468,6 +482,7 @@ void zmq::pipe_t::terminate(bool delay_)
         msg_t msg;
         msg.init_delimiter();
         _out_pipe->write(msg, false);
+        _flush_deferred = false;
         flush();
     }
 }
@@ -557,6 +572,44 @@ void zmq::pipe_t::set_hwms_boost (int inhwmboost_, int outhwmboost_)
     _out_hwm_boost = outhwmboost_;
 }
 
+uint64_t zmq::pipe_t::get_queue_depth () const
+{
+    return _msgs_written - _peers_msgs_read;
+}
+
+void zmq::pipe_t::set_lb_weight (int weight_)
+{
+    zmq_assert (weight_ > 0);
+    _lb_weight = weight_;
+}
+
+int zmq::pipe_t::get_lb_weight () const
+{
+    return _lb_weight;
+}
+
+void zmq::pipe_t::set_fq_priority (int priority_)
+{
+    zmq_assert (priority_ >= 0);
+    _fq_priority = priority_;
+}
+
+int zmq::pipe_t::get_fq_priority () const
+{
+    return _fq_priority;
+}
+
+void zmq::pipe_t::set_fq_weight (int weight_)
+{
+    zmq_assert (weight_ > 0);
+    _fq_weight = weight_;
+}
+
+int zmq::pipe_t::get_fq_weight () const
+{
+    return _fq_weight;
+}
+
 bool zmq::pipe_t::check_hwm () const
 {
     const bool full = _hwm > 0 && _msgs_written - _peers_msgs_read >= uint64_t (_hwm);
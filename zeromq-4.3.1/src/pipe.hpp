@@ -80,6 +80,10 @@ public:
     //  Flush the messages downstream.
     void flush ();
 
+    //  While flushes are deferred, flush() leaves the written messages
+    //  in the pipe. Ending the deferral flushes them.
+    void set_flush_deferred (bool deferred_);
+
     //  Temporarily disconnects the inbound message stream and drops
     //  all the messages on the fly. Causes 'hiccuped' event to be generated
     //  in the peer.
@@ -106,6 +110,23 @@ public:
     //  Returns true if HWM is not reached
     bool check_hwm () const;
 
+    //  Number of messages written to the pipe that the peer is not yet
+    //  known to have read. The peer reports its progress only every LWM
+    //  messages, so this is an upper bound with that granularity.
+    uint64_t get_queue_depth () const;
+
+    //  Share of the traffic this pipe gets from a load balancer using
+    //  ZMQ_LB_WEIGHTED, fixed when the connection is set up.
+    void set_lb_weight (int weight_);
+    int get_lb_weight () const;
+
+    //  Priority class and share of the traffic this pipe gets from a fair
+    //  queue on the inbound side, fixed when the connection is set up.
+    void set_fq_priority (int priority_);
+    int get_fq_priority () const;
+    void set_fq_weight (int weight_);
+    int get_fq_weight () const;
+
     void set_endpoint_uri (const char *name_);
     std::string &get_endpoint_uri ();
 
@@ -201,6 +222,16 @@ public:
     //  Routing id of the writer. Used uniquely by the reader side.
     int _server_socket_routing_id;
 
+    //  Weight for ZMQ_LB_WEIGHTED load balancing of the outbound side.
+    int _lb_weight;
+
+    //  ZMQ_FQ_PRIORITY and ZMQ_FQ_WEIGHT of the inbound side.
+    int _fq_priority;
+    int _fq_weight;
+
+    //  If true, flush() is a no-op, see set_flush_deferred.
+    bool _flush_deferred;
+
     //  Returns true if the message is delimiter; false otherwise.
     static bool is_delimiter(const msg_t &msg_);
 
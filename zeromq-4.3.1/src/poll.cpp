@@ -95,6 +95,21 @@ void zmq::poll_t::rm_fd (handle_t handle_)
     adjust_load (-1);
 }
 
+//  Invalid descriptors are only detected once polled.
+int zmq::poll_t::try_add_fd (fd_t fd_,
+                             i_poll_events *events_,
+                             handle_t &handle_)
+{
+    handle_ = add_fd (fd_, events_);
+    return 0;
+}
+
+int zmq::poll_t::try_rm_fd (handle_t handle_)
+{
+    rm_fd (handle_);
+    return 0;
+}
+
 void zmq::poll_t::set_pollin (handle_t handle_)
 {
     check_thread ();
@@ -32,7 +32,9 @@ class poll_t : public worker_poller_base_t
     //  "poller" concept.
     //  These methods may only be called from an event callback; add_fd may also be called before start.
     handle_t add_fd (fd_t fd_, zmq::i_poll_events *events_);
+    int try_add_fd (fd_t fd_, zmq::i_poll_events *events_, handle_t &handle_);
     void rm_fd (handle_t handle_);
+    int try_rm_fd (handle_t handle_);
     void set_pollin (handle_t handle_);
     void reset_pollin (handle_t handle_);
     void set_pollout (handle_t handle_);
@@ -31,27 +31,16 @@ void zmq::poller_base_t::adjust_load(int amount_)
     }
 }
 
-void zmq::poller_base_t::add_timer(int timeout_, i_poll_events *sink_, int id_)
+zmq::poller_base_t::timer_handle_t
+zmq::poller_base_t::add_timer(int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = _clock.now_ms() + timeout_;
-    timer_info_t info = {sink_, id_};
-    _timers.insert(timers_t::value_type(expiration, info));
+    const uint64_t now = _clock.now_ms();
+    return _timers.add(now, now + timeout_, sink_, id_);
 }
 
-void zmq::poller_base_t::cancel_timer(i_poll_events *sink_, int id_)
+void zmq::poller_base_t::cancel_timer(timer_handle_t handle_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = _timers.begin(), end = _timers.end(); it != end; ++it)
-    {
-        if (it->second.sink == sink_ && it->second.id == id_)
-        {
-            _timers.erase(it);
-            return;
-        }
-    }
-
-    //  Timer not found.
-    zmq_assert(false);
+    _timers.cancel(handle_);
 }
 
 uint64_t zmq::poller_base_t::execute_timers()
@@ -63,32 +52,19 @@ uint64_t zmq::poller_base_t::execute_timers()
     //  Get the current time.
     const uint64_t current = _clock.now_ms();
 
-    //   Execute the timers that are already due.
-    const timers_t::iterator begin = _timers.begin();
-    const timers_t::iterator end   = _timers.end();
-    uint64_t res = 0;
-    timers_t::iterator it = begin;
-    for (; it != end; ++it) 
+    //  Execute the timers that are already due. Each one is removed before
+    //  its handler runs, so handlers may add and cancel timers freely.
+    i_poll_events *sink;
+    int id;
+    while (_timers.pop_expired(current, &sink, &id))
     {
-        //  If we have to wait to execute the item, same will be true about
-        //  all the following items (multimap is sorted). Thus we can stop
-        //  checking the subsequent timers.
-        if (it->first > current) 
-        {
-            res = it->first - current;
-            break;
-        }
-
         //  Trigger the timer.
-        it->second.sink->timer_event(it->second.id);
+        sink->timer_event(id);
     }
 
-    //  Remove them from the list of active timers.
-    _timers.erase(begin, it);
-
     //  Return the time to wait for the next timer (at least 1ms), or 0, if
     //  there are no more timers.
-    return res;
+    return _timers.timeout(current);
 }
 
 zmq::worker_poller_base_t::worker_poller_base_t(const thread_ctx_t &ctx_) : _ctx (ctx_)
@@ -107,6 +83,11 @@ void zmq::worker_poller_base_t::start ()
     _ctx.start_thread(_worker, worker_routine, this);
 }
 
+bool zmq::worker_poller_base_t::is_worker_thread () const
+{
+    return _worker.is_current_thread ();
+}
+
 void zmq::worker_poller_base_t::check_thread ()
 {
 #ifdef _DEBUG
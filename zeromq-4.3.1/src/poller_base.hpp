@@ -1,11 +1,10 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
-
 #include "clock.hpp"
 #include "atomic_counter.hpp"
 #include "ctx.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -25,20 +24,30 @@ struct i_poll_events;
 //
 //   Add a timeout to expire in timeout_ milliseconds. After the
 //   expiration, timer_event on sink_ object will be called with
-//   argument set to id_.
-// void add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
+//   argument set to id_. Returns a handle to cancel the timer with.
+// timer_handle_t add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
 //
-//   Cancel the timer created by sink_ object with ID equal to id_.
-// void cancel_timer(zmq::i_poll_events *sink_, int id_);
+//   Cancel a pending timer given the handle returned by add_timer.
+// void cancel_timer(timer_handle_t handle_);
 //
 //   Adds a fd to the poller. Initially, no events are activated. These must
 //   be activated by the set_* methods using the returned handle_.
 // handle_t add_fd(fd_t fd_, zmq::i_poll_events *events_);
 //
+//   Like add_fd, but fails instead of asserting if the fd cannot be polled,
+//   e.g. because it is not open or was added already. Returns 0 and sets
+//   handle_, or -1 with errno set.
+// int try_add_fd(fd_t fd_, zmq::i_poll_events *events_, handle_t &handle_);
+//
 //   Deactivates any events that may be active for the given handle_, and
 //   removes the fd associated with the given handle_.
 // void rm_fd(handle_t handle_);
 //
+//   Like rm_fd, but fails instead of asserting if the fd was closed
+//   before. The handle_ is removed either way. Returns 0, or -1 with
+//   errno set.
+// int try_rm_fd(handle_t handle_);
+//
 //   The set_* and reset_* methods activate resp. deactivate polling for
 //   input/output readiness on the respective handle_, such that the
 //   in_event/out_event methods on the associated zmq::i_poll_events object
@@ -101,10 +110,12 @@ public:
     int iFlag;
 
 public:
+    typedef timer_wheel_t::handle_t timer_handle_t;
+
     // Methods from the poller concept.
     int  get_load() const;
-    void add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
-    void cancel_timer(zmq::i_poll_events *sink_, int id_);
+    timer_handle_t add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
+    void cancel_timer(timer_handle_t handle_);
 
 protected:
     //  Called by individual poller implementations to manage the load.
@@ -118,14 +129,8 @@ private:
     //  Clock instance private to this I/O thread.
     clock_t _clock;
 
-    //  List of active timers.
-    struct timer_info_t
-    {
-        zmq::i_poll_events *sink;
-        int id;
-    };
-    typedef std::multimap<uint64_t, timer_info_t> timers_t;
-    timers_t _timers;
+    //  Active timers.
+    timer_wheel_t _timers;
 
     //  Load of the poller. Currently the number of file descriptors registered.
     atomic_counter_t _load;
@@ -145,6 +150,9 @@ public:
     // Methods from the poller concept.
     void start ();
 
+    //  Returns whether the calling thread is the worker thread.
+    bool is_worker_thread () const;
+
 protected:
     //  Checks whether the currently executing thread is the worker thread
     //  via an assertion.
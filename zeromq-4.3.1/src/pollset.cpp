@@ -108,6 +108,21 @@ void zmq::pollset_t::rm_fd (handle_t handle_)
     adjust_load (-1);
 }
 
+//  Invalid descriptors are only detected once polled.
+int zmq::pollset_t::try_add_fd (fd_t fd_,
+                                i_poll_events *events_,
+                                handle_t &handle_)
+{
+    handle_ = add_fd (fd_, events_);
+    return 0;
+}
+
+int zmq::pollset_t::try_rm_fd (handle_t handle_)
+{
+    rm_fd (handle_);
+    return 0;
+}
+
 void zmq::pollset_t::set_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t *) handle_;
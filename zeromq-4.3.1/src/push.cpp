@@ -35,7 +35,8 @@
 #include "msg.hpp"
 
 zmq::push_t::push_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
-    socket_base_t (parent_, tid_, sid_)
+    socket_base_t (parent_, tid_, sid_),
+    _lb (options)
 {
     options.type = ZMQ_PUSH;
 }
@@ -77,20 +77,19 @@ void zmq::radio_t::xread_activated (pipe_t *pipe_)
     while (pipe_->read (&msg)) {
         //  Apply the subscription to the trie
         if (msg.is_join () || msg.is_leave ()) {
-            std::string group = std::string (msg.group ());
+            const group_key_t group (msg.group ());
 
             if (msg.is_join ())
-                _subscriptions.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (group),
-                                                          pipe_);
+                _subscriptions.insert (group).push_back (pipe_);
             else {
-                std::pair<subscriptions_t::iterator, subscriptions_t::iterator>
-                  range = _subscriptions.equal_range (group);
-
-                for (subscriptions_t::iterator it = range.first;
-                     it != range.second; ++it) {
-                    if (it->second == pipe_) {
-                        _subscriptions.erase (it);
-                        break;
+                group_pipes_t *pipes = _subscriptions.find (group);
+                if (pipes) {
+                    const group_pipes_t::iterator it =
+                      std::find (pipes->begin (), pipes->end (), pipe_);
+                    if (it != pipes->end ()) {
+                        pipes->erase (it);
+                        if (pipes->empty ())
+                            _subscriptions.erase (group);
                     }
                 }
             }
@@ -122,19 +121,24 @@ int zmq::radio_t::xsetsockopt (int option_,
 
 void zmq::radio_t::xpipe_terminated (pipe_t *pipe_)
 {
-    for (subscriptions_t::iterator it = _subscriptions.begin (),
-                                   end = _subscriptions.end ();
-         it != end;) {
-        if (it->second == pipe_) {
-#if __cplusplus >= 201103L
-            it = _subscriptions.erase (it);
-#else
-            _subscriptions.erase (it++);
-#endif
-        } else {
-            ++it;
-        }
+    //  Drop the pipe from every group. Groups left without pipes are only
+    //  collected here, erasing them while walking the table could move
+    //  entries not yet visited into slots already visited.
+    std::vector<group_key_t> unused_groups;
+    for (subscriptions_t::size_type i = 0, n = _subscriptions.capacity ();
+         i != n; ++i) {
+        if (!_subscriptions.occupied (i))
+            continue;
+        group_pipes_t &pipes = _subscriptions.value (i);
+        pipes.erase (std::remove (pipes.begin (), pipes.end (), pipe_),
+                     pipes.end ());
+        if (pipes.empty ())
+            unused_groups.push_back (_subscriptions.key (i));
     }
+    for (std::vector<group_key_t>::iterator it = unused_groups.begin (),
+                                            end = unused_groups.end ();
+         it != end; ++it)
+        _subscriptions.erase (*it);
 
     {
         const udp_pipes_t::iterator end = _udp_pipes.end ();
@@ -157,11 +161,15 @@ int zmq::radio_t::xsend (msg_t *msg_)
 
     _dist.unmatch ();
 
-    std::pair<subscriptions_t::iterator, subscriptions_t::iterator> range =
-      _subscriptions.equal_range (std::string (msg_->group ()));
-
-    for (subscriptions_t::iterator it = range.first; it != range.second; ++it)
-        _dist.match (it->second);
+    //  One lookup per message, then match the group's pipes straight from
+    //  the vector stored in the table.
+    const group_pipes_t *pipes =
+      _subscriptions.find (group_key_t (msg_->group ()));
+    if (pipes)
+        for (group_pipes_t::const_iterator it = pipes->begin (),
+                                           end = pipes->end ();
+             it != end; ++it)
+            _dist.match (*it);
 
     for (udp_pipes_t::iterator it = _udp_pipes.begin (),
                                end = _udp_pipes.end ();
@@ -30,14 +30,13 @@
 #ifndef __ZMQ_RADIO_HPP_INCLUDED__
 #define __ZMQ_RADIO_HPP_INCLUDED__
 
-#include <map>
-#include <string>
 #include <vector>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "dist.hpp"
 #include "msg.hpp"
+#include "group_table.hpp"
 
 namespace zmq
 {
@@ -65,8 +64,10 @@ class radio_t : public socket_base_t
     void xpipe_terminated (zmq::pipe_t *pipe_);
 
   private:
-    //  List of all subscriptions mapped to corresponding pipes.
-    typedef std::multimap<std::string, pipe_t *> subscriptions_t;
+    //  List of all subscriptions mapped to corresponding pipes. A pipe is
+    //  listed once per JOIN it sent for the group.
+    typedef std::vector<pipe_t *> group_pipes_t;
+    typedef group_table_t<group_pipes_t> subscriptions_t;
     subscriptions_t _subscriptions;
 
     //  List of udp pipes
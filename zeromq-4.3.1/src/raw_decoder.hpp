@@ -27,6 +27,13 @@ class raw_decoder_t : public i_decoder
 
     virtual void resize_buffer (size_t) {}
 
+    virtual void set_buffer_pool (buffer_pool_t *pool_)
+    {
+        _allocator.set_pool (pool_);
+    }
+
+    virtual void release_buffer () { _allocator.return_buffer (); }
+
   private:
     msg_t _in_progress;
 
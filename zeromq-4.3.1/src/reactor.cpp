@@ -0,0 +1,411 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "reactor.hpp"
+#include "io_thread.hpp"
+#include "socket_base.hpp"
+#include "err.hpp"
+#include "macros.hpp"
+
+//  Number of times the handler of a socket is called in a row before the
+//  other handlers get their turn.
+static const int socket_batch = 256;
+
+zmq::reactor_t::reactor_t (ctx_t *ctx_, io_thread_t *io_thread_) :
+    object_t (ctx_, io_thread_->get_tid ()),
+    _tag (0xCAFEC0DE),
+    _poller (io_thread_->get_poller ()),
+    _next_timer_id (0)
+{
+}
+
+zmq::reactor_t::~reactor_t ()
+{
+    zmq_assert (_items.empty () && _timers.empty ());
+
+    for (items_t::size_type i = 0; i != _retired.size (); i++)
+        LIBZMQ_DELETE (_retired[i]);
+
+    //  Mark the reactor as dead
+    _tag = 0xdeadbeef;
+}
+
+bool zmq::reactor_t::check_tag () const
+{
+    return _tag == 0xCAFEC0DE;
+}
+
+int zmq::reactor_t::add_fd (fd_t fd_,
+                            short events_,
+                            reactor_fd_fn *handler_,
+                            void *arg_)
+{
+    if (handler_ == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (!events_ || (events_ & ~(ZMQ_POLLIN | ZMQ_POLLOUT))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    item_t *item = new (std::nothrow) item_t ();
+    alloc_assert (item);
+    item->fd = fd_;
+    item->socket = NULL;
+    item->events = events_;
+    item->fd_handler = handler_;
+    item->arg = arg_;
+
+    request_t request;
+    request.type = request_t::add_item;
+    request.item = item;
+    const int rc = execute (request);
+    if (rc == -1)
+        delete item;
+    return rc;
+}
+
+int zmq::reactor_t::remove_fd (fd_t fd_)
+{
+    request_t request;
+    request.type = request_t::remove_fd;
+    request.fd = fd_;
+    return execute (request);
+}
+
+int zmq::reactor_t::add_socket (socket_base_t *socket_,
+                                short events_,
+                                reactor_socket_fn *handler_,
+                                void *arg_)
+{
+    if (handler_ == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (!events_ || (events_ & ~(ZMQ_POLLIN | ZMQ_POLLOUT))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  The socket is watched through its notification file descriptor,
+    //  which thread safe sockets don't have. The sockets of a compact
+    //  context share theirs with the thread that created them, which the
+    //  reactor's thread is not.
+    if (socket_->has_shared_fd ()) {
+        errno = ENOTSUP;
+        return -1;
+    }
+    fd_t fd;
+    size_t fd_size = sizeof fd;
+    if (socket_->getsockopt (ZMQ_FD, &fd, &fd_size) == -1)
+        return -1;
+
+    item_t *item = new (std::nothrow) item_t ();
+    alloc_assert (item);
+    item->fd = fd;
+    item->socket = socket_;
+    item->events = events_;
+    item->socket_handler = handler_;
+    item->arg = arg_;
+
+    request_t request;
+    request.type = request_t::add_item;
+    request.item = item;
+    const int rc = execute (request);
+    if (rc == -1)
+        delete item;
+    return rc;
+}
+
+int zmq::reactor_t::remove_socket (socket_base_t *socket_)
+{
+    request_t request;
+    request.type = request_t::remove_socket;
+    request.socket = socket_;
+    return execute (request);
+}
+
+int zmq::reactor_t::add_timer (size_t interval_,
+                               timers_timer_fn *handler_,
+                               void *arg_)
+{
+    if (handler_ == NULL) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    request_t request;
+    request.type = request_t::add_timer;
+    request.timer.interval = interval_;
+    request.timer.handler = handler_;
+    request.timer.arg = arg_;
+    return execute (request);
+}
+
+int zmq::reactor_t::cancel_timer (int timer_id_)
+{
+    request_t request;
+    request.type = request_t::cancel_timer;
+    request.timer_id = timer_id_;
+    return execute (request);
+}
+
+int zmq::reactor_t::stop ()
+{
+    //  The reactor would be deleted while its handler runs.
+    if (_poller->is_worker_thread ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    request_t request;
+    request.type = request_t::stop;
+    return execute (request);
+}
+
+int zmq::reactor_t::execute (request_t &request_)
+{
+    request_.result = 0;
+
+    //  Handlers run in the I/O thread and can carry out their requests
+    //  straight away.
+    if (_poller->is_worker_thread ())
+        apply (request_);
+    else {
+        scoped_lock_t lock (_sync);
+        request_.done = false;
+        send_reactor (this, &request_);
+        while (!request_.done)
+            _cond.wait (&_sync, -1);
+    }
+
+    if (request_.result == -1)
+        errno = request_.error;
+    return request_.result;
+}
+
+void zmq::reactor_t::process_reactor (void *request_)
+{
+    //  No handler is running, the items removed so far can go.
+    for (items_t::size_type i = 0; i != _retired.size (); i++)
+        LIBZMQ_DELETE (_retired[i]);
+    _retired.clear ();
+
+    request_t *request = static_cast<request_t *> (request_);
+    apply (*request);
+
+    scoped_lock_t lock (_sync);
+    request->done = true;
+    _cond.broadcast ();
+}
+
+void zmq::reactor_t::apply (request_t &request_)
+{
+    switch (request_.type) {
+        case request_t::add_item: {
+            item_t *item = request_.item;
+            for (items_t::size_type i = 0; i != _items.size (); i++)
+                if (_items[i]->fd == item->fd) {
+                    request_.result = -1;
+                    request_.error = EINVAL;
+                    return;
+                }
+            item->poller = _poller;
+            if (_poller->try_add_fd (item->fd, item, item->handle) == -1) {
+                request_.result = -1;
+                request_.error = errno;
+                return;
+            }
+            item->retry = false;
+            if (item->socket) {
+                _poller->set_pollin (item->handle);
+
+                //  The socket may be ready already, without its file
+                //  descriptor signalling it.
+                item->retry_timer = _poller->add_timer (0, item, 0);
+                item->retry = true;
+            } else {
+                if (item->events & ZMQ_POLLIN)
+                    _poller->set_pollin (item->handle);
+                if (item->events & ZMQ_POLLOUT)
+                    _poller->set_pollout (item->handle);
+            }
+            _items.push_back (item);
+            break;
+        }
+
+        case request_t::remove_fd:
+        case request_t::remove_socket:
+            for (items_t::size_type i = 0; i != _items.size (); i++) {
+                item_t *item = _items[i];
+                if (request_.type == request_t::remove_fd
+                      ? !item->socket && item->fd == request_.fd
+                      : item->socket == request_.socket) {
+                    _items[i] = _items.back ();
+                    _items.pop_back ();
+                    if (retire (item) == -1) {
+                        request_.result = -1;
+                        request_.error = errno;
+                    }
+                    return;
+                }
+            }
+            request_.result = -1;
+            request_.error = EINVAL;
+            break;
+
+        case request_t::add_timer: {
+            const int timer_id = ++_next_timer_id;
+            timer_t &timer = _timers[timer_id];
+            timer = request_.timer;
+            timer.handle = _poller->add_timer (
+              static_cast<int> (timer.interval), this, timer_id);
+            timer.armed = true;
+            request_.result = timer_id;
+            break;
+        }
+
+        case request_t::cancel_timer: {
+            const timer_map_t::iterator it = _timers.find (request_.timer_id);
+            if (it == _timers.end ()) {
+                request_.result = -1;
+                request_.error = EINVAL;
+                return;
+            }
+            if (it->second.armed)
+                _poller->cancel_timer (it->second.handle);
+            _timers.erase (it);
+            break;
+        }
+
+        case request_t::stop:
+            for (items_t::size_type i = 0; i != _items.size (); i++)
+                retire (_items[i]);
+            _items.clear ();
+            for (timer_map_t::iterator it = _timers.begin ();
+                 it != _timers.end (); ++it)
+                if (it->second.armed)
+                    _poller->cancel_timer (it->second.handle);
+            _timers.clear ();
+            break;
+    }
+}
+
+int zmq::reactor_t::retire (item_t *item_)
+{
+    const int rc = _poller->try_rm_fd (item_->handle);
+    const int err = errno;
+    if (item_->retry) {
+        _poller->cancel_timer (item_->retry_timer);
+        item_->retry = false;
+    }
+    item_->fd = retired_fd;
+    _retired.push_back (item_);
+    errno = err;
+    return rc;
+}
+
+void zmq::reactor_t::in_event ()
+{
+    //  We are never polled for events.
+    zmq_assert (false);
+}
+
+void zmq::reactor_t::out_event ()
+{
+    //  We are never polled for events.
+    zmq_assert (false);
+}
+
+void zmq::reactor_t::timer_event (int id_)
+{
+    timer_map_t::iterator it = _timers.find (id_);
+    zmq_assert (it != _timers.end ());
+    it->second.armed = false;
+    it->second.handler (id_, it->second.arg);
+
+    //  Unless the handler cancelled it, the timer fires again after its
+    //  interval.
+    it = _timers.find (id_);
+    if (it != _timers.end () && !it->second.armed) {
+        it->second.handle = _poller->add_timer (
+          static_cast<int> (it->second.interval), this, id_);
+        it->second.armed = true;
+    }
+}
+
+void zmq::reactor_t::item_t::check_socket ()
+{
+    for (int i = 0; i != socket_batch; i++) {
+        //  Retrieving the events processes the commands of the socket,
+        //  so that its file descriptor stops signalling.
+        uint32_t ready;
+        size_t ready_size = sizeof ready;
+        if (socket->getsockopt (ZMQ_EVENTS, &ready, &ready_size) == -1)
+            return;
+        ready &= events;
+        if (!ready)
+            return;
+
+        socket_handler (socket, static_cast<short> (ready), arg);
+
+        //  The handler removed the socket.
+        if (fd == retired_fd)
+            return;
+    }
+
+    //  Still ready; let the other handlers run before coming back.
+    if (!retry) {
+        retry_timer = poller->add_timer (0, this, 0);
+        retry = true;
+    }
+}
+
+void zmq::reactor_t::item_t::in_event ()
+{
+    //  Errors are signalled as input, or as errors where no input is
+    //  expected.
+    if (socket)
+        check_socket ();
+    else
+        fd_handler (fd, events & ZMQ_POLLIN ? ZMQ_POLLIN : ZMQ_POLLERR, arg);
+}
+
+void zmq::reactor_t::item_t::out_event ()
+{
+    fd_handler (fd, ZMQ_POLLOUT, arg);
+}
+
+void zmq::reactor_t::item_t::timer_event (int)
+{
+    retry = false;
+    check_socket ();
+}
@@ -0,0 +1,193 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_REACTOR_HPP_INCLUDED__
+#define __ZMQ_REACTOR_HPP_INCLUDED__
+
+#include <map>
+#include <vector>
+
+#include "fd.hpp"
+#include "object.hpp"
+#include "poller.hpp"
+#include "i_poll_events.hpp"
+#include "mutex.hpp"
+#include "condition_variable.hpp"
+#include "timers.hpp"
+
+namespace zmq
+{
+class ctx_t;
+class io_thread_t;
+class socket_base_t;
+
+typedef void(reactor_fd_fn) (fd_t fd_, short events_, void *arg_);
+typedef void(reactor_socket_fn) (void *socket_, short events_, void *arg_);
+
+//  Runs the handlers of file descriptors, sockets and timers registered by
+//  the application directly in the loop of an I/O thread, the objects
+//  being watched by the poller of the thread like any engine.
+//
+//  Requests from other threads are carried out by the I/O thread, the
+//  calls waiting until they are complete so that, for instance, a file
+//  descriptor can be closed as soon as it was removed. Handlers run in the
+//  I/O thread and their requests are carried out in place.
+
+class reactor_t : public object_t, public i_poll_events
+{
+  public:
+    reactor_t (zmq::ctx_t *ctx_, zmq::io_thread_t *io_thread_);
+    ~reactor_t ();
+
+    //  Return false if object is not a reactor.
+    bool check_tag () const;
+
+    int add_fd (fd_t fd_,
+                short events_,
+                reactor_fd_fn *handler_,
+                void *arg_);
+    int remove_fd (fd_t fd_);
+
+    //  The socket is used by the I/O thread until it is removed.
+    int add_socket (socket_base_t *socket_,
+                    short events_,
+                    reactor_socket_fn *handler_,
+                    void *arg_);
+    int remove_socket (socket_base_t *socket_);
+
+    //  Adds a timer repeating every interval_ ms until it is cancelled.
+    //  Returns the id of the timer.
+    int add_timer (size_t interval_, timers_timer_fn *handler_, void *arg_);
+    int cancel_timer (int timer_id_);
+
+    //  Removes all the registrations. Must be called before the reactor
+    //  is deleted, and not from a handler.
+    int stop ();
+
+    //  i_poll_events implementation, for the timers.
+    void in_event ();
+    void out_event ();
+    void timer_event (int id_);
+
+  private:
+    //  A registered file descriptor or socket.
+    struct item_t : public i_poll_events
+    {
+        poller_t *poller;
+        fd_t fd;
+        socket_base_t *socket;
+        short events;
+        reactor_fd_fn *fd_handler;
+        reactor_socket_fn *socket_handler;
+        void *arg;
+        poller_t::handle_t handle;
+
+        //  Whether a timer is armed to check the socket again.
+        bool retry;
+        poller_t::timer_handle_t retry_timer;
+
+        //  Calls the handler for as long as the socket has the events it
+        //  is registered for, up to a batch.
+        void check_socket ();
+
+        void in_event ();
+        void out_event ();
+        void timer_event (int id_);
+    };
+
+    struct timer_t
+    {
+        size_t interval;
+        timers_timer_fn *handler;
+        void *arg;
+
+        //  Whether the timer is in the poller. It isn't while its handler
+        //  runs.
+        bool armed;
+        poller_t::timer_handle_t handle;
+    };
+
+    struct request_t
+    {
+        enum
+        {
+            add_item,
+            remove_fd,
+            remove_socket,
+            add_timer,
+            cancel_timer,
+            stop
+        } type;
+        item_t *item;
+        fd_t fd;
+        socket_base_t *socket;
+        int timer_id;
+        timer_t timer;
+
+        int result;
+        int error;
+        bool done;
+    };
+
+    //  Has the I/O thread carry out the request.
+    int execute (request_t &request_);
+
+    //  Carries out the request in the I/O thread.
+    void apply (request_t &request_);
+
+    void process_reactor (void *request_);
+
+    //  Removes the item from the poller. It is deleted once its handler
+    //  cannot be running anymore. Returns -1 if its file descriptor was
+    //  closed before, the item being removed all the same.
+    int retire (item_t *item_);
+
+    //  Used to check whether the object is a reactor.
+    uint32_t _tag;
+
+    poller_t *_poller;
+
+    typedef std::vector<item_t *> items_t;
+    items_t _items;
+    items_t _retired;
+
+    typedef std::map<int, timer_t> timer_map_t;
+    timer_map_t _timers;
+    int _next_timer_id;
+
+    //  Synchronisation of the requests with the I/O thread.
+    mutex_t _sync;
+    condition_variable_t _cond;
+
+    reactor_t (const reactor_t &);
+    const reactor_t &operator= (const reactor_t &);
+};
+}
+
+#endif
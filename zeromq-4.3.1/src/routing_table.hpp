@@ -0,0 +1,252 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_ROUTING_TABLE_HPP_INCLUDED__
+#define __ZMQ_ROUTING_TABLE_HPP_INCLUDED__
+
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "stdint.hpp"
+#include "err.hpp"
+
+namespace zmq
+{
+//  Open-addressing hash table mapping routing IDs (opaque byte strings) to
+//  values of type T. Linear probing over a power-of-two sized slot vector,
+//  backward-shift deletion, growth when half full.
+//
+//  Routing IDs up to inline_size bytes, which covers the 5-byte IDs
+//  generated by ROUTER and STREAM sockets, are stored in the slot itself;
+//  only longer IDs are copied to the heap. Each slot also caches the hash
+//  so that most mismatches are rejected without touching the key bytes.
+//
+//  Lookups take a plain pointer and size, so callers can probe the table
+//  with the routing ID frame of a message without building a blob_t.
+//
+//  T has to be cheaply copyable, it is moved around by assignment.
+
+template <typename T> class routing_table_t
+{
+  public:
+    typedef size_t size_type;
+
+    inline routing_table_t () : _size (0) {}
+
+    ~routing_table_t ()
+    {
+        for (typename slots_t::iterator it = _slots.begin (),
+                                        end = _slots.end ();
+             it != end; ++it)
+            if (it->used)
+                release_key (*it);
+    }
+
+    inline size_type size () const { return _size; }
+
+    inline bool empty () const { return _size == 0; }
+
+    inline size_type capacity () const { return _slots.size (); }
+
+    inline bool occupied (size_type index_) const
+    {
+        return _slots[index_].used;
+    }
+
+    inline T &value (size_type index_) { return _slots[index_].value; }
+
+    //  Returns the value stored for the routing ID or NULL if there is none.
+    inline T *find (const unsigned char *data_, size_t size_)
+    {
+        const size_type index = lookup (data_, size_, hash (data_, size_));
+        return index == npos ? NULL : &_slots[index].value;
+    }
+
+    inline const T *find (const unsigned char *data_, size_t size_) const
+    {
+        const size_type index = lookup (data_, size_, hash (data_, size_));
+        return index == npos ? NULL : &_slots[index].value;
+    }
+
+    //  Adds the routing ID with the given value. Returns false, leaving the
+    //  table untouched, if the routing ID is already present.
+    bool insert (const unsigned char *data_, size_t size_, const T &value_)
+    {
+        const uint32_t h = hash (data_, size_);
+        if (lookup (data_, size_, h) != npos)
+            return false;
+
+        if ((_size + 1) * 2 > _slots.size ())
+            grow ();
+
+        const size_type mask = _slots.size () - 1;
+        size_type i = h & mask;
+        while (_slots[i].used)
+            i = (i + 1) & mask;
+
+        slot_t &slot = _slots[i];
+        slot.used = true;
+        slot.hash = h;
+        slot.size = size_;
+        unsigned char *key = slot.key.bytes;
+        if (size_ > inline_size) {
+            key = static_cast<unsigned char *> (malloc (size_));
+            alloc_assert (key);
+            slot.key.heap = key;
+        }
+        if (size_)
+            memcpy (key, data_, size_);
+        slot.value = value_;
+        _size++;
+        return true;
+    }
+
+    //  Removes the routing ID. Returns false if it was not present. If
+    //  value_ is not NULL, it is set to the value being removed.
+    bool erase (const unsigned char *data_, size_t size_, T *value_ = NULL)
+    {
+        size_type i = lookup (data_, size_, hash (data_, size_));
+        if (i == npos)
+            return false;
+
+        if (value_)
+            *value_ = _slots[i].value;
+        release_key (_slots[i]);
+
+        //  Shift the following entries of the cluster back into the hole
+        //  unless their home slot lies cyclically within (hole, entry].
+        const size_type mask = _slots.size () - 1;
+        for (size_type j = (i + 1) & mask; _slots[j].used; j = (j + 1) & mask) {
+            const size_type k = _slots[j].hash & mask;
+            const bool in_place =
+              i <= j ? (i < k && k <= j) : (i < k || k <= j);
+            if (in_place)
+                continue;
+            _slots[i] = _slots[j];
+            i = j;
+        }
+
+        _slots[i].used = false;
+        _size--;
+        return true;
+    }
+
+  private:
+    enum
+    {
+        inline_size = 16
+    };
+
+    static const size_type npos = static_cast<size_type> (-1);
+
+    struct slot_t
+    {
+        slot_t () : used (false), hash (0), size (0) {}
+
+        bool used;
+        uint32_t hash;
+        size_t size;
+        union
+        {
+            unsigned char bytes[inline_size];
+            unsigned char *heap;
+        } key;
+        T value;
+
+        inline const unsigned char *data () const
+        {
+            return size > inline_size ? key.heap : key.bytes;
+        }
+    };
+    typedef std::vector<slot_t> slots_t;
+
+    //  FNV-1a followed by a multiplicative mix, so that the low bits used
+    //  for indexing depend on all the bytes of the routing ID.
+    static inline uint32_t hash (const unsigned char *data_, size_t size_)
+    {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i != size_; i++) {
+            h ^= data_[i];
+            h *= 0x100000001b3ULL;
+        }
+        h ^= h >> 32;
+        h *= 0x9e3779b97f4a7c15ULL;
+        return static_cast<uint32_t> (h >> 32);
+    }
+
+    size_type
+    lookup (const unsigned char *data_, size_t size_, uint32_t hash_) const
+    {
+        if (_size == 0)
+            return npos;
+        const size_type mask = _slots.size () - 1;
+        for (size_type i = hash_ & mask; _slots[i].used; i = (i + 1) & mask) {
+            const slot_t &slot = _slots[i];
+            if (slot.hash == hash_ && slot.size == size_
+                && (size_ == 0 || memcmp (slot.data (), data_, size_) == 0))
+                return i;
+        }
+        return npos;
+    }
+
+    static void release_key (slot_t &slot_)
+    {
+        if (slot_.size > inline_size)
+            free (slot_.key.heap);
+    }
+
+    void grow ()
+    {
+        slots_t old;
+        old.swap (_slots);
+        _slots.resize (old.empty () ? 8 : old.size () * 2);
+
+        //  Slots are relocated by plain copy, heap keys change owner.
+        const size_type mask = _slots.size () - 1;
+        for (typename slots_t::iterator it = old.begin (), end = old.end ();
+             it != end; ++it) {
+            if (!it->used)
+                continue;
+            size_type i = it->hash & mask;
+            while (_slots[i].used)
+                i = (i + 1) & mask;
+            _slots[i] = *it;
+        }
+    }
+
+    slots_t _slots;
+    size_type _size;
+
+    routing_table_t (const routing_table_t &);
+    const routing_table_t &operator= (const routing_table_t &);
+};
+}
+
+#endif
@@ -38,6 +38,7 @@
 
 zmq::server_t::server_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_, true),
+    _out_pipes_count (0),
     _next_routing_id (generate_random ())
 {
     options.type = ZMQ_SERVER;
@@ -45,7 +46,7 @@ zmq::server_t::server_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
 
 zmq::server_t::~server_t ()
 {
-    zmq_assert (_out_pipes.empty ());
+    zmq_assert (_out_pipes_count == 0);
 }
 
 void zmq::server_t::xattach_pipe (pipe_t *pipe_,
@@ -57,25 +58,33 @@ void zmq::server_t::xattach_pipe (pipe_t *pipe_,
 
     zmq_assert (pipe_);
 
+    //  Keep the slot array at most half full so that a free slot is found
+    //  after a couple of increments.
+    if ((_out_pipes_count + 1) * 2 > _out_pipes.size ())
+        grow_out_pipes ();
+
+    const uint32_t mask = static_cast<uint32_t> (_out_pipes.size () - 1);
     uint32_t routing_id = _next_routing_id++;
-    if (!routing_id)
-        routing_id = _next_routing_id++; //  Never use Routing ID zero
+    //  Never use Routing ID zero
+    while (!routing_id || _out_pipes[routing_id & mask].pipe)
+        routing_id = _next_routing_id++;
 
     pipe_->set_server_socket_routing_id (routing_id);
     //  Add the record into output pipes lookup table
-    outpipe_t outpipe = {pipe_, true};
-    bool ok = _out_pipes.ZMQ_MAP_INSERT_OR_EMPLACE (routing_id, outpipe).second;
-    zmq_assert (ok);
+    const outpipe_t outpipe = {pipe_, true, routing_id};
+    _out_pipes[routing_id & mask] = outpipe;
+    _out_pipes_count++;
 
     _fq.attach (pipe_);
 }
 
 void zmq::server_t::xpipe_terminated (pipe_t *pipe_)
 {
-    out_pipes_t::iterator it =
-      _out_pipes.find (pipe_->get_server_socket_routing_id ());
-    zmq_assert (it != _out_pipes.end ());
-    _out_pipes.erase (it);
+    outpipe_t *outpipe =
+      lookup_out_pipe (pipe_->get_server_socket_routing_id ());
+    zmq_assert (outpipe);
+    outpipe->pipe = NULL;
+    _out_pipes_count--;
     _fq.pipe_terminated (pipe_);
 }
 
@@ -86,15 +95,11 @@ void zmq::server_t::xread_activated (pipe_t *pipe_)
 
 void zmq::server_t::xwrite_activated (pipe_t *pipe_)
 {
-    const out_pipes_t::iterator end = _out_pipes.end ();
-    out_pipes_t::iterator it;
-    for (it = _out_pipes.begin (); it != end; ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != _out_pipes.end ());
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    outpipe_t *outpipe =
+      lookup_out_pipe (pipe_->get_server_socket_routing_id ());
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::server_t::xsend (msg_t *msg_)
@@ -105,12 +110,11 @@ int zmq::server_t::xsend (msg_t *msg_)
         return -1;
     }
     //  Find the pipe associated with the routing stored in the message.
-    uint32_t routing_id = msg_->get_routing_id ();
-    out_pipes_t::iterator it = _out_pipes.find (routing_id);
+    outpipe_t *outpipe = lookup_out_pipe (msg_->get_routing_id ());
 
-    if (it != _out_pipes.end ()) {
-        if (!it->second.pipe->check_write ()) {
-            it->second.active = false;
+    if (outpipe) {
+        if (!outpipe->pipe->check_write ()) {
+            outpipe->active = false;
             errno = EAGAIN;
             return -1;
         }
@@ -123,13 +127,13 @@ int zmq::server_t::xsend (msg_t *msg_)
     int rc = msg_->reset_routing_id ();
     errno_assert (rc == 0);
 
-    bool ok = it->second.pipe->write (msg_);
+    bool ok = outpipe->pipe->write (msg_);
     if (unlikely (!ok)) {
         // Message failed to send - we must close it ourselves.
         rc = msg_->close ();
         errno_assert (rc == 0);
     } else
-        it->second.pipe->flush ();
+        outpipe->pipe->flush ();
 
     //  Detach the message from the data buffer.
     rc = msg_->init ();
@@ -179,3 +183,29 @@ bool zmq::server_t::xhas_out ()
     //  to be routed to.
     return true;
 }
+
+zmq::server_t::outpipe_t *zmq::server_t::lookup_out_pipe (uint32_t routing_id_)
+{
+    if (_out_pipes.empty ())
+        return NULL;
+    outpipe_t &outpipe = _out_pipes[routing_id_ & (_out_pipes.size () - 1)];
+    if (!outpipe.pipe || outpipe.routing_id != routing_id_)
+        return NULL;
+    return &outpipe;
+}
+
+void zmq::server_t::grow_out_pipes ()
+{
+    out_pipes_t old;
+    old.swap (_out_pipes);
+    const outpipe_t empty = {NULL, false, 0};
+    _out_pipes.resize (old.empty () ? 16 : old.size () * 2, empty);
+
+    //  Records occupying distinct slots under the old mask differ in those
+    //  low bits, so they cannot collide under the wider one either.
+    const uint32_t mask = static_cast<uint32_t> (_out_pipes.size () - 1);
+    for (out_pipes_t::iterator it = old.begin (), end = old.end (); it != end;
+         ++it)
+        if (it->pipe)
+            _out_pipes[it->routing_id & mask] = *it;
+}
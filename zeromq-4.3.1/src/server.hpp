@@ -30,7 +30,7 @@
 #ifndef __ZMQ_SERVER_HPP_INCLUDED__
 #define __ZMQ_SERVER_HPP_INCLUDED__
 
-#include <map>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
@@ -71,14 +71,31 @@ class server_t : public socket_base_t
     {
         zmq::pipe_t *pipe;
         bool active;
+        uint32_t routing_id;
     };
 
-    //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<uint32_t, outpipe_t> out_pipes_t;
+    //  Returns the outbound pipe record for the routing ID, NULL if there
+    //  is no such peer.
+    outpipe_t *lookup_out_pipe (uint32_t routing_id_);
+
+    //  Doubles the size of the slot array, moving every record to the slot
+    //  selected by the wider mask.
+    void grow_out_pipes ();
+
+    //  Outbound pipes indexed directly by the low bits of the peer IDs.
+    //  The array size is a power of two and routing IDs are only ever
+    //  handed out for free slots, so each peer owns the slot
+    //  'routing_id & (size - 1)' and lookups need no search. A free slot
+    //  has a NULL pipe.
+    typedef std::vector<outpipe_t> out_pipes_t;
     out_pipes_t _out_pipes;
 
+    //  Number of used slots in _out_pipes.
+    size_t _out_pipes_count;
+
     //  Routing IDs are generated. It's a simple increment and wrap-over
     //  algorithm. This value is the next ID to use (if not used already).
+    //  IDs whose slot is taken are skipped.
     uint32_t _next_routing_id;
 
     server_t (const server_t &);
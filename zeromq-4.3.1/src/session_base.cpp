@@ -17,6 +17,7 @@
 #include "udp_engine.hpp"
 
 #include "ctx.hpp"
+#include "io_thread.hpp"
 #include "req.hpp"
 #include "radio.hpp"
 #include "dish.hpp"
@@ -311,6 +312,26 @@ void zmq::session_base_t::hiccuped (pipe_t *)
     zmq_assert (false);
 }
 
+bool zmq::session_base_t::submit_crypto_job (crypto_job_t *job_)
+{
+    crypto_pool_t *pool = _io_thread->get_crypto_pool ();
+    if (!pool)
+        return false;
+    pool->submit (job_, _io_thread);
+    return true;
+}
+
+void zmq::session_base_t::crypto_job_done ()
+{
+    zmq_assert (_engine);
+    _engine->crypto_job_done ();
+}
+
+std::string &zmq::session_base_t::mechanism_state ()
+{
+    return _mechanism_state;
+}
+
 zmq::socket_base_t *zmq::session_base_t::get_socket()
 {
     return _socket;
@@ -400,6 +421,12 @@ void zmq::session_base_t::process_attach(i_engine * engine_)
         //  Plug the local end of the pipe.
         pipes[0]->set_event_sink(this);
 
+        //  Scheduling parameters of the socket's end are the ones in effect
+        //  when this connection was set up.
+        pipes[1]->set_lb_weight (options.lb_weight);
+        pipes[1]->set_fq_priority (options.fq_priority);
+        pipes[1]->set_fq_weight (options.fq_weight);
+
         //  Remember the local end of the pipe.
         zmq_assert (!_pipe);
         _pipe = pipes[0];
@@ -13,6 +13,7 @@ namespace zmq
 class  io_thread_t;
 struct i_engine;
 struct address_t;
+class  crypto_job_t;
 
 class session_base_t : public own_t, public io_object_t, public i_pipe_events
 {
@@ -43,6 +44,18 @@ public:
     int zap_connect ();
     bool zap_enabled ();
 
+    //  Hands the job to the crypto pool of the context. Returns false if
+    //  there is none, in which case the caller does the work itself.
+    bool submit_crypto_job (crypto_job_t *job_);
+
+    //  Called by the mechanism once its crypto job has completed, so that
+    //  the engine carries on with the handshake.
+    void crypto_job_done ();
+
+    //  State the security mechanism keeps from one connection of the
+    //  session to the next, e.g. a CURVE resumption ticket.
+    std::string &mechanism_state ();
+
     //  Fetches a message. Returns 0 if successful; -1 otherwise.
     //  The caller is responsible for freeing the message when no
     //  longer used.
@@ -145,6 +158,9 @@ private:
     //  Protocol and address to use when connecting.
     address_t *_addr;
 
+    //  See mechanism_state.
+    std::string _mechanism_state;
+
 private:
     session_base_t (const session_base_t &);
     const session_base_t &operator= (const session_base_t &);
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <unistd.h>
 #include <ctype.h>
+#include <limits.h>
 
 #include "precompiled.hpp"
 #include "macros.hpp"
@@ -15,6 +16,7 @@
 #include "io_thread.hpp"
 #include "session_base.hpp"
 #include "config.hpp"
+#include "clock.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "ctx.hpp"
@@ -27,6 +29,7 @@
 #include "tipc_address.hpp"
 #include "mailbox.hpp"
 #include "mailbox_safe.hpp"
+#include "compact_mailbox.hpp"
 
 #ifdef ZMQ_HAVE_OPENPGM
 #include "pgm_socket.hpp"
@@ -52,14 +55,34 @@
 #include "scatter.hpp"
 #include "dgram.hpp"
 
+zmq::socket_base_t::inprocs_t::inprocs_t () : _inprocs (NULL)
+{
+}
+
+zmq::socket_base_t::inprocs_t::~inprocs_t ()
+{
+    LIBZMQ_DELETE (_inprocs);
+}
+
 void zmq::socket_base_t::inprocs_t::emplace(const char *endpoint_uri_, pipe_t *pipe_)
 {
-    _inprocs.ZMQ_MAP_INSERT_OR_EMPLACE (std::string (endpoint_uri_), pipe_);
+    if (!_inprocs) 
+    {
+        _inprocs = new (std::nothrow) map_t ();
+        alloc_assert (_inprocs);
+    }
+    _inprocs->ZMQ_MAP_INSERT_OR_EMPLACE (std::string (endpoint_uri_), pipe_);
 }
 
 int zmq::socket_base_t::inprocs_t::erase_pipes(const std::string &endpoint_uri_str_)
 {
-    const std::pair<map_t::iterator, map_t::iterator> range = _inprocs.equal_range (endpoint_uri_str_);
+    if (!_inprocs) 
+    {
+        errno = ENOENT;
+        return -1;
+    }
+
+    const std::pair<map_t::iterator, map_t::iterator> range = _inprocs->equal_range (endpoint_uri_str_);
     if (range.first == range.second) 
     {
         errno = ENOENT;
@@ -71,16 +94,19 @@ int zmq::socket_base_t::inprocs_t::erase_pipes(const std::string &endpoint_uri_s
         it->second->terminate(true);
     }
 
-    _inprocs.erase (range.first, range.second);
+    _inprocs->erase (range.first, range.second);
     return 0;
 }
 
 void zmq::socket_base_t::inprocs_t::erase_pipe(pipe_t *pipe_)
 {
-    for (map_t::iterator it = _inprocs.begin(), end = _inprocs.end(); it != end; ++it)
+    if (!_inprocs)
+        return;
+
+    for (map_t::iterator it = _inprocs->begin(), end = _inprocs->end(); it != end; ++it)
         if (it->second == pipe_) 
         {
-            _inprocs.erase (it);
+            _inprocs->erase (it);
             break;
         }
 }
@@ -137,14 +163,21 @@ zmq::socket_base_t *zmq::socket_base_t::create(int type_, class ctx_t *parent_,
 
 zmq::socket_base_t::socket_base_t (ctx_t *parent_, uint32_t tid_, int sid_, bool thread_safe_) :
     own_t (parent_, tid_),
+    _endpoints (NULL),
     _tag (0xbaddecaf),
     _ctx_terminated (false),
     _destroyed (false),
+    _compact (false),
     _poller (NULL),
     _handle (static_cast<poller_t::handle_t> (NULL)),
     _last_tsc (0),
+    _command_delay (0),
+    _min_command_delay (0),
+    _max_command_delay (0),
+    _command_delay_calibrated (false),
     _ticks (0),
     _rcvmore (false),
+    _flush_deferred (false),
     _monitor_socket (NULL),
     _monitor_events (0),
     _thread_safe (thread_safe_),
@@ -156,12 +189,28 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_, uint32_t tid_, int sid_, bool
     options.ipv6      = (parent_->get(ZMQ_IPV6) != 0);
     options.linger.store(parent_->get(ZMQ_BLOCKY) ? -1 : 0);
     options.zero_copy = (parent_->get(ZMQ_ZERO_COPY_RECV) != 0);
+    update_command_delay ();
 
     if (_thread_safe) 
     {
         _mailbox = new (std::nothrow) mailbox_safe_t (&_sync);
         zmq_assert (_mailbox);
     } 
+    else if (parent_->get (ZMQ_COMPACT_SOCKETS))
+    {
+        //  Use the signaler of the calling thread.
+        shared_signaler_t *signaler = parent_->acquire_shared_signaler ();
+        if (signaler)
+        {
+            _mailbox = new (std::nothrow) compact_mailbox_t (signaler);
+            zmq_assert (_mailbox);
+            _compact = true;
+        }
+        else
+        {
+            _mailbox = NULL;
+        }
+    }
     else 
     {
         // 
@@ -192,9 +241,18 @@ int zmq::socket_base_t::get_peer_state(const void *routing_id_, size_t routing_i
 
 zmq::socket_base_t::~socket_base_t ()
 {
+    if (_compact)
+    {
+        shared_signaler_t *signaler = (static_cast<compact_mailbox_t *> (_mailbox))->unshare ();
+        if (signaler)
+            get_ctx ()->release_shared_signaler (signaler);
+    }
+
     if (_mailbox)
         LIBZMQ_DELETE(_mailbox);
 
+    LIBZMQ_DELETE (_endpoints);
+
     if (_reaper_signaler)
         LIBZMQ_DELETE(_reaper_signaler);
 
@@ -209,6 +267,28 @@ zmq::i_mailbox * zmq::socket_base_t::get_mailbox() const
     return _mailbox;
 }
 
+zmq::fd_t zmq::socket_base_t::get_mailbox_fd () const
+{
+    if (_compact)
+        return (static_cast<compact_mailbox_t *> (_mailbox))->get_fd ();
+    return (static_cast<mailbox_t *> (_mailbox))->get_fd ();
+}
+
+zmq::socket_base_t::endpoints_t &zmq::socket_base_t::endpoints ()
+{
+    if (!_endpoints)
+    {
+        _endpoints = new (std::nothrow) endpoints_t ();
+        alloc_assert (_endpoints);
+    }
+    return *_endpoints;
+}
+
+bool zmq::socket_base_t::has_endpoint (const std::string &endpoint_uri_) const
+{
+    return _endpoints && _endpoints->count (endpoint_uri_) != 0;
+}
+
 void zmq::socket_base_t::stop()
 {
     //  Called by ctx when it is terminated (zmq_ctx_term).
@@ -292,9 +372,12 @@ void zmq::socket_base_t::attach_pipe(pipe_t *pipe_, bool subscribe_to_all_, bool
     //  First, register the pipe so that we can terminate it later on.
     pipe_->set_event_sink(this);
     _pipes.push_back(pipe_);
+    if (_flush_deferred)
+        pipe_->set_flush_deferred (true);
 
     //  Let the derived socket type know about new pipe.
     xattach_pipe(pipe_, subscribe_to_all_, locally_initiated_);
+    events_changed ();
 
     //  If the socket is already being closed, ask any new pipes to terminate
     //  straight away.
@@ -328,9 +411,36 @@ int zmq::socket_base_t::setsockopt(int option_, const void *optval_, size_t optv
 
     update_pipe_options(option_);
 
+    if (rc == 0 && option_ == ZMQ_COMMAND_DELAY)
+        update_command_delay ();
+
     return rc;
 }
 
+void zmq::socket_base_t::update_command_delay ()
+{
+    //  No delay is no delay at any rate of the clock.
+    if (options.command_delay == 0) {
+        _command_delay_calibrated = true;
+        _min_command_delay = _max_command_delay = _command_delay = 0;
+        return;
+    }
+
+    const uint64_t ticks_per_ms = clock_t::rdtsc_per_ms ();
+    _command_delay_calibrated = ticks_per_ms != 0;
+
+    if (!_command_delay_calibrated)
+        _min_command_delay = _max_command_delay = uncalibrated_command_delay;
+    else if (options.command_delay < 0) {
+        _min_command_delay = ticks_per_ms * min_command_delay / 1000;
+        _max_command_delay = ticks_per_ms * max_command_delay / 1000;
+    } else
+        _min_command_delay = _max_command_delay =
+          ticks_per_ms * options.command_delay / 1000;
+
+    _command_delay = _max_command_delay;
+}
+
 int zmq::socket_base_t::getsockopt(int option_, void *optval_, size_t *optvallen_)
 {
     scoped_optional_lock_t sync_lock(_thread_safe ? &_sync : NULL);
@@ -355,7 +465,7 @@ int zmq::socket_base_t::getsockopt(int option_, void *optval_, size_t *optvallen
             return -1;
         }
 
-        return do_getsockopt<fd_t> (optval_, optvallen_, (static_cast<mailbox_t *>(_mailbox))->get_fd());
+        return do_getsockopt<fd_t> (optval_, optvallen_, get_mailbox_fd ());
     }
 
     if (option_ == ZMQ_EVENTS) 
@@ -413,6 +523,21 @@ void zmq::socket_base_t::remove_signaler (signaler_t *s_)
     (static_cast<mailbox_safe_t *> (_mailbox))->remove_signaler (s_);
 }
 
+void zmq::socket_base_t::add_watcher (i_socket_watcher *watcher_)
+{
+    zmq_assert (!_thread_safe);
+
+    _watchers.push_back (watcher_);
+}
+
+void zmq::socket_base_t::remove_watcher (i_socket_watcher *watcher_)
+{
+    const watchers_t::iterator it =
+      std::find (_watchers.begin (), _watchers.end (), watcher_);
+    if (it != _watchers.end ())
+        _watchers.erase (it);
+}
+
 int zmq::socket_base_t::bind(const char *endpoint_uri_)
 {
     scoped_optional_lock_t sync_lock(_thread_safe ? &_sync : NULL);
@@ -502,6 +627,9 @@ int zmq::socket_base_t::bind(const char *endpoint_uri_)
         bool conflates[2] = {false, false};
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+        new_pipes[0]->set_fq_priority (options.fq_priority);
+        new_pipes[0]->set_fq_weight (options.fq_weight);
 
         //  Attach local end of the pipe to the socket object.
         attach_pipe (new_pipes[0], true, true);
@@ -672,6 +800,15 @@ int zmq::socket_base_t::connect(const char * endpoint_uri_)
 
         errno_assert (rc == 0);
 
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+        new_pipes[0]->set_fq_priority (options.fq_priority);
+        new_pipes[0]->set_fq_weight (options.fq_weight);
+        if (peer.socket) {
+            new_pipes[1]->set_lb_weight (peer.options.lb_weight);
+            new_pipes[1]->set_fq_priority (peer.options.fq_priority);
+            new_pipes[1]->set_fq_weight (peer.options.fq_weight);
+        }
+
         if (!peer.socket) 
         {
             //  The peer doesn't exist yet so we don't know whether
@@ -719,7 +856,7 @@ int zmq::socket_base_t::connect(const char * endpoint_uri_)
     
     if (unlikely (is_single_connect)) 
     {
-        if (0 != _endpoints.count (endpoint_uri_)) 
+        if (has_endpoint (endpoint_uri_)) 
         {
             // There is no valid use for multiple connects for SUB-PUB nor
             // DEALER-ROUTER nor REQ-REP. Multiple connects produces
@@ -882,6 +1019,9 @@ int zmq::socket_base_t::connect(const char * endpoint_uri_)
 
         rc = pipepair(parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
+        new_pipes[0]->set_lb_weight (options.lb_weight);
+        new_pipes[0]->set_fq_priority (options.fq_priority);
+        new_pipes[0]->set_fq_weight (options.fq_weight);
 
         //  Attach local end of the pipe to the socket object.
         attach_pipe(new_pipes[0], subscribe_to_all, true);
@@ -906,14 +1046,14 @@ std::string zmq::socket_base_t::resolve_tcp_addr(std::string endpoint_uri_, cons
     // IPv4-in-IPv6 mapping (EG: tcp://[::ffff:127.0.0.1]:9999), so try to
     // resolve before giving up. Given at this stage we don't know whether a
     // socket is connected or bound, try with both.
-    if (_endpoints.find (endpoint_uri_) == _endpoints.end ()) {
+    if (!has_endpoint (endpoint_uri_)) {
         tcp_address_t *tcp_addr = new (std::nothrow) tcp_address_t ();
         alloc_assert (tcp_addr);
         int rc = tcp_addr->resolve (tcp_address_, false, options.ipv6);
 
         if (rc == 0) {
             tcp_addr->to_string (endpoint_uri_);
-            if (_endpoints.find (endpoint_uri_) == _endpoints.end ()) {
+            if (!has_endpoint (endpoint_uri_)) {
                 rc = tcp_addr->resolve (tcp_address_, true, options.ipv6);
                 if (rc == 0) {
                     tcp_addr->to_string (endpoint_uri_);
@@ -930,7 +1070,7 @@ void zmq::socket_base_t::add_endpoint(const char *endpoint_uri_, own_t *endpoint
     //  Activate the session. Make it a child of this socket.
     launch_child(endpoint_);
 
-    _endpoints.ZMQ_MAP_INSERT_OR_EMPLACE(std::string(endpoint_uri_), endpoint_pipe_t (endpoint_, pipe_));
+    endpoints ().ZMQ_MAP_INSERT_OR_EMPLACE(std::string(endpoint_uri_), endpoint_pipe_t (endpoint_, pipe_));
 
     if (pipe_ != NULL)
     {
@@ -984,8 +1124,12 @@ int zmq::socket_base_t::term_endpoint (const char *endpoint_uri_)
         : endpoint_uri_str;
 
     //  Find the endpoints range (if any) corresponding to the endpoint_uri_ string.
+    if (!_endpoints) {
+        errno = ENOENT;
+        return -1;
+    }
     const std::pair<endpoints_t::iterator, endpoints_t::iterator> range =
-      _endpoints.equal_range (resolved_endpoint_uri);
+      _endpoints->equal_range (resolved_endpoint_uri);
     if (range.first == range.second) {
         errno = ENOENT;
         return -1;
@@ -997,7 +1141,7 @@ int zmq::socket_base_t::term_endpoint (const char *endpoint_uri_)
             it->second.second->terminate (false);
         term_child (it->second.first);
     }
-    _endpoints.erase (range.first, range.second);
+    _endpoints->erase (range.first, range.second);
     return 0;
 }
 
@@ -1019,6 +1163,8 @@ int zmq::socket_base_t::send(msg_t *msg_, int flags_)
         return -1;
     }
 
+    events_changed ();
+
     //  Process pending commands, if any.
     int rc = process_commands(0, true);
     if (unlikely (rc != 0)) 
@@ -1035,13 +1181,22 @@ int zmq::socket_base_t::send(msg_t *msg_, int flags_)
 
     msg_->reset_metadata ();
 
+    if (flags_ & ZMQ_DONTFLUSH)
+        defer_flushes ();
+
     //  Try to send the message using method in each socket class
     rc = xsend(msg_);
     if (rc == 0) 
     {
+        if (!(flags_ & ZMQ_DONTFLUSH))
+            flush_deferred ();
         return 0;
     }
 
+    //  The peers can only make room once they see the messages held back
+    //  by ZMQ_DONTFLUSH.
+    flush_deferred ();
+
     //  Special case for ZMQ_PUSH: -2 means pipe is dead while a
     //  multi-part send is in progress and can't be recovered, so drop
     //  silently when in blocking mode to keep backward compatibility.
@@ -1125,6 +1280,8 @@ int zmq::socket_base_t::recv(msg_t *msg_, int flags_)
         return -1;
     }
 
+    events_changed ();
+
     //  Once every inbound_poll_rate messages check for signals and process
     //  incoming commands. This happens only if we are not polling altogether
     //  because there are messages available all the time. If poll occurs,
@@ -1222,6 +1379,100 @@ int zmq::socket_base_t::recv(msg_t *msg_, int flags_)
     return 0;
 }
 
+int zmq::socket_base_t::recv_multi (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+
+    if (unlikely (!msgs_ || count_ == 0 || count_ > INT_MAX))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  Check all the messages up front so that no part is received into
+    //  an invalid one once some have been consumed.
+    for (size_t i = 0; i != count_; i++)
+    {
+        if (unlikely (!msgs_[i].check ()))
+        {
+            errno = EFAULT;
+            return -1;
+        }
+    }
+
+    //  The first part goes through the regular path which processes
+    //  commands and waits as requested.
+    int rc = recv (&msgs_[0], flags_);
+    if (rc != 0)
+        return -1;
+
+    //  The following parts are read straight from the pipes; commands are
+    //  not processed again until the next call.
+    size_t received = 1;
+    while (received < count_)
+    {
+        rc = xrecv (&msgs_[received]);
+        if (rc != 0)
+            break;
+        extract_flags (&msgs_[received]);
+        received++;
+    }
+
+    //  Account for the parts read in the command throttle so that commands
+    //  are processed on the next call at the latest.
+    _ticks += static_cast<int> (received - 1);
+    if (_ticks >= inbound_poll_rate)
+        _ticks = inbound_poll_rate - 1;
+
+    return static_cast<int> (received);
+}
+
+int zmq::socket_base_t::send_multi (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
+
+    if (unlikely (!msgs_ || count_ == 0 || count_ > INT_MAX))
+    {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t sent = 0;
+    while (sent < count_)
+    {
+        msg_t *msg = &msgs_[sent];
+        int part_flags = (flags_ & ZMQ_DONTWAIT) | ZMQ_DONTFLUSH;
+        if (msg->check () && (msg->flags () & msg_t::more))
+            part_flags |= ZMQ_SNDMORE;
+        if (send (msg, part_flags) != 0)
+            break;
+        sent++;
+    }
+
+    if (!(flags_ & ZMQ_DONTFLUSH))
+        flush_deferred ();
+
+    return sent ? static_cast<int> (sent) : -1;
+}
+
+void zmq::socket_base_t::defer_flushes ()
+{
+    if (_flush_deferred)
+        return;
+    _flush_deferred = true;
+    for (pipes_t::size_type i = 0; i != _pipes.size (); ++i)
+        _pipes[i]->set_flush_deferred (true);
+}
+
+void zmq::socket_base_t::flush_deferred ()
+{
+    if (!_flush_deferred)
+        return;
+    _flush_deferred = false;
+    for (pipes_t::size_type i = 0; i != _pipes.size (); ++i)
+        _pipes[i]->set_flush_deferred (false);
+}
+
 int zmq::socket_base_t::close()
 {
     scoped_optional_lock_t sync_lock (_thread_safe ? &_sync : NULL);
@@ -1232,6 +1483,9 @@ int zmq::socket_base_t::close()
         (static_cast<mailbox_safe_t *>(_mailbox))->clear_signalers();
     }
 
+    //  The reaper thread must not call into the watchers.
+    _watchers.clear ();
+
     //  Mark the socket as dead
     _tag = 0xdeadbeef;
 
@@ -1260,10 +1514,19 @@ void zmq::socket_base_t::start_reaping(poller_t * poller_)
 
     fd_t fd;
 
-    if (!_thread_safe)
+    if (_compact)
+    {
+        //  The reaper thread can't share the signaler with the application
+        //  thread, give the mailbox one of its own.
+        shared_signaler_t *signaler = (static_cast<compact_mailbox_t *> (_mailbox))->unshare ();
+        if (signaler)
+            get_ctx ()->release_shared_signaler (signaler);
+        fd = get_mailbox_fd ();
+    }
+    else if (!_thread_safe)
     {
         // 
-        fd = (static_cast<mailbox_t *> (_mailbox))->get_fd();
+        fd = get_mailbox_fd ();
     }
     else 
     {
@@ -1290,6 +1553,8 @@ void zmq::socket_base_t::start_reaping(poller_t * poller_)
 
 int zmq::socket_base_t::process_commands(int timeout_, bool throttle_)
 {
+    bool throttled = false;
+
     if (timeout_ == 0) 
     {
         //  If we are asked not to wait, check whether we haven't processed
@@ -1300,24 +1565,46 @@ int zmq::socket_base_t::process_commands(int timeout_, bool throttle_)
 
         //  Optimised version of command processing - it doesn't have to check
         //  for incoming commands each time. It does so only if certain time
-        //  elapsed since last command processing. Command delay varies
-        //  depending on CPU speed: It's ~1ms on 3GHz CPU, ~2ms on 1.5GHz CPU
-        //  etc. The optimisation makes sense only on platforms where getting
-        //  a timestamp is a very cheap operation (tens of nanoseconds).
+        //  elapsed since last command processing. The delay is measured in
+        //  ticks calibrated against the clock, so it does not depend on CPU
+        //  speed. The optimisation makes sense only on platforms where
+        //  getting a timestamp is a very cheap operation (tens of
+        //  nanoseconds).
         if (tsc && throttle_) 
         {
             //  Check whether TSC haven't jumped backwards (in case of migration
             //  between CPU cores) and whether certain time have elapsed since
             //  last command processing. If it didn't do nothing.
-            if (tsc >= _last_tsc && tsc - _last_tsc <= max_command_delay)
+            if (tsc >= _last_tsc && tsc - _last_tsc <= _command_delay)
                 return 0;
             _last_tsc = tsc;
+            throttled = true;
+
+            if (unlikely (!_command_delay_calibrated))
+                update_command_delay ();
         }
     }
 
     //  Check whether there are any commands pending for this thread.
     command_t cmd;
     int rc = _mailbox->recv(&cmd, timeout_);
+    if (rc == 0)
+        events_changed ();
+
+    //  Check sooner while commands keep coming, less often while they
+    //  do not.
+    if (throttled) {
+        if (rc == 0) {
+            _command_delay /= 2;
+            if (_command_delay < _min_command_delay)
+                _command_delay = _min_command_delay;
+        } else {
+            _command_delay *= 2;
+            if (_command_delay > _max_command_delay
+                || _command_delay < _min_command_delay)
+                _command_delay = _max_command_delay;
+        }
+    }
 
     //  Process all available commands.
     while (rc == 0) 
@@ -1534,10 +1821,10 @@ void zmq::socket_base_t::pipe_terminated (pipe_t *pipe_)
     _pipes.erase(pipe_);
 
     // Remove the pipe from _endpoints (set it to NULL).
-    if (!pipe_->get_endpoint_uri().empty ()) 
+    if (_endpoints && !pipe_->get_endpoint_uri().empty ()) 
     {
         std::pair<endpoints_t::iterator, endpoints_t::iterator> range;
-        range = _endpoints.equal_range (pipe_->get_endpoint_uri ());
+        range = _endpoints->equal_range (pipe_->get_endpoint_uri ());
 
         for (endpoints_t::iterator it = range.first; it != range.second; ++it) 
         {
@@ -1780,15 +2067,10 @@ int zmq::routing_socket_base_t::xsetsockopt (int option_,
 
 void zmq::routing_socket_base_t::xwrite_activated (pipe_t *pipe_)
 {
-    const out_pipes_t::iterator end = _out_pipes.end ();
-    out_pipes_t::iterator it;
-    for (it = _out_pipes.begin (); it != end; ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != end);
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    out_pipe_t *out_pipe = lookup_out_pipe (pipe_->get_routing_id ());
+    zmq_assert (out_pipe && out_pipe->pipe == pipe_);
+    zmq_assert (!out_pipe->active);
+    out_pipe->active = true;
 }
 
 std::string zmq::routing_socket_base_t::extract_connect_routing_id ()
@@ -1809,47 +2091,38 @@ void zmq::routing_socket_base_t::add_out_pipe (blob_t routing_id_,
     //  Add the record into output pipes lookup table
     const out_pipe_t outpipe = {pipe_, true};
     const bool ok =
-      _out_pipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id_), outpipe)
-        .second;
+      _out_pipes.insert (routing_id_.data (), routing_id_.size (), outpipe);
     zmq_assert (ok);
 }
 
 bool zmq::routing_socket_base_t::has_out_pipe (const blob_t &routing_id_) const
 {
-    return 0 != _out_pipes.count (routing_id_);
+    return NULL != _out_pipes.find (routing_id_.data (), routing_id_.size ());
 }
 
 zmq::routing_socket_base_t::out_pipe_t *
 zmq::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_)
 {
-    // TODO we could probably avoid constructor a temporary blob_t to call this function
-    out_pipes_t::iterator it = _out_pipes.find (routing_id_);
-    return it == _out_pipes.end () ? NULL : &it->second;
+    return _out_pipes.find (routing_id_.data (), routing_id_.size ());
 }
 
 const zmq::routing_socket_base_t::out_pipe_t *
 zmq::routing_socket_base_t::lookup_out_pipe (const blob_t &routing_id_) const
 {
-    // TODO we could probably avoid constructor a temporary blob_t to call this function
-    const out_pipes_t::const_iterator it = _out_pipes.find (routing_id_);
-    return it == _out_pipes.end () ? NULL : &it->second;
+    return _out_pipes.find (routing_id_.data (), routing_id_.size ());
 }
 
 void zmq::routing_socket_base_t::erase_out_pipe (pipe_t *pipe_)
 {
-    const size_t erased = _out_pipes.erase (pipe_->get_routing_id ());
+    const blob_t &routing_id = pipe_->get_routing_id ();
+    const bool erased =
+      _out_pipes.erase (routing_id.data (), routing_id.size ());
     zmq_assert (erased);
 }
 
 zmq::routing_socket_base_t::out_pipe_t zmq::routing_socket_base_t::try_erase_out_pipe(const blob_t &routing_id_)
 {
-    const out_pipes_t::iterator it = _out_pipes.find (routing_id_);
     out_pipe_t res = {NULL, false};
-    if (it != _out_pipes.end ()) 
-    {
-        res = it->second;
-        _out_pipes.erase (it);
-    }
-
+    _out_pipes.erase (routing_id_.data (), routing_id_.size (), &res);
     return res;
 }
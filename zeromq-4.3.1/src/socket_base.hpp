@@ -3,15 +3,18 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <stdarg.h>
 
 #include "own.hpp"
 #include "array.hpp"
 #include "blob.hpp"
+#include "routing_table.hpp"
 #include "stdint.hpp"
 #include "poller.hpp"
 #include "i_poll_events.hpp"
 #include "i_mailbox.hpp"
+#include "i_socket_watcher.hpp"
 #include "clock.hpp"
 #include "pipe.hpp"
 
@@ -40,6 +43,10 @@ public:
     //  Returns whether the socket is thread-safe.
     bool is_thread_safe () const;
 
+    //  Returns whether the file descriptor retrieved by ZMQ_FD is shared
+    //  with the other sockets of the thread, as in a compact context.
+    bool has_shared_fd () const { return _compact; }
+
     //  Returns the mailbox associated with this socket.
     i_mailbox * get_mailbox () const;
 
@@ -55,8 +62,23 @@ public:
     int  term_endpoint (const char *endpoint_uri_);
     int  send (zmq::msg_t *msg_, int flags_);
     int  recv (zmq::msg_t *msg_, int flags_);
+
+    //  Receives up to count_ message parts into msgs_. Only the first part
+    //  may wait for a message, the rest are the parts already queued.
+    //  Returns the number of parts received.
+    int  recv_multi (zmq::msg_t *msgs_, size_t count_, int flags_);
+
+    //  Sends count_ message parts from msgs_, a part being final unless
+    //  its MORE flag is set. The pipes are flushed once, at the end,
+    //  unless ZMQ_DONTFLUSH is passed. Returns the number of parts sent.
+    int  send_multi (zmq::msg_t *msgs_, size_t count_, int flags_);
     void add_signaler (signaler_t *s_);
     void remove_signaler (signaler_t *s_);
+
+    //  Watchers are told whenever the events of the socket may have
+    //  changed. Only sockets that are not thread safe support them.
+    void add_watcher (i_socket_watcher *watcher_);
+    void remove_watcher (i_socket_watcher *watcher_);
     int  close ();
 
     //  These functions are used by the polling mechanism to determine
@@ -155,22 +177,35 @@ private:
     //  Creates new endpoint ID and adds the endpoint to the map.
     void add_endpoint(const char *endpoint_uri_, own_t *endpoint_, pipe_t *pipe_);
 
-    //  Map of open endpoints.
+    //  Map of open endpoints. Most sockets have few endpoints and many
+    //  have none, so the map is only allocated with the first one.
     typedef std::pair<own_t *, pipe_t *> endpoint_pipe_t;
     typedef std::multimap<std::string, endpoint_pipe_t> endpoints_t;
-    endpoints_t _endpoints;
+    endpoints_t *_endpoints;
+
+    //  Returns the map of open endpoints, allocating it if needed.
+    endpoints_t &endpoints ();
 
-    //  Map of open inproc endpoints.
+    //  Checks whether the endpoint is open, without allocating the map.
+    bool has_endpoint (const std::string &endpoint_uri_) const;
+
+    //  Map of open inproc endpoints, allocated the same way.
     class inprocs_t
     {
     public:
+        inprocs_t ();
+        ~inprocs_t ();
+
         void emplace (const char *endpoint_uri_, pipe_t *pipe_);
         int  erase_pipes (const std::string &endpoint_uri_str_);
         void erase_pipe (pipe_t *pipe_);
 
     private:
         typedef std::multimap<std::string, pipe_t *> map_t;
-        map_t _inprocs;
+        map_t *_inprocs;
+
+        inprocs_t (const inprocs_t &);
+        const inprocs_t &operator= (const inprocs_t &);
     };
     inprocs_t _inprocs;
 
@@ -217,11 +252,24 @@ private:
 
     void update_pipe_options (int option_);
 
+    //  Computes the bounds of the command processing delay from the
+    //  ZMQ_COMMAND_DELAY option. Until the rate of the CPU ticks is known,
+    //  the delay is fixed to uncalibrated_command_delay.
+    void update_command_delay ();
+
     std::string resolve_tcp_addr (std::string endpoint_uri_, const char *tcp_address_);
 
     //  Socket's mailbox object.
     i_mailbox *_mailbox;
 
+    //  True if the mailbox is a compact_mailbox_t, as in a context in
+    //  compact mode.
+    bool _compact;
+
+    //  Returns the file descriptor signalling the commands of a socket
+    //  that is not thread safe.
+    fd_t get_mailbox_fd () const;
+
     //  List of attached pipes.
     typedef array_t<pipe_t, 3> pipes_t;
     pipes_t _pipes;
@@ -233,12 +281,30 @@ private:
     //  Timestamp of when commands were processed the last time.
     uint64_t _last_tsc;
 
+    //  Current delay between checks for commands and its bounds, in
+    //  CPU ticks. The delay shrinks while checks find commands and grows
+    //  back while they do not.
+    uint64_t _command_delay;
+    uint64_t _min_command_delay;
+    uint64_t _max_command_delay;
+    bool _command_delay_calibrated;
+
     //  Number of messages received since last command processing.
     int _ticks;
 
     //  True if the last message received had MORE flag set.
     bool _rcvmore;
 
+    //  True while messages sent with ZMQ_DONTFLUSH are held in the pipes.
+    bool _flush_deferred;
+
+    //  Makes the pipes hold written messages until flush_deferred is
+    //  called.
+    void defer_flushes ();
+
+    //  Flushes the messages held back by ZMQ_DONTFLUSH, if any.
+    void flush_deferred ();
+
     //  Improves efficiency of time measurement.
     clock_t _clock;
 
@@ -257,6 +323,17 @@ private:
     // Signaler to be used in the reaping stage
     signaler_t *_reaper_signaler;
 
+    // Objects tracking the events of the socket.
+    typedef std::vector<i_socket_watcher *> watchers_t;
+    watchers_t _watchers;
+
+    // Tells the watchers the events of the socket may have changed.
+    void events_changed ()
+    {
+        for (watchers_t::size_type i = 0; i != _watchers.size (); i++)
+            _watchers[i]->events_changed ();
+    }
+
     // Mutex for synchronize access to the socket in thread safe mode
     mutex_t _sync;
 
@@ -297,9 +374,10 @@ class routing_socket_base_t : public socket_base_t
     template <typename Func> bool any_of_out_pipes (Func func_)
     {
         bool res = false;
-        for (out_pipes_t::iterator it = _out_pipes.begin ();
-             it != _out_pipes.end () && !res; ++it) {
-            res |= func_ (*it->second.pipe);
+        for (out_pipes_t::size_type i = 0, n = _out_pipes.capacity ();
+             i != n && !res; ++i) {
+            if (_out_pipes.occupied (i))
+                res |= func_ (*_out_pipes.value (i).pipe);
         }
 
         return res;
@@ -307,7 +385,7 @@ class routing_socket_base_t : public socket_base_t
 
   private:
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, out_pipe_t> out_pipes_t;
+    typedef routing_table_t<out_pipe_t> out_pipes_t;
     out_pipes_t _out_pipes;
 
     // Next assigned name on a zmq_connect() call used by ROUTER and STREAM socket types
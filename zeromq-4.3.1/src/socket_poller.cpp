@@ -32,8 +32,10 @@
 #include "err.hpp"
 #include "polling_util.hpp"
 #include "macros.hpp"
+#include "config.hpp"
 
 #include <limits.h>
+#include <algorithm>
 
 static bool is_thread_safe (zmq::socket_base_t &socket_)
 {
@@ -44,7 +46,10 @@ static bool is_thread_safe (zmq::socket_base_t &socket_)
 zmq::socket_poller_t::socket_poller_t () :
     _tag (0xCAFEBABE),
     _signaler (NULL)
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    ,
+    _pollset_size (0)
+#elif defined ZMQ_POLL_BASED_ON_POLL
     ,
     _pollfds (NULL)
 #elif defined ZMQ_POLL_BASED_ON_SELECT
@@ -52,7 +57,16 @@ zmq::socket_poller_t::socket_poller_t () :
     _max_fd (0)
 #endif
 {
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+#ifdef ZMQ_IOTHREAD_POLLER_USE_EPOLL_CLOEXEC
+    _epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+#else
+    _epoll_fd = epoll_create (1);
+#endif
+    errno_assert (_epoll_fd != -1);
+#else
     rebuild ();
+#endif
 }
 
 zmq::socket_poller_t::~socket_poller_t ()
@@ -63,17 +77,25 @@ zmq::socket_poller_t::~socket_poller_t ()
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
         // TODO shouldn't this zmq_assert (it->socket->check_tag ()) instead?
-        if (it->socket && it->socket->check_tag ()
-            && is_thread_safe (*it->socket)) {
-            it->socket->remove_signaler (_signaler);
+        item_t *item = *it;
+        if (item->socket && item->socket->check_tag ()) {
+            if (is_thread_safe (*item->socket))
+                item->socket->remove_signaler (_signaler);
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+            else
+                item->socket->remove_watcher (item);
+#endif
         }
+        LIBZMQ_DELETE (item);
     }
 
     if (_signaler != NULL) {
         LIBZMQ_DELETE (_signaler);
     }
 
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    close (_epoll_fd);
+#elif defined ZMQ_POLL_BASED_ON_POLL
     if (_pollfds) {
         free (_pollfds);
         _pollfds = NULL;
@@ -92,48 +114,84 @@ int zmq::socket_poller_t::add (socket_base_t *socket_,
 {
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (it->socket == socket_) {
+        if ((*it)->socket == socket_) {
             errno = EINVAL;
             return -1;
         }
     }
 
-    if (is_thread_safe (*socket_)) {
-        if (_signaler == NULL) {
-            _signaler = new (std::nothrow) signaler_t ();
-            if (!_signaler) {
-                errno = ENOMEM;
-                return -1;
-            }
-            if (!_signaler->valid ()) {
-                delete _signaler;
-                _signaler = NULL;
-                errno = EMFILE;
-                return -1;
-            }
+    const bool thread_safe = is_thread_safe (*socket_);
+    if (thread_safe && _signaler == NULL) {
+        _signaler = new (std::nothrow) signaler_t ();
+        if (!_signaler) {
+            errno = ENOMEM;
+            return -1;
         }
-
-        socket_->add_signaler (_signaler);
+        if (!_signaler->valid ()) {
+            delete _signaler;
+            _signaler = NULL;
+            errno = EMFILE;
+            return -1;
+        }
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+        epoll_event ev;
+        memset (&ev, 0, sizeof ev);
+        ev.events = EPOLLIN;
+        ev.data.ptr = NULL;
+        const int rc =
+          epoll_ctl (_epoll_fd, EPOLL_CTL_ADD, _signaler->get_fd (), &ev);
+        errno_assert (rc == 0);
+#endif
     }
 
-    item_t item = {
-        socket_,
-        0,
-        user_data_,
-        events_
-#if defined ZMQ_POLL_BASED_ON_POLL
-        ,
-        -1
+    item_t *item = new (std::nothrow) item_t ();
+    if (!item) {
+        errno = ENOMEM;
+        return -1;
+    }
+    item->socket = socket_;
+    item->fd = retired_fd;
+    item->user_data = user_data_;
+    item->events = events_;
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    item->poller = this;
+    item->pending = false;
+    item->registered = false;
+    item->duplicated = false;
+    if (!thread_safe) {
+        size_t fd_size = sizeof item->fd;
+        const int rc = socket_->getsockopt (ZMQ_FD, &item->fd, &fd_size);
+        zmq_assert (rc == 0);
+    }
+#elif defined ZMQ_POLL_BASED_ON_POLL
+    item->pollfd_index = -1;
 #endif
-    };
     try {
         _items.push_back (item);
     }
     catch (const std::bad_alloc &) {
+        delete item;
         errno = ENOMEM;
         return -1;
     }
+
+    if (thread_safe)
+        socket_->add_signaler (_signaler);
+
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    if (!thread_safe)
+        socket_->add_watcher (item);
+    const int rc = update_epoll (item);
+    errno_assert (rc == 0);
+
+    //  The socket may already be ready.
+    if (events_) {
+        _pollset_size++;
+        mark_pending (item);
+    }
+#else
     _need_rebuild = true;
+#endif
 
     return 0;
 }
@@ -142,30 +200,53 @@ int zmq::socket_poller_t::add_fd (fd_t fd_, void *user_data_, short events_)
 {
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (!it->socket && it->fd == fd_) {
+        if (!(*it)->socket && (*it)->fd == fd_) {
             errno = EINVAL;
             return -1;
         }
     }
 
-    item_t item = {
-        NULL,
-        fd_,
-        user_data_,
-        events_
-#if defined ZMQ_POLL_BASED_ON_POLL
-        ,
-        -1
+    item_t *item = new (std::nothrow) item_t ();
+    if (!item) {
+        errno = ENOMEM;
+        return -1;
+    }
+    item->socket = NULL;
+    item->fd = fd_;
+    item->user_data = user_data_;
+    item->events = events_;
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    item->poller = this;
+    item->pending = false;
+    item->registered = false;
+
+    //  Unlike poll (), epoll rejects descriptors it cannot wait for.
+    if (update_epoll (item) == -1) {
+        delete item;
+        return -1;
+    }
+#elif defined ZMQ_POLL_BASED_ON_POLL
+    item->pollfd_index = -1;
 #endif
-    };
     try {
         _items.push_back (item);
     }
     catch (const std::bad_alloc &) {
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+        item->events = 0;
+        update_epoll (item);
+#endif
+        delete item;
         errno = ENOMEM;
         return -1;
     }
+
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    if (events_)
+        _pollset_size++;
+#else
     _need_rebuild = true;
+#endif
 
     return 0;
 }
@@ -176,7 +257,7 @@ int zmq::socket_poller_t::modify (socket_base_t *socket_, short events_)
     items_t::iterator it;
 
     for (it = _items.begin (); it != end; ++it) {
-        if (it->socket == socket_)
+        if ((*it)->socket == socket_)
             break;
     }
 
@@ -185,8 +266,18 @@ int zmq::socket_poller_t::modify (socket_base_t *socket_, short events_)
         return -1;
     }
 
-    it->events = events_;
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    item_t *item = *it;
+    _pollset_size += (events_ != 0) - (item->events != 0);
+    item->events = events_;
+    const int rc = update_epoll (item);
+    errno_assert (rc == 0);
+    if (events_)
+        mark_pending (item);
+#else
+    (*it)->events = events_;
     _need_rebuild = true;
+#endif
 
     return 0;
 }
@@ -198,7 +289,7 @@ int zmq::socket_poller_t::modify_fd (fd_t fd_, short events_)
     items_t::iterator it;
 
     for (it = _items.begin (); it != end; ++it) {
-        if (!it->socket && it->fd == fd_)
+        if (!(*it)->socket && (*it)->fd == fd_)
             break;
     }
 
@@ -207,8 +298,19 @@ int zmq::socket_poller_t::modify_fd (fd_t fd_, short events_)
         return -1;
     }
 
-    it->events = events_;
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    item_t *item = *it;
+    const short old_events = item->events;
+    item->events = events_;
+    if (update_epoll (item) == -1) {
+        item->events = old_events;
+        return -1;
+    }
+    _pollset_size += (events_ != 0) - (old_events != 0);
+#else
+    (*it)->events = events_;
     _need_rebuild = true;
+#endif
 
     return 0;
 }
@@ -220,7 +322,7 @@ int zmq::socket_poller_t::remove (socket_base_t *socket_)
     items_t::iterator it;
 
     for (it = _items.begin (); it != end; ++it) {
-        if (it->socket == socket_)
+        if ((*it)->socket == socket_)
             break;
     }
 
@@ -229,8 +331,15 @@ int zmq::socket_poller_t::remove (socket_base_t *socket_)
         return -1;
     }
 
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    if (!is_thread_safe (*socket_))
+        socket_->remove_watcher (*it);
+    remove_item (it);
+#else
+    LIBZMQ_DELETE (*it);
     _items.erase (it);
     _need_rebuild = true;
+#endif
 
     if (is_thread_safe (*socket_)) {
         socket_->remove_signaler (_signaler);
@@ -245,7 +354,7 @@ int zmq::socket_poller_t::remove_fd (fd_t fd_)
     items_t::iterator it;
 
     for (it = _items.begin (); it != end; ++it) {
-        if (!it->socket && it->fd == fd_)
+        if (!(*it)->socket && (*it)->fd == fd_)
             break;
     }
 
@@ -254,12 +363,142 @@ int zmq::socket_poller_t::remove_fd (fd_t fd_)
         return -1;
     }
 
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    remove_item (it);
+#else
+    LIBZMQ_DELETE (*it);
     _items.erase (it);
     _need_rebuild = true;
+#endif
+
+    return 0;
+}
+
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
 
+void zmq::socket_poller_t::item_t::events_changed ()
+{
+    poller->mark_pending (this);
+}
+
+void zmq::socket_poller_t::mark_pending (item_t *item_)
+{
+    if (!item_->pending) {
+        item_->pending = true;
+        _pending.push_back (item_);
+    }
+}
+
+int zmq::socket_poller_t::update_epoll (item_t *item_)
+{
+    //  Thread safe sockets are woken up through the signaler.
+    if (item_->fd == retired_fd)
+        return 0;
+
+    const bool wanted = item_->events != 0;
+    int op;
+    if (wanted)
+        op = item_->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+    else if (item_->registered)
+        op = EPOLL_CTL_DEL;
+    else
+        return 0;
+
+    epoll_event ev;
+    memset (&ev, 0, sizeof ev);
+    ev.data.ptr = item_;
+
+    //  For a 0MQ socket we are interested in input on the notification
+    //  file descriptor retrieved by the ZMQ_FD socket option.
+    if (item_->socket)
+        ev.events = EPOLLIN;
+    else {
+        if (item_->events & ZMQ_POLLIN)
+            ev.events |= EPOLLIN;
+        if (item_->events & ZMQ_POLLOUT)
+            ev.events |= EPOLLOUT;
+        if (item_->events & ZMQ_POLLPRI)
+            ev.events |= EPOLLPRI;
+    }
+
+    int rc = epoll_ctl (_epoll_fd, op, item_->fd, &ev);
+    if (rc == -1 && errno == EEXIST && item_->socket) {
+        //  Sockets of a compact context share their ZMQ_FD. A duplicate
+        //  descriptor is a distinct entry of the set.
+        const fd_t fd = dup (item_->fd);
+        if (fd == -1)
+            return -1;
+        item_->fd = fd;
+        item_->duplicated = true;
+        rc = epoll_ctl (_epoll_fd, op, item_->fd, &ev);
+    }
+    if (rc == -1) {
+        //  A descriptor closed before being removed has already left
+        //  the set.
+        if (op != EPOLL_CTL_DEL)
+            return -1;
+    }
+    item_->registered = wanted;
     return 0;
 }
 
+void zmq::socket_poller_t::remove_item (items_t::iterator it_)
+{
+    item_t *item = *it_;
+    if (item->events) {
+        _pollset_size--;
+        item->events = 0;
+        update_epoll (item);
+    }
+    if (item->duplicated)
+        close (item->fd);
+    if (item->pending)
+        _pending.erase (std::find (_pending.begin (), _pending.end (), item));
+    _items.erase (it_);
+    LIBZMQ_DELETE (item);
+}
+
+int zmq::socket_poller_t::check_pending (
+  zmq::socket_poller_t::event_t *events_, int n_events_, int found_)
+{
+    int rc = 0;
+    items_t::size_type kept = 0;
+    for (items_t::size_type i = 0; i != _pending.size (); i++) {
+        item_t *item = _pending[i];
+        if (found_ < n_events_ && rc == 0) {
+            //  Retrieve pending events using the ZMQ_EVENTS socket option.
+            //  This processes the commands of the socket, so its ZMQ_FD
+            //  stops firing until new ones arrive.
+            size_t events_size = sizeof (uint32_t);
+            uint32_t events;
+            rc = item->socket->getsockopt (ZMQ_EVENTS, &events, &events_size);
+            if (rc == 0) {
+                if (item->events & events) {
+                    events_[found_].socket = item->socket;
+                    events_[found_].user_data = item->user_data;
+                    events_[found_].events = item->events & events;
+                    ++found_;
+                } else if (!item->events
+                           || !(is_thread_safe (*item->socket)
+                                || item->socket->has_shared_fd ())) {
+                    //  Not ready; the socket will tell us when this may
+                    //  change. A socket sharing its ZMQ_FD may not, the
+                    //  signal meant for it may be received through another
+                    //  socket, so it is checked on each pass.
+                    item->pending = false;
+                    continue;
+                }
+            }
+        }
+        _pending[kept++] = item;
+    }
+    _pending.resize (kept);
+
+    return rc == 0 ? found_ : -1;
+}
+
+#else
+
 void zmq::socket_poller_t::rebuild ()
 {
     _use_signaler = false;
@@ -275,8 +514,9 @@ void zmq::socket_poller_t::rebuild ()
 
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (it->events) {
-            if (it->socket && is_thread_safe (*it->socket)) {
+        item_t *item = *it;
+        if (item->events) {
+            if (item->socket && is_thread_safe (*item->socket)) {
                 if (!_use_signaler) {
                     _use_signaler = true;
                     _pollset_size++;
@@ -302,11 +542,12 @@ void zmq::socket_poller_t::rebuild ()
 
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (it->events) {
-            if (it->socket) {
-                if (!is_thread_safe (*it->socket)) {
+        item_t *item = *it;
+        if (item->events) {
+            if (item->socket) {
+                if (!is_thread_safe (*item->socket)) {
                     size_t fd_size = sizeof (zmq::fd_t);
-                    int rc = it->socket->getsockopt (
+                    int rc = item->socket->getsockopt (
                       ZMQ_FD, &_pollfds[item_nbr].fd, &fd_size);
                     zmq_assert (rc == 0);
 
@@ -314,12 +555,12 @@ void zmq::socket_poller_t::rebuild ()
                     item_nbr++;
                 }
             } else {
-                _pollfds[item_nbr].fd = it->fd;
+                _pollfds[item_nbr].fd = item->fd;
                 _pollfds[item_nbr].events =
-                  (it->events & ZMQ_POLLIN ? POLLIN : 0)
-                  | (it->events & ZMQ_POLLOUT ? POLLOUT : 0)
-                  | (it->events & ZMQ_POLLPRI ? POLLPRI : 0);
-                it->pollfd_index = item_nbr;
+                  (item->events & ZMQ_POLLIN ? POLLIN : 0)
+                  | (item->events & ZMQ_POLLOUT ? POLLOUT : 0)
+                  | (item->events & ZMQ_POLLPRI ? POLLPRI : 0);
+                item->pollfd_index = item_nbr;
                 item_nbr++;
             }
         }
@@ -341,7 +582,8 @@ void zmq::socket_poller_t::rebuild ()
 
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (it->socket && is_thread_safe (*it->socket) && it->events) {
+        item_t *item = *it;
+        if (item->socket && is_thread_safe (*item->socket) && item->events) {
             _use_signaler = true;
             FD_SET (_signaler->get_fd (), _pollset_in.get ());
             _pollset_size = 1;
@@ -354,15 +596,16 @@ void zmq::socket_poller_t::rebuild ()
     //  Build the fd_sets for passing to select ().
     for (items_t::iterator it = _items.begin (), end = _items.end (); it != end;
          ++it) {
-        if (it->events) {
+        item_t *item = *it;
+        if (item->events) {
             //  If the poll item is a 0MQ socket we are interested in input on the
             //  notification file descriptor retrieved by the ZMQ_FD socket option.
-            if (it->socket) {
-                if (!is_thread_safe (*it->socket)) {
+            if (item->socket) {
+                if (!is_thread_safe (*item->socket)) {
                     zmq::fd_t notify_fd;
                     size_t fd_size = sizeof (zmq::fd_t);
                     int rc =
-                      it->socket->getsockopt (ZMQ_FD, &notify_fd, &fd_size);
+                      item->socket->getsockopt (ZMQ_FD, &notify_fd, &fd_size);
                     zmq_assert (rc == 0);
 
                     FD_SET (notify_fd, _pollset_in.get ());
@@ -375,14 +618,14 @@ void zmq::socket_poller_t::rebuild ()
             //  Else, the poll item is a raw file descriptor. Convert the poll item
             //  events to the appropriate fd_sets.
             else {
-                if (it->events & ZMQ_POLLIN)
-                    FD_SET (it->fd, _pollset_in.get ());
-                if (it->events & ZMQ_POLLOUT)
-                    FD_SET (it->fd, _pollset_out.get ());
-                if (it->events & ZMQ_POLLERR)
-                    FD_SET (it->fd, _pollset_err.get ());
-                if (_max_fd < it->fd)
-                    _max_fd = it->fd;
+                if (item->events & ZMQ_POLLIN)
+                    FD_SET (item->fd, _pollset_in.get ());
+                if (item->events & ZMQ_POLLOUT)
+                    FD_SET (item->fd, _pollset_out.get ());
+                if (item->events & ZMQ_POLLERR)
+                    FD_SET (item->fd, _pollset_err.get ());
+                if (_max_fd < item->fd)
+                    _max_fd = item->fd;
 
                 _pollset_size++;
             }
@@ -392,6 +635,8 @@ void zmq::socket_poller_t::rebuild ()
 #endif
 }
 
+#endif
+
 void zmq::socket_poller_t::zero_trail_events (
   zmq::socket_poller_t::event_t *events_, int n_events_, int found_)
 {
@@ -403,7 +648,8 @@ void zmq::socket_poller_t::zero_trail_events (
     }
 }
 
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+#elif defined ZMQ_POLL_BASED_ON_POLL
 int zmq::socket_poller_t::check_events (zmq::socket_poller_t::event_t *events_,
                                         int n_events_)
 #elif defined ZMQ_POLL_BASED_ON_SELECT
@@ -413,24 +659,26 @@ int zmq::socket_poller_t::check_events (zmq::socket_poller_t::event_t *events_,
                                         fd_set &outset_,
                                         fd_set &errset_)
 #endif
+#if !defined ZMQ_SOCKET_POLLER_USE_EPOLL
 {
     int found = 0;
     for (items_t::iterator it = _items.begin (), end = _items.end ();
          it != end && found < n_events_; ++it) {
+        item_t *item = *it;
         //  The poll item is a 0MQ socket. Retrieve pending events
         //  using the ZMQ_EVENTS socket option.
-        if (it->socket) {
+        if (item->socket) {
             size_t events_size = sizeof (uint32_t);
             uint32_t events;
-            if (it->socket->getsockopt (ZMQ_EVENTS, &events, &events_size)
+            if (item->socket->getsockopt (ZMQ_EVENTS, &events, &events_size)
                 == -1) {
                 return -1;
             }
 
-            if (it->events & events) {
-                events_[found].socket = it->socket;
-                events_[found].user_data = it->user_data;
-                events_[found].events = it->events & events;
+            if (item->events & events) {
+                events_[found].socket = item->socket;
+                events_[found].user_data = item->user_data;
+                events_[found].events = item->events & events;
                 ++found;
             }
         }
@@ -439,7 +687,7 @@ int zmq::socket_poller_t::check_events (zmq::socket_poller_t::event_t *events_,
         else {
 #if defined ZMQ_POLL_BASED_ON_POLL
 
-            short revents = _pollfds[it->pollfd_index].revents;
+            short revents = _pollfds[item->pollfd_index].revents;
             short events = 0;
 
             if (revents & POLLIN)
@@ -455,18 +703,18 @@ int zmq::socket_poller_t::check_events (zmq::socket_poller_t::event_t *events_,
 
             short events = 0;
 
-            if (FD_ISSET (it->fd, &inset_))
+            if (FD_ISSET (item->fd, &inset_))
                 events |= ZMQ_POLLIN;
-            if (FD_ISSET (it->fd, &outset_))
+            if (FD_ISSET (item->fd, &outset_))
                 events |= ZMQ_POLLOUT;
-            if (FD_ISSET (it->fd, &errset_))
+            if (FD_ISSET (item->fd, &errset_))
                 events |= ZMQ_POLLERR;
 #endif //POLL_SELECT
 
             if (events) {
                 events_[found].socket = NULL;
-                events_[found].user_data = it->user_data;
-                events_[found].fd = it->fd;
+                events_[found].user_data = item->user_data;
+                events_[found].fd = item->fd;
                 events_[found].events = events;
                 ++found;
             }
@@ -475,6 +723,7 @@ int zmq::socket_poller_t::check_events (zmq::socket_poller_t::event_t *events_,
 
     return found;
 }
+#endif
 
 //Return 0 if timeout is expired otherwise 1
 int zmq::socket_poller_t::adjust_timeout (zmq::clock_t &clock_,
@@ -523,8 +772,10 @@ int zmq::socket_poller_t::wait (zmq::socket_poller_t::event_t *events_,
         return -1;
     }
 
+#if !defined ZMQ_SOCKET_POLLER_USE_EPOLL
     if (_need_rebuild)
         rebuild ();
+#endif
 
     if (unlikely (_pollset_size == 0)) {
         // We'll report an error (timed out) as if the list was non-empty and
@@ -556,7 +807,86 @@ int zmq::socket_poller_t::wait (zmq::socket_poller_t::event_t *events_,
 #endif
     }
 
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    zmq::clock_t clock;
+    uint64_t now = 0;
+    uint64_t end = 0;
+
+    bool first_pass = true;
+
+    while (true) {
+        //  Compute the timeout for the subsequent poll.
+        int timeout;
+        if (first_pass)
+            timeout = 0;
+        else if (timeout_ < 0)
+            timeout = -1;
+        else
+            timeout =
+              static_cast<int> (std::min<uint64_t> (end - now, INT_MAX));
+
+        //  Wait for events.
+        epoll_event ev_buf[max_io_events];
+        const int n = epoll_wait (_epoll_fd, ev_buf, max_io_events, timeout);
+        if (n == -1 && errno == EINTR)
+            return -1;
+        errno_assert (n >= 0);
+
+        int found = 0;
+        for (int i = 0; i < n; i++) {
+            item_t *item = static_cast<item_t *> (ev_buf[i].data.ptr);
+
+            //  Receive the signal for the thread safe sockets, which are
+            //  checked on each pass anyway.
+            if (!item) {
+                _signaler->recv ();
+                continue;
+            }
+
+            //  The ZMQ_FD of the socket fired, check its events.
+            if (item->socket) {
+                mark_pending (item);
+                continue;
+            }
+
+            //  The poll item is a raw file descriptor, simply convert the
+            //  events to zmq_pollitem_t-style format. Those we have no room
+            //  for are reported again by the next wait.
+            if (found == n_events_)
+                continue;
+            const uint32_t revents = ev_buf[i].events;
+            short events = 0;
+            if (revents & EPOLLIN)
+                events |= ZMQ_POLLIN;
+            if (revents & EPOLLOUT)
+                events |= ZMQ_POLLOUT;
+            if (revents & EPOLLPRI)
+                events |= ZMQ_POLLPRI;
+            if (revents & ~(EPOLLIN | EPOLLOUT | EPOLLPRI))
+                events |= ZMQ_POLLERR;
+            events_[found].socket = NULL;
+            events_[found].user_data = item->user_data;
+            events_[found].fd = item->fd;
+            events_[found].events = events;
+            ++found;
+        }
+
+        //  Check for the events of the sockets.
+        found = check_pending (events_, n_events_, found);
+        if (found) {
+            if (found > 0)
+                zero_trail_events (events_, n_events_, found);
+            return found;
+        }
+
+        //  Adjust timeout or break
+        if (adjust_timeout (clock, timeout_, now, end, first_pass) == 0)
+            break;
+    }
+    errno = EAGAIN;
+    return -1;
+
+#elif defined ZMQ_POLL_BASED_ON_POLL
     zmq::clock_t clock;
     uint64_t now = 0;
     uint64_t end = 0;
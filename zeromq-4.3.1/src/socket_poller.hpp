@@ -32,6 +32,13 @@
 
 #include "poller.hpp"
 
+//  Where epoll is available the poller keeps a persistent epoll set
+//  instead of rebuilding a pollset for each change.
+#if defined ZMQ_IOTHREAD_POLLER_USE_EPOLL && !defined ZMQ_HAVE_WINDOWS
+#define ZMQ_SOCKET_POLLER_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
 #if defined ZMQ_POLL_BASED_ON_POLL && !defined ZMQ_HAVE_WINDOWS
 #include <poll.h>
 #endif
@@ -51,9 +58,18 @@
 #include "socket_base.hpp"
 #include "signaler.hpp"
 #include "polling_util.hpp"
+#include "i_socket_watcher.hpp"
 
 namespace zmq
 {
+//  With the epoll backend, waiting costs time proportional to the number
+//  of items that may be ready rather than the number registered: raw file
+//  descriptors and the ZMQ_FD of sockets are kept in an epoll set, and the
+//  events of a socket are only queried when its ZMQ_FD fired, when the
+//  socket tells the poller they may have changed (as a watcher) or while
+//  it was found ready. Thread safe sockets have no ZMQ_FD and are queried
+//  on each wait.
+
 class socket_poller_t
 {
   public:
@@ -84,10 +100,28 @@ class socket_poller_t
     bool check_tag ();
 
   private:
+    struct item_t;
+
     void zero_trail_events (zmq::socket_poller_t::event_t *events_,
                             int n_events_,
                             int found_);
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    //  Adds, modifies or removes the item in the epoll set to match its
+    //  events.
+    int update_epoll (item_t *item_);
+
+    //  Queues the item for checking its socket's events.
+    void mark_pending (item_t *item_);
+
+    //  Checks the events of the queued sockets, storing the ready ones
+    //  after the found_ events already found. Sockets found not ready are
+    //  dequeued. Returns the number of events found.
+    int check_pending (zmq::socket_poller_t::event_t *events_,
+                       int n_events_,
+                       int found_);
+
+    void remove_item (std::vector<item_t *>::iterator it_);
+#elif defined ZMQ_POLL_BASED_ON_POLL
     int check_events (zmq::socket_poller_t::event_t *events_, int n_events_);
 #elif defined ZMQ_POLL_BASED_ON_SELECT
     int check_events (zmq::socket_poller_t::event_t *events_,
@@ -101,7 +135,9 @@ class socket_poller_t
                         uint64_t &now_,
                         uint64_t &end_,
                         bool &first_pass_);
+#if !defined ZMQ_SOCKET_POLLER_USE_EPOLL
     void rebuild ();
+#endif
 
     //  Used to check whether the object is a socket_poller.
     uint32_t _tag;
@@ -109,31 +145,56 @@ class socket_poller_t
     //  Signaler used for thread safe sockets polling
     signaler_t *_signaler;
 
-    typedef struct item_t
+    struct item_t
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+        : public i_socket_watcher
+#endif
     {
         socket_base_t *socket;
         fd_t fd;
         void *user_data;
         short events;
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+        socket_poller_t *poller;
+
+        //  Whether the socket is queued for checking its events.
+        bool pending;
+
+        //  Whether the fd is in the epoll set.
+        bool registered;
+
+        //  Whether fd is a duplicate of the socket's ZMQ_FD, which is
+        //  in the set for another socket sharing it already.
+        bool duplicated;
+
+        //  i_socket_watcher implementation.
+        void events_changed ();
+#elif defined ZMQ_POLL_BASED_ON_POLL
         int pollfd_index;
 #endif
-    } item_t;
+    };
 
     //  List of sockets
-    typedef std::vector<item_t> items_t;
+    typedef std::vector<item_t *> items_t;
     items_t _items;
 
+#if !defined ZMQ_SOCKET_POLLER_USE_EPOLL
     //  Does the pollset needs rebuilding?
     bool _need_rebuild;
 
     //  Should the signaler be used for the thread safe polling?
     bool _use_signaler;
+#endif
 
     //  Size of the pollset
     int _pollset_size;
 
-#if defined ZMQ_POLL_BASED_ON_POLL
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    int _epoll_fd;
+
+    //  Sockets whose events are to be checked.
+    items_t _pending;
+#elif defined ZMQ_POLL_BASED_ON_POLL
     pollfd *_pollfds;
 #elif defined ZMQ_POLL_BASED_ON_SELECT
     resizable_optimized_fd_set_t _pollset_in;
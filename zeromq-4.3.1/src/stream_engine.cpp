@@ -10,6 +10,7 @@
 #include "stream_engine.hpp"
 #include "io_thread.hpp"
 #include "session_base.hpp"
+#include "ctx.hpp"
 #include "v1_encoder.hpp"
 #include "v1_decoder.hpp"
 #include "v2_encoder.hpp"
@@ -55,10 +56,11 @@ zmq::stream_engine_t::stream_engine_t(fd_t fd_, const options_t & options_, cons
     _input_stopped (false),
     _output_stopped (false),
     _has_handshake_timer (false),
-    _has_ttl_timer (false),
-    _has_timeout_timer (false),
-    _has_heartbeat_timer (false),
+    _heartbeats (NULL),
+    _heartbeat_handle (0),
+    _has_heartbeat (false),
     _heartbeat_timeout (0),
+    _buffer_pool (NULL),
     _socket (NULL)
 {
     int rc = _tx_msg.init ();
@@ -154,7 +156,9 @@ void zmq::stream_engine_t::plug(io_thread_t *io_thread_, session_base_t *session
     _socket   = _session->get_socket();
 
     //  Connect to I/O threads poller object.
-    io_object_t::plug(io_thread_); // epoll
+    io_object_t::plug(io_thread_);
+    _heartbeats = io_thread_->get_heartbeat_scheduler ();
+    _buffer_pool = io_thread_->get_buffer_pool ();
     _handle   = add_fd(_s);
     _io_error = false;
 
@@ -167,6 +171,9 @@ void zmq::stream_engine_t::plug(io_thread_t *io_thread_, session_base_t *session
         _decoder = new (std::nothrow) raw_decoder_t(in_batch_size);
         alloc_assert (_decoder);
 
+        _encoder->set_buffer_pool (_buffer_pool);
+        _decoder->set_buffer_pool (_buffer_pool);
+
         // disable handshaking for raw socket
         _handshaking = false;
 
@@ -178,8 +185,8 @@ void zmq::stream_engine_t::plug(io_thread_t *io_thread_, session_base_t *session
         {
             //  Compile metadata.
             zmq_assert (_metadata == NULL);
-            _metadata = new (std::nothrow) metadata_t (properties);
-            alloc_assert (_metadata);
+            _metadata = _session->get_ctx ()->get_metadata_registry ()->intern (
+              properties);
         }
 
         if (_options.raw_notify) 
@@ -228,22 +235,10 @@ void zmq::stream_engine_t::unplug()
         _has_handshake_timer = false;
     }
 
-    if (_has_ttl_timer) 
-    {
-        cancel_timer (heartbeat_ttl_timer_id);
-        _has_ttl_timer = false;
-    }
-
-    if (_has_timeout_timer) 
-    {
-        cancel_timer (heartbeat_timeout_timer_id);
-        _has_timeout_timer = false;
-    }
-
-    if (_has_heartbeat_timer) 
+    if (_has_heartbeat) 
     {
-        cancel_timer (heartbeat_ivl_timer_id);
-        _has_heartbeat_timer = false;
+        _heartbeats->rm (_heartbeat_handle);
+        _has_heartbeat = false;
     }
 
     //  Cancel all fd subscriptions.
@@ -308,8 +303,11 @@ void zmq::stream_engine_t::in_event()
             if (errno != EAGAIN)
             {
                 error(connection_error);
+                return;
             }
 
+            //  Nothing to read, don't keep the buffer.
+            _decoder->release_buffer();
             return;
         }
 
@@ -351,6 +349,11 @@ void zmq::stream_engine_t::in_event()
         reset_pollin(_handle);
     }
 
+    //  All the data read was decoded, the buffer is not needed until
+    //  more arrives.
+    if (_insize == 0)
+        _decoder->release_buffer();
+
     _session->flush();
 }
 
@@ -392,9 +395,11 @@ void zmq::stream_engine_t::out_event()
             _outsize += n;
         }
 
-        //  If there is no data to send, stop polling for output.
+        //  If there is no data to send, stop polling for output and
+        //  give the buffer back until there is.
         if (_outsize == 0) 
         {
+            _encoder->release_buffer();
             _output_stopped = true;
             reset_pollout(_handle);
             return;
@@ -537,6 +542,9 @@ bool zmq::stream_engine_t::handshake()
         return false;
     }
 
+    _encoder->set_buffer_pool (_buffer_pool);
+    _decoder->set_buffer_pool (_buffer_pool);
+
     // Start polling for output if necessary.
     if (_outsize == 0)
         set_pollout(_handle);
@@ -935,6 +943,15 @@ void zmq::stream_engine_t::zap_msg_available ()
         restart_output ();
 }
 
+void zmq::stream_engine_t::crypto_job_done ()
+{
+    //  The mechanism stopped the input until the job was done. Have it
+    //  process the command again, which restarts the output as well. The
+    //  engine may have been deleted on return.
+    zmq_assert (_input_stopped);
+    restart_input ();
+}
+
 const char *zmq::stream_engine_t::get_endpoint() const
 {
     return _endpoint.c_str ();
@@ -943,8 +960,11 @@ const char *zmq::stream_engine_t::get_endpoint() const
 void zmq::stream_engine_t::mechanism_ready ()
 {
     if (_options.heartbeat_interval > 0) {
-        add_timer (_options.heartbeat_interval, heartbeat_ivl_timer_id);
-        _has_heartbeat_timer = true;
+        //  Sweep often enough to notice a missed PONG in time.
+        int period = _options.heartbeat_interval;
+        if (_heartbeat_timeout > 0 && _heartbeat_timeout < period)
+            period = _heartbeat_timeout;
+        add_heartbeat (period);
     }
 
     bool flush_session = false;
@@ -996,10 +1016,9 @@ void zmq::stream_engine_t::mechanism_ready ()
     properties.insert (zmtp_properties.begin (), zmtp_properties.end ());
 
     zmq_assert (_metadata == NULL);
-    if (!properties.empty ()) {
-        _metadata = new (std::nothrow) metadata_t (properties);
-        alloc_assert (_metadata);
-    }
+    if (!properties.empty ())
+        _metadata =
+          _session->get_ctx ()->get_metadata_registry ()->intern (properties);
 
     _socket->event_handshake_succeeded (_endpoint, 0);
 }
@@ -1049,7 +1068,14 @@ int zmq::stream_engine_t::pull_and_encode(msg_t *msg_)
 {
     zmq_assert (_mechanism != NULL);
 
-
+    //  The messages waiting are encoded as one while they fit, if the
+    //  mechanism negotiated it.
+    if (_mechanism->batching ()) {
+        while (_session->pull_msg (msg_) == 0)
+            if (_mechanism->batch (msg_) == 1)
+                return 0;
+        return _mechanism->flush_batch (msg_);
+    }
 
     if (_session->pull_msg(msg_) == -1)
         return -1;
@@ -1065,15 +1091,18 @@ int zmq::stream_engine_t::decode_and_push(msg_t *msg_)
     if (_mechanism->decode (msg_) == -1)
         return -1;
 
-    if (_has_timeout_timer) {
-        _has_timeout_timer = false;
-        cancel_timer (heartbeat_timeout_timer_id);
-    }
+    //  A batch is pushed message by message.
+    do {
+        if (push_decoded (msg_) == -1)
+            return -1;
+    } while (_mechanism->next_decoded (msg_) == 0);
+    return 0;
+}
 
-    if (_has_ttl_timer) {
-        _has_ttl_timer = false;
-        cancel_timer (heartbeat_ttl_timer_id);
-    }
+int zmq::stream_engine_t::push_decoded (msg_t *msg_)
+{
+    if (_has_heartbeat)
+        _heartbeats->received (_heartbeat_handle);
 
     if (msg_->flags () & msg_t::command) {
         process_command_message (msg_);
@@ -1094,9 +1123,15 @@ int zmq::stream_engine_t::decode_and_push(msg_t *msg_)
 int zmq::stream_engine_t::push_one_then_decode_and_push(msg_t *msg_)
 {
     const int rc = _session->push_msg (msg_);
-    if (rc == 0)
-        _process_msg = &stream_engine_t::decode_and_push;
-    return rc;
+    if (rc == -1)
+        return -1;
+    _process_msg = &stream_engine_t::decode_and_push;
+
+    //  Then the rest of the batch the message came in.
+    while (_mechanism->next_decoded (msg_) == 0)
+        if (push_decoded (msg_) == -1)
+            return -1;
+    return 0;
 }
 
 void zmq::stream_engine_t::error(error_reason_t reason_)
@@ -1174,32 +1209,32 @@ void zmq::stream_engine_t::timer_event(int id_)
         //  handshake timer expired before handshake completed, so engine fail
         error (timeout_error);
     } 
-    else if (id_ == heartbeat_ivl_timer_id) 
-    {
-
-        _next_msg = &stream_engine_t::produce_ping_message;
-        out_event ();
-        add_timer (_options.heartbeat_interval, heartbeat_ivl_timer_id);
-    } 
-    else if (id_ == heartbeat_ttl_timer_id) 
-    {
-
-
-        _has_ttl_timer = false;
-        error (timeout_error);
-    } 
-    else if (id_ == heartbeat_timeout_timer_id) 
-    {
-
-
-        _has_timeout_timer = false;
-        error (timeout_error);
-    } 
     else
         // There are no other valid timer ids!
         assert (false);
 }
 
+void zmq::stream_engine_t::heartbeat_ping ()
+{
+    _next_msg = &stream_engine_t::produce_ping_message;
+    out_event ();
+}
+
+void zmq::stream_engine_t::heartbeat_expired ()
+{
+    error (timeout_error);
+}
+
+void zmq::stream_engine_t::add_heartbeat (int period_)
+{
+    zmq_assert (!_has_heartbeat);
+    const int interval =
+      _options.heartbeat_interval > 0 ? _options.heartbeat_interval : 0;
+    const int timeout = interval > 0 ? _heartbeat_timeout : 0;
+    _heartbeat_handle = _heartbeats->add (this, period_, interval, timeout);
+    _has_heartbeat = true;
+}
+
 int zmq::stream_engine_t::produce_ping_message (msg_t *msg_)
 {
     // 16-bit TTL + \4PING == 7
@@ -1218,10 +1253,7 @@ int zmq::stream_engine_t::produce_ping_message (msg_t *msg_)
 
     rc = _mechanism->encode (msg_);
     _next_msg = &stream_engine_t::pull_and_encode;
-    if (!_has_timeout_timer && _heartbeat_timeout > 0) {
-        add_timer (_heartbeat_timeout, heartbeat_timeout_timer_id);
-        _has_timeout_timer = true;
-    }
+    _heartbeats->ping_sent (_heartbeat_handle);
     return rc;
 }
 
@@ -1255,9 +1287,10 @@ int zmq::stream_engine_t::process_heartbeat_message (msg_t *msg_)
         // so we multiply it by 100 to get the timer interval in ms.
         remote_heartbeat_ttl *= 100;
 
-        if (!_has_ttl_timer && remote_heartbeat_ttl > 0) {
-            add_timer (remote_heartbeat_ttl, heartbeat_ttl_timer_id);
-            _has_ttl_timer = true;
+        if (remote_heartbeat_ttl > 0) {
+            if (!_has_heartbeat)
+                add_heartbeat (remote_heartbeat_ttl);
+            _heartbeats->set_ttl (_heartbeat_handle, remote_heartbeat_ttl);
         }
 
         //  As per ZMTP 3.1 the PING command might contain an up to 16 bytes
@@ -4,6 +4,8 @@
 #include <stddef.h>
 #include "fd.hpp"
 #include "i_engine.hpp"
+#include "i_heartbeat_events.hpp"
+#include "heartbeat_scheduler.hpp"
 #include "io_object.hpp"
 #include "i_encoder.hpp"
 #include "i_decoder.hpp"
@@ -29,7 +31,9 @@ class mechanism_t;
 //  This engine handles any socket with SOCK_STREAM semantics,
 //  e.g. TCP socket or an UNIX domain socket.
 
-class stream_engine_t : public io_object_t, public i_engine
+class stream_engine_t : public io_object_t,
+                        public i_engine,
+                        public i_heartbeat_events
 {
 public:
     enum error_reason_t
@@ -50,6 +54,7 @@ public:
     bool restart_input ();
     void restart_output ();
     void zap_msg_available ();
+    void crypto_job_done ();
     const char *get_endpoint () const;
 
     //  i_poll_events interface implementation.
@@ -57,6 +62,10 @@ public:
     void out_event();
     void timer_event(int id_);
 
+    //  i_heartbeat_events interface implementation.
+    void heartbeat_ping ();
+    void heartbeat_expired ();
+
 private:
     //  Unplug the engine from the session.
     void unplug();
@@ -93,6 +102,7 @@ private:
     int write_credential (msg_t *msg_);
     int pull_and_encode (msg_t *msg_);
     int decode_and_push (msg_t *msg_);
+    int push_decoded (msg_t *msg_);
     int push_one_then_decode_and_push (msg_t *msg_);
 
     void mechanism_ready ();
@@ -190,19 +200,20 @@ private:
     //  True is linger timer is running.
     bool _has_handshake_timer;
 
-    //  Heartbeat stuff
-    enum
-    {
-        heartbeat_ivl_timer_id     = 0x80,
-        heartbeat_timeout_timer_id = 0x81,
-        heartbeat_ttl_timer_id     = 0x82
-    };
+    //  Registers the engine with the heartbeat scheduler of its thread.
+    void add_heartbeat (int period_);
 
-    bool _has_ttl_timer;
-    bool _has_timeout_timer;
-    bool _has_heartbeat_timer;
+    //  Heartbeat stuff. The engine is registered with the scheduler once
+    //  it sends PINGs or its peer announced a TTL.
+    heartbeat_scheduler_t *_heartbeats;
+    heartbeat_scheduler_t::handle_t _heartbeat_handle;
+    bool _has_heartbeat;
     int  _heartbeat_timeout;
 
+    //  Pool of the I/O thread the encoder and decoder borrow their
+    //  buffers from while data is flowing.
+    buffer_pool_t *_buffer_pool;
+
     // Socket
     zmq::socket_base_t *_socket;
 
@@ -18,7 +18,11 @@ public:
     //  structure. If 'local' is true, names are resolved as local interface
     //  names. If it is false, names are resolved as remote hostnames.
     //  If 'ipv6' is true, the name may resolve to IPv6 address.
-    int resolve (const char *name_, bool local_, bool ipv6_);
+    //  If 'allow_dns' is false, remote names must be numeric addresses.
+    int resolve (const char *name_,
+                 bool local_,
+                 bool ipv6_,
+                 bool allow_dns_ = true);
 
     //  The opposite to resolve()
     int to_string (std::string &addr_) const;
@@ -27,6 +27,8 @@ zmq::tcp_connecter_t::tcp_connecter_t(class io_thread_t *io_thread_, class sessi
     own_t(io_thread_, options_),
     io_object_t(io_thread_),
     _addr(addr_),
+    _io_thread(io_thread_),
+    _dns_request(NULL),
     _s(retired_fd),
     _handle(static_cast<handle_t>(NULL)),
     _delayed_start(delayed_start_),
@@ -50,6 +52,7 @@ zmq::tcp_connecter_t::~tcp_connecter_t()
     zmq_assert (!_reconnect_timer_started);
     zmq_assert (!_handle);
     zmq_assert (_s == retired_fd);
+    zmq_assert (!_dns_request);
 }
 
 void zmq::tcp_connecter_t::process_plug()
@@ -84,6 +87,12 @@ void zmq::tcp_connecter_t::process_term(int linger_)
         rm_handle();
     }
 
+    if (_dns_request)
+    {
+        _dns_request->abandon ();
+        _dns_request = NULL;
+    }
+
     if (_s != retired_fd)
         close();
 
@@ -155,7 +164,89 @@ void zmq::tcp_connecter_t::timer_event(int id_)
     }
 }
 
+zmq::tcp_connecter_t::resolve_request_t::resolve_request_t (
+  tcp_connecter_t *connecter_, const std::string &name_, bool ipv6_) :
+    dns_request_t (name_, ipv6_),
+    _connecter (connecter_)
+{
+}
+
+void zmq::tcp_connecter_t::resolve_request_t::completed ()
+{
+    _connecter->address_resolved ();
+}
+
 void zmq::tcp_connecter_t::start_connecting()
+{
+    const int rc = resolve_address ();
+
+    //  The name server is asked, connecting goes on once it answered.
+    if (rc == -1 && errno == EAGAIN)
+        return;
+
+    if (rc == -1)
+    {
+        add_reconnect_timer ();
+        return;
+    }
+
+    connect_to_address ();
+}
+
+int zmq::tcp_connecter_t::resolve_address ()
+{
+    if (_addr->resolved.tcp_addr != NULL) 
+    {
+        LIBZMQ_DELETE (_addr->resolved.tcp_addr);
+    }
+
+    tcp_address_t *tcp_addr = new (std::nothrow) tcp_address_t ();
+    alloc_assert (tcp_addr);
+
+    //  Numeric addresses and names answered recently are resolved
+    //  right away, others by the resolver thread of the context.
+    dns_resolver_t *resolver = _io_thread->get_dns_resolver ();
+    if (resolver->lookup (_addr->address, options.ipv6, tcp_addr) == 0)
+    {
+        _addr->resolved.tcp_addr = tcp_addr;
+        return 0;
+    }
+    const int err = errno;
+    LIBZMQ_DELETE (tcp_addr);
+
+    if (err == EAGAIN)
+    {
+        zmq_assert (!_dns_request);
+        _dns_request = new (std::nothrow)
+          resolve_request_t (this, _addr->address, options.ipv6);
+        alloc_assert (_dns_request);
+        resolver->submit (_dns_request, _io_thread);
+    }
+    errno = err;
+    return -1;
+}
+
+void zmq::tcp_connecter_t::address_resolved ()
+{
+    resolve_request_t *request = _dns_request;
+    _dns_request = NULL;
+
+    if (request->rc == -1)
+    {
+        LIBZMQ_DELETE (request);
+        add_reconnect_timer ();
+        return;
+    }
+
+    _addr->resolved.tcp_addr =
+      new (std::nothrow) tcp_address_t (request->address);
+    alloc_assert (_addr->resolved.tcp_addr);
+    LIBZMQ_DELETE (request);
+
+    connect_to_address ();
+}
+
+void zmq::tcp_connecter_t::connect_to_address()
 {
     //  Open the connecting socket.
     const int rc = open();
@@ -224,23 +315,9 @@ int zmq::tcp_connecter_t::get_new_reconnect_ivl()
 int zmq::tcp_connecter_t::open()
 {
     zmq_assert (_s == retired_fd);
-
-    //  Resolve the address
-    if (_addr->resolved.tcp_addr != NULL) 
-    {
-        LIBZMQ_DELETE (_addr->resolved.tcp_addr);
-    }
-
-    _addr->resolved.tcp_addr = new (std::nothrow) tcp_address_t ();
-    alloc_assert (_addr->resolved.tcp_addr);
-    int rc = _addr->resolved.tcp_addr->resolve(_addr->address.c_str (), false, options.ipv6);
-    if (rc != 0) 
-    {
-        LIBZMQ_DELETE (_addr->resolved.tcp_addr);
-        return -1;
-    }
     zmq_assert (_addr->resolved.tcp_addr != NULL);
     const tcp_address_t *const tcp_addr = _addr->resolved.tcp_addr;
+    int rc;
 
     //  Create the socket.
     _s = open_socket(tcp_addr->family(), SOCK_STREAM, IPPROTO_TCP);
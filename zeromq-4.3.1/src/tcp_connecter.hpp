@@ -5,6 +5,7 @@
 #include "own.hpp"
 #include "stdint.hpp"
 #include "io_object.hpp"
+#include "dns_resolver.hpp"
 
 namespace zmq
 {
@@ -41,9 +42,32 @@ private:
     //  Removes the handle from the poller.
     void rm_handle ();
 
+    //  Request resolving the address to connect to, handed back to
+    //  address_resolved once answered.
+    class resolve_request_t : public dns_request_t
+    {
+      public:
+        resolve_request_t (tcp_connecter_t *connecter_,
+                           const std::string &name_,
+                           bool ipv6_);
+        void completed ();
+
+      private:
+        tcp_connecter_t *const _connecter;
+    };
+
     //  Internal function to start the actual connection establishment.
     void start_connecting ();
 
+    //  Resolves the address to connect to. Returns -1 with EAGAIN if a
+    //  name server has to be asked, the connecter then waits for
+    //  address_resolved.
+    int resolve_address ();
+    void address_resolved ();
+
+    //  Connects to the resolved address.
+    void connect_to_address ();
+
     //  Internal function to add a connect timer
     void add_connect_timer ();
 
@@ -55,9 +79,9 @@ private:
     //  Returns the currently used interval
     int get_new_reconnect_ivl ();
 
-    //  Open TCP connecting socket. Returns -1 in case of error,
-    //  0 if connect was successful immediately. Returns -1 with
-    //  EAGAIN errno if async connect was launched.
+    //  Open TCP connecting socket to the resolved address. Returns -1 in
+    //  case of error, 0 if connect was successful immediately. Returns -1
+    //  with EAGAIN errno if async connect was launched.
     int open ();
 
     //  Close the connecting socket.
@@ -73,6 +97,12 @@ private:
     //  Address to connect to. Owned by session_base_t.
     address_t *const _addr;
 
+    //  I/O thread the connecter runs in.
+    zmq::io_thread_t *const _io_thread;
+
+    //  Pending resolution of the address, or NULL.
+    resolve_request_t *_dns_request;
+
     //  Underlying socket.
     fd_t _s;
 
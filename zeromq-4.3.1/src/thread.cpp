@@ -8,6 +8,26 @@ bool zmq::thread_t::get_started () const
     return _started;
 }
 
+zmq::thread_t::id_t zmq::thread_t::current_id ()
+{
+#ifdef ZMQ_HAVE_WINDOWS
+    return GetCurrentThreadId ();
+#elif defined ZMQ_HAVE_VXWORKS
+    return taskIdSelf ();
+#else
+    return pthread_self ();
+#endif
+}
+
+bool zmq::thread_t::same_id (id_t a_, id_t b_)
+{
+#if defined ZMQ_HAVE_WINDOWS || defined ZMQ_HAVE_VXWORKS
+    return a_ == b_;
+#else
+    return pthread_equal (a_, b_) != 0;
+#endif
+}
+
 #include <signal.h>
 #include <unistd.h>
 #include <sys/time.h>
@@ -50,6 +70,16 @@ void zmq::thread_t::stop()
     }
 }
 
+void zmq::thread_t::detach ()
+{
+    if (_started)
+    {
+        int rc = pthread_detach(_descriptor);
+        posix_assert (rc);
+        _started = false;
+    }
+}
+
 bool zmq::thread_t::is_current_thread () const
 {
     return pthread_self() == _descriptor;
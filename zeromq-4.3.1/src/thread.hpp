@@ -19,6 +19,15 @@ typedef void(thread_fn) (void *);
 class thread_t
 {
 public:
+    //  Identifies a thread, including threads not started by thread_t.
+#ifdef ZMQ_HAVE_WINDOWS
+    typedef DWORD id_t;
+#elif defined ZMQ_HAVE_VXWORKS
+    typedef int id_t;
+#else
+    typedef pthread_t id_t;
+#endif
+
     inline thread_t () : _tfn (NULL), _arg(NULL), _started(false), _thread_priority(ZMQ_THREAD_PRIORITY_DFLT), _thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT)
     {
 
@@ -35,9 +44,18 @@ public:
     //  thread object.
     bool is_current_thread () const;
 
+    //  Returns the id of the executing thread.
+    static id_t current_id ();
+
+    //  Returns whether two ids identify the same thread.
+    static bool same_id (id_t a_, id_t b_);
+
     //  Waits for thread termination.
     void stop ();
 
+    //  Lets the thread run to its end without being waited for.
+    void detach ();
+
     // Sets the thread scheduling parameters. Only implemented for
     // pthread. Has no effect on other platforms.
     void setSchedulingParameters (int priority_,
@@ -0,0 +1,284 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "timer_wheel.hpp"
+#include "err.hpp"
+
+zmq::timer_wheel_t::timer_wheel_t () : _current (0), _free (npos), _count (0)
+{
+    for (int i = 0; i != slots; i++)
+        _heads[i] = _tails[i] = npos;
+    for (int i = 0; i != slots / 64; i++)
+        _occupied[i] = 0;
+}
+
+zmq::timer_wheel_t::handle_t zmq::timer_wheel_t::add (uint64_t now_,
+                                                      uint64_t expiration_,
+                                                      i_poll_events *sink_,
+                                                      int id_)
+{
+    //  An empty wheel can jump to the present straight away.
+    if (_count == 0 && now_ > _current)
+        _current = now_;
+
+    uint32_t index = _free;
+    if (index != npos)
+        _free = _nodes[index].next;
+    else {
+        index = static_cast<uint32_t> (_nodes.size ());
+        zmq_assert (index != npos);
+        node_t node;
+        node.generation = 0;
+        _nodes.push_back (node);
+    }
+
+    node_t &node = _nodes[index];
+    node.expiration = expiration_;
+    node.sink = sink_;
+    node.id = id_;
+    link (index, slot_for (expiration_));
+    _count++;
+
+    return (static_cast<handle_t> (node.generation) << 32) | index;
+}
+
+void zmq::timer_wheel_t::cancel (handle_t handle_)
+{
+    const uint32_t index = static_cast<uint32_t> (handle_);
+    const uint32_t generation = static_cast<uint32_t> (handle_ >> 32);
+
+    //  Timer not found.
+    zmq_assert (index < _nodes.size ());
+    zmq_assert (_nodes[index].generation == generation);
+    zmq_assert (_nodes[index].slot != npos);
+
+    unlink (index);
+    release (index);
+    _count--;
+}
+
+bool zmq::timer_wheel_t::pop_expired (uint64_t now_,
+                                      i_poll_events **sink_,
+                                      int *id_)
+{
+    while (true) {
+        if (_count == 0) {
+            if (now_ > _current)
+                _current = now_;
+            return false;
+        }
+
+        //  The timers in the slot of the current millisecond are due.
+        const uint32_t index = _heads[_current & (root_slots - 1)];
+        if (index != npos) {
+            *sink_ = _nodes[index].sink;
+            *id_ = _nodes[index].id;
+            unlink (index);
+            release (index);
+            _count--;
+            return true;
+        }
+
+        if (_current >= now_)
+            return false;
+        step (now_);
+    }
+}
+
+uint64_t zmq::timer_wheel_t::timeout (uint64_t now_) const
+{
+    if (_count == 0)
+        return 0;
+
+    //  The first level knows the exact expirations, either later in the
+    //  current turn or, for the slots already passed, in the next one.
+    const uint32_t pos = static_cast<uint32_t> (_current & (root_slots - 1));
+    const uint64_t turn = _current - pos;
+    uint64_t next = ~uint64_t (0);
+    uint32_t slot = find_occupied (pos, root_slots - 1);
+    if (slot != npos)
+        next = turn + slot;
+    else if (pos > 0 && (slot = find_occupied (0, pos - 1)) != npos)
+        next = turn + root_slots + slot;
+
+    //  Upper levels: the next occupied slot cascades at the start of its
+    //  span. The slot of the current span holds the timers of the next
+    //  revolution.
+    for (int level = 1; level != levels; level++) {
+        const int shift = root_bits + (level - 1) * level_bits;
+        const uint64_t word = _occupied[root_slots / 64 + level - 1];
+        if (!word)
+            continue;
+        const uint32_t idx =
+          static_cast<uint32_t> ((_current >> shift) & (level_slots - 1));
+        for (uint32_t distance = 1; distance <= level_slots; distance++) {
+            if (word & (uint64_t (1) << ((idx + distance) & (level_slots - 1)))) {
+                const uint64_t start = ((_current >> shift) + distance) << shift;
+                if (start < next)
+                    next = start;
+                break;
+            }
+        }
+    }
+
+    return next > now_ ? next - now_ : 1;
+}
+
+uint32_t zmq::timer_wheel_t::slot_for (uint64_t expiration_) const
+{
+    if (expiration_ <= _current)
+        return static_cast<uint32_t> (_current & (root_slots - 1));
+
+    const uint64_t delta = expiration_ - _current;
+    if (delta < root_slots)
+        return static_cast<uint32_t> (expiration_ & (root_slots - 1));
+
+    for (int level = 1; level != levels; level++) {
+        const int shift = root_bits + (level - 1) * level_bits;
+        const uint64_t span = uint64_t (1) << (shift + level_bits);
+        uint64_t expiration = expiration_;
+        if (delta >= span) {
+            if (level != levels - 1)
+                continue;
+            //  Beyond the reach of the wheel; the timer is refiled when
+            //  it cascades from the last slot in range.
+            expiration = _current + span - 1;
+        }
+        return root_slots + (level - 1) * level_slots
+               + static_cast<uint32_t> ((expiration >> shift)
+                                        & (level_slots - 1));
+    }
+
+    zmq_assert (false);
+    return npos;
+}
+
+void zmq::timer_wheel_t::link (uint32_t node_, uint32_t slot_)
+{
+    node_t &node = _nodes[node_];
+    node.slot = slot_;
+    node.next = npos;
+    node.prev = _tails[slot_];
+    if (node.prev != npos)
+        _nodes[node.prev].next = node_;
+    else
+        _heads[slot_] = node_;
+    _tails[slot_] = node_;
+    _occupied[slot_ / 64] |= uint64_t (1) << (slot_ % 64);
+}
+
+void zmq::timer_wheel_t::unlink (uint32_t node_)
+{
+    node_t &node = _nodes[node_];
+    const uint32_t slot = node.slot;
+    if (node.prev != npos)
+        _nodes[node.prev].next = node.next;
+    else
+        _heads[slot] = node.next;
+    if (node.next != npos)
+        _nodes[node.next].prev = node.prev;
+    else
+        _tails[slot] = node.prev;
+    if (_heads[slot] == npos)
+        _occupied[slot / 64] &= ~(uint64_t (1) << (slot % 64));
+}
+
+void zmq::timer_wheel_t::release (uint32_t node_)
+{
+    node_t &node = _nodes[node_];
+    node.slot = npos;
+    node.generation++;
+    node.next = _free;
+    _free = node_;
+}
+
+void zmq::timer_wheel_t::step (uint64_t now_)
+{
+    const uint32_t pos = static_cast<uint32_t> (_current & (root_slots - 1));
+
+    //  Stop at the next occupied slot of this turn, at the end of the
+    //  turn, or at now_, whichever comes first.
+    uint64_t target = (_current | (root_slots - 1)) + 1;
+    if (pos + 1 < root_slots) {
+        const uint32_t slot = find_occupied (pos + 1, root_slots - 1);
+        if (slot != npos)
+            target = _current - pos + slot;
+    }
+    if (target > now_)
+        target = now_;
+    _current = target;
+
+    if ((_current & (root_slots - 1)) == 0)
+        cascade ();
+}
+
+void zmq::timer_wheel_t::cascade ()
+{
+    for (int level = 1; level != levels; level++) {
+        const int shift = root_bits + (level - 1) * level_bits;
+        const uint32_t idx =
+          static_cast<uint32_t> ((_current >> shift) & (level_slots - 1));
+        const uint32_t slot = root_slots + (level - 1) * level_slots + idx;
+
+        uint32_t index = _heads[slot];
+        _heads[slot] = _tails[slot] = npos;
+        _occupied[slot / 64] &= ~(uint64_t (1) << (slot % 64));
+        while (index != npos) {
+            const uint32_t next = _nodes[index].next;
+            link (index, slot_for (_nodes[index].expiration));
+            index = next;
+        }
+
+        //  The next level turns over only when this one does.
+        if (idx != 0)
+            break;
+    }
+}
+
+uint32_t zmq::timer_wheel_t::find_occupied (uint32_t first_,
+                                            uint32_t last_) const
+{
+    for (uint32_t word = first_ / 64; word <= last_ / 64; word++) {
+        uint64_t bits = _occupied[word];
+        if (word == first_ / 64)
+            bits &= ~uint64_t (0) << (first_ % 64);
+        if (word == last_ / 64 && last_ % 64 != 63)
+            bits &= (uint64_t (1) << (last_ % 64 + 1)) - 1;
+        if (bits) {
+            uint32_t bit = 0;
+            while (!(bits & 1)) {
+                bits >>= 1;
+                bit++;
+            }
+            return word * 64 + bit;
+        }
+    }
+    return npos;
+}
@@ -0,0 +1,141 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+struct i_poll_events;
+
+//  Hierarchical timing wheel holding the timers of a poller.
+//
+//  The first level has one slot per millisecond for the next 256 ms; each
+//  of the four upper levels has 64 slots, each covering a whole turn of the
+//  level below. A timer is filed in the lowest level that can hold its
+//  expiration and moves down a level ("cascades") when the wheel reaches
+//  its slot, so adding and cancelling a timer are O(1). Time is advanced
+//  lazily while expired timers are collected, skipping runs of empty slots.
+//
+//  Timers live in a pool of nodes and are identified by a handle combining
+//  the node index with a generation counter, so cancelling a timer that
+//  has already fired or been cancelled is detected.
+
+class timer_wheel_t
+{
+  public:
+    typedef uint64_t handle_t;
+
+    timer_wheel_t ();
+
+    bool empty () const { return _count == 0; }
+
+    //  Adds a timer firing at expiration_ (ms). now_ is the current time.
+    handle_t add (uint64_t now_, uint64_t expiration_, i_poll_events *sink_,
+                  int id_);
+
+    //  Removes a pending timer.
+    void cancel (handle_t handle_);
+
+    //  Removes a timer due at now_ and returns its sink and id. Returns
+    //  false if there is none. Timers due at the same millisecond come in
+    //  the order they were added.
+    bool pop_expired (uint64_t now_, i_poll_events **sink_, int *id_);
+
+    //  Returns the number of milliseconds after now_ at which a timer may
+    //  become due, or 0 if there are no timers. The wheel only knows the
+    //  exact expiration of timers in its first level; for the others this
+    //  is the time the next occupied slot cascades.
+    uint64_t timeout (uint64_t now_) const;
+
+  private:
+    enum
+    {
+        root_bits = 8,
+        level_bits = 6,
+        levels = 5,
+        root_slots = 1 << root_bits,
+        level_slots = 1 << level_bits,
+        slots = root_slots + (levels - 1) * level_slots
+    };
+
+    static const uint32_t npos = 0xffffffff;
+
+    struct node_t
+    {
+        uint64_t expiration;
+        i_poll_events *sink;
+        int id;
+        uint32_t generation;
+        uint32_t slot;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    //  Returns the slot index in which to file a timer given the current
+    //  position of the wheel.
+    uint32_t slot_for (uint64_t expiration_) const;
+
+    void link (uint32_t node_, uint32_t slot_);
+    void unlink (uint32_t node_);
+    void release (uint32_t node_);
+
+    //  Moves the wheel forward to at most now_, stopping at the next
+    //  occupied first level slot or turn of the first level.
+    void step (uint64_t now_);
+
+    //  Refiles the timers of the upper level slots reached by the wheel.
+    void cascade ();
+
+    //  Returns the first occupied slot of the range [first_, last_] of a
+    //  bitmap group, or npos.
+    uint32_t find_occupied (uint32_t first_, uint32_t last_) const;
+
+    //  Time of the last millisecond the wheel has reached.
+    uint64_t _current;
+
+    //  Heads of the per slot lists and the bitmap of non-empty slots.
+    uint32_t _heads[slots];
+    uint32_t _tails[slots];
+    uint64_t _occupied[slots / 64];
+
+    std::vector<node_t> _nodes;
+    uint32_t _free;
+    size_t _count;
+
+    timer_wheel_t (const timer_wheel_t &);
+    const timer_wheel_t &operator= (const timer_wheel_t &);
+};
+}
+
+#endif
@@ -33,7 +33,13 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <algorithm>
 
-zmq::timers_t::timers_t () : _tag (0xCAFEDADA), _next_timer_id (0)
+static const size_t npos = static_cast<size_t> (-1);
+
+zmq::timers_t::timers_t () :
+    _tag (0xCAFEDADA),
+    _next_timer_id (0),
+    _free (npos),
+    _sequence (0)
 {
 }
 
@@ -55,130 +61,185 @@ int zmq::timers_t::add (size_t interval_, timers_timer_fn handler_, void *arg_)
         return -1;
     }
 
-    uint64_t when = _clock.now_ms () + interval_;
-    timer_t timer = {++_next_timer_id, interval_, handler_, arg_};
-    _timers.insert (timersmap_t::value_type (when, timer));
+    size_t index = _free;
+    if (index != npos)
+        _free = _timers[index].heap_index;
+    else {
+        index = _timers.size ();
+        _timers.push_back (timer_t ());
+    }
 
-    return timer.timer_id;
-}
+    timer_t &timer = _timers[index];
+    timer.timer_id = ++_next_timer_id;
+    timer.interval = interval_;
+    timer.handler = handler_;
+    timer.arg = arg_;
+    timer.heap_index = _heap.size ();
+    _heap.push_back (index);
 
-struct zmq::timers_t::match_by_id
-{
-    match_by_id (int timer_id_) : _timer_id (timer_id_) {}
+    const bool inserted =
+      _ids.insert (ids_t::value_type (timer.timer_id, index)).second;
+    zmq_assert (inserted);
 
-    bool operator() (timersmap_t::value_type const &entry_) const
-    {
-        return entry_.second.timer_id == _timer_id;
-    }
+    schedule (index, _clock.now_ms () + interval_);
 
-  private:
-    int _timer_id;
-};
+    return timer.timer_id;
+}
 
 int zmq::timers_t::cancel (int timer_id_)
 {
-    // check first if timer exists at all
-    if (_timers.end ()
-        == std::find_if (_timers.begin (), _timers.end (),
-                         match_by_id (timer_id_))) {
-        errno = EINVAL;
-        return -1;
-    }
-
-    // check if timer was already canceled
-    if (_cancelled_timers.count (timer_id_)) {
+    const int index = find (timer_id_);
+    if (index < 0) {
         errno = EINVAL;
         return -1;
     }
 
-    _cancelled_timers.insert (timer_id_);
-
+    remove (index);
     return 0;
 }
 
 int zmq::timers_t::set_interval (int timer_id_, size_t interval_)
 {
-    const timersmap_t::iterator end = _timers.end ();
-    const timersmap_t::iterator it =
-      std::find_if (_timers.begin (), end, match_by_id (timer_id_));
-    if (it != end) {
-        timer_t timer = it->second;
-        timer.interval = interval_;
-        uint64_t when = _clock.now_ms () + interval_;
-        _timers.erase (it);
-        _timers.insert (timersmap_t::value_type (when, timer));
-
-        return 0;
+    const int index = find (timer_id_);
+    if (index < 0) {
+        errno = EINVAL;
+        return -1;
     }
 
-    errno = EINVAL;
-    return -1;
+    _timers[index].interval = interval_;
+    schedule (index, _clock.now_ms () + interval_);
+    return 0;
 }
 
 int zmq::timers_t::reset (int timer_id_)
 {
-    const timersmap_t::iterator end = _timers.end ();
-    const timersmap_t::iterator it =
-      std::find_if (_timers.begin (), end, match_by_id (timer_id_));
-    if (it != end) {
-        timer_t timer = it->second;
-        uint64_t when = _clock.now_ms () + timer.interval;
-        _timers.erase (it);
-        _timers.insert (timersmap_t::value_type (when, timer));
-
-        return 0;
+    const int index = find (timer_id_);
+    if (index < 0) {
+        errno = EINVAL;
+        return -1;
     }
 
-    errno = EINVAL;
-    return -1;
+    schedule (index, _clock.now_ms () + _timers[index].interval);
+    return 0;
 }
 
 long zmq::timers_t::timeout ()
 {
+    if (_heap.empty ())
+        return -1;
+
     const uint64_t now = _clock.now_ms ();
-    long res = -1;
-
-    const timersmap_t::iterator begin = _timers.begin ();
-    const timersmap_t::iterator end = _timers.end ();
-    timersmap_t::iterator it = begin;
-    for (; it != end; ++it) {
-        if (0 == _cancelled_timers.erase (it->second.timer_id)) {
-            //  Live timer, lets return the timeout
-            res = std::max (static_cast<long> (it->first - now), 0l);
+    const uint64_t when = _timers[_heap[0]].when;
+    return when > now ? static_cast<long> (when - now) : 0l;
+}
+
+int zmq::timers_t::execute ()
+{
+    const uint64_t now = _clock.now_ms ();
+
+    //  Timers rescheduled or added while executing wait for the next call.
+    const uint64_t sequence = _sequence;
+
+    while (!_heap.empty ()) {
+        const size_t index = _heap[0];
+        const timer_t &timer = _timers[index];
+
+        //  Heap is ordered, if we have to wait for the first timer we can
+        //  stop.
+        if (timer.when > now || timer.sequence >= sequence)
             break;
-        }
+
+        //  Reschedule before invoking the handler, which may cancel or
+        //  reset the timer, or add new ones.
+        const int timer_id = timer.timer_id;
+        timers_timer_fn *handler = timer.handler;
+        void *arg = timer.arg;
+        schedule (index, now + timer.interval);
+
+        handler (timer_id, arg);
     }
 
-    //  Remove timed-out timers
-    _timers.erase (begin, it);
+    return 0;
+}
 
-    return res;
+int zmq::timers_t::find (int timer_id_) const
+{
+    const ids_t::const_iterator it = _ids.find (timer_id_);
+    return it != _ids.end () ? static_cast<int> (it->second) : -1;
 }
 
-int zmq::timers_t::execute ()
+void zmq::timers_t::schedule (size_t index_, uint64_t when_)
 {
-    const uint64_t now = _clock.now_ms ();
+    timer_t &timer = _timers[index_];
+    timer.when = when_;
+    timer.sequence = _sequence++;
 
-    const timersmap_t::iterator begin = _timers.begin ();
-    const timersmap_t::iterator end = _timers.end ();
-    timersmap_t::iterator it = _timers.begin ();
-    for (; it != end; ++it) {
-        if (0 == _cancelled_timers.erase (it->second.timer_id)) {
-            //  Timer is not cancelled
+    //  The new key may be earlier or later than the old one.
+    sift_up (timer.heap_index);
+    sift_down (_timers[index_].heap_index);
+}
 
-            //  Map is ordered, if we have to wait for current timer we can stop.
-            if (it->first > now)
-                break;
+void zmq::timers_t::remove (size_t index_)
+{
+    timer_t &timer = _timers[index_];
+    const size_t erased = _ids.erase (timer.timer_id);
+    zmq_assert (erased == 1);
+
+    const size_t position = timer.heap_index;
+    const size_t last = _heap.size () - 1;
+    if (position != last) {
+        swap_heap (position, last);
+        _heap.pop_back ();
+        sift_up (position);
+        sift_down (_timers[_heap[position]].heap_index);
+    } else
+        _heap.pop_back ();
+
+    timer.handler = NULL;
+    timer.heap_index = _free;
+    _free = index_;
+}
 
-            const timer_t &timer = it->second;
+bool zmq::timers_t::earlier (size_t left_, size_t right_) const
+{
+    const timer_t &left = _timers[_heap[left_]];
+    const timer_t &right = _timers[_heap[right_]];
+    return left.when < right.when
+           || (left.when == right.when && left.sequence < right.sequence);
+}
 
-            timer.handler (timer.timer_id, timer.arg);
+void zmq::timers_t::swap_heap (size_t left_, size_t right_)
+{
+    std::swap (_heap[left_], _heap[right_]);
+    _timers[_heap[left_]].heap_index = left_;
+    _timers[_heap[right_]].heap_index = right_;
+}
 
-            _timers.insert (
-              timersmap_t::value_type (now + timer.interval, timer));
-        }
+void zmq::timers_t::sift_up (size_t position_)
+{
+    while (position_ > 0) {
+        const size_t parent = (position_ - 1) / 2;
+        if (!earlier (position_, parent))
+            break;
+        swap_heap (position_, parent);
+        position_ = parent;
     }
-    _timers.erase (begin, it);
+}
 
-    return 0;
+void zmq::timers_t::sift_down (size_t position_)
+{
+    const size_t size = _heap.size ();
+    while (true) {
+        size_t smallest = position_;
+        const size_t left = 2 * position_ + 1;
+        const size_t right = left + 1;
+        if (left < size && earlier (left, smallest))
+            smallest = left;
+        if (right < size && earlier (right, smallest))
+            smallest = right;
+        if (smallest == position_)
+            break;
+        swap_heap (position_, smallest);
+        position_ = smallest;
+    }
 }
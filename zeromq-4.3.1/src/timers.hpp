@@ -32,7 +32,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stddef.h>
 #include <map>
-#include <set>
+#include <vector>
 
 #include "clock.hpp"
 
@@ -40,6 +40,11 @@ namespace zmq
 {
 typedef void(timers_timer_fn) (int timer_id_, void *arg_);
 
+//  Timers are kept in a binary min-heap ordered by expiration, ties going
+//  to the timer scheduled first. Each timer records its position in the
+//  heap and is found by id through a map, so cancel, reset and
+//  set_interval are O(log n) and timeout is O(1).
+
 class timers_t
 {
   public:
@@ -52,12 +57,10 @@ class timers_t
     int add (size_t interval_, timers_timer_fn handler_, void *arg_);
 
     //  Set the interval of the timer.
-    //  This method is slow, cancelling exsting and adding a new timer yield better performance.
     //  Returns 0 on success and -1 on error.
     int set_interval (int timer_id_, size_t interval_);
 
     //  Reset the timer.
-    //  This method is slow, cancelling exsting and adding a new timer yield better performance.
     //  Returns 0 on success and -1 on error.
     int reset (int timer_id_);
 
@@ -91,18 +94,47 @@ class timers_t
         size_t interval;
         timers_timer_fn *handler;
         void *arg;
+
+        //  Expiration time and scheduling order, the heap key.
+        uint64_t when;
+        uint64_t sequence;
+
+        //  Position in the heap, or index of the next free timer while
+        //  the entry is unused.
+        size_t heap_index;
     } timer_t;
 
-    typedef std::multimap<uint64_t, timer_t> timersmap_t;
-    timersmap_t _timers;
+    //  Returns the index of the timer or -1 if there is none.
+    int find (int timer_id_) const;
+
+    //  Sets the expiration of the timer and moves it to its place in the
+    //  heap.
+    void schedule (size_t index_, uint64_t when_);
+
+    //  Removes the timer and frees its entry.
+    void remove (size_t index_);
 
-    typedef std::set<int> cancelled_timers_t;
-    cancelled_timers_t _cancelled_timers;
+    bool earlier (size_t left_, size_t right_) const;
+    void swap_heap (size_t left_, size_t right_);
+    void sift_up (size_t position_);
+    void sift_down (size_t position_);
+
+    //  Storage of the timers; unused entries form a free list.
+    std::vector<timer_t> _timers;
+    size_t _free;
+
+    //  Indices into _timers ordered as a binary heap.
+    std::vector<size_t> _heap;
+
+    //  Index of each timer in _timers, by timer id.
+    typedef std::map<int, size_t> ids_t;
+    ids_t _ids;
+
+    //  Counter providing the scheduling order.
+    uint64_t _sequence;
 
     timers_t (const timers_t &);
     const timers_t &operator= (const timers_t &);
-
-    struct match_by_id;
 };
 }
 
@@ -42,12 +42,25 @@
 #define crypto_secretbox_NONCEBYTES 24
 #define crypto_secretbox_ZEROBYTES 32
 #define crypto_secretbox_BOXZEROBYTES 16
+#define crypto_hash_BYTES 64
+#define crypto_aead_chacha20poly1305_ietf_KEYBYTES 32
+#define crypto_aead_chacha20poly1305_ietf_NPUBBYTES 12
+#define crypto_aead_chacha20poly1305_ietf_ABYTES 16
+#define crypto_aead_aes256gcm_KEYBYTES 32
+#define crypto_aead_aes256gcm_NPUBBYTES 12
+#define crypto_aead_aes256gcm_ABYTES 16
 typedef unsigned char u8;
 typedef unsigned long u32;
 typedef unsigned long long u64;
 typedef long long i64;
 typedef i64 gf[16];
 
+/* Expanded AES-256-GCM key, as with libsodium. */
+typedef struct crypto_aead_aes256gcm_state_
+{
+    unsigned char opaque[512];
+} crypto_aead_aes256gcm_state;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -71,6 +84,73 @@ int crypto_scalarmult_base (u8 *q_, const u8 *n_);
 int crypto_secretbox (u8 *c_, const u8 *m_, u64 d_, const u8 *n_, const u8 *k_);
 int crypto_secretbox_open (
   u8 *m_, const u8 *c_, u64 d_, const u8 *n_, const u8 *k_);
+int crypto_hash (u8 *out_, const u8 *m_, u64 n_);
+int crypto_verify_16 (const u8 *x_, const u8 *y_);
+
+/* The AEAD constructions of libsodium the CURVE data phase can be
+   negotiated to, implemented in nacl_fast.cpp. ChaCha20-Poly1305 is the
+   one of RFC 8439, AES-256-GCM needs AES-NI and PCLMULQDQ. */
+int crypto_aead_chacha20poly1305_ietf_encrypt_detached (u8 *c_,
+                                                        u8 *mac_,
+                                                        u64 *maclen_p_,
+                                                        const u8 *m_,
+                                                        u64 mlen_,
+                                                        const u8 *ad_,
+                                                        u64 adlen_,
+                                                        const u8 *nsec_,
+                                                        const u8 *npub_,
+                                                        const u8 *k_);
+int crypto_aead_chacha20poly1305_ietf_decrypt_detached (u8 *m_,
+                                                        u8 *nsec_,
+                                                        const u8 *c_,
+                                                        u64 clen_,
+                                                        const u8 *mac_,
+                                                        const u8 *ad_,
+                                                        u64 adlen_,
+                                                        const u8 *npub_,
+                                                        const u8 *k_);
+int crypto_aead_aes256gcm_is_available (void);
+int crypto_aead_aes256gcm_beforenm (crypto_aead_aes256gcm_state *state_,
+                                    const u8 *k_);
+int crypto_aead_aes256gcm_encrypt_detached_afternm (
+  u8 *c_,
+  u8 *mac_,
+  u64 *maclen_p_,
+  const u8 *m_,
+  u64 mlen_,
+  const u8 *ad_,
+  u64 adlen_,
+  const u8 *nsec_,
+  const u8 *npub_,
+  const crypto_aead_aes256gcm_state *state_);
+int crypto_aead_aes256gcm_decrypt_detached_afternm (
+  u8 *m_,
+  u8 *nsec_,
+  const u8 *c_,
+  u64 clen_,
+  const u8 *mac_,
+  const u8 *ad_,
+  u64 adlen_,
+  const u8 *npub_,
+  const crypto_aead_aes256gcm_state *state_);
+
+/* Primitives the functions above are made of. They are implemented in
+   nacl_fast.cpp, the reference versions with the _ref suffix are kept to
+   check them against. */
+int crypto_stream (u8 *c_, u64 d_, const u8 *n_, const u8 *k_);
+int crypto_stream_xor (
+  u8 *c_, const u8 *m_, u64 d_, const u8 *n_, const u8 *k_);
+int crypto_onetimeauth (u8 *out_, const u8 *m_, u64 n_, const u8 *k_);
+int crypto_onetimeauth_verify (
+  const u8 *h_, const u8 *m_, u64 n_, const u8 *k_);
+int crypto_scalarmult (u8 *q_, const u8 *n_, const u8 *p_);
+int crypto_stream_ref (u8 *c_, u64 d_, const u8 *n_, const u8 *k_);
+int crypto_stream_xor_ref (
+  u8 *c_, const u8 *m_, u64 d_, const u8 *n_, const u8 *k_);
+int crypto_onetimeauth_ref (u8 *out_, const u8 *m_, u64 n_, const u8 *k_);
+int crypto_onetimeauth_verify_ref (
+  const u8 *h_, const u8 *m_, u64 n_, const u8 *k_);
+int crypto_scalarmult_ref (u8 *q_, const u8 *n_, const u8 *p_);
 #ifdef __cplusplus
 }
 #endif
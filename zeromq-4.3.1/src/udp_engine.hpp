@@ -39,6 +39,7 @@ class udp_engine_t : public io_object_t, public i_engine
     void restart_output ();
 
     void zap_msg_available (){};
+    void crypto_job_done (){};
 
     void in_event ();
     void out_event ();
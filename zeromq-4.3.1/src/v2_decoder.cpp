@@ -9,7 +9,7 @@
 #include "wire.hpp"
 #include "err.hpp"
 
-zmq::v2_decoder_t::v2_decoder_t(size_t bufsize_, int64_t maxmsgsize_, bool zero_copy_) : decoder_base_t<v2_decoder_t, shared_message_memory_allocator>(bufsize_), _msg_flags(0), _zero_copy (zero_copy_), _max_msg_size (maxmsgsize_)
+zmq::v2_decoder_t::v2_decoder_t(size_t bufsize_, int64_t maxmsgsize_, bool zero_copy_) : decoder_base_t<v2_decoder_t, shared_message_memory_allocator>(bufsize_), _msg_flags(0), _in_place (false), _zero_copy (zero_copy_), _max_msg_size (maxmsgsize_)
 {
     int rc = _in_progress.init();
     errno_assert (rc == 0);
@@ -105,6 +105,7 @@ int zmq::v2_decoder_t::size_ready(uint64_t msg_size_, unsigned char const *read_
         {
             allocator.advance_content();
             allocator.inc_ref();
+            _in_place = true;
         }
     }
 
@@ -133,7 +134,34 @@ int zmq::v2_decoder_t::message_ready(unsigned char const *)
 {
     //  Message is completely read. Signal this to the caller
     //  and prepare to decode next message.
+    _in_place = false;
     next_step(_tmpbuf, 1, &v2_decoder_t::flags_ready);
 
     return 1;
 }
+
+void zmq::v2_decoder_t::release_buffer ()
+{
+    //  The message being received in place would keep the whole buffer
+    //  alive. Move the part received so far to a message of its own.
+    if (_in_place)
+    {
+        const size_t size = _in_progress.size();
+        const size_t received = size - to_read();
+
+        msg_t msg;
+        int rc = msg.init_size(size);
+        if (rc == 0)
+        {
+            memcpy(msg.data(), _in_progress.data(), received);
+            msg.set_flags(_msg_flags);
+            rc = _in_progress.move(msg);
+            errno_assert (rc == 0);
+            _in_place = false;
+            next_step(static_cast<unsigned char *>(_in_progress.data()) + received, size - received, &v2_decoder_t::message_ready);
+        }
+        //  Out of memory the message simply stays where it is.
+    }
+
+    decoder_base_t<v2_decoder_t, shared_message_memory_allocator>::release_buffer();
+}
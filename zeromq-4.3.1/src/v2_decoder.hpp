@@ -19,6 +19,8 @@ public:
     //  i_decoder interface.
     virtual msg_t * msg () { return &_in_progress; }
 
+    virtual void release_buffer ();
+
 private:
     int flags_ready (unsigned char const *);
     int one_byte_size_ready (unsigned char const *);
@@ -31,6 +33,9 @@ private:
     unsigned char _msg_flags;
     msg_t _in_progress;
 
+    //  True while a message using the buffer as storage is being received.
+    bool _in_place;
+
     const bool _zero_copy;
     const int64_t _max_msg_size;
 
@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "zap_cache.hpp"
+#include "config.hpp"
+
+zmq::zap_cache_t::zap_cache_t () : _ttl (0), _generation (0)
+{
+}
+
+void zmq::zap_cache_t::set_ttl (int ttl_)
+{
+    scoped_lock_t locker (_sync);
+    _ttl = ttl_;
+    if (_ttl == 0) {
+        _entries.clear ();
+        ++_generation;
+    }
+}
+
+int zmq::zap_cache_t::get_ttl ()
+{
+    scoped_lock_t locker (_sync);
+    return _ttl;
+}
+
+static void append_field (std::string &key_, const void *data_, size_t size_)
+{
+    //  Fields are prefixed with their length so that no two different
+    //  requests map to the same key.
+    const uint32_t size = static_cast<uint32_t> (size_);
+    key_.append (reinterpret_cast<const char *> (&size), sizeof size);
+    key_.append (static_cast<const char *> (data_), size_);
+}
+
+std::string zmq::zap_cache_t::make_key (const std::string &domain_,
+                                        const char *mechanism_,
+                                        size_t mechanism_length_,
+                                        const std::string &address_,
+                                        const unsigned char *routing_id_,
+                                        size_t routing_id_size_,
+                                        const uint8_t **credentials_,
+                                        size_t *credentials_sizes_,
+                                        size_t credentials_count_)
+{
+    std::string key;
+    append_field (key, domain_.data (), domain_.size ());
+    append_field (key, mechanism_, mechanism_length_);
+    append_field (key, address_.data (), address_.size ());
+    append_field (key, routing_id_, routing_id_size_);
+    for (size_t i = 0; i < credentials_count_; ++i)
+        append_field (key, credentials_[i], credentials_sizes_[i]);
+    return key;
+}
+
+bool zmq::zap_cache_t::find (const std::string &key_, reply_t *reply_)
+{
+    scoped_lock_t locker (_sync);
+    if (_ttl == 0)
+        return false;
+
+    const entries_t::iterator it = _entries.find (key_);
+    if (it == _entries.end ())
+        return false;
+    if (it->second.expiry <= _clock.now_ms ()) {
+        _entries.erase (it);
+        return false;
+    }
+    *reply_ = it->second.reply;
+    return true;
+}
+
+uint64_t zmq::zap_cache_t::generation ()
+{
+    scoped_lock_t locker (_sync);
+    return _generation;
+}
+
+void zmq::zap_cache_t::insert (const std::string &key_,
+                               const std::string &domain_,
+                               const void *credential_,
+                               size_t credential_size_,
+                               uint64_t generation_,
+                               const reply_t &reply_)
+{
+    if (reply_.status_code != "200" && reply_.status_code != "400")
+        return;
+
+    scoped_lock_t locker (_sync);
+    if (_ttl == 0 || generation_ != _generation)
+        return;
+
+    const uint64_t now = _clock.now_ms ();
+    if (_entries.size () >= max_zap_cache_entries
+        && _entries.find (key_) == _entries.end ()) {
+        purge_expired (now);
+        if (_entries.size () >= max_zap_cache_entries)
+            return;
+    }
+
+    entry_t &entry = _entries[key_];
+    entry.reply = reply_;
+    entry.domain = domain_;
+    entry.credential.assign (static_cast<const char *> (credential_),
+                             credential_size_);
+    entry.expiry = now + _ttl;
+}
+
+void zmq::zap_cache_t::invalidate (const char *domain_,
+                                   const void *credential_,
+                                   size_t credential_size_)
+{
+    scoped_lock_t locker (_sync);
+    ++_generation;
+    for (entries_t::iterator it = _entries.begin (); it != _entries.end ();) {
+        const entry_t &entry = it->second;
+        if ((!domain_ || entry.domain == domain_)
+            && (!credential_
+                || (entry.credential.size () == credential_size_
+                    && memcmp (entry.credential.data (), credential_,
+                               credential_size_)
+                         == 0)))
+            _entries.erase (it++);
+        else
+            ++it;
+    }
+}
+
+void zmq::zap_cache_t::purge_expired (uint64_t now_)
+{
+    for (entries_t::iterator it = _entries.begin (); it != _entries.end ();) {
+        if (it->second.expiry <= now_)
+            _entries.erase (it++);
+        else
+            ++it;
+    }
+}
@@ -0,0 +1,133 @@
+/*
+Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+This file is part of libzmq, the ZeroMQ core engine in C++.
+
+libzmq is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License (LGPL) as published
+by the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+As a special exception, the Contributors give you permission to link
+this library with independent modules to produce an executable,
+regardless of the license terms of these independent modules, and to
+copy and distribute the resulting executable under terms of your choice,
+provided that you also meet, for each linked independent module, the
+terms and conditions of the license of that module. An independent
+module is a module which is not derived from or based on this library.
+If you modify this library, you must extend this exception to your
+version of the library.
+
+libzmq is distributed in the hope that it will be useful, but WITHOUT
+ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_ZAP_CACHE_HPP_INCLUDED__
+#define __ZMQ_ZAP_CACHE_HPP_INCLUDED__
+
+#include <map>
+#include <string>
+
+#include "clock.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Replies of the ZAP handler kept by the context, so that a peer
+//  connecting again with the same credentials from the same address is
+//  let in (or turned away) without another round-trip to the handler.
+//
+//  Only final decisions are kept, i.e. 200 and 400 replies; 300 and 500
+//  are temporary by definition and always go to the handler. Entries
+//  expire after the TTL set with ZMQ_ZAP_CACHE_TTL, a TTL of 0 disables
+//  the cache.
+
+class zap_cache_t
+{
+  public:
+    struct reply_t
+    {
+        std::string status_code;
+        std::string user_id;
+        std::string metadata;
+    };
+
+    zap_cache_t ();
+
+    //  Time to live of new entries in milliseconds.
+    void set_ttl (int ttl_);
+    int get_ttl ();
+
+    //  Builds the key of a ZAP request. The credentials are part of the
+    //  key as they are, not hashed, so that two peers can only share an
+    //  entry if they presented exactly the same credentials.
+    static std::string make_key (const std::string &domain_,
+                                 const char *mechanism_,
+                                 size_t mechanism_length_,
+                                 const std::string &address_,
+                                 const unsigned char *routing_id_,
+                                 size_t routing_id_size_,
+                                 const uint8_t **credentials_,
+                                 size_t *credentials_sizes_,
+                                 size_t credentials_count_);
+
+    //  Copies the reply cached under the key to reply_. Returns false if
+    //  there is none or it has expired.
+    bool find (const std::string &key_, reply_t *reply_);
+
+    //  Changes whenever entries are dropped other than by expiring. Taken
+    //  when a request is sent and passed back to insert with its reply.
+    uint64_t generation ();
+
+    //  Caches a reply, unless it is not a final decision or the cache is
+    //  disabled or full. domain_ and credential_ are what invalidate
+    //  matches against, the latter is the first credentials frame. Replies
+    //  to requests sent before the cache was last invalidated or flushed
+    //  are dropped, they may be what the invalidation was meant to revoke.
+    void insert (const std::string &key_,
+                 const std::string &domain_,
+                 const void *credential_,
+                 size_t credential_size_,
+                 uint64_t generation_,
+                 const reply_t &reply_);
+
+    //  Drops the entries of a ZAP domain and with the given first
+    //  credentials frame. NULL matches any domain or credential.
+    void invalidate (const char *domain_,
+                     const void *credential_,
+                     size_t credential_size_);
+
+  private:
+    struct entry_t
+    {
+        reply_t reply;
+        std::string domain;
+        std::string credential;
+        uint64_t expiry;
+    };
+
+    void purge_expired (uint64_t now_);
+
+    typedef std::map<std::string, entry_t> entries_t;
+    entries_t _entries;
+
+    int _ttl;
+
+    uint64_t _generation;
+
+    clock_t _clock;
+
+    mutex_t _sync;
+
+    zap_cache_t (const zap_cache_t &);
+    const zap_cache_t &operator= (const zap_cache_t &);
+};
+}
+
+#endif
@@ -32,6 +32,7 @@
 #include "zap_client.hpp"
 #include "msg.hpp"
 #include "session_base.hpp"
+#include "ctx.hpp"
 
 namespace zmq
 {
@@ -45,7 +46,9 @@ zap_client_t::zap_client_t (session_base_t *const session_,
                             const std::string &peer_address_,
                             const options_t &options_) :
     mechanism_base_t (session_, options_),
-    peer_address (peer_address_)
+    peer_address (peer_address_),
+    _zap_cache_generation (0),
+    _zap_reply_cached (false)
 {
 }
 
@@ -64,6 +67,25 @@ void zap_client_t::send_zap_request (const char *mechanism_,
                                      size_t *credentials_sizes_,
                                      size_t credentials_count_)
 {
+    //  A peer seen recently with the same credentials gets the reply the
+    //  handler gave then, without a request.
+    zap_cache_t *cache = session->get_ctx ()->get_zap_cache ();
+    if (cache->get_ttl () > 0) {
+        _zap_cache_key = zap_cache_t::make_key (
+          options.zap_domain, mechanism_, mechanism_length_, peer_address,
+          options.routing_id, options.routing_id_size, credentials_,
+          credentials_sizes_, credentials_count_);
+        if (credentials_count_ > 0)
+            _zap_cache_credential.assign (
+              reinterpret_cast<const char *> (credentials_[0]),
+              credentials_sizes_[0]);
+        _zap_cache_generation = cache->generation ();
+        if (cache->find (_zap_cache_key, &_cached_reply)) {
+            _zap_reply_cached = true;
+            return;
+        }
+    }
+
     // write_zap_msg cannot fail. It could only fail if the HWM was exceeded,
     // but on the ZAP socket, the HWM is disabled.
 
@@ -141,6 +163,9 @@ void zap_client_t::send_zap_request (const char *mechanism_,
 
 int zap_client_t::receive_and_process_zap_reply ()
 {
+    if (_zap_reply_cached)
+        return process_cached_zap_reply ();
+
     int rc = 0;
     const size_t zap_reply_frame_count = 7;
     msg_t msg[zap_reply_frame_count];
@@ -222,6 +247,18 @@ int zap_client_t::receive_and_process_zap_reply ()
         return close_and_return (msg, -1);
     }
 
+    if (!_zap_cache_key.empty ()) {
+        zap_cache_t::reply_t reply;
+        reply.status_code = status_code;
+        reply.user_id.assign (static_cast<const char *> (msg[5].data ()),
+                              msg[5].size ());
+        reply.metadata.assign (static_cast<const char *> (msg[6].data ()),
+                               msg[6].size ());
+        session->get_ctx ()->get_zap_cache ()->insert (
+          _zap_cache_key, options.zap_domain, _zap_cache_credential.data (),
+          _zap_cache_credential.size (), _zap_cache_generation, reply);
+    }
+
     //  Close all reply frames
     for (size_t i = 0; i < zap_reply_frame_count; i++) {
         const int rc2 = msg[i].close ();
@@ -233,6 +270,25 @@ int zap_client_t::receive_and_process_zap_reply ()
     return 0;
 }
 
+int zap_client_t::process_cached_zap_reply ()
+{
+    _zap_reply_cached = false;
+
+    status_code = _cached_reply.status_code;
+    set_user_id (_cached_reply.user_id.data (),
+                 _cached_reply.user_id.size ());
+
+    //  The metadata was valid when the handler sent it
+    const int rc = parse_metadata (
+      reinterpret_cast<const unsigned char *> (_cached_reply.metadata.data ()),
+      _cached_reply.metadata.size (), true);
+    zmq_assert (rc == 0);
+
+    handle_zap_status_code ();
+
+    return 0;
+}
+
 void zap_client_t::handle_zap_status_code ()
 {
     //  we can assume here that status_code is a valid ZAP status code,
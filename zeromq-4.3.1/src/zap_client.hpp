@@ -2,6 +2,7 @@
 #define __ZMQ_ZAP_CLIENT_HPP_INCLUDED__
 
 #include "mechanism_base.hpp"
+#include "zap_cache.hpp"
 
 namespace zmq
 {
@@ -23,6 +24,21 @@ protected:
 
     //  Status code as received from ZAP handler
     std::string status_code;
+
+  private:
+    //  Applies the reply found in the ZAP cache instead of one read from
+    //  the handler.
+    int process_cached_zap_reply ();
+
+    //  Key and first credentials frame of the request sent, empty if the
+    //  ZAP cache is disabled, and the generation of the cache then.
+    std::string _zap_cache_key;
+    std::string _zap_cache_credential;
+    uint64_t _zap_cache_generation;
+
+    //  Reply of the ZAP cache, valid if _zap_reply_cached is set.
+    bool _zap_reply_cached;
+    zap_cache_t::reply_t _cached_reply;
 };
 
 class zap_client_common_handshake_t : public zap_client_t
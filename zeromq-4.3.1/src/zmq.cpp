@@ -52,6 +52,8 @@ struct iovec
 #include "metadata.hpp"
 #include "socket_poller.hpp"
 #include "timers.hpp"
+#include "reactor.hpp"
+#include "io_thread.hpp"
 #include "ip.hpp"
 #include "address.hpp"
 
@@ -538,6 +540,37 @@ int zmq_recviov (void *s_, iovec *a_, size_t *count_, int flags_)
     return nread;
 }
 
+//  Receives up to count_ message parts in one call. The first part is
+//  received like zmq_msg_recv() does; the others are the parts that are
+//  already queued, without waiting for more. Each part's ZMQ_MORE flag can
+//  be checked with zmq_msg_more().
+//  Returns the number of parts received, or -1 on error.
+int zmq_msg_recv_multi (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+
+    return s->recv_multi (reinterpret_cast<zmq::msg_t *> (msgs_), count_,
+                          flags_);
+}
+
+//  Sends count_ message parts in one call, flushing the pipes only once at
+//  the end. A part is followed by more parts of the same message if its
+//  ZMQ_MORE property is set. ZMQ_DONTFLUSH leaves the parts unflushed until
+//  a later send without it.
+//  Returns the number of parts sent, which is less than count_ if a part
+//  could not be sent, or -1 if none was.
+int zmq_msg_send_multi (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+
+    return s->send_multi (reinterpret_cast<zmq::msg_t *> (msgs_), count_,
+                          flags_);
+}
+
 // Message manipulators.
 
 int zmq_msg_init (zmq_msg_t *msg_)
@@ -629,11 +662,23 @@ int zmq_msg_get (const zmq_msg_t *msg_, int property_)
     }
 }
 
-int zmq_msg_set (zmq_msg_t *, int, int)
+int zmq_msg_set (zmq_msg_t *msg_, int property_, int optval_)
 {
-    //  No properties supported at present
-    errno = EINVAL;
-    return -1;
+    zmq::msg_t *msg = reinterpret_cast<zmq::msg_t *> (msg_);
+    switch (property_) {
+        case ZMQ_MORE:
+            //  Only used by zmq_msg_send_multi, the other send functions
+            //  take the MORE flag from their arguments.
+            if (optval_)
+                msg->set_flags (zmq::msg_t::more);
+            else
+                msg->reset_flags (zmq::msg_t::more);
+            return 0;
+
+        default:
+            errno = EINVAL;
+            return -1;
+    }
 }
 
 int zmq_msg_set_routing_id (zmq_msg_t *msg_, uint32_t routing_id_)
@@ -665,7 +710,7 @@ const char *zmq_msg_gets (const zmq_msg_t *msg_, const char *property_)
       reinterpret_cast<const zmq::msg_t *> (msg_)->metadata ();
     const char *value = NULL;
     if (metadata)
-        value = metadata->get (std::string (property_));
+        value = metadata->get (property_);
     if (value)
         return value;
 
@@ -749,6 +794,10 @@ inline int zmq_poller_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
     //  checking for matches only on the first event.
     //  If there are repeat items, they cannot be assumed to be co-ordered,
     //  so each pollitem must check fired events from the beginning.
+    //  The epoll based poller reports events in the order they fire.
+#if defined ZMQ_SOCKET_POLLER_USE_EPOLL
+    repeat_items = true;
+#endif
     int j_start = 0, found_events = rc;
     for (int i = 0; i < nitems_; i++) {
         for (int j = j_start; j < found_events; ++j) {
@@ -1350,6 +1399,139 @@ int zmq_timers_execute (void *timers_)
     return (static_cast<zmq::timers_t *> (timers_))->execute ();
 }
 
+//  Reactor running handlers in the I/O threads.
+
+static zmq::reactor_t *as_reactor_t (void *reactor_)
+{
+    zmq::reactor_t *reactor = static_cast<zmq::reactor_t *> (reactor_);
+    if (!reactor_ || !reactor->check_tag ()) {
+        errno = EFAULT;
+        return NULL;
+    }
+    return reactor;
+}
+
+void *zmq_reactor_new (void *ctx_)
+{
+    if (!ctx_ || !(static_cast<zmq::ctx_t *> (ctx_))->check_tag ()) {
+        errno = EFAULT;
+        return NULL;
+    }
+    zmq::ctx_t *ctx = static_cast<zmq::ctx_t *> (ctx_);
+    zmq::io_thread_t *io_thread = ctx->reactor_io_thread ();
+    if (!io_thread)
+        return NULL;
+
+    zmq::reactor_t *reactor =
+      new (std::nothrow) zmq::reactor_t (ctx, io_thread);
+    alloc_assert (reactor);
+    return reactor;
+}
+
+int zmq_reactor_destroy (void **reactor_p_)
+{
+    if (!reactor_p_) {
+        errno = EFAULT;
+        return -1;
+    }
+    zmq::reactor_t *reactor = as_reactor_t (*reactor_p_);
+    if (!reactor || reactor->stop () == -1)
+        return -1;
+    delete reactor;
+    *reactor_p_ = NULL;
+    return 0;
+}
+
+int zmq_reactor_add_fd (void *reactor_,
+                        zmq::fd_t fd_,
+                        short events_,
+                        zmq_reactor_fd_fn handler_,
+                        void *arg_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    if (fd_ == zmq::retired_fd) {
+        errno = EBADF;
+        return -1;
+    }
+    return reactor->add_fd (fd_, events_, handler_, arg_);
+}
+
+int zmq_reactor_remove_fd (void *reactor_, zmq::fd_t fd_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    return reactor->remove_fd (fd_);
+}
+
+int zmq_reactor_add_socket (void *reactor_,
+                            void *s_,
+                            short events_,
+                            zmq_reactor_socket_fn handler_,
+                            void *arg_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    return reactor->add_socket (s, events_, handler_, arg_);
+}
+
+int zmq_reactor_remove_socket (void *reactor_, void *s_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    return reactor->remove_socket (s);
+}
+
+int zmq_reactor_add_timer (void *reactor_,
+                           size_t interval_,
+                           zmq_timer_fn handler_,
+                           void *arg_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    return reactor->add_timer (interval_, handler_, arg_);
+}
+
+int zmq_reactor_cancel_timer (void *reactor_, int timer_id_)
+{
+    zmq::reactor_t *reactor = as_reactor_t (reactor_);
+    if (!reactor)
+        return -1;
+    return reactor->cancel_timer (timer_id_);
+}
+
+//  Cache of ZAP replies
+
+int zmq_zap_cache_flush (void *ctx_)
+{
+    return zmq_zap_cache_invalidate (ctx_, NULL, NULL, 0);
+}
+
+int zmq_zap_cache_invalidate (void *ctx_,
+                              const char *domain_,
+                              const void *credential_,
+                              size_t size_)
+{
+    if (!ctx_ || !(static_cast<zmq::ctx_t *> (ctx_))->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    static_cast<zmq::ctx_t *> (ctx_)->get_zap_cache ()->invalidate (
+      domain_, credential_, size_);
+    return 0;
+}
+
 //  The proxy functionality
 
 int zmq_proxy (void *frontend_, void *backend_, void *capture_)
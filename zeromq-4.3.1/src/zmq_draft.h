@@ -52,9 +52,23 @@
 #define ZMQ_METADATA 95
 #define ZMQ_MULTICAST_LOOP 96
 #define ZMQ_ROUTER_NOTIFY 97
+#define ZMQ_LB_POLICY 98
+#define ZMQ_LB_WEIGHT 99
+#define ZMQ_FQ_PRIORITY 100
+#define ZMQ_FQ_WEIGHT 101
+#define ZMQ_COMMAND_DELAY 102
+#define ZMQ_CURVE_TICKET_LIFETIME 103
+#define ZMQ_CURVE_AEAD 104
+#define ZMQ_CURVE_BATCH 105
 
 /*  DRAFT Context options                                                     */
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_COMPACT_SOCKETS 11
+#define ZMQ_CRYPTO_THREADS 12
+#define ZMQ_ZAP_CACHE_TTL 13
+
+/*  DRAFT Send/recv options.                                                  */
+#define ZMQ_DONTFLUSH 4
 
 /*  DRAFT Socket methods.                                                     */
 int zmq_join (void *s_, const char *group_);
@@ -64,6 +78,8 @@ int zmq_leave (void *s_, const char *group_);
 int zmq_msg_set_routing_id (zmq_msg_t *msg_, uint32_t routing_id_);
 uint32_t zmq_msg_routing_id (zmq_msg_t *msg_);
 int zmq_msg_set_group (zmq_msg_t *msg_, const char *group_);
+int zmq_msg_recv_multi (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_);
+int zmq_msg_send_multi (zmq_msg_t *msgs_, size_t count_, void *s_, int flags_);
 const char *zmq_msg_group (zmq_msg_t *msg_);
 
 /*  DRAFT Msg property names.                                                 */
@@ -76,6 +92,12 @@ const char *zmq_msg_group (zmq_msg_t *msg_);
 #define ZMQ_NOTIFY_CONNECT 1
 #define ZMQ_NOTIFY_DISCONNECT 2
 
+/*  Load balancing policies (ZMQ_LB_POLICY)                                   */
+#define ZMQ_LB_ROUND_ROBIN 0
+#define ZMQ_LB_LEAST_QUEUE 1
+#define ZMQ_LB_WEIGHTED 2
+#define ZMQ_LB_POWER_OF_TWO 3
+
 /******************************************************************************/
 /*  Poller polling on sockets,fd and thread-safe sockets                      */
 /******************************************************************************/
@@ -123,6 +145,56 @@ int zmq_socket_get_peer_state (void *socket_,
                                const void *routing_id_,
                                size_t routing_id_size_);
 
+/******************************************************************************/
+/*  Reactor running handlers in the I/O threads                               */
+/******************************************************************************/
+
+#if defined _WIN32
+typedef void(zmq_reactor_fd_fn) (SOCKET fd, short events, void *arg);
+#else
+typedef void(zmq_reactor_fd_fn) (int fd, short events, void *arg);
+#endif
+typedef void(zmq_reactor_socket_fn) (void *socket, short events, void *arg);
+
+void *zmq_reactor_new (void *context_);
+int zmq_reactor_destroy (void **reactor_p_);
+#if defined _WIN32
+int zmq_reactor_add_fd (void *reactor_,
+                        SOCKET fd_,
+                        short events_,
+                        zmq_reactor_fd_fn handler_,
+                        void *arg_);
+int zmq_reactor_remove_fd (void *reactor_, SOCKET fd_);
+#else
+int zmq_reactor_add_fd (void *reactor_,
+                        int fd_,
+                        short events_,
+                        zmq_reactor_fd_fn handler_,
+                        void *arg_);
+int zmq_reactor_remove_fd (void *reactor_, int fd_);
+#endif
+int zmq_reactor_add_socket (void *reactor_,
+                            void *socket_,
+                            short events_,
+                            zmq_reactor_socket_fn handler_,
+                            void *arg_);
+int zmq_reactor_remove_socket (void *reactor_, void *socket_);
+int zmq_reactor_add_timer (void *reactor_,
+                           size_t interval_,
+                           zmq_timer_fn handler_,
+                           void *arg_);
+int zmq_reactor_cancel_timer (void *reactor_, int timer_id_);
+
+/******************************************************************************/
+/*  Cache of ZAP replies (ZMQ_ZAP_CACHE_TTL)                                  */
+/******************************************************************************/
+
+int zmq_zap_cache_flush (void *context_);
+int zmq_zap_cache_invalidate (void *context_,
+                              const char *domain_,
+                              const void *credential_,
+                              size_t size_);
+
 #endif // ZMQ_BUILD_DRAFT_API
 
 #endif //ifndef __ZMQ_DRAFT_H_INCLUDED__
@@ -0,0 +1,133 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_sockopt_command_delay ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    int value;
+    size_t value_size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_COMMAND_DELAY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (-1, value);
+
+    value = 250;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_COMMAND_DELAY, &value, sizeof (value)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_COMMAND_DELAY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (250, value);
+
+    value = -2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_COMMAND_DELAY, &value, sizeof (value)));
+
+    test_context_socket_close (push);
+}
+
+//  Streams messages through a small pipe, so the sender keeps depending on
+//  the activation commands of the receiver. Once the pipe is full, sending
+//  only resumes when the sender checks its commands again.
+static void stream_with_command_delay (int delay_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+
+    int hwm = 10;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_COMMAND_DELAY, &delay_, sizeof (delay_)));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://command-delay"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://command-delay"));
+
+    const int count = 2000;
+    int sent = 0;
+    int received = 0;
+    char buffer[16];
+    while (received < count) {
+        while (sent < count
+               && zmq_send (push, "data", 4, ZMQ_DONTWAIT) == 4)
+            sent++;
+        TEST_ASSERT_TRUE (sent == count || errno == EAGAIN);
+
+        while (zmq_recv (pull, buffer, sizeof (buffer), ZMQ_DONTWAIT) == 4)
+            received++;
+        TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    }
+    TEST_ASSERT_EQUAL_INT (count, sent);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_stream_adaptive ()
+{
+    stream_with_command_delay (-1);
+}
+
+void test_stream_no_delay ()
+{
+    stream_with_command_delay (0);
+}
+
+void test_stream_long_delay ()
+{
+    stream_with_command_delay (2000);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_sockopt_command_delay);
+    RUN_TEST (test_stream_adaptive);
+    RUN_TEST (test_stream_no_delay);
+    RUN_TEST (test_stream_long_delay);
+    return UNITY_END ();
+}
@@ -0,0 +1,241 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (get_test_context (), ZMQ_COMPACT_SOCKETS, 1));
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_ctx_option ()
+{
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_COMPACT_SOCKETS));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_COMPACT_SOCKETS, 1));
+    TEST_ASSERT_EQUAL_INT (1, zmq_ctx_get (ctx, ZMQ_COMPACT_SOCKETS));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+static fd_t socket_fd (void *socket_)
+{
+    fd_t fd;
+    size_t fd_size = sizeof fd;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_getsockopt (socket_, ZMQ_FD, &fd, &fd_size));
+    return fd;
+}
+
+static void create_socket_in_thread (void *fd_)
+{
+    void *socket = zmq_socket (get_test_context (), ZMQ_DEALER);
+    TEST_ASSERT_NOT_NULL (socket);
+    *static_cast<fd_t *> (fd_) = socket_fd (socket);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (socket));
+}
+
+void test_fd_shared_per_thread ()
+{
+    void *dealer = test_context_socket (ZMQ_DEALER);
+    void *router = test_context_socket (ZMQ_ROUTER);
+    TEST_ASSERT_EQUAL_INT (socket_fd (dealer), socket_fd (router));
+
+    fd_t other = retired_fd;
+    void *thread = zmq_threadstart (create_socket_in_thread, &other);
+    zmq_threadclose (thread);
+    TEST_ASSERT_TRUE (other != retired_fd);
+    TEST_ASSERT_TRUE (other != socket_fd (dealer));
+
+    test_context_socket_close (dealer);
+    test_context_socket_close (router);
+}
+
+//  The commands of all the pairs are signalled through the same descriptor,
+//  so most of them are received while another socket is being used.
+void test_inproc_pairs ()
+{
+    const int count = 50;
+    void *binds[count];
+    void *connects[count];
+    int timeout = 2000;
+    char endpoint[32];
+
+    for (int i = 0; i != count; i++) {
+        binds[i] = test_context_socket (ZMQ_PAIR);
+        connects[i] = test_context_socket (ZMQ_PAIR);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (binds[i], ZMQ_RCVTIMEO, &timeout, sizeof timeout));
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (connects[i], ZMQ_RCVTIMEO, &timeout, sizeof timeout));
+        sprintf (endpoint, "inproc://compact-%d", i);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (binds[i], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (connects[i], endpoint));
+    }
+
+    for (int round = 0; round != 10; round++) {
+        for (int i = 0; i != count; i++)
+            send_string_expect_success (connects[i], "ping", 0);
+        for (int i = count - 1; i >= 0; i--) {
+            recv_string_expect_success (binds[i], "ping", 0);
+            send_string_expect_success (binds[i], "pong", 0);
+        }
+        for (int i = 0; i != count; i++)
+            recv_string_expect_success (connects[i], "pong", 0);
+    }
+
+    for (int i = 0; i != count; i++) {
+        test_context_socket_close (binds[i]);
+        test_context_socket_close (connects[i]);
+    }
+}
+
+//  A blocking receive must not miss the signal of its socket, even if it
+//  was received while processing the commands of another socket.
+void test_tcp_blocking_recv ()
+{
+    char endpoint[MAX_SOCKET_STRING];
+    void *pull = test_context_socket (ZMQ_PULL);
+    void *other = test_context_socket (ZMQ_PULL);
+    bind_loopback_ipv4 (pull, endpoint, sizeof endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (other, "inproc://compact-other"));
+
+    int timeout = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_RCVTIMEO, &timeout, sizeof timeout));
+
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    for (int i = 0; i != 100; i++) {
+        send_string_expect_success (push, "data", 0);
+        //  Let the commands of the connection arrive and check them
+        //  through the other socket first.
+        if (i % 10 == 0)
+            msleep (SETTLE_TIME / 10);
+        char buffer[8];
+        TEST_ASSERT_FAILURE_ERRNO (
+          EAGAIN, zmq_recv (other, buffer, sizeof buffer, ZMQ_DONTWAIT));
+        recv_string_expect_success (pull, "data", 0);
+    }
+
+    test_context_socket_close (push);
+    test_context_socket_close (other);
+    test_context_socket_close (pull);
+}
+
+void test_poller_shared_fd ()
+{
+    const int count = 4;
+    void *pulls[count];
+    void *pushes[count];
+    char endpoint[32];
+
+    void *poller = zmq_poller_new ();
+    TEST_ASSERT_NOT_NULL (poller);
+
+    for (int i = 0; i != count; i++) {
+        pulls[i] = test_context_socket (ZMQ_PULL);
+        pushes[i] = test_context_socket (ZMQ_PUSH);
+        sprintf (endpoint, "inproc://compact-poller-%d", i);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pulls[i], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (pushes[i], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_poller_add (poller, pulls[i], pulls[i], ZMQ_POLLIN));
+    }
+
+    for (int round = 0; round != 10; round++) {
+        //  Only every other socket gets a message.
+        for (int i = round % 2; i < count; i += 2)
+            send_string_expect_success (pushes[i], "data", 0);
+
+        int received = 0;
+        while (received != count / 2) {
+            zmq_poller_event_t events[count];
+            const int n = TEST_ASSERT_SUCCESS_ERRNO (
+              zmq_poller_wait_all (poller, events, count, 2000));
+            for (int j = 0; j != n; j++) {
+                TEST_ASSERT_EQUAL_INT (ZMQ_POLLIN, events[j].events);
+                recv_string_expect_success (events[j].socket, "data", 0);
+                received++;
+            }
+        }
+    }
+
+    //  Removing the sockets closes the duplicated descriptors only.
+    for (int i = 0; i != count; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_remove (poller, pulls[i]));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_destroy (&poller));
+
+    for (int i = 0; i != count; i++) {
+        test_context_socket_close (pulls[i]);
+        test_context_socket_close (pushes[i]);
+    }
+}
+
+static void socket_handler (void *, short, void *)
+{
+}
+
+void test_reactor_rejects_socket ()
+{
+    void *socket = test_context_socket (ZMQ_PULL);
+    void *reactor = zmq_reactor_new (get_test_context ());
+    TEST_ASSERT_NOT_NULL (reactor);
+
+    TEST_ASSERT_FAILURE_ERRNO (
+      ENOTSUP,
+      zmq_reactor_add_socket (reactor, socket, ZMQ_POLLIN, socket_handler, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+    test_context_socket_close (socket);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_ctx_option);
+    RUN_TEST (test_fd_shared_per_thread);
+    RUN_TEST (test_inproc_pairs);
+    RUN_TEST (test_tcp_blocking_recv);
+    RUN_TEST (test_poller_shared_fd);
+    RUN_TEST (test_reactor_rejects_socket);
+    return UNITY_END ();
+}
@@ -203,6 +203,59 @@ void test_ctx_zero_copy (void *ctx_)
 #endif
 }
 
+//  Slots and I/O threads are set up as needed; check the socket limit still
+//  holds across slot chunks and that any I/O thread can be picked first.
+void test_ctx_lazy_start ()
+{
+    const int max_sockets = 300;
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    assert (0 == zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, max_sockets));
+    assert (0 == zmq_ctx_set (ctx, ZMQ_IO_THREADS, 3));
+
+    void *sockets[max_sockets];
+    for (int i = 0; i != max_sockets; i++) {
+        sockets[i] = zmq_socket (ctx, ZMQ_PAIR);
+        assert (sockets[i]);
+    }
+    assert (zmq_socket (ctx, ZMQ_PAIR) == NULL);
+    assert (errno == EMFILE);
+
+    //  The slot of a closed socket is reused once the reaper released it.
+    assert (0 == zmq_close (sockets[0]));
+    while (!(sockets[0] = zmq_socket (ctx, ZMQ_PAIR))) {
+        assert (errno == EMFILE);
+        msleep (SETTLE_TIME / 10);
+    }
+
+    //  Use the last I/O thread only.
+    uint64_t affinity = 4;
+    void *pull = sockets[0];
+    void *push = sockets[max_sockets - 1];
+    assert (0
+            == zmq_setsockopt (pull, ZMQ_AFFINITY, &affinity, sizeof (affinity)));
+    assert (0
+            == zmq_setsockopt (push, ZMQ_AFFINITY, &affinity, sizeof (affinity)));
+    assert (0 == zmq_bind (pull, "tcp://127.0.0.1:*"));
+    size_t endpoint_len = MAX_SOCKET_STRING;
+    char endpoint[MAX_SOCKET_STRING];
+    assert (
+      0 == zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+    assert (0 == zmq_connect (push, endpoint));
+    assert (4 == zmq_send (push, "abcd", 4, 0));
+    char buffer[4];
+    assert (4 == zmq_recv (pull, buffer, sizeof (buffer), 0));
+
+    int linger = 0;
+    for (int i = 0; i != max_sockets; i++) {
+        assert (0
+                == zmq_setsockopt (sockets[i], ZMQ_LINGER, &linger,
+                                   sizeof (linger)));
+        assert (0 == zmq_close (sockets[i]));
+    }
+    assert (0 == zmq_ctx_term (ctx));
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -264,5 +317,7 @@ int main (void)
     rc = zmq_ctx_term (ctx);
     assert (rc == 0);
 
+    test_ctx_lazy_start ();
+
     return 0;
 }
@@ -0,0 +1,174 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_sockopt_fq ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+
+    int value;
+    size_t value_size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_FQ_PRIORITY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (0, value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_FQ_WEIGHT, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    value = 7;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_FQ_PRIORITY, &value, sizeof (value)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_FQ_PRIORITY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (7, value);
+
+    value = 8;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (pull, ZMQ_FQ_PRIORITY, &value, sizeof (value)));
+    value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (pull, ZMQ_FQ_PRIORITY, &value, sizeof (value)));
+    value = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (pull, ZMQ_FQ_WEIGHT, &value, sizeof (value)));
+
+    test_context_socket_close (pull);
+}
+
+//  Connects pull_ to a new PUSH bound at endpoint_ with the given inbound
+//  priority and weight.
+static void *connect_sender (void *pull_,
+                             const char *endpoint_,
+                             int priority_,
+                             int weight_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (push, endpoint_));
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull_, ZMQ_FQ_PRIORITY, &priority_, sizeof (priority_)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull_, ZMQ_FQ_WEIGHT, &weight_, sizeof (weight_)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (pull_, endpoint_));
+    return push;
+}
+
+static void send_n (void *socket_, const char *data_, int count_)
+{
+    for (int i = 0; i < count_; i++)
+        send_string_expect_success (socket_, data_, 0);
+}
+
+static void recv_sequence (void *socket_, const char *expected_)
+{
+    for (const char *c = expected_; *c; c++) {
+        char buffer[2] = {*c, 0};
+        recv_string_expect_success (socket_, buffer, 0);
+    }
+}
+
+void test_priority ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    void *bulk = connect_sender (pull, "inproc://bulk", 0, 1);
+    void *control = connect_sender (pull, "inproc://control", 1, 1);
+
+    send_n (bulk, "b", 3);
+    send_n (control, "c", 3);
+
+    //  Control messages overtake the bulk ones already queued.
+    recv_sequence (pull, "cccbbb");
+
+    test_context_socket_close (pull);
+    test_context_socket_close (bulk);
+    test_context_socket_close (control);
+}
+
+void test_priority_keeps_multipart_atomic ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    void *bulk = connect_sender (pull, "inproc://bulk", 0, 1);
+    void *control = connect_sender (pull, "inproc://control", 1, 1);
+
+    send_string_expect_success (bulk, "b", ZMQ_SNDMORE);
+    send_string_expect_success (bulk, "b", 0);
+    recv_string_expect_success (pull, "b", 0);
+
+    //  A higher priority message arriving in the middle of a multipart
+    //  message is delivered after the last part.
+    send_n (control, "c", 1);
+    recv_sequence (pull, "bc");
+
+    test_context_socket_close (pull);
+    test_context_socket_close (bulk);
+    test_context_socket_close (control);
+}
+
+void test_weighted ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    void *heavy = connect_sender (pull, "inproc://heavy", 0, 3);
+    void *light = connect_sender (pull, "inproc://light", 0, 1);
+
+    send_n (heavy, "h", 6);
+    send_n (light, "l", 2);
+
+    recv_sequence (pull, "hhhlhhhl");
+
+    test_context_socket_close (pull);
+    test_context_socket_close (heavy);
+    test_context_socket_close (light);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_sockopt_fq);
+    RUN_TEST (test_priority);
+    RUN_TEST (test_priority_keeps_multipart_atomic);
+    RUN_TEST (test_weighted);
+
+    return UNITY_END ();
+}
@@ -220,23 +220,14 @@ static void prep_server_socket (int set_heartbeats_,
     *mon_out_ = server_mon;
 }
 
-// This checks for a broken TCP connection (or, in this case a stuck one
-// where the peer never responds to PINGS). There should be an accepted event
-// then a disconnect event.
-static void test_heartbeat_timeout (int server_type_, int mock_ping_)
+//  Connects a raw TCP socket to the loopback endpoint.
+static raw_socket connect_raw_socket (const char *endpoint_)
 {
-    int rc;
-    char my_endpoint[MAX_SOCKET_STRING];
-
-    void *server, *server_mon;
-    prep_server_socket (!mock_ping_, 0, &server, &server_mon, my_endpoint,
-                        MAX_SOCKET_STRING, server_type_);
-
     struct sockaddr_in ip4addr;
     raw_socket s;
 
     ip4addr.sin_family = AF_INET;
-    ip4addr.sin_port = htons (atoi (strrchr (my_endpoint, ':') + 1));
+    ip4addr.sin_port = htons (atoi (strrchr (endpoint_, ':') + 1));
 #if defined(ZMQ_HAVE_WINDOWS) && (_WIN32_WINNT < 0x0600)
     ip4addr.sin_addr.s_addr = inet_addr ("127.0.0.1");
 #else
@@ -244,9 +235,25 @@ static void test_heartbeat_timeout (int server_type_, int mock_ping_)
 #endif
 
     s = socket (AF_INET, SOCK_STREAM, IPPROTO_TCP);
-    rc = TEST_ASSERT_SUCCESS_RAW_ERRNO (
+    int rc = TEST_ASSERT_SUCCESS_RAW_ERRNO (
       connect (s, (struct sockaddr *) &ip4addr, sizeof ip4addr));
     TEST_ASSERT_GREATER_THAN_INT (-1, rc);
+    return s;
+}
+
+// This checks for a broken TCP connection (or, in this case a stuck one
+// where the peer never responds to PINGS). There should be an accepted event
+// then a disconnect event.
+static void test_heartbeat_timeout (int server_type_, int mock_ping_)
+{
+    int rc;
+    char my_endpoint[MAX_SOCKET_STRING];
+
+    void *server, *server_mon;
+    prep_server_socket (!mock_ping_, 0, &server, &server_mon, my_endpoint,
+                        MAX_SOCKET_STRING, server_type_);
+
+    raw_socket s = connect_raw_socket (my_endpoint);
 
     // Mock a ZMTP 3 client so we can forcibly time out a connection
     mock_handshake (s, mock_ping_);
@@ -344,6 +351,57 @@ test_heartbeat_notimeout (int is_curve_, int client_type_, int server_type_)
     test_context_socket_close (server_mon);
 }
 
+// The engines of an I/O thread share one heartbeat scheduler. With many
+// connections on the single I/O thread of the test context, the peers that
+// never answer PINGs must all time out, and the peers that do must all stay
+// connected.
+void test_heartbeat_shared_scheduler ()
+{
+    const int silent_count = 8;
+    const int live_count = 8;
+    char my_endpoint[MAX_SOCKET_STRING];
+
+    void *server, *server_mon;
+    prep_server_socket (1, 0, &server, &server_mon, my_endpoint,
+                        MAX_SOCKET_STRING, ZMQ_ROUTER);
+
+    void *clients[live_count];
+    for (int i = 0; i < live_count; i++) {
+        clients[i] = test_context_socket (ZMQ_DEALER);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (clients[i], my_endpoint));
+    }
+
+    raw_socket silent[silent_count];
+    for (int i = 0; i < silent_count; i++) {
+        silent[i] = connect_raw_socket (my_endpoint);
+        mock_handshake (silent[i], 0);
+    }
+
+    int accepted = 0;
+    int disconnected = 0;
+    int misses = 0;
+    while (disconnected < silent_count) {
+        const int event = get_monitor_event (server_mon);
+        if (event == ZMQ_EVENT_ACCEPTED)
+            accepted++;
+        else if (event == ZMQ_EVENT_DISCONNECTED)
+            disconnected++;
+        else
+            TEST_ASSERT_LESS_THAN_INT (10, ++misses);
+    }
+    TEST_ASSERT_EQUAL_INT (silent_count + live_count, accepted);
+
+    // The peers answering PINGs are still connected
+    TEST_ASSERT_EQUAL_INT (-1, get_monitor_event (server_mon));
+
+    for (int i = 0; i < silent_count; i++)
+        close (silent[i]);
+    for (int i = 0; i < live_count; i++)
+        test_context_socket_close (clients[i]);
+    test_context_socket_close (server);
+    test_context_socket_close (server_mon);
+}
+
 void test_heartbeat_timeout_router ()
 {
     test_heartbeat_timeout (ZMQ_ROUTER, 0);
@@ -424,6 +482,7 @@ int main (void)
 
     RUN_TEST (test_heartbeat_timeout_router);
     RUN_TEST (test_heartbeat_timeout_router_mock_ping);
+    RUN_TEST (test_heartbeat_shared_scheduler);
 
     RUN_TEST (test_heartbeat_ttl_dealer_router);
     RUN_TEST (test_heartbeat_ttl_req_rep);
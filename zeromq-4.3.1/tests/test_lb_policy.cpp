@@ -0,0 +1,193 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_sockopt_lb_policy ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    int value;
+    size_t value_size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_POLICY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_ROUND_ROBIN, value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_WEIGHT, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (1, value);
+
+    value = ZMQ_LB_POWER_OF_TWO;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_POLICY, &value, sizeof (value)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_LB_POLICY, &value, &value_size));
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_POWER_OF_TWO, value);
+
+    value = ZMQ_LB_POWER_OF_TWO + 1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_POLICY, &value, sizeof (value)));
+    value = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_WEIGHT, &value, sizeof (value)));
+
+    test_context_socket_close (push);
+}
+
+static int recv_all (void *socket_)
+{
+    int count = 0;
+    char buffer[16];
+    while (zmq_recv (socket_, buffer, sizeof (buffer), ZMQ_DONTWAIT) >= 0)
+        count++;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    return count;
+}
+
+void test_weighted ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *heavy = test_context_socket (ZMQ_PULL);
+    void *light = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (heavy, "inproc://heavy"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (light, "inproc://light"));
+
+    int value = ZMQ_LB_WEIGHTED;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_POLICY, &value, sizeof (value)));
+
+    //  The weight applies to connections set up after it was changed.
+    value = 3;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_WEIGHT, &value, sizeof (value)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://heavy"));
+    value = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_WEIGHT, &value, sizeof (value)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://light"));
+
+    for (int i = 0; i < 8; i++)
+        send_string_expect_success (push, "x", 0);
+
+    TEST_ASSERT_EQUAL_INT (6, recv_all (heavy));
+    TEST_ASSERT_EQUAL_INT (2, recv_all (light));
+
+    test_context_socket_close (push);
+    test_context_socket_close (heavy);
+    test_context_socket_close (light);
+}
+
+//  One PULL never reads, the other is drained after every message. Round-
+//  robin keeps feeding the stalled peer until its pipe (HWM 10 + 10) is
+//  full. The queue aware policies stop once the stalled queue is deeper
+//  than anything the working peer reports, which happens every LWM (10)
+//  messages.
+static int send_to_stalled_peer (int policy_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *stalled = test_context_socket (ZMQ_PULL);
+    void *working = test_context_socket (ZMQ_PULL);
+
+    int hwm = 10;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (stalled, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (working, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LB_POLICY, &policy_, sizeof (policy_)));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (stalled, "inproc://stalled"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (working, "inproc://working"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://stalled"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://working"));
+
+    int received = 0;
+    for (int i = 0; i < 100; i++) {
+        send_string_expect_success (push, "x", ZMQ_DONTWAIT);
+        received += recv_all (working);
+
+        //  Let the PUSH socket process the reader's progress reports.
+        int events;
+        size_t events_size = sizeof (events);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_getsockopt (push, ZMQ_EVENTS, &events, &events_size));
+    }
+    const int queued = recv_all (stalled);
+    TEST_ASSERT_EQUAL_INT (100, received + queued);
+
+    test_context_socket_close (push);
+    test_context_socket_close (stalled);
+    test_context_socket_close (working);
+    return queued;
+}
+
+void test_round_robin_fills_stalled_peer ()
+{
+    TEST_ASSERT_EQUAL_INT (20, send_to_stalled_peer (ZMQ_LB_ROUND_ROBIN));
+}
+
+void test_least_queue ()
+{
+    TEST_ASSERT_LESS_OR_EQUAL_INT (10,
+                                   send_to_stalled_peer (ZMQ_LB_LEAST_QUEUE));
+}
+
+void test_power_of_two ()
+{
+    TEST_ASSERT_LESS_OR_EQUAL_INT (10,
+                                   send_to_stalled_peer (ZMQ_LB_POWER_OF_TWO));
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_sockopt_lb_policy);
+    RUN_TEST (test_weighted);
+    RUN_TEST (test_round_robin_fills_stalled_peer);
+    RUN_TEST (test_least_queue);
+    RUN_TEST (test_power_of_two);
+
+    return UNITY_END ();
+}
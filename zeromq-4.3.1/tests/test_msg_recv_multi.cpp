@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void *_push;
+static void *_pull;
+
+static void setup_pair ()
+{
+    _push = test_context_socket (ZMQ_PUSH);
+    _pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (_pull, "inproc://recv_multi"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (_push, "inproc://recv_multi"));
+}
+
+static void close_pair ()
+{
+    test_context_socket_close (_push);
+    test_context_socket_close (_pull);
+}
+
+static void init_msgs (zmq_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msgs_[i]));
+}
+
+static void close_msgs (zmq_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs_[i]));
+}
+
+void test_recv_multi_invalid ()
+{
+    setup_pair ();
+
+    zmq_msg_t msgs[1];
+    init_msgs (msgs, 1);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_msg_recv_multi (msgs, 0, _pull, ZMQ_DONTWAIT));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_msg_recv_multi (NULL, 1, _pull, ZMQ_DONTWAIT));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_msg_recv_multi (msgs, 1, _pull, ZMQ_DONTWAIT));
+    close_msgs (msgs, 1);
+
+    close_pair ();
+}
+
+void test_recv_multi_drains_queue ()
+{
+    setup_pair ();
+
+    char buffer[4];
+    for (int i = 0; i < 10; i++) {
+        sprintf (buffer, "%d", i);
+        send_string_expect_success (_push, buffer, 0);
+    }
+
+    zmq_msg_t msgs[16];
+    init_msgs (msgs, 16);
+
+    //  The batch is limited by the array size first, then by the number
+    //  of queued messages.
+    TEST_ASSERT_EQUAL_INT (4, zmq_msg_recv_multi (msgs, 4, _pull, 0));
+    TEST_ASSERT_EQUAL_INT (6, zmq_msg_recv_multi (msgs + 4, 12, _pull, 0));
+    for (int i = 0; i < 10; i++) {
+        sprintf (buffer, "%d", i);
+        TEST_ASSERT_EQUAL_INT (1, zmq_msg_size (&msgs[i]));
+        TEST_ASSERT_EQUAL_MEMORY (buffer, zmq_msg_data (&msgs[i]), 1);
+    }
+
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_msg_recv_multi (msgs, 16, _pull, ZMQ_DONTWAIT));
+    close_msgs (msgs, 16);
+
+    close_pair ();
+}
+
+void test_recv_multi_more_flags ()
+{
+    setup_pair ();
+
+    send_string_expect_success (_push, "a", ZMQ_SNDMORE);
+    send_string_expect_success (_push, "b", 0);
+    send_string_expect_success (_push, "c", ZMQ_SNDMORE);
+    send_string_expect_success (_push, "d", 0);
+
+    zmq_msg_t msgs[3];
+    init_msgs (msgs, 3);
+
+    //  The batch may end in the middle of a message.
+    TEST_ASSERT_EQUAL_INT (3, zmq_msg_recv_multi (msgs, 3, _pull, 0));
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_more (&msgs[0]));
+    TEST_ASSERT_EQUAL_INT (0, zmq_msg_more (&msgs[1]));
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_more (&msgs[2]));
+
+    int more;
+    size_t more_size = sizeof (more);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (_pull, ZMQ_RCVMORE, &more, &more_size));
+    TEST_ASSERT_EQUAL_INT (1, more);
+
+    recv_string_expect_success (_pull, "d", 0);
+    close_msgs (msgs, 3);
+
+    close_pair ();
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_recv_multi_invalid);
+    RUN_TEST (test_recv_multi_drains_queue);
+    RUN_TEST (test_recv_multi_more_flags);
+
+    return UNITY_END ();
+}
@@ -0,0 +1,234 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void init_msgs (zmq_msg_t *msgs_, const char **data_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++) {
+        const char *data = data_[i];
+        const bool more = *data == '+';
+        if (more)
+            data++;
+        const size_t size = strlen (data);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msgs_[i], size));
+        memcpy (zmq_msg_data (&msgs_[i]), data, size);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_set (&msgs_[i], ZMQ_MORE, more));
+    }
+}
+
+static void close_msgs (zmq_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs_[i]));
+}
+
+static void expect_nothing (void *socket_)
+{
+    char buffer[16];
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_recv (socket_, buffer, sizeof (buffer), ZMQ_DONTWAIT));
+}
+
+void test_send_multi_invalid ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_msg_send_multi (&msg, 0, push, 0));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_msg_send_multi (NULL, 1, push, 0));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_msg_send_multi (&msg, 1, push, ZMQ_DONTWAIT));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+
+    test_context_socket_close (push);
+}
+
+void test_send_multi_push ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://send_multi"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://send_multi"));
+
+    const char *data[] = {"a", "+b", "c", "d"};
+    zmq_msg_t msgs[4];
+    init_msgs (msgs, data, 4);
+    TEST_ASSERT_EQUAL_INT (4, zmq_msg_send_multi (msgs, 4, push, 0));
+    close_msgs (msgs, 4);
+
+    recv_string_expect_success (pull, "a", 0);
+    recv_string_expect_success (pull, "b", 0);
+    int more;
+    size_t more_size = sizeof (more);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_RCVMORE, &more, &more_size));
+    TEST_ASSERT_EQUAL_INT (1, more);
+    recv_string_expect_success (pull, "c", 0);
+    recv_string_expect_success (pull, "d", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_dontflush ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://dontflush"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://dontflush"));
+
+    //  Messages sent with ZMQ_DONTFLUSH are not visible to the peer ...
+    send_string_expect_success (push, "a", ZMQ_DONTFLUSH);
+    send_string_expect_success (push, "b", ZMQ_DONTFLUSH);
+    expect_nothing (pull);
+
+    zmq_msg_t msg;
+    const char *data[] = {"c"};
+    init_msgs (&msg, data, 1);
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_send_multi (&msg, 1, push,
+                                                  ZMQ_DONTFLUSH));
+    close_msgs (&msg, 1);
+    expect_nothing (pull);
+
+    //  ... until a send without it.
+    send_string_expect_success (push, "d", 0);
+    recv_string_expect_success (pull, "a", 0);
+    recv_string_expect_success (pull, "b", 0);
+    recv_string_expect_success (pull, "c", 0);
+    recv_string_expect_success (pull, "d", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_dontflush_flushes_when_full ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    int hwm = 5;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://full"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://full"));
+
+    int sent = 0;
+    while (zmq_send (push, "x", 1, ZMQ_DONTFLUSH | ZMQ_DONTWAIT) == 1)
+        sent++;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    TEST_ASSERT_EQUAL_INT (10, sent);
+
+    //  A send failing for lack of room flushes what was held back, so
+    //  that the peer can make room.
+    for (int i = 0; i < sent; i++)
+        recv_string_expect_success (pull, "x", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_send_multi_router ()
+{
+    void *router = test_context_socket (ZMQ_ROUTER);
+    void *dealer = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (dealer, ZMQ_ROUTING_ID, "D", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (router, "inproc://router"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (dealer, "inproc://router"));
+
+    send_string_expect_success (dealer, "hi", 0);
+    recv_string_expect_success (router, "D", 0);
+    recv_string_expect_success (router, "hi", 0);
+
+    const char *data[] = {"+D", "one", "+D", "two"};
+    zmq_msg_t msgs[4];
+    init_msgs (msgs, data, 4);
+    TEST_ASSERT_EQUAL_INT (4, zmq_msg_send_multi (msgs, 4, router, 0));
+    close_msgs (msgs, 4);
+
+    recv_string_expect_success (dealer, "one", 0);
+    recv_string_expect_success (dealer, "two", 0);
+
+    test_context_socket_close (router);
+    test_context_socket_close (dealer);
+}
+
+void test_send_multi_pub ()
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    void *sub = test_context_socket (ZMQ_SUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://pub"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://pub"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    msleep (SETTLE_TIME);
+
+    const char *data[] = {"a", "b", "c"};
+    zmq_msg_t msgs[3];
+    init_msgs (msgs, data, 3);
+    TEST_ASSERT_EQUAL_INT (3, zmq_msg_send_multi (msgs, 3, pub, 0));
+    close_msgs (msgs, 3);
+
+    recv_string_expect_success (sub, "a", 0);
+    recv_string_expect_success (sub, "b", 0);
+    recv_string_expect_success (sub, "c", 0);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_send_multi_invalid);
+    RUN_TEST (test_send_multi_push);
+    RUN_TEST (test_dontflush);
+    RUN_TEST (test_dontflush_flushes_when_full);
+    RUN_TEST (test_send_multi_router);
+    RUN_TEST (test_send_multi_pub);
+
+    return UNITY_END ();
+}
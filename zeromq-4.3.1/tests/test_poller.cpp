@@ -523,6 +523,94 @@ void test_poll_basic ()
     TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_destroy (&poller));
 }
 
+void test_poll_events_changed_outside_poller ()
+{
+    void *sb = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (sb, "inproc://events_changed"));
+
+    void *poller = zmq_poller_new ();
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_add (poller, sb, NULL, ZMQ_POLLOUT));
+
+    zmq_poller_event_t event;
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_poller_wait (poller, &event, 0));
+
+    //  Connecting makes the socket writable without any command.
+    void *sc = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sc, "inproc://events_changed"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_wait (poller, &event, 0));
+    TEST_ASSERT_EQUAL_PTR (sb, event.socket);
+    TEST_ASSERT_EQUAL (ZMQ_POLLOUT, event.events);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_modify (poller, sb, ZMQ_POLLIN));
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_poller_wait (poller, &event, 0));
+
+    //  The command announcing the message is processed by querying the
+    //  events outside the poller, which must still report the message.
+    send_string_expect_success (sc, "H", 0);
+    int events;
+    size_t events_size = sizeof events;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sb, ZMQ_EVENTS, &events, &events_size));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_wait (poller, &event, 500));
+    TEST_ASSERT_EQUAL_PTR (sb, event.socket);
+    TEST_ASSERT_EQUAL (ZMQ_POLLIN, event.events);
+
+    //  Still ready until the message is received.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_wait (poller, &event, 0));
+    recv_string_expect_success (sb, "H", 0);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN, zmq_poller_wait (poller, &event, 0));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_destroy (&poller));
+    test_context_socket_close (sc);
+    test_context_socket_close (sb);
+}
+
+void test_poll_many_sockets ()
+{
+    const int count = 50;
+    void *sockets[count][2];
+    void *poller = zmq_poller_new ();
+    for (int i = 0; i < count; i++) {
+        char endpoint[64];
+        sprintf (endpoint, "inproc://many_%d", i);
+        sockets[i][0] = test_context_socket (ZMQ_PAIR);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (sockets[i][0], endpoint));
+        sockets[i][1] = test_context_socket (ZMQ_PAIR);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sockets[i][1], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_poller_add (poller, sockets[i][0], &sockets[i], ZMQ_POLLIN));
+    }
+
+    zmq_poller_event_t events[count];
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_poller_wait_all (poller, events, count, 0));
+
+    //  Only the sockets with a message are reported.
+    for (int i = 0; i < count; i += 10)
+        send_string_expect_success (sockets[i][1], "H", 0);
+    int found = 0;
+    while (found < count / 10) {
+        const int rc = TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_poller_wait_all (poller, events, count, 500));
+        for (int i = 0; i < rc; i++) {
+            TEST_ASSERT_EQUAL (ZMQ_POLLIN, events[i].events);
+            TEST_ASSERT_EQUAL_PTR (events[i].socket,
+                                   *(void **) events[i].user_data);
+            recv_string_expect_success (events[i].socket, "H", 0);
+        }
+        found += rc;
+    }
+    TEST_ASSERT_EQUAL_INT (count / 10, found);
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_poller_wait_all (poller, events, count, 0));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_poller_destroy (&poller));
+    for (int i = 0; i < count; i++) {
+        test_context_socket_close (sockets[i][0]);
+        test_context_socket_close (sockets[i][1]);
+    }
+}
+
 void test_poll_fd ()
 {
     //  Create sockets
@@ -655,6 +743,8 @@ int main (void)
     RUN_TEST (test_call_poller_wait_all_empty_with_timeout_fails);
 
     RUN_TEST (test_poll_basic);
+    RUN_TEST (test_poll_events_changed_outside_poller);
+    RUN_TEST (test_poll_many_sockets);
     RUN_TEST (test_poll_fd);
     RUN_TEST (test_poll_client_server);
 
@@ -0,0 +1,286 @@
+/*
+    Copyright (c) 2007-2019 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+//  Waits up to a second for the counter to reach the value.
+static void expect_counter (void *counter_, int value_)
+{
+    for (int i = 0; i != 1000 && zmq_atomic_counter_value (counter_) < value_;
+         i++)
+        msleep (1);
+    TEST_ASSERT_EQUAL_INT (value_, zmq_atomic_counter_value (counter_));
+}
+
+static void count_timer (int timer_id_, void *arg_)
+{
+    (void) timer_id_;
+    zmq_atomic_counter_inc (arg_);
+}
+
+static void unused_socket (void *, short, void *)
+{
+    TEST_FAIL ();
+}
+
+void test_reactor_invalid ()
+{
+    TEST_ASSERT_NULL (zmq_reactor_new (NULL));
+    TEST_ASSERT_FAILURE_ERRNO (EFAULT,
+                               zmq_reactor_add_timer (NULL, 1, count_timer, NULL));
+
+    void *reactor = zmq_reactor_new (get_test_context ());
+    TEST_ASSERT_NOT_NULL (reactor);
+
+    TEST_ASSERT_FAILURE_ERRNO (EFAULT,
+                               zmq_reactor_add_timer (reactor, 1, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_reactor_cancel_timer (reactor, 1));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_reactor_remove_fd (reactor, 0));
+
+    //  Thread safe sockets have no file descriptor to be watched through.
+    void *server = test_context_socket (ZMQ_SERVER);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_reactor_add_socket (reactor, server, ZMQ_POLLIN, unused_socket, NULL));
+    test_context_socket_close (server);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+    TEST_ASSERT_NULL (reactor);
+    TEST_ASSERT_FAILURE_ERRNO (EFAULT, zmq_reactor_destroy (&reactor));
+}
+
+void test_reactor_timer ()
+{
+    void *reactor = zmq_reactor_new (get_test_context ());
+    void *counter = zmq_atomic_counter_new ();
+
+    const int timer_id = TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_timer (reactor, 5, count_timer, counter));
+    expect_counter (counter, 3);
+
+    //  The timer doesn't fire once cancelled.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_cancel_timer (reactor, timer_id));
+    const int fired = zmq_atomic_counter_value (counter);
+    msleep (30);
+    TEST_ASSERT_EQUAL_INT (fired, zmq_atomic_counter_value (counter));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_reactor_cancel_timer (reactor, timer_id));
+
+    zmq_atomic_counter_destroy (&counter);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+}
+
+struct self_cancel_t
+{
+    void *reactor;
+    void *counter;
+};
+
+static void self_cancel_timer (int timer_id_, void *arg_)
+{
+    self_cancel_t *arg = static_cast<self_cancel_t *> (arg_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_cancel_timer (arg->reactor, timer_id_));
+    zmq_atomic_counter_inc (arg->counter);
+}
+
+void test_reactor_timer_cancelled_by_handler ()
+{
+    void *reactor = zmq_reactor_new (get_test_context ());
+    self_cancel_t arg = {reactor, zmq_atomic_counter_new ()};
+
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_timer (reactor, 1, self_cancel_timer, &arg));
+    expect_counter (arg.counter, 1);
+    msleep (20);
+    TEST_ASSERT_EQUAL_INT (1, zmq_atomic_counter_value (arg.counter));
+
+    zmq_atomic_counter_destroy (&arg.counter);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+}
+
+struct fd_arg_t
+{
+    void *reactor;
+    void *counter;
+};
+
+static void read_fd (int fd_, short events_, void *arg_)
+{
+    TEST_ASSERT_EQUAL (ZMQ_POLLIN, events_);
+    char buf;
+    TEST_ASSERT_EQUAL (1, read (fd_, &buf, 1));
+    fd_arg_t *arg = static_cast<fd_arg_t *> (arg_);
+
+    //  Stop watching after the second byte, from within the handler.
+    if (zmq_atomic_counter_inc (arg->counter) == 1)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_remove_fd (arg->reactor, fd_));
+}
+
+void test_reactor_fd ()
+{
+    void *reactor = zmq_reactor_new (get_test_context ());
+    fd_arg_t arg = {reactor, zmq_atomic_counter_new ()};
+
+    int fds[2];
+    TEST_ASSERT_SUCCESS_ERRNO (pipe (fds));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_fd (reactor, fds[0], ZMQ_POLLIN, read_fd, &arg));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_reactor_add_fd (reactor, fds[0], ZMQ_POLLIN, read_fd, &arg));
+
+    TEST_ASSERT_EQUAL (1, write (fds[1], "a", 1));
+    expect_counter (arg.counter, 1);
+    TEST_ASSERT_EQUAL (1, write (fds[1], "b", 1));
+    expect_counter (arg.counter, 2);
+
+    //  The handler removed the descriptor.
+    TEST_ASSERT_EQUAL (1, write (fds[1], "c", 1));
+    msleep (20);
+    TEST_ASSERT_EQUAL_INT (2, zmq_atomic_counter_value (arg.counter));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_reactor_remove_fd (reactor, fds[0]));
+
+    close (fds[0]);
+    close (fds[1]);
+    zmq_atomic_counter_destroy (&arg.counter);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+}
+
+static void unused_fd (int, short, void *)
+{
+    TEST_FAIL ();
+}
+
+void test_reactor_bad_fd ()
+{
+    void *reactor = zmq_reactor_new (get_test_context ());
+
+    int fds[2];
+    TEST_ASSERT_SUCCESS_ERRNO (pipe (fds));
+    close (fds[0]);
+    close (fds[1]);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EBADF, zmq_reactor_add_fd (reactor, fds[0], ZMQ_POLLIN, unused_fd, NULL));
+
+    //  Regular files cannot be polled.
+    FILE *file = tmpfile ();
+    TEST_ASSERT_NOT_NULL (file);
+    TEST_ASSERT_FAILURE_ERRNO (EPERM,
+                               zmq_reactor_add_fd (reactor, fileno (file),
+                                                   ZMQ_POLLIN, unused_fd, NULL));
+    fclose (file);
+
+    //  A descriptor closed before being removed is removed all the same.
+    TEST_ASSERT_SUCCESS_ERRNO (pipe (fds));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_fd (reactor, fds[0], ZMQ_POLLIN, unused_fd, NULL));
+    close (fds[0]);
+    close (fds[1]);
+    TEST_ASSERT_FAILURE_ERRNO (EBADF, zmq_reactor_remove_fd (reactor, fds[0]));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_reactor_remove_fd (reactor, fds[0]));
+
+    //  Or when the reactor is destroyed.
+    TEST_ASSERT_SUCCESS_ERRNO (pipe (fds));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_fd (reactor, fds[0], ZMQ_POLLIN, unused_fd, NULL));
+    close (fds[0]);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+
+    close (fds[1]);
+}
+
+static void echo_socket (void *socket_, short events_, void *arg_)
+{
+    TEST_ASSERT_EQUAL (ZMQ_POLLIN, events_);
+    zmq_msg_t msg;
+    zmq_msg_init (&msg);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, socket_, ZMQ_DONTWAIT));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_send (&msg, socket_, ZMQ_DONTWAIT));
+    zmq_atomic_counter_inc (arg_);
+}
+
+void test_reactor_socket ()
+{
+    void *reactor = zmq_reactor_new (get_test_context ());
+    void *counter = zmq_atomic_counter_new ();
+
+    void *echo = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (echo, "inproc://reactor"));
+    void *client = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, "inproc://reactor"));
+
+    //  A message queued before the socket is added is handled too.
+    send_string_expect_success (client, "a", 0);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_reactor_add_socket (reactor, echo, ZMQ_POLLIN, echo_socket, counter));
+    recv_string_expect_success (client, "a", 0);
+
+    const int count = 1000;
+    for (int i = 0; i != count; i++)
+        send_string_expect_success (client, "b", 0);
+    for (int i = 0; i != count; i++)
+        recv_string_expect_success (client, "b", 0);
+    TEST_ASSERT_EQUAL_INT (count + 1, zmq_atomic_counter_value (counter));
+
+    //  Once removed the socket is back in the hands of the application.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_remove_socket (reactor, echo));
+    send_string_expect_success (client, "c", 0);
+    recv_string_expect_success (echo, "c", 0);
+
+    zmq_atomic_counter_destroy (&counter);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_reactor_destroy (&reactor));
+    test_context_socket_close (client);
+    test_context_socket_close (echo);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_reactor_invalid);
+    RUN_TEST (test_reactor_timer);
+    RUN_TEST (test_reactor_timer_cancelled_by_handler);
+    RUN_TEST (test_reactor_fd);
+    RUN_TEST (test_reactor_bad_fd);
+    RUN_TEST (test_reactor_socket);
+
+    return UNITY_END ();
+}
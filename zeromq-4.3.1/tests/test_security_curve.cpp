@@ -40,6 +40,7 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #endif
+#include <vector>
 #include <unity.h>
 
 #include "../src/tweetnacl.h"
@@ -169,6 +170,347 @@ void test_curve_security_with_valid_credentials ()
     TEST_ASSERT_ZMQ_ERRNO (rc == 0);
 }
 
+#ifdef ZMQ_CRYPTO_THREADS
+//  Key exchanges done by the I/O thread rather than the crypto pool.
+void test_curve_security_with_valid_credentials_inline ()
+{
+    TEST_ASSERT_EQUAL_INT (1, zmq_ctx_get (ctx, ZMQ_CRYPTO_THREADS));
+    int rc = zmq_ctx_set (ctx, ZMQ_CRYPTO_THREADS, 0);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    TEST_ASSERT_EQUAL_INT (0, zmq_ctx_get (ctx, ZMQ_CRYPTO_THREADS));
+
+    test_curve_security_with_valid_credentials ();
+}
+#endif
+
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+//  Drops the connections accepted by the server, its clients reconnect.
+static void rebind_server ()
+{
+    int rc = zmq_unbind (server, my_endpoint);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+
+    //  The listening socket is closed by the I/O thread, asynchronously.
+    while ((rc = zmq_bind (server, my_endpoint)) == -1 && errno == EADDRINUSE)
+        msleep (SETTLE_TIME / 10);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+}
+
+//  Waits for the next handshake of the server. The server socket has to
+//  process commands meanwhile, for its old connections to be closed.
+static int get_server_handshake_event (int *value_)
+{
+    int event;
+    while ((event = get_monitor_event_with_timeout (server_mon, value_, NULL,
+                                                    SETTLE_TIME / 10))
+           == -1) {
+        int events;
+        size_t events_size = sizeof (int);
+        int rc = zmq_getsockopt (server, ZMQ_EVENTS, &events, &events_size);
+        TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    }
+    return event;
+}
+
+static void *create_and_connect_resuming_client (int server_lifetime_)
+{
+    int rc = zmq_setsockopt (server, ZMQ_CURVE_TICKET_LIFETIME,
+                             &server_lifetime_, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rebind_server ();
+
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = zmq_socket (ctx, ZMQ_DEALER);
+    TEST_ASSERT_NOT_NULL (client);
+    socket_config_curve_client (client, &curve_client_data);
+    int lifetime = 60000;
+    rc = zmq_setsockopt (client, ZMQ_CURVE_TICKET_LIFETIME, &lifetime,
+                         sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rc = zmq_connect (client, my_endpoint);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    return client;
+}
+
+void test_curve_security_resumption ()
+{
+    void *client = create_and_connect_resuming_client (60000);
+    bounce (server, client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+
+    //  The client resumes its session, then resumes it again with the
+    //  ticket it was given when resuming. Messages are only sent once the
+    //  client reconnected, so as not to lose them with the old connection.
+    for (int i = 0; i < 2; i++) {
+        rebind_server ();
+        TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                               get_server_handshake_event (NULL));
+        bounce (server, client);
+    }
+    assert_no_more_monitor_events_with_timeout (server_mon, timeout);
+
+    close_zero_linger (client);
+}
+
+void test_curve_security_resumption_with_expired_ticket ()
+{
+    void *client = create_and_connect_resuming_client (100);
+    bounce (server, client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+
+    //  The server turns the ticket down, the client falls back to a full
+    //  handshake when it reconnects.
+    msleep (200);
+    rebind_server ();
+    int value;
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_FAILED_PROTOCOL,
+                           get_server_handshake_event (&value));
+    TEST_ASSERT_EQUAL_INT (ZMQ_PROTOCOL_ERROR_ZMTP_CRYPTOGRAPHIC, value);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_server_handshake_event (NULL));
+    bounce (server, client);
+
+    close_zero_linger (client);
+}
+#endif
+
+#ifdef ZMQ_CURVE_AEAD
+static void *create_and_connect_aead_client (int server_aead_)
+{
+    int rc =
+      zmq_setsockopt (server, ZMQ_CURVE_AEAD, &server_aead_, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rebind_server ();
+
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = zmq_socket (ctx, ZMQ_DEALER);
+    TEST_ASSERT_NOT_NULL (client);
+    socket_config_curve_client (client, &curve_client_data);
+    int aead = 1;
+    rc = zmq_setsockopt (client, ZMQ_CURVE_AEAD, &aead, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rc = zmq_connect (client, my_endpoint);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    return client;
+}
+
+//  Sends a multipart message larger than the AEAD functions process at
+//  once, and echoes it.
+static void bounce_large (void *client_)
+{
+    const size_t size = 100000;
+    std::vector<char> content (size);
+    for (size_t i = 0; i < size; i++)
+        content[i] = static_cast<char> (i * 7);
+
+    TEST_ASSERT_EQUAL_INT (0, zmq_send (client_, "", 0, ZMQ_SNDMORE));
+    TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                           zmq_send (client_, &content[0], size, 0));
+
+    std::vector<char> received (size);
+    TEST_ASSERT_EQUAL_INT (0, zmq_recv (server, &received[0], size, 0));
+    TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                           zmq_recv (server, &received[0], size, 0));
+    TEST_ASSERT_EQUAL_MEMORY (&content[0], &received[0], size);
+
+    TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                           zmq_send (server, &received[0], size, 0));
+    TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                           zmq_recv (client_, &received[0], size, 0));
+    TEST_ASSERT_EQUAL_MEMORY (&content[0], &received[0], size);
+}
+
+void test_curve_security_aead ()
+{
+    void *client = create_and_connect_aead_client (1);
+    bounce (server, client);
+    bounce_large (client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+    assert_no_more_monitor_events_with_timeout (server_mon, timeout);
+
+    close_zero_linger (client);
+}
+
+//  The server ignores the ciphers offered, messages are boxed.
+void test_curve_security_aead_client_only ()
+{
+    void *client = create_and_connect_aead_client (0);
+    bounce (server, client);
+    bounce_large (client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+
+    close_zero_linger (client);
+}
+
+//  A resumed session negotiates its cipher again.
+void test_curve_security_aead_resumption ()
+{
+    int lifetime = 60000;
+    int rc = zmq_setsockopt (server, ZMQ_CURVE_TICKET_LIFETIME, &lifetime,
+                             sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    void *client = create_and_connect_aead_client (1);
+    rc = zmq_setsockopt (client, ZMQ_CURVE_TICKET_LIFETIME, &lifetime,
+                         sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    bounce (server, client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+
+    rebind_server ();
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_server_handshake_event (NULL));
+    bounce (server, client);
+    bounce_large (client);
+
+    close_zero_linger (client);
+}
+#endif
+
+#ifdef ZMQ_CURVE_BATCH
+static void *create_and_connect_batch_client (int aead_)
+{
+    int batch = 1;
+    int rc =
+      zmq_setsockopt (server, ZMQ_CURVE_BATCH, &batch, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rc = zmq_setsockopt (server, ZMQ_CURVE_AEAD, &aead_, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rebind_server ();
+
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *client = zmq_socket (ctx, ZMQ_DEALER);
+    TEST_ASSERT_NOT_NULL (client);
+    socket_config_curve_client (client, &curve_client_data);
+    rc = zmq_setsockopt (client, ZMQ_CURVE_BATCH, &batch, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rc = zmq_setsockopt (client, ZMQ_CURVE_AEAD, &aead_, sizeof (int));
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    rc = zmq_connect (client, my_endpoint);
+    TEST_ASSERT_ZMQ_ERRNO (rc == 0);
+    return client;
+}
+
+//  Sends many messages at once, small ones that are copied around, larger
+//  ones that refer to the batch they came in, and ones that do not fit in
+//  a batch, then checks they arrive whole and in order.
+static void send_burst (void *from_, void *to_)
+{
+    const size_t sizes[] = {0, 1, 40, 33, 34, 1000, 20000};
+    const int size_count = sizeof sizes / sizeof sizes[0];
+    const int count = 500;
+    std::vector<char> content (20000);
+
+    for (int i = 0; i < count; i++) {
+        const size_t size = sizes[i % size_count];
+        for (size_t j = 0; j < size; j++)
+            content[j] = static_cast<char> (i + j);
+        TEST_ASSERT_EQUAL_INT (
+          static_cast<int> (size),
+          zmq_send (from_, &content[0], size, i % 3 == 0 ? ZMQ_SNDMORE : 0));
+    }
+
+    //  Keep every message until the end, so that batches stay alive
+    //  while their messages are read.
+    std::vector<zmq_msg_t> msgs (count);
+    for (int i = 0; i < count; i++) {
+        zmq_msg_init (&msgs[i]);
+        const size_t size = sizes[i % size_count];
+        TEST_ASSERT_EQUAL_INT (static_cast<int> (size),
+                               zmq_msg_recv (&msgs[i], to_, 0));
+        TEST_ASSERT_EQUAL_INT (i % 3 == 0, zmq_msg_more (&msgs[i]));
+    }
+    for (int i = 0; i < count; i++) {
+        const size_t size = sizes[i % size_count];
+        const char *data = static_cast<const char *> (zmq_msg_data (&msgs[i]));
+        for (size_t j = 0; j < size; j++)
+            TEST_ASSERT_EQUAL_INT8 (static_cast<char> (i + j), data[j]);
+        TEST_ASSERT_EQUAL_INT (0, zmq_msg_close (&msgs[i]));
+    }
+}
+
+void test_curve_security_batch ()
+{
+    void *client = create_and_connect_batch_client (0);
+    bounce (server, client);
+    send_burst (client, server);
+    send_burst (server, client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+    assert_no_more_monitor_events_with_timeout (server_mon, timeout);
+
+    close_zero_linger (client);
+}
+
+void test_curve_security_batch_aead ()
+{
+    void *client = create_and_connect_batch_client (1);
+    bounce (server, client);
+    send_burst (client, server);
+    send_burst (server, client);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_HANDSHAKE_SUCCEEDED,
+                           get_monitor_event (server_mon, NULL, NULL));
+    assert_no_more_monitor_events_with_timeout (server_mon, timeout);
+
+    close_zero_linger (client);
+}
+#endif
+
+//  Many clients handshaking at once, as when they reconnect after a
+//  restart of the server.
+void test_curve_security_handshake_storm ()
+{
+    const int client_count = 32;
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    void *clients[client_count];
+    for (int i = 0; i < client_count; i++) {
+        clients[i] = create_and_connect_client (
+          ctx, my_endpoint, socket_config_curve_client, &curve_client_data);
+        TEST_ASSERT_EQUAL_INT (5, s_send (clients[i], "storm"));
+    }
+
+    for (int i = 0; i < client_count; i++) {
+        char *msg = s_recv (server);
+        TEST_ASSERT_EQUAL_STRING ("storm", msg);
+        free (msg);
+    }
+
+    for (int i = 0; i < client_count; i++)
+        close_zero_linger (clients[i]);
+
+    TEST_ASSERT_EQUAL_INT (client_count,
+                           expect_monitor_event_multiple (
+                             server_mon, ZMQ_EVENT_HANDSHAKE_SUCCEEDED));
+}
+
+//  Clients going away while the server works on their handshake.
+void test_curve_security_handshake_abandoned ()
+{
+    const int client_count = 16;
+    curve_client_data_t curve_client_data = {
+      valid_server_public, valid_client_public, valid_client_secret};
+    for (int i = 0; i < client_count; i++) {
+        void *client = create_and_connect_client (
+          ctx, my_endpoint, socket_config_curve_client, &curve_client_data);
+        msleep (i % 4);
+        close_zero_linger (client);
+    }
+
+    //  The server is still serving new clients.
+    void *client = create_and_connect_client (
+      ctx, my_endpoint, socket_config_curve_client, &curve_client_data);
+    bounce (server, client);
+    close_zero_linger (client);
+}
+
 void test_curve_security_with_bogus_client_credentials ()
 {
     //  This must be caught by the ZAP handler
@@ -617,6 +959,24 @@ int main (void)
 
     UNITY_BEGIN ();
     RUN_TEST (test_curve_security_with_valid_credentials);
+#ifdef ZMQ_CRYPTO_THREADS
+    RUN_TEST (test_curve_security_with_valid_credentials_inline);
+#endif
+#ifdef ZMQ_CURVE_TICKET_LIFETIME
+    RUN_TEST (test_curve_security_resumption);
+    RUN_TEST (test_curve_security_resumption_with_expired_ticket);
+#endif
+#ifdef ZMQ_CURVE_AEAD
+    RUN_TEST (test_curve_security_aead);
+    RUN_TEST (test_curve_security_aead_client_only);
+    RUN_TEST (test_curve_security_aead_resumption);
+#endif
+#ifdef ZMQ_CURVE_BATCH
+    RUN_TEST (test_curve_security_batch);
+    RUN_TEST (test_curve_security_batch_aead);
+#endif
+    RUN_TEST (test_curve_security_handshake_storm);
+    RUN_TEST (test_curve_security_handshake_abandoned);
     RUN_TEST (test_null_server_key);
     RUN_TEST (test_null_client_public_key);
     RUN_TEST (test_null_client_secret_key);
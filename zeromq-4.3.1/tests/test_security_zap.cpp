@@ -74,6 +74,11 @@ static void zap_handler_do_not_send (void *ctx_)
     zap_handler_generic (ctx_, zap_do_not_send);
 }
 
+static void zap_handler_hold_reply (void *ctx_)
+{
+    zap_handler_generic (ctx_, zap_hold_reply);
+}
+
 int expect_new_client_bounce_fail_and_count_monitor_events (
   void *ctx_,
   char *my_endpoint_,
@@ -332,6 +337,264 @@ void test_zap_errors (socket_config_fn server_socket_config_,
                                       handler);
 }
 
+#ifdef ZMQ_ZAP_CACHE_TTL
+static void expect_zap_requests_handled (int expected_)
+{
+    //  The handler counts a request before replying, and the handshakes
+    //  are over
+    assert (zmq_atomic_counter_value (zap_requests_handled) == expected_);
+}
+
+//  The server is a DEALER: until it has dropped a closed client, it could
+//  send the reply of the next bounce to the closed client's pipe. So each
+//  client is waited for until its disconnection shows on the server.
+
+static void *monitor_server_disconnects (void *ctx_, void *server_)
+{
+    //  The handshake events of the server are not looked at by the ZAP
+    //  cache tests
+    int rc = zmq_socket_monitor (server_, "inproc://monitor-server-disconnects",
+                                 ZMQ_EVENT_DISCONNECTED);
+    assert (rc == 0);
+    void *server_disconnects = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (server_disconnects);
+    rc = zmq_connect (server_disconnects,
+                      "inproc://monitor-server-disconnects");
+    assert (rc == 0);
+    return server_disconnects;
+}
+
+static void expect_new_client_bounce (void *ctx_,
+                                      char *my_endpoint_,
+                                      void *server_,
+                                      void *server_disconnects_,
+                                      socket_config_fn socket_config_,
+                                      void *socket_config_data_)
+{
+    void *client = create_and_connect_client (ctx_, my_endpoint_,
+                                              socket_config_, socket_config_data_);
+    bounce (server_, client);
+    close_zero_linger (client);
+    expect_monitor_event (server_disconnects_, ZMQ_EVENT_DISCONNECTED);
+}
+
+static void expect_new_client_refused (void *ctx_,
+                                       char *my_endpoint_,
+                                       void *server_disconnects_,
+                                       socket_config_fn socket_config_,
+                                       void *socket_config_data_)
+{
+    //  Waits for the refusal rather than for a bounce to time out. The
+    //  monitor endpoints of closed clients are released asynchronously.
+    static int clients_refused = 0;
+    char monitor_endpoint[64];
+    sprintf (monitor_endpoint, "inproc://refused-client-%d",
+             clients_refused++);
+
+    //  A cached refusal can be over before a monitor set up after
+    //  connecting would see it
+    void *client = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (client);
+    socket_config_ (client, socket_config_data_);
+    void *client_mon;
+    setup_handshake_socket_monitor (ctx_, client, &client_mon,
+                                    monitor_endpoint);
+    int rc = zmq_connect (client, my_endpoint_);
+    assert (rc == 0);
+
+    int events_received = expect_monitor_event_multiple (
+      client_mon, ZMQ_EVENT_HANDSHAKE_FAILED_AUTH, 400);
+    assert (events_received == 1);
+
+    rc = zmq_close (client_mon);
+    assert (rc == 0);
+    close_zero_linger (client);
+    expect_monitor_event (server_disconnects_, ZMQ_EVENT_DISCONNECTED);
+}
+
+void test_zap_cache (socket_config_fn server_socket_config_,
+                     void *server_socket_config_data_,
+                     socket_config_fn client_socket_config_,
+                     void *client_socket_config_data_,
+                     socket_config_fn bad_client_socket_config_,
+                     void *bad_client_socket_config_data_,
+                     const void *credential_,
+                     size_t credential_size_)
+{
+    void *ctx;
+    void *handler;
+    void *zap_thread;
+    void *server;
+    void *server_mon;
+    char my_endpoint[MAX_SOCKET_STRING];
+
+    fprintf (stderr, "test_zap_cache\n");
+    setup_context_and_server_side (&ctx, &handler, &zap_thread, &server,
+                                   &server_mon, my_endpoint, &zap_handler,
+                                   server_socket_config_,
+                                   server_socket_config_data_);
+    assert (zmq_ctx_get (ctx, ZMQ_ZAP_CACHE_TTL) == 0);
+    int rc = zmq_ctx_set (ctx, ZMQ_ZAP_CACHE_TTL, 60000);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_ZAP_CACHE_TTL) == 60000);
+    void *server_disconnects = monitor_server_disconnects (ctx, server);
+
+    //  Only the first of the connections with the same credentials reaches
+    //  the handler
+    for (int i = 0; i < 3; i++)
+        expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                                  client_socket_config_,
+                                  client_socket_config_data_);
+    expect_zap_requests_handled (1);
+
+    //  Refusals are cached as well, even if the client retries
+    for (int i = 0; i < 2; i++)
+        expect_new_client_refused (ctx, my_endpoint, server_disconnects,
+                                   bad_client_socket_config_,
+                                   bad_client_socket_config_data_);
+    expect_zap_requests_handled (2);
+
+    //  Invalidating other credentials or another domain keeps the entry
+    rc = zmq_zap_cache_invalidate (ctx, NULL, "other", 5);
+    assert (rc == 0);
+    rc = zmq_zap_cache_invalidate (ctx, "other", NULL, 0);
+    assert (rc == 0);
+    expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                              client_socket_config_,
+                              client_socket_config_data_);
+    expect_zap_requests_handled (2);
+
+    //  Invalidating the credentials asks the handler again
+    rc = zmq_zap_cache_invalidate (ctx, test_zap_domain, credential_,
+                                   credential_size_);
+    assert (rc == 0);
+    expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                              client_socket_config_,
+                              client_socket_config_data_);
+    expect_zap_requests_handled (3);
+
+    //  And so does flushing the cache, for all credentials
+    rc = zmq_zap_cache_flush (ctx);
+    assert (rc == 0);
+    expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                              client_socket_config_,
+                              client_socket_config_data_);
+    expect_new_client_refused (ctx, my_endpoint, server_disconnects,
+                               bad_client_socket_config_,
+                               bad_client_socket_config_data_);
+    expect_zap_requests_handled (5);
+
+    //  Nothing is cached with a TTL of 0
+    rc = zmq_ctx_set (ctx, ZMQ_ZAP_CACHE_TTL, 0);
+    assert (rc == 0);
+    expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                              client_socket_config_,
+                              client_socket_config_data_);
+    expect_new_client_bounce (ctx, my_endpoint, server, server_disconnects,
+                              client_socket_config_,
+                              client_socket_config_data_);
+    expect_zap_requests_handled (7);
+
+    rc = zmq_zap_cache_flush (NULL);
+    assert (rc == -1 && errno == EFAULT);
+
+    close_zero_linger (server_disconnects);
+
+    shutdown_context_and_server_side (ctx, zap_thread, server, server_mon,
+                                      handler);
+}
+
+static void expect_held_zap_reply (void *hold_)
+{
+    char *buf = s_recv (hold_);
+    assert (buf);
+    assert (streq (buf, "HELD"));
+    free (buf);
+}
+
+static void release_held_zap_reply (void *hold_)
+{
+    int rc = s_send (hold_, "RELEASE");
+    assert (rc == 7);
+}
+
+void test_zap_cache_invalidate_pending (
+  socket_config_fn server_socket_config_,
+  void *server_socket_config_data_,
+  socket_config_fn client_socket_config_,
+  void *client_socket_config_data_,
+  const void *credential_,
+  size_t credential_size_)
+{
+    void *ctx;
+    void *handler;
+    void *zap_thread;
+    void *server;
+    void *server_mon;
+    char my_endpoint[MAX_SOCKET_STRING];
+
+    fprintf (stderr, "test_zap_cache_invalidate_pending\n");
+    setup_context_and_server_side (&ctx, &handler, &zap_thread, &server,
+                                   &server_mon, my_endpoint,
+                                   &zap_handler_hold_reply,
+                                   server_socket_config_,
+                                   server_socket_config_data_);
+    int rc = zmq_ctx_set (ctx, ZMQ_ZAP_CACHE_TTL, 60000);
+    assert (rc == 0);
+    void *server_disconnects = monitor_server_disconnects (ctx, server);
+
+    void *hold = zmq_socket (ctx, ZMQ_REP);
+    assert (hold);
+    rc = zmq_bind (hold, zap_hold_endpoint);
+    assert (rc == 0);
+    int timeout = 10000;
+    rc = zmq_setsockopt (hold, ZMQ_RCVTIMEO, &timeout, sizeof timeout);
+    assert (rc == 0);
+
+    //  The credentials are revoked while the handler is still deciding on
+    //  them, its reply lets the client in but is not cached
+    void *client = create_and_connect_client (ctx, my_endpoint,
+                                              client_socket_config_,
+                                              client_socket_config_data_);
+    expect_held_zap_reply (hold);
+    rc = zmq_zap_cache_invalidate (ctx, NULL, credential_, credential_size_);
+    assert (rc == 0);
+    release_held_zap_reply (hold);
+    bounce (server, client);
+    close_zero_linger (client);
+    expect_monitor_event (server_disconnects, ZMQ_EVENT_DISCONNECTED);
+    expect_zap_requests_handled (1);
+
+    //  So the next client is decided on by the handler again
+    client = create_and_connect_client (ctx, my_endpoint,
+                                        client_socket_config_,
+                                        client_socket_config_data_);
+    expect_held_zap_reply (hold);
+    release_held_zap_reply (hold);
+    bounce (server, client);
+    close_zero_linger (client);
+    expect_monitor_event (server_disconnects, ZMQ_EVENT_DISCONNECTED);
+    expect_zap_requests_handled (2);
+
+    close_zero_linger (hold);
+    close_zero_linger (server_disconnects);
+    shutdown_context_and_server_side (ctx, zap_thread, server, server_mon,
+                                      handler);
+}
+
+static void socket_config_plain_client_wrong_password (void *server_,
+                                                       void *server_secret_)
+{
+    LIBZMQ_UNUSED (server_secret_);
+
+    int rc = zmq_setsockopt (server_, ZMQ_PLAIN_PASSWORD, "wrongpass", 9);
+    assert (rc == 0);
+
+    rc = zmq_setsockopt (server_, ZMQ_PLAIN_USERNAME, test_plain_username, 8);
+    assert (rc == 0);
+}
+#endif
+
 int main (void)
 {
     setup_test_environment ();
@@ -343,6 +606,15 @@ int main (void)
     fprintf (stderr, "PLAIN mechanism\n");
     test_zap_errors (&socket_config_plain_server, NULL,
                      &socket_config_plain_client, NULL);
+#ifdef ZMQ_ZAP_CACHE_TTL
+    test_zap_cache (&socket_config_plain_server, NULL,
+                    &socket_config_plain_client, NULL,
+                    &socket_config_plain_client_wrong_password, NULL,
+                    test_plain_username, strlen (test_plain_username));
+    test_zap_cache_invalidate_pending (
+      &socket_config_plain_server, NULL, &socket_config_plain_client, NULL,
+      test_plain_username, strlen (test_plain_username));
+#endif
 
     if (zmq_has ("curve")) {
         fprintf (stderr, "CURVE mechanism\n");
@@ -352,5 +624,23 @@ int main (void)
           valid_server_public, valid_client_public, valid_client_secret};
         test_zap_errors (&socket_config_curve_server, valid_server_secret,
                          &socket_config_curve_client, &curve_client_data);
+#ifdef ZMQ_ZAP_CACHE_TTL
+        char bad_client_public[41];
+        char bad_client_secret[41];
+        int rc = zmq_curve_keypair (bad_client_public, bad_client_secret);
+        assert (rc == 0);
+        curve_client_data_t bad_curve_client_data = {
+          valid_server_public, bad_client_public, bad_client_secret};
+        uint8_t client_key[32];
+        zmq_z85_decode (client_key, valid_client_public);
+        test_zap_cache (&socket_config_curve_server, valid_server_secret,
+                        &socket_config_curve_client, &curve_client_data,
+                        &socket_config_curve_client, &bad_curve_client_data,
+                        client_key, sizeof client_key);
+        test_zap_cache_invalidate_pending (
+          &socket_config_curve_server, valid_server_secret,
+          &socket_config_curve_client, &curve_client_data, client_key,
+          sizeof client_key);
+#endif
     }
 }
@@ -210,6 +210,70 @@ void test_timers ()
     TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_destroy (&timers));
 }
 
+struct cancel_arg_t
+{
+    void *timers;
+    int victim;
+    int fired;
+};
+
+void cancelling_handler (int timer_id_, void *arg_)
+{
+    (void) timer_id_;
+    cancel_arg_t *arg = (cancel_arg_t *) arg_;
+    arg->fired++;
+    if (arg->victim) {
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_cancel (arg->timers, arg->victim));
+        arg->victim = 0;
+    }
+}
+
+void counting_handler (int timer_id_, void *arg_)
+{
+    (void) timer_id_;
+    (*(int *) arg_)++;
+}
+
+void test_many_timers ()
+{
+    void *timers = zmq_timers_new ();
+    TEST_ASSERT_NOT_NULL (timers);
+
+    //  Many timers, half of them cancelled out of order.
+    const int count = 1000;
+    int fired = 0;
+    int ids[count];
+    for (int i = 0; i < count; i++)
+        ids[i] = TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_timers_add (timers, 10 + (i * 7) % 40, counting_handler, &fired));
+    for (int i = 0; i < count; i += 2)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_cancel (timers, ids[i]));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_timers_cancel (timers, ids[0]));
+
+    //  A timer firing before another one cancels it from its handler.
+    cancel_arg_t arg = {timers, 0, 0};
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_timers_add (timers, 5, cancelling_handler, &arg));
+    int late_fired = 0;
+    const int victim = TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_timers_add (timers, 60, counting_handler, &late_fired));
+    arg.victim = victim;
+
+    msleep (100);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_execute (timers));
+
+    //  Each remaining timer fires once per execution, however late.
+    TEST_ASSERT_EQUAL_INT (count / 2, fired);
+    TEST_ASSERT_EQUAL_INT (1, arg.fired);
+    TEST_ASSERT_EQUAL_INT (0, late_fired);
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_timers_cancel (timers, victim));
+
+    for (int i = 1; i < count; i += 2)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_cancel (timers, ids[i]));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_timers_destroy (&timers));
+}
+
 int main ()
 {
     setup_test_environment ();
@@ -218,5 +282,6 @@ int main ()
     RUN_TEST (test_timers);
     RUN_TEST (test_null_timer_pointers);
     RUN_TEST (test_corner_cases);
+    RUN_TEST (test_many_timers);
     return UNITY_END ();
 }
@@ -169,11 +169,33 @@ enum zap_protocol_t
     zap_too_many_parts,
     zap_disconnect,
     zap_do_not_recv,
-    zap_do_not_send
+    zap_do_not_send,
+    // Replies only once the main thread says so, see zap_hold_reply
+    zap_hold_reply
 };
 
 void *zap_requests_handled;
 
+//  With zap_hold_reply, the handler tells the main thread through a REQ
+//  socket connected to this endpoint that it holds a request, and replies
+//  once the main thread answers.
+const char zap_hold_endpoint[] = "inproc://zap-hold";
+
+void zap_hold_reply_until_released (void *ctx_)
+{
+    void *hold = zmq_socket (ctx_, ZMQ_REQ);
+    assert (hold);
+    int rc = zmq_connect (hold, zap_hold_endpoint);
+    assert (rc == 0);
+    rc = s_send (hold, "HELD");
+    assert (rc == 4);
+    char *buf = s_recv (hold);
+    assert (buf);
+    assert (streq (buf, "RELEASE"));
+    free (buf);
+    close_zero_linger (hold);
+}
+
 void zap_handler_generic (void *ctx_,
                           zap_protocol_t zap_protocol_,
                           const char *expected_routing_id_ = "IDENT")
@@ -260,6 +282,13 @@ void zap_handler_generic (void *ctx_,
         assert (streq (version, "1.0"));
         assert (streq (routing_id, expected_routing_id_));
 
+        //  Counted before replying, so that the count is up to date by the
+        //  time the handshake waiting for the reply is over
+        zmq_atomic_counter_inc (zap_requests_handled);
+
+        if (zap_protocol_ == zap_hold_reply)
+            zap_hold_reply_until_released (ctx_);
+
         s_sendmore (handler, zap_protocol_ == zap_wrong_version
                                ? "invalid_version"
                                : version);
@@ -303,8 +332,6 @@ void zap_handler_generic (void *ctx_,
         free (address);
         free (routing_id);
         free (mechanism);
-
-        zmq_atomic_counter_inc (zap_requests_handled);
     }
     rc = zmq_unbind (handler, "inproc://zeromq.zap.01");
     assert (rc == 0);
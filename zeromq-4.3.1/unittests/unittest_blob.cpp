@@ -0,0 +1,124 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "../tests/testutil.hpp"
+
+#include <blob.hpp>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static const unsigned char data[] =
+  "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+static void test_copy (size_t size_)
+{
+    zmq::blob_t blob (data, size_);
+    TEST_ASSERT_EQUAL_UINT (size_, blob.size ());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, blob.data (), size_);
+
+    zmq::blob_t copy;
+    copy.set_deep_copy (blob);
+    TEST_ASSERT_EQUAL_UINT (size_, copy.size ());
+    TEST_ASSERT_TRUE (copy.data () != blob.data ());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, copy.data (), size_);
+
+    //  Replacing the content of either leaves the other as it was.
+    copy.set (data + 1, size_);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, blob.data (), size_);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data + 1, copy.data (), size_);
+}
+
+void test_copy_inline ()
+{
+    test_copy (5);
+    test_copy (zmq::blob_t::inline_size);
+}
+
+void test_copy_allocated ()
+{
+    test_copy (zmq::blob_t::inline_size + 1);
+    test_copy (sizeof data);
+}
+
+#ifdef ZMQ_HAS_MOVE_SEMANTICS
+static void test_move (size_t size_)
+{
+    zmq::blob_t blob (data, size_);
+    zmq::blob_t moved (ZMQ_MOVE (blob));
+    TEST_ASSERT_EQUAL_UINT (size_, moved.size ());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, moved.data (), size_);
+
+    zmq::blob_t assigned (data + 1, sizeof data - 1);
+    assigned = ZMQ_MOVE (moved);
+    TEST_ASSERT_EQUAL_UINT (size_, assigned.size ());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, assigned.data (), size_);
+
+    //  Moved blobs can be reused.
+    moved.set (data + 2, size_);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data, assigned.data (), size_);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (data + 2, moved.data (), size_);
+}
+
+void test_move_inline ()
+{
+    test_move (5);
+    test_move (zmq::blob_t::inline_size);
+}
+
+void test_move_allocated ()
+{
+    test_move (zmq::blob_t::inline_size + 1);
+    test_move (sizeof data);
+}
+#endif
+
+void test_order ()
+{
+    const zmq::blob_t short_blob (data, 5);
+    const zmq::blob_t long_blob (data, sizeof data);
+    const zmq::blob_t other_blob (data + 1, 5);
+    TEST_ASSERT_TRUE (short_blob < long_blob);
+    TEST_ASSERT_FALSE (long_blob < short_blob);
+    TEST_ASSERT_TRUE (long_blob < other_blob);
+    TEST_ASSERT_FALSE (short_blob < short_blob);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_copy_inline);
+    RUN_TEST (test_copy_allocated);
+#ifdef ZMQ_HAS_MOVE_SEMANTICS
+    RUN_TEST (test_move_inline);
+    RUN_TEST (test_move_allocated);
+#endif
+    RUN_TEST (test_order);
+    return UNITY_END ();
+}
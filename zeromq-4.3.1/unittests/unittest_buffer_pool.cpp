@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <buffer_pool.hpp>
+#include <config.hpp>
+#include <msg.hpp>
+#include <v2_decoder.hpp>
+#include <v2_encoder.hpp>
+
+#include <string.h>
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_reuse ()
+{
+    zmq::buffer_pool_t pool;
+    void *buf = pool.allocate (100);
+    TEST_ASSERT_NOT_NULL (buf);
+    pool.deallocate (buf, 100);
+    TEST_ASSERT_EQUAL_UINT (1, pool.idle ());
+
+    //  Only a buffer of the same size is reused.
+    void *other = pool.allocate (200);
+    TEST_ASSERT_EQUAL_UINT (1, pool.idle ());
+    TEST_ASSERT_TRUE (pool.allocate (100) == buf);
+    TEST_ASSERT_EQUAL_UINT (0, pool.idle ());
+
+    pool.deallocate (buf, 100);
+    pool.deallocate (other, 200);
+    TEST_ASSERT_EQUAL_UINT (2, pool.idle ());
+}
+
+void test_idle_limit ()
+{
+    zmq::buffer_pool_t pool;
+    std::vector<void *> buffers;
+    for (int i = 0; i != zmq::max_pooled_buffers + 10; i++)
+        buffers.push_back (pool.allocate (64));
+    for (size_t i = 0; i != buffers.size (); i++)
+        pool.deallocate (buffers[i], 64);
+    TEST_ASSERT_EQUAL_UINT (zmq::max_pooled_buffers, pool.idle ());
+}
+
+void test_encoder_release ()
+{
+    zmq::buffer_pool_t pool;
+    zmq::v2_encoder_t encoder (zmq::out_batch_size);
+    encoder.set_buffer_pool (&pool);
+
+    //  Nothing is borrowed until there is something to encode.
+    unsigned char *data = NULL;
+    TEST_ASSERT_EQUAL_UINT (0, encoder.encode (&data, 0));
+    encoder.release_buffer ();
+    TEST_ASSERT_EQUAL_UINT (0, pool.idle ());
+
+    zmq::msg_t msg;
+    TEST_ASSERT_EQUAL_INT (0, msg.init_size (10));
+    encoder.load_msg (&msg);
+    data = NULL;
+    TEST_ASSERT_EQUAL_UINT (12, encoder.encode (&data, 0));
+    encoder.release_buffer ();
+    TEST_ASSERT_EQUAL_UINT (1, pool.idle ());
+    TEST_ASSERT_EQUAL_INT (0, msg.close ());
+}
+
+//  Releasing the buffer in the middle of a message received in place in it
+//  must not keep the buffer alive.
+void test_decoder_release_partial_message ()
+{
+    const size_t size = 100;
+    unsigned char frame[size + 2];
+    frame[0] = 0;
+    frame[1] = static_cast<unsigned char> (size);
+    for (size_t i = 0; i != size; i++)
+        frame[i + 2] = static_cast<unsigned char> (i);
+
+    zmq::buffer_pool_t pool;
+    zmq::v2_decoder_t decoder (zmq::in_batch_size, -1, true);
+    decoder.set_buffer_pool (&pool);
+
+    unsigned char *buf;
+    size_t buf_size;
+    size_t processed;
+    const size_t first = 50;
+    decoder.get_buffer (&buf, &buf_size);
+    TEST_ASSERT_TRUE (buf_size >= first);
+    memcpy (buf, frame, first);
+    TEST_ASSERT_EQUAL_INT (0, decoder.decode (buf, first, processed));
+    TEST_ASSERT_EQUAL_UINT (first, processed);
+
+    decoder.release_buffer ();
+    TEST_ASSERT_EQUAL_UINT (1, pool.idle ());
+
+    decoder.get_buffer (&buf, &buf_size);
+    TEST_ASSERT_EQUAL_UINT (0, pool.idle ());
+    memcpy (buf, frame + first, sizeof frame - first);
+    TEST_ASSERT_EQUAL_INT (
+      1, decoder.decode (buf, sizeof frame - first, processed));
+    TEST_ASSERT_EQUAL_UINT (sizeof frame - first, processed);
+
+    zmq::msg_t *msg = decoder.msg ();
+    TEST_ASSERT_EQUAL_UINT (size, msg->size ());
+    TEST_ASSERT_EQUAL_MEMORY (frame + 2, msg->data (), size);
+
+    //  The message was completed in memory of its own, the buffer goes
+    //  back to the pool.
+    decoder.release_buffer ();
+    TEST_ASSERT_EQUAL_UINT (1, pool.idle ());
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_reuse);
+    RUN_TEST (test_idle_limit);
+    RUN_TEST (test_encoder_release);
+    RUN_TEST (test_decoder_release_partial_message);
+
+    return UNITY_END ();
+}
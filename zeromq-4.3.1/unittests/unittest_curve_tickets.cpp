@@ -0,0 +1,152 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <curve_tickets.hpp>
+#include <random.hpp>
+
+#include <string.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+#ifdef ZMQ_HAVE_CURVE
+
+static const uint8_t server_tag[zmq::curve_tickets_t::tag_size] = {1, 2, 3};
+static const uint8_t client_key[32] = {4, 5, 6};
+static const uint8_t secret[zmq::curve_tickets_t::secret_size] = {7, 8, 9};
+
+void test_open_and_redeem ()
+{
+    zmq::curve_tickets_t tickets;
+    uint8_t ticket[zmq::curve_tickets_t::ticket_size];
+    tickets.issue (server_tag, client_key, secret, 60000, ticket);
+
+    uint64_t expiry;
+    uint8_t key[32];
+    uint8_t secret_out[zmq::curve_tickets_t::secret_size];
+    TEST_ASSERT_EQUAL_INT (
+      0, tickets.open (ticket, server_tag, &expiry, key, secret_out));
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (client_key, key, sizeof key);
+    TEST_ASSERT_EQUAL_UINT8_ARRAY (secret, secret_out, sizeof secret_out);
+
+    TEST_ASSERT_EQUAL_INT (0, tickets.redeem (ticket, expiry));
+    TEST_ASSERT_EQUAL_INT (-1, tickets.redeem (ticket, expiry));
+}
+
+void test_open_other_server ()
+{
+    zmq::curve_tickets_t tickets;
+    uint8_t ticket[zmq::curve_tickets_t::ticket_size];
+    tickets.issue (server_tag, client_key, secret, 60000, ticket);
+
+    uint8_t other_tag[zmq::curve_tickets_t::tag_size] = {3, 2, 1};
+    uint64_t expiry;
+    uint8_t key[32];
+    uint8_t secret_out[zmq::curve_tickets_t::secret_size];
+    TEST_ASSERT_EQUAL_INT (
+      -1, tickets.open (ticket, other_tag, &expiry, key, secret_out));
+}
+
+void test_open_other_context ()
+{
+    zmq::curve_tickets_t tickets;
+    zmq::curve_tickets_t other_tickets;
+    uint8_t ticket[zmq::curve_tickets_t::ticket_size];
+    tickets.issue (server_tag, client_key, secret, 60000, ticket);
+
+    uint64_t expiry;
+    uint8_t key[32];
+    uint8_t secret_out[zmq::curve_tickets_t::secret_size];
+    TEST_ASSERT_EQUAL_INT (
+      -1, other_tickets.open (ticket, server_tag, &expiry, key, secret_out));
+
+    //  Nor once the context issued tickets of its own.
+    uint8_t other_ticket[zmq::curve_tickets_t::ticket_size];
+    other_tickets.issue (server_tag, client_key, secret, 60000,
+                         other_ticket);
+    TEST_ASSERT_EQUAL_INT (
+      -1, other_tickets.open (ticket, server_tag, &expiry, key, secret_out));
+}
+
+void test_open_forged ()
+{
+    zmq::curve_tickets_t tickets;
+    uint8_t ticket[zmq::curve_tickets_t::ticket_size];
+    tickets.issue (server_tag, client_key, secret, 60000, ticket);
+
+    uint64_t expiry;
+    uint8_t key[32];
+    uint8_t secret_out[zmq::curve_tickets_t::secret_size];
+    for (size_t i = 0; i < sizeof ticket; i++) {
+        ticket[i] ^= 1;
+        TEST_ASSERT_EQUAL_INT (
+          -1, tickets.open (ticket, server_tag, &expiry, key, secret_out));
+        ticket[i] ^= 1;
+    }
+    TEST_ASSERT_EQUAL_INT (
+      0, tickets.open (ticket, server_tag, &expiry, key, secret_out));
+}
+
+void test_open_expired ()
+{
+    zmq::curve_tickets_t tickets;
+    uint8_t ticket[zmq::curve_tickets_t::ticket_size];
+    tickets.issue (server_tag, client_key, secret, 1, ticket);
+    msleep (10);
+
+    uint64_t expiry;
+    uint8_t key[32];
+    uint8_t secret_out[zmq::curve_tickets_t::secret_size];
+    TEST_ASSERT_EQUAL_INT (
+      -1, tickets.open (ticket, server_tag, &expiry, key, secret_out));
+}
+
+#endif
+
+int main (void)
+{
+    setup_test_environment ();
+#ifdef ZMQ_HAVE_CURVE
+    zmq::random_open ();
+#endif
+
+    UNITY_BEGIN ();
+#ifdef ZMQ_HAVE_CURVE
+    RUN_TEST (test_open_and_redeem);
+    RUN_TEST (test_open_other_server);
+    RUN_TEST (test_open_other_context);
+    RUN_TEST (test_open_forged);
+    RUN_TEST (test_open_expired);
+#endif
+    const int rc = UNITY_END ();
+
+#ifdef ZMQ_HAVE_CURVE
+    zmq::random_close ();
+#endif
+    return rc;
+}
@@ -0,0 +1,210 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+
+#include "../tests/testutil.hpp"
+
+#include <dns_resolver.hpp>
+
+#include <string.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+//  Resolves host names from a table rather than asking a name server,
+//  and counts the lookups.
+class test_dns_resolver_t : public zmq::dns_resolver_t
+{
+  public:
+    test_dns_resolver_t (int ttl_, int negative_ttl_) :
+        dns_resolver_t (NULL, ttl_, negative_ttl_),
+        lookups (0)
+    {
+    }
+
+    int lookups;
+
+  protected:
+    virtual int do_resolve (const std::string &name_,
+                            bool ipv6_,
+                            zmq::tcp_address_t *address_)
+    {
+        struct dns_lut_t
+        {
+            const char *hostname;
+            const char *ipv4;
+            const char *ipv6;
+        };
+        static const dns_lut_t dns_lut[] = {
+          {"ip.zeromq.org", "10.100.0.1", "[fdf5:d058:d656::1]"},
+          {"ipv4only.zeromq.org", "10.100.0.2", NULL},
+        };
+
+        lookups++;
+
+        const std::string::size_type colon = name_.rfind (':');
+        const std::string host = name_.substr (0, colon);
+        const std::string port = name_.substr (colon);
+        for (size_t i = 0; i < sizeof dns_lut / sizeof dns_lut[0]; i++) {
+            if (host != dns_lut[i].hostname)
+                continue;
+            const char *ip = ipv6_ && dns_lut[i].ipv6 ? dns_lut[i].ipv6
+                                                      : dns_lut[i].ipv4;
+            return address_->resolve ((ip + port).c_str (), false, ipv6_,
+                                      false);
+        }
+        errno = EINVAL;
+        return -1;
+    }
+};
+
+class test_request_t : public zmq::dns_request_t
+{
+  public:
+    test_request_t (const char *name_, bool ipv6_) :
+        dns_request_t (name_, ipv6_)
+    {
+    }
+
+    void completed () {}
+};
+
+static void test_address (const char *expected_,
+                          const zmq::tcp_address_t &address_)
+{
+    std::string address;
+    TEST_ASSERT_EQUAL_INT (0, address_.to_string (address));
+    TEST_ASSERT_EQUAL_STRING (expected_, address.c_str ());
+}
+
+void test_lookup_numeric ()
+{
+    test_dns_resolver_t resolver (60000, 60000);
+
+    zmq::tcp_address_t address;
+    TEST_ASSERT_EQUAL_INT (
+      0, resolver.lookup ("10.100.0.3:5555", false, &address));
+    test_address ("tcp://10.100.0.3:5555", address);
+    TEST_ASSERT_EQUAL_INT (0, resolver.lookup ("[::1]:5555", true, &address));
+    test_address ("tcp://[::1]:5555", address);
+    TEST_ASSERT_EQUAL_INT (0, resolver.lookups);
+}
+
+void test_resolve_cached ()
+{
+    test_dns_resolver_t resolver (60000, 60000);
+
+    zmq::tcp_address_t address;
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("ip.zeromq.org:5555", false, &address));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+    test_request_t request ("ip.zeromq.org:5555", false);
+    resolver.resolve (&request);
+    TEST_ASSERT_EQUAL_INT (0, request.rc);
+    test_address ("tcp://10.100.0.1:5555", request.address);
+    TEST_ASSERT_EQUAL_INT (1, resolver.lookups);
+
+    TEST_ASSERT_EQUAL_INT (
+      0, resolver.lookup ("ip.zeromq.org:5555", false, &address));
+    test_address ("tcp://10.100.0.1:5555", address);
+
+    //  A request queued before the answer came is answered from the cache.
+    test_request_t queued ("ip.zeromq.org:5555", false);
+    resolver.resolve (&queued);
+    TEST_ASSERT_EQUAL_INT (0, queued.rc);
+    test_address ("tcp://10.100.0.1:5555", queued.address);
+    TEST_ASSERT_EQUAL_INT (1, resolver.lookups);
+
+    //  Other ports and address families are other names.
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("ip.zeromq.org:5556", false, &address));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("ip.zeromq.org:5555", true, &address));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+    test_request_t ipv6 ("ip.zeromq.org:5555", true);
+    resolver.resolve (&ipv6);
+    TEST_ASSERT_EQUAL_INT (0, ipv6.rc);
+    test_address ("tcp://[fdf5:d058:d656::1]:5555", ipv6.address);
+    TEST_ASSERT_EQUAL_INT (2, resolver.lookups);
+}
+
+void test_resolve_expired ()
+{
+    test_dns_resolver_t resolver (10, 60000);
+
+    test_request_t request ("ipv4only.zeromq.org:5555", false);
+    resolver.resolve (&request);
+    TEST_ASSERT_EQUAL_INT (0, request.rc);
+
+    zmq::tcp_address_t address;
+    TEST_ASSERT_EQUAL_INT (
+      0, resolver.lookup ("ipv4only.zeromq.org:5555", false, &address));
+
+    msleep (50);
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("ipv4only.zeromq.org:5555", false, &address));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+
+    resolver.resolve (&request);
+    TEST_ASSERT_EQUAL_INT (2, resolver.lookups);
+}
+
+void test_resolve_failure_cached ()
+{
+    test_dns_resolver_t resolver (60000, 10);
+
+    test_request_t request ("unknown.zeromq.org:5555", false);
+    resolver.resolve (&request);
+    TEST_ASSERT_EQUAL_INT (-1, request.rc);
+    TEST_ASSERT_EQUAL_INT (EINVAL, request.error);
+
+    //  The failure is known until the negative TTL expires.
+    zmq::tcp_address_t address;
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("unknown.zeromq.org:5555", false, &address));
+    TEST_ASSERT_EQUAL_INT (EINVAL, errno);
+
+    msleep (50);
+    TEST_ASSERT_EQUAL_INT (
+      -1, resolver.lookup ("unknown.zeromq.org:5555", false, &address));
+    TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+    TEST_ASSERT_EQUAL_INT (1, resolver.lookups);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_lookup_numeric);
+    RUN_TEST (test_resolve_cached);
+    RUN_TEST (test_resolve_expired);
+    RUN_TEST (test_resolve_failure_cached);
+    return UNITY_END ();
+}
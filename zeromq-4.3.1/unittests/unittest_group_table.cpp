@@ -0,0 +1,139 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <group_table.hpp>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_key_ignores_bytes_after_terminator ()
+{
+    //  msg_t's group field may hold garbage after the terminating NUL.
+    char group[16];
+    memset (group, 'x', sizeof group);
+    memcpy (group, "abc", 4);
+
+    const zmq::group_key_t key (group);
+    TEST_ASSERT_TRUE (key == zmq::group_key_t ("abc"));
+    TEST_ASSERT_EQUAL_STRING ("abc", key.c_str ());
+    TEST_ASSERT_TRUE (key.hash () == zmq::group_key_t ("abc").hash ());
+}
+
+void test_key_max_length ()
+{
+    const zmq::group_key_t key ("0123456789abcdefXYZ");
+    TEST_ASSERT_EQUAL_STRING ("0123456789abcde", key.c_str ());
+    TEST_ASSERT_TRUE (key != zmq::group_key_t ("0123456789abcd"));
+}
+
+void test_find_empty ()
+{
+    zmq::group_table_t<int> table;
+    TEST_ASSERT_TRUE (table.empty ());
+    TEST_ASSERT_NULL (table.find (zmq::group_key_t ("a")));
+    TEST_ASSERT_FALSE (table.erase (zmq::group_key_t ("a")));
+}
+
+void test_insert_find_erase ()
+{
+    zmq::group_table_t<int> table;
+    bool inserted = false;
+    table.insert (zmq::group_key_t ("a"), &inserted) = 1;
+    TEST_ASSERT_TRUE (inserted);
+    table.insert (zmq::group_key_t ("a"), &inserted) = 2;
+    TEST_ASSERT_FALSE (inserted);
+    TEST_ASSERT_EQUAL (1u, table.size ());
+
+    //  The empty group is a valid key.
+    table.insert (zmq::group_key_t ("")) = 3;
+
+    int *value = table.find (zmq::group_key_t ("a"));
+    TEST_ASSERT_NOT_NULL (value);
+    TEST_ASSERT_EQUAL_INT (2, *value);
+    value = table.find (zmq::group_key_t (""));
+    TEST_ASSERT_NOT_NULL (value);
+    TEST_ASSERT_EQUAL_INT (3, *value);
+
+    TEST_ASSERT_TRUE (table.erase (zmq::group_key_t ("a")));
+    TEST_ASSERT_FALSE (table.erase (zmq::group_key_t ("a")));
+    TEST_ASSERT_NULL (table.find (zmq::group_key_t ("a")));
+    TEST_ASSERT_NOT_NULL (table.find (zmq::group_key_t ("")));
+    TEST_ASSERT_EQUAL (1u, table.size ());
+}
+
+void test_many_groups ()
+{
+    const int count = 5000;
+    char group[16];
+    zmq::group_table_t<int> table;
+
+    for (int i = 0; i < count; i++) {
+        sprintf (group, "group-%d", i);
+        table.insert (zmq::group_key_t (group)) = i;
+    }
+    TEST_ASSERT_EQUAL (static_cast<size_t> (count), table.size ());
+
+    //  Remove every other group so that probe clusters are shifted back.
+    for (int i = 0; i < count; i += 2) {
+        sprintf (group, "group-%d", i);
+        TEST_ASSERT_TRUE (table.erase (zmq::group_key_t (group)));
+    }
+
+    for (int i = 0; i < count; i++) {
+        sprintf (group, "group-%d", i);
+        int *value = table.find (zmq::group_key_t (group));
+        if (i % 2 == 0) {
+            TEST_ASSERT_NULL (value);
+        } else {
+            TEST_ASSERT_NOT_NULL (value);
+            TEST_ASSERT_EQUAL_INT (i, *value);
+        }
+    }
+
+    size_t occupied = 0;
+    for (size_t i = 0; i != table.capacity (); ++i)
+        if (table.occupied (i))
+            occupied++;
+    TEST_ASSERT_EQUAL (static_cast<size_t> (count / 2), occupied);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_key_ignores_bytes_after_terminator);
+    RUN_TEST (test_key_max_length);
+    RUN_TEST (test_find_empty);
+    RUN_TEST (test_insert_find_erase);
+    RUN_TEST (test_many_groups);
+
+    return UNITY_END ();
+}
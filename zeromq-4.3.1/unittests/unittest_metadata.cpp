@@ -0,0 +1,158 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <macros.hpp>
+#include <metadata.hpp>
+
+#include <stdio.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static zmq::metadata_t::dict_t make_dict ()
+{
+    zmq::metadata_t::dict_t dict;
+    dict["Socket-Type"] = "DEALER";
+    dict["Routing-Id"] = "peer";
+    dict["Peer-Address"] = "127.0.0.1";
+    dict["Hello"] = "World";
+    dict["X-Custom"] = "value";
+    dict["Zeta"] = "";
+    return dict;
+}
+
+static void release (zmq::metadata_t *metadata_)
+{
+    if (metadata_->drop_ref ())
+        LIBZMQ_DELETE (metadata_);
+}
+
+void test_get ()
+{
+    zmq::metadata_t *metadata = zmq::metadata_t::create (make_dict ());
+
+    TEST_ASSERT_EQUAL_STRING ("DEALER",
+                              metadata->get ("Socket-Type"));
+    TEST_ASSERT_EQUAL_STRING ("peer",
+                              metadata->get ("Routing-Id"));
+    TEST_ASSERT_EQUAL_STRING ("peer", metadata->get ("Identity"));
+    TEST_ASSERT_EQUAL_STRING ("127.0.0.1",
+                              metadata->get ("Peer-Address"));
+    TEST_ASSERT_NULL (metadata->get ("User-Id"));
+
+    TEST_ASSERT_EQUAL_STRING ("World", metadata->get ("Hello"));
+    TEST_ASSERT_EQUAL_STRING ("value", metadata->get ("X-Custom"));
+    TEST_ASSERT_EQUAL_STRING ("", metadata->get ("Zeta"));
+    TEST_ASSERT_NULL (metadata->get ("A"));
+    TEST_ASSERT_NULL (metadata->get ("Hell"));
+    TEST_ASSERT_NULL (metadata->get ("Zz"));
+    TEST_ASSERT_NULL (metadata->get (""));
+
+    release (metadata);
+}
+
+void test_get_many ()
+{
+    zmq::metadata_t::dict_t dict;
+    char name[16];
+    char value[16];
+    for (int i = 0; i < 100; i++) {
+        sprintf (name, "X-%d", i);
+        sprintf (value, "%d", i * 7);
+        dict[name] = value;
+    }
+    zmq::metadata_t *metadata = zmq::metadata_t::create (dict);
+
+    for (int i = 0; i < 100; i++) {
+        sprintf (name, "X-%d", i);
+        sprintf (value, "%d", i * 7);
+        TEST_ASSERT_EQUAL_STRING (value, metadata->get (name));
+    }
+    TEST_ASSERT_NULL (metadata->get ("X-100"));
+
+    release (metadata);
+}
+
+void test_intern_shares ()
+{
+    zmq::metadata_registry_t registry;
+
+    zmq::metadata_t *first = registry.intern (make_dict ());
+    zmq::metadata_t *second = registry.intern (make_dict ());
+    TEST_ASSERT_EQUAL_PTR (first, second);
+
+    zmq::metadata_t::dict_t dict = make_dict ();
+    dict["Peer-Address"] = "127.0.0.2";
+    zmq::metadata_t *other = registry.intern (dict);
+    TEST_ASSERT_TRUE (other != first);
+    TEST_ASSERT_EQUAL_STRING ("127.0.0.2",
+                              other->get ("Peer-Address"));
+
+    //  Values differing after a null byte are different properties.
+    dict["Peer-Address"] = std::string ("127.0.0.2\0a", 11);
+    zmq::metadata_t *nul = registry.intern (dict);
+    TEST_ASSERT_TRUE (nul != other);
+
+    release (first);
+    release (second);
+    release (other);
+    release (nul);
+}
+
+void test_intern_outlives_registry ()
+{
+    zmq::metadata_t *metadata;
+    {
+        zmq::metadata_registry_t registry;
+        metadata = registry.intern (make_dict ());
+
+        //  Enough distinct metadata to drop those no longer used.
+        for (int i = 0; i < 1000; i++) {
+            zmq::metadata_t::dict_t dict;
+            dict["Index"] = std::string (1, static_cast<char> (i % 256))
+                            + std::string (1, static_cast<char> (i / 256));
+            release (registry.intern (dict));
+        }
+        TEST_ASSERT_EQUAL_PTR (metadata, registry.intern (make_dict ()));
+        release (metadata);
+    }
+    TEST_ASSERT_EQUAL_STRING ("World", metadata->get ("Hello"));
+    release (metadata);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_get);
+    RUN_TEST (test_get_many);
+    RUN_TEST (test_intern_shares);
+    RUN_TEST (test_intern_outlives_registry);
+    return UNITY_END ();
+}
@@ -0,0 +1,390 @@
+/*
+Copyright (c) 2019 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <nacl_fast.hpp>
+#include <tweetnacl.h>
+
+#include <string.h>
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+#if defined(ZMQ_USE_TWEETNACL)
+
+//  Deterministic test data.
+static uint32_t state = 12345;
+
+static void fill (unsigned char *buf_, size_t size_)
+{
+    for (size_t i = 0; i != size_; i++) {
+        state = state * 1103515245 + 12345;
+        buf_[i] = static_cast<unsigned char> (state >> 16);
+    }
+}
+
+//  Lengths around the block sizes of each implementation.
+static const size_t lengths[] = {1,   15,  16,  17,  31,   32,   33,   63,
+                                 64,  65,  127, 128, 255, 256,  257,  511,
+                                 512, 513, 767, 1000, 1024, 1537, 4100};
+static const int length_count = sizeof lengths / sizeof lengths[0];
+
+static void check_stream (zmq::salsa20_impl_t impl_)
+{
+    if (!zmq::salsa20_impl_available (impl_))
+        TEST_IGNORE_MESSAGE ("not supported by the CPU");
+
+    const zmq::salsa20_impl_t previous = zmq::salsa20_impl ();
+    zmq::set_salsa20_impl (impl_);
+
+    unsigned char key[32];
+    unsigned char nonce[24];
+    for (int i = 0; i != length_count; i++) {
+        const size_t len = lengths[i];
+        fill (key, sizeof key);
+        fill (nonce, sizeof nonce);
+        std::vector<unsigned char> m (len + 1), expected (len + 1),
+          actual (len + 1);
+        fill (&m[0], len);
+
+        crypto_stream_xor_ref (&expected[0], &m[0], len, nonce, key);
+        crypto_stream_xor (&actual[0], &m[0], len, nonce, key);
+        TEST_ASSERT_EQUAL_MEMORY (&expected[0], &actual[0], len);
+
+        //  In place.
+        actual = m;
+        crypto_stream_xor (&actual[0], &actual[0], len, nonce, key);
+        TEST_ASSERT_EQUAL_MEMORY (&expected[0], &actual[0], len);
+
+        //  Key stream.
+        crypto_stream_ref (&expected[0], len, nonce, key);
+        crypto_stream (&actual[0], len, nonce, key);
+        TEST_ASSERT_EQUAL_MEMORY (&expected[0], &actual[0], len);
+    }
+
+    zmq::set_salsa20_impl (previous);
+}
+
+void test_stream_scalar ()
+{
+    check_stream (zmq::salsa20_scalar);
+}
+
+void test_stream_sse2 ()
+{
+    check_stream (zmq::salsa20_sse2);
+}
+
+void test_stream_avx2 ()
+{
+    check_stream (zmq::salsa20_avx2);
+}
+
+void test_onetimeauth ()
+{
+    unsigned char key[32];
+    unsigned char expected[16];
+    unsigned char actual[16];
+    for (int i = 0; i != length_count; i++) {
+        const size_t len = lengths[i];
+        std::vector<unsigned char> m (len + 1);
+        fill (&m[0], len);
+        fill (key, sizeof key);
+
+        crypto_onetimeauth_ref (expected, &m[0], len, key);
+        crypto_onetimeauth (actual, &m[0], len, key);
+        TEST_ASSERT_EQUAL_MEMORY (expected, actual, sizeof expected);
+        TEST_ASSERT_EQUAL_INT (0, crypto_onetimeauth_verify (actual, &m[0],
+                                                             len, key));
+        actual[i % 16] ^= 1;
+        TEST_ASSERT_EQUAL_INT (-1, crypto_onetimeauth_verify (actual, &m[0],
+                                                              len, key));
+    }
+
+    //  Accumulators close to the modulus.
+    memset (key, 0xff, sizeof key);
+    unsigned char m[64];
+    memset (m, 0xff, sizeof m);
+    crypto_onetimeauth_ref (expected, m, sizeof m, key);
+    crypto_onetimeauth (actual, m, sizeof m, key);
+    TEST_ASSERT_EQUAL_MEMORY (expected, actual, sizeof expected);
+}
+
+void test_scalarmult ()
+{
+    unsigned char n[32];
+    unsigned char p[32];
+    unsigned char expected[32];
+    unsigned char actual[32];
+    for (int i = 0; i != 32; i++) {
+        fill (n, sizeof n);
+        fill (p, sizeof p);
+        crypto_scalarmult_ref (expected, n, p);
+        crypto_scalarmult (actual, n, p);
+        TEST_ASSERT_EQUAL_MEMORY (expected, actual, sizeof expected);
+    }
+
+    //  Points at the edges of the field.
+    memset (p, 0xff, sizeof p);
+    crypto_scalarmult_ref (expected, n, p);
+    crypto_scalarmult (actual, n, p);
+    TEST_ASSERT_EQUAL_MEMORY (expected, actual, sizeof expected);
+    memset (p, 0, sizeof p);
+    crypto_scalarmult_ref (expected, n, p);
+    crypto_scalarmult (actual, n, p);
+    TEST_ASSERT_EQUAL_MEMORY (expected, actual, sizeof expected);
+}
+
+//  A box made by one side opens on the other.
+void test_box ()
+{
+    unsigned char pk1[32], sk1[32], pk2[32], sk2[32];
+    fill (sk1, sizeof sk1);
+    fill (sk2, sizeof sk2);
+    TEST_ASSERT_EQUAL_INT (0, crypto_scalarmult_base (pk1, sk1));
+    TEST_ASSERT_EQUAL_INT (0, crypto_scalarmult_base (pk2, sk2));
+
+    unsigned char nonce[24];
+    fill (nonce, sizeof nonce);
+    unsigned char m[32 + 600];
+    memset (m, 0, 32);
+    fill (m + 32, sizeof m - 32);
+    unsigned char c[sizeof m];
+    unsigned char opened[sizeof m];
+    TEST_ASSERT_EQUAL_INT (0, crypto_box (c, m, sizeof m, nonce, pk2, sk1));
+    TEST_ASSERT_EQUAL_INT (
+      0, crypto_box_open (opened, c, sizeof c, nonce, pk1, sk2));
+    TEST_ASSERT_EQUAL_MEMORY (m, opened, sizeof m);
+
+    c[100] ^= 1;
+    TEST_ASSERT_EQUAL_INT (
+      -1, crypto_box_open (opened, c, sizeof c, nonce, pk1, sk2));
+}
+
+//  RFC 8439, 2.8.2.
+static const unsigned char chacha20poly1305_key[32] = {
+  0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89, 0x8a,
+  0x8b, 0x8c, 0x8d, 0x8e, 0x8f, 0x90, 0x91, 0x92, 0x93, 0x94, 0x95,
+  0x96, 0x97, 0x98, 0x99, 0x9a, 0x9b, 0x9c, 0x9d, 0x9e, 0x9f};
+static const unsigned char chacha20poly1305_nonce[12] = {
+  0x07, 0x00, 0x00, 0x00, 0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47};
+static const unsigned char chacha20poly1305_ad[12] = {
+  0x50, 0x51, 0x52, 0x53, 0xc0, 0xc1, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7};
+static const char chacha20poly1305_m[] =
+  "Ladies and Gentlemen of the class of '99: If I could offer you only one "
+  "tip for the future, sunscreen would be it.";
+static const unsigned char chacha20poly1305_c[114] = {
+  0xd3, 0x1a, 0x8d, 0x34, 0x64, 0x8e, 0x60, 0xdb, 0x7b, 0x86, 0xaf, 0xbc,
+  0x53, 0xef, 0x7e, 0xc2, 0xa4, 0xad, 0xed, 0x51, 0x29, 0x6e, 0x08, 0xfe,
+  0xa9, 0xe2, 0xb5, 0xa7, 0x36, 0xee, 0x62, 0xd6, 0x3d, 0xbe, 0xa4, 0x5e,
+  0x8c, 0xa9, 0x67, 0x12, 0x82, 0xfa, 0xfb, 0x69, 0xda, 0x92, 0x72, 0x8b,
+  0x1a, 0x71, 0xde, 0x0a, 0x9e, 0x06, 0x0b, 0x29, 0x05, 0xd6, 0xa5, 0xb6,
+  0x7e, 0xcd, 0x3b, 0x36, 0x92, 0xdd, 0xbd, 0x7f, 0x2d, 0x77, 0x8b, 0x8c,
+  0x98, 0x03, 0xae, 0xe3, 0x28, 0x09, 0x1b, 0x58, 0xfa, 0xb3, 0x24, 0xe4,
+  0xfa, 0xd6, 0x75, 0x94, 0x55, 0x85, 0x80, 0x8b, 0x48, 0x31, 0xd7, 0xbc,
+  0x3f, 0xf4, 0xde, 0xf0, 0x8e, 0x4b, 0x7a, 0x9d, 0xe5, 0x76, 0xd2, 0x65,
+  0x86, 0xce, 0xc6, 0x4b, 0x61, 0x16};
+static const unsigned char chacha20poly1305_tag[16] = {
+  0x1a, 0xe1, 0x0b, 0x59, 0x4f, 0x09, 0xe2, 0x6a,
+  0x7e, 0x90, 0x2e, 0xcb, 0xd0, 0x60, 0x06, 0x91};
+
+static void check_chacha20poly1305 (zmq::salsa20_impl_t impl_)
+{
+    if (!zmq::salsa20_impl_available (impl_))
+        TEST_IGNORE_MESSAGE ("not supported by the CPU");
+
+    const zmq::salsa20_impl_t previous = zmq::salsa20_impl ();
+
+    unsigned char c[sizeof chacha20poly1305_c];
+    unsigned char m[sizeof chacha20poly1305_c];
+    unsigned char tag[16];
+    zmq::set_salsa20_impl (impl_);
+    TEST_ASSERT_EQUAL_INT (
+      0, crypto_aead_chacha20poly1305_ietf_encrypt_detached (
+           c, tag, NULL,
+           reinterpret_cast<const unsigned char *> (chacha20poly1305_m),
+           sizeof c, chacha20poly1305_ad, sizeof chacha20poly1305_ad, NULL,
+           chacha20poly1305_nonce, chacha20poly1305_key));
+    TEST_ASSERT_EQUAL_MEMORY (chacha20poly1305_c, c, sizeof c);
+    TEST_ASSERT_EQUAL_MEMORY (chacha20poly1305_tag, tag, sizeof tag);
+    TEST_ASSERT_EQUAL_INT (
+      0, crypto_aead_chacha20poly1305_ietf_decrypt_detached (
+           m, NULL, c, sizeof c, tag, chacha20poly1305_ad,
+           sizeof chacha20poly1305_ad, chacha20poly1305_nonce,
+           chacha20poly1305_key));
+    TEST_ASSERT_EQUAL_MEMORY (chacha20poly1305_m, m, sizeof m);
+
+    //  Longer messages against the scalar implementation.
+    unsigned char key[32];
+    unsigned char nonce[12];
+    unsigned char ad[20];
+    unsigned char expected_tag[16];
+    for (int i = 0; i != length_count; i++) {
+        const size_t len = lengths[i];
+        fill (key, sizeof key);
+        fill (nonce, sizeof nonce);
+        fill (ad, sizeof ad);
+        std::vector<unsigned char> plain (len + 1), expected (len + 1),
+          actual (len + 1);
+        fill (&plain[0], len);
+
+        zmq::set_salsa20_impl (zmq::salsa20_scalar);
+        crypto_aead_chacha20poly1305_ietf_encrypt_detached (
+          &expected[0], expected_tag, NULL, &plain[0], len, ad, i % 21, NULL,
+          nonce, key);
+        zmq::set_salsa20_impl (impl_);
+        crypto_aead_chacha20poly1305_ietf_encrypt_detached (
+          &actual[0], tag, NULL, &plain[0], len, ad, i % 21, NULL, nonce,
+          key);
+        TEST_ASSERT_EQUAL_MEMORY (&expected[0], &actual[0], len);
+        TEST_ASSERT_EQUAL_MEMORY (expected_tag, tag, sizeof tag);
+
+        //  In place.
+        TEST_ASSERT_EQUAL_INT (
+          0, crypto_aead_chacha20poly1305_ietf_decrypt_detached (
+               &actual[0], NULL, &actual[0], len, tag, ad, i % 21, nonce,
+               key));
+        TEST_ASSERT_EQUAL_MEMORY (&plain[0], &actual[0], len);
+
+        expected[i % len] ^= 1;
+        TEST_ASSERT_EQUAL_INT (
+          -1, crypto_aead_chacha20poly1305_ietf_decrypt_detached (
+                &actual[0], NULL, &expected[0], len, tag, ad, i % 21, nonce,
+                key));
+    }
+
+    zmq::set_salsa20_impl (previous);
+}
+
+void test_chacha20poly1305_scalar ()
+{
+    check_chacha20poly1305 (zmq::salsa20_scalar);
+}
+
+void test_chacha20poly1305_sse2 ()
+{
+    check_chacha20poly1305 (zmq::salsa20_sse2);
+}
+
+void test_chacha20poly1305_avx2 ()
+{
+    check_chacha20poly1305 (zmq::salsa20_avx2);
+}
+
+void test_aes256gcm ()
+{
+    if (!crypto_aead_aes256gcm_is_available ())
+        TEST_IGNORE_MESSAGE ("not supported by the CPU");
+
+    //  Test case 16 of the GCM specification.
+    const unsigned char key[32] = {
+      0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65, 0x73, 0x1c, 0x6d, 0x6a, 0x8f,
+      0x94, 0x67, 0x30, 0x83, 0x08, 0xfe, 0xff, 0xe9, 0x92, 0x86, 0x65,
+      0x73, 0x1c, 0x6d, 0x6a, 0x8f, 0x94, 0x67, 0x30, 0x83, 0x08};
+    const unsigned char nonce[12] = {0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce,
+                                     0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88};
+    const unsigned char ad[20] = {0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe,
+                                  0xef, 0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad,
+                                  0xbe, 0xef, 0xab, 0xad, 0xda, 0xd2};
+    const unsigned char plain[60] = {
+      0xd9, 0x31, 0x32, 0x25, 0xf8, 0x84, 0x06, 0xe5, 0xa5, 0x59, 0x09, 0xc5,
+      0xaf, 0xf5, 0x26, 0x9a, 0x86, 0xa7, 0xa9, 0x53, 0x15, 0x34, 0xf7, 0xda,
+      0x2e, 0x4c, 0x30, 0x3d, 0x8a, 0x31, 0x8a, 0x72, 0x1c, 0x3c, 0x0c, 0x95,
+      0x95, 0x68, 0x09, 0x53, 0x2f, 0xcf, 0x0e, 0x24, 0x49, 0xa6, 0xb5, 0x25,
+      0xb1, 0x6a, 0xed, 0xf5, 0xaa, 0x0d, 0xe6, 0x57, 0xba, 0x63, 0x7b, 0x39};
+    const unsigned char cipher[60] = {
+      0x52, 0x2d, 0xc1, 0xf0, 0x99, 0x56, 0x7d, 0x07, 0xf4, 0x7f, 0x37, 0xa3,
+      0x2a, 0x84, 0x42, 0x7d, 0x64, 0x3a, 0x8c, 0xdc, 0xbf, 0xe5, 0xc0, 0xc9,
+      0x75, 0x98, 0xa2, 0xbd, 0x25, 0x55, 0xd1, 0xaa, 0x8c, 0xb0, 0x8e, 0x48,
+      0x59, 0x0d, 0xbb, 0x3d, 0xa7, 0xb0, 0x8b, 0x10, 0x56, 0x82, 0x88, 0x38,
+      0xc5, 0xf6, 0x1e, 0x63, 0x93, 0xba, 0x7a, 0x0a, 0xbc, 0xc9, 0xf6, 0x62};
+    const unsigned char expected_tag[16] = {0x76, 0xfc, 0x6e, 0xce, 0x0f, 0x4e,
+                                            0x17, 0x68, 0xcd, 0xdf, 0x88, 0x53,
+                                            0xbb, 0x2d, 0x55, 0x1b};
+
+    crypto_aead_aes256gcm_state state;
+    TEST_ASSERT_EQUAL_INT (0, crypto_aead_aes256gcm_beforenm (&state, key));
+
+    unsigned char c[sizeof cipher];
+    unsigned char m[sizeof plain];
+    unsigned char tag[16];
+    TEST_ASSERT_EQUAL_INT (0, crypto_aead_aes256gcm_encrypt_detached_afternm (
+                                c, tag, NULL, plain, sizeof plain, ad,
+                                sizeof ad, NULL, nonce, &state));
+    TEST_ASSERT_EQUAL_MEMORY (cipher, c, sizeof c);
+    TEST_ASSERT_EQUAL_MEMORY (expected_tag, tag, sizeof tag);
+    TEST_ASSERT_EQUAL_INT (0, crypto_aead_aes256gcm_decrypt_detached_afternm (
+                                m, NULL, c, sizeof c, tag, ad, sizeof ad,
+                                nonce, &state));
+    TEST_ASSERT_EQUAL_MEMORY (plain, m, sizeof m);
+
+    //  Round trips across the block and chunk sizes.
+    for (int i = 0; i != length_count; i++) {
+        const size_t len = lengths[i];
+        std::vector<unsigned char> message (len + 1), sealed (len + 1),
+          opened (len + 1);
+        fill (&message[0], len);
+        crypto_aead_aes256gcm_encrypt_detached_afternm (
+          &sealed[0], tag, NULL, &message[0], len, ad, i % 21, NULL, nonce,
+          &state);
+        TEST_ASSERT_EQUAL_INT (0,
+                               crypto_aead_aes256gcm_decrypt_detached_afternm (
+                                 &opened[0], NULL, &sealed[0], len, tag, ad,
+                                 i % 21, nonce, &state));
+        TEST_ASSERT_EQUAL_MEMORY (&message[0], &opened[0], len);
+
+        sealed[i % len] ^= 1;
+        TEST_ASSERT_EQUAL_INT (-1,
+                               crypto_aead_aes256gcm_decrypt_detached_afternm (
+                                 &opened[0], NULL, &sealed[0], len, tag, ad,
+                                 i % 21, nonce, &state));
+    }
+}
+
+#endif
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+#if defined(ZMQ_USE_TWEETNACL)
+    RUN_TEST (test_stream_scalar);
+    RUN_TEST (test_stream_sse2);
+    RUN_TEST (test_stream_avx2);
+    RUN_TEST (test_onetimeauth);
+    RUN_TEST (test_scalarmult);
+    RUN_TEST (test_box);
+    RUN_TEST (test_chacha20poly1305_scalar);
+    RUN_TEST (test_chacha20poly1305_sse2);
+    RUN_TEST (test_chacha20poly1305_avx2);
+    RUN_TEST (test_aes256gcm);
+#endif
+
+    return UNITY_END ();
+}
@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <routing_table.hpp>
+#include <wire.hpp>
+
+#include <string.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+typedef zmq::routing_table_t<int> table_t;
+
+static const unsigned char *bytes (const char *str_)
+{
+    return reinterpret_cast<const unsigned char *> (str_);
+}
+
+void test_find_empty ()
+{
+    table_t table;
+    TEST_ASSERT_TRUE (table.empty ());
+    TEST_ASSERT_NULL (table.find (bytes ("a"), 1));
+    TEST_ASSERT_FALSE (table.erase (bytes ("a"), 1));
+}
+
+void test_insert_duplicate ()
+{
+    table_t table;
+    TEST_ASSERT_TRUE (table.insert (bytes ("peer"), 4, 1));
+    TEST_ASSERT_FALSE (table.insert (bytes ("peer"), 4, 2));
+    TEST_ASSERT_EQUAL (1u, table.size ());
+
+    const int *value = table.find (bytes ("peer"), 4);
+    TEST_ASSERT_NOT_NULL (value);
+    TEST_ASSERT_EQUAL_INT (1, *value);
+
+    //  A prefix is a different routing ID.
+    TEST_ASSERT_NULL (table.find (bytes ("peer"), 3));
+}
+
+void test_long_routing_id ()
+{
+    //  Longer than what fits into a slot, stored on the heap.
+    unsigned char id[255];
+    for (size_t i = 0; i != sizeof id; i++)
+        id[i] = static_cast<unsigned char> (i);
+
+    table_t table;
+    TEST_ASSERT_TRUE (table.insert (id, sizeof id, 7));
+    TEST_ASSERT_TRUE (table.insert (id, 16, 8));
+
+    const int *value = table.find (id, sizeof id);
+    TEST_ASSERT_NOT_NULL (value);
+    TEST_ASSERT_EQUAL_INT (7, *value);
+    value = table.find (id, 16);
+    TEST_ASSERT_NOT_NULL (value);
+    TEST_ASSERT_EQUAL_INT (8, *value);
+
+    int erased = 0;
+    TEST_ASSERT_TRUE (table.erase (id, sizeof id, &erased));
+    TEST_ASSERT_EQUAL_INT (7, erased);
+    TEST_ASSERT_NULL (table.find (id, sizeof id));
+}
+
+void test_many_routing_ids ()
+{
+    //  Same layout as the IDs generated by ROUTER sockets.
+    const int count = 10000;
+    unsigned char id[5] = {0};
+    table_t table;
+
+    for (int i = 0; i < count; i++) {
+        zmq::put_uint32 (id + 1, i);
+        TEST_ASSERT_TRUE (table.insert (id, sizeof id, i));
+    }
+    TEST_ASSERT_EQUAL (static_cast<size_t> (count), table.size ());
+
+    for (int i = 0; i < count; i += 3) {
+        zmq::put_uint32 (id + 1, i);
+        TEST_ASSERT_TRUE (table.erase (id, sizeof id));
+    }
+
+    for (int i = 0; i < count; i++) {
+        zmq::put_uint32 (id + 1, i);
+        const int *value = table.find (id, sizeof id);
+        if (i % 3 == 0) {
+            TEST_ASSERT_NULL (value);
+        } else {
+            TEST_ASSERT_NOT_NULL (value);
+            TEST_ASSERT_EQUAL_INT (i, *value);
+        }
+    }
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_find_empty);
+    RUN_TEST (test_insert_duplicate);
+    RUN_TEST (test_long_routing_id);
+    RUN_TEST (test_many_routing_ids);
+
+    return UNITY_END ();
+}
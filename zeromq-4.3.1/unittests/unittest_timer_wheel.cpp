@@ -0,0 +1,180 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <timer_wheel.hpp>
+
+#include <stdlib.h>
+#include <vector>
+
+#include <unity.h>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_empty ()
+{
+    zmq::timer_wheel_t wheel;
+    zmq::i_poll_events *sink;
+    int id;
+    TEST_ASSERT_TRUE (wheel.empty ());
+    TEST_ASSERT_EQUAL_UINT64 (0, wheel.timeout (1000));
+    TEST_ASSERT_FALSE (wheel.pop_expired (1000, &sink, &id));
+}
+
+//  Drives the wheel by jumping to the time given by timeout(), which must
+//  never skip past a timer, and checks that every timer fires exactly at
+//  its expiration.
+void test_fires_on_time ()
+{
+    const uint64_t start = 123456;
+    const uint64_t delays[] = {0,    1,     17,      255,     256,
+                               257,  1000,  16383,   16384,   16385,
+                               60000, 1048575, 1048577, 70000000};
+    const int count = sizeof delays / sizeof delays[0];
+
+    zmq::timer_wheel_t wheel;
+    for (int i = 0; i < count; i++)
+        wheel.add (start, start + delays[i], NULL, i);
+
+    uint64_t now = start;
+    int fired = 0;
+    while (!wheel.empty ()) {
+        zmq::i_poll_events *sink;
+        int id;
+        while (wheel.pop_expired (now, &sink, &id)) {
+            TEST_ASSERT_NULL (sink);
+            TEST_ASSERT_EQUAL_INT (fired, id);
+            TEST_ASSERT_EQUAL_UINT64 (start + delays[id], now);
+            fired++;
+        }
+        const uint64_t timeout = wheel.timeout (now);
+        if (wheel.empty ())
+            TEST_ASSERT_EQUAL_UINT64 (0, timeout);
+        else
+            TEST_ASSERT_TRUE (timeout > 0);
+        now += timeout;
+    }
+    TEST_ASSERT_EQUAL_INT (count, fired);
+}
+
+void test_same_expiration_in_order ()
+{
+    zmq::timer_wheel_t wheel;
+    for (int i = 0; i < 10; i++)
+        wheel.add (0, 5000, NULL, i);
+
+    zmq::i_poll_events *sink;
+    int id;
+    TEST_ASSERT_FALSE (wheel.pop_expired (4999, &sink, &id));
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_TRUE (wheel.pop_expired (6000, &sink, &id));
+        TEST_ASSERT_EQUAL_INT (i, id);
+    }
+    TEST_ASSERT_FALSE (wheel.pop_expired (6000, &sink, &id));
+}
+
+void test_cancel ()
+{
+    zmq::timer_wheel_t wheel;
+    const zmq::timer_wheel_t::handle_t a = wheel.add (0, 10, NULL, 1);
+    const zmq::timer_wheel_t::handle_t b = wheel.add (0, 100000, NULL, 2);
+    wheel.add (0, 20, NULL, 3);
+
+    wheel.cancel (a);
+    wheel.cancel (b);
+
+    //  The node of a cancelled timer is reused under a new handle.
+    const zmq::timer_wheel_t::handle_t c = wheel.add (0, 30, NULL, 4);
+    TEST_ASSERT_TRUE (c != a && c != b);
+
+    zmq::i_poll_events *sink;
+    int id;
+    TEST_ASSERT_TRUE (wheel.pop_expired (1000000, &sink, &id));
+    TEST_ASSERT_EQUAL_INT (3, id);
+    TEST_ASSERT_TRUE (wheel.pop_expired (1000000, &sink, &id));
+    TEST_ASSERT_EQUAL_INT (4, id);
+    TEST_ASSERT_FALSE (wheel.pop_expired (1000000, &sink, &id));
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_random ()
+{
+    const int count = 20000;
+    std::vector<uint64_t> expirations (count);
+    std::vector<zmq::timer_wheel_t::handle_t> handles (count);
+    std::vector<bool> pending (count, true);
+
+    srand (42);
+    zmq::timer_wheel_t wheel;
+    uint64_t now = 0;
+    for (int i = 0; i < count; i++) {
+        expirations[i] = now + rand () % 200000;
+        handles[i] = wheel.add (now, expirations[i], NULL, i);
+        if (i % 100 == 0)
+            now += rand () % 50;
+    }
+
+    //  Cancel a third of them.
+    for (int i = 0; i < count; i += 3) {
+        wheel.cancel (handles[i]);
+        pending[i] = false;
+    }
+
+    uint64_t last = 0;
+    uint64_t previous = 0;
+    while (!wheel.empty ()) {
+        now += 1 + rand () % 700;
+        zmq::i_poll_events *sink;
+        int id;
+        while (wheel.pop_expired (now, &sink, &id)) {
+            TEST_ASSERT_TRUE (pending[id]);
+            pending[id] = false;
+
+            //  Not early, not missed by the previous call, and in order.
+            TEST_ASSERT_TRUE (expirations[id] <= now);
+            TEST_ASSERT_TRUE (previous == 0 || expirations[id] > previous);
+            TEST_ASSERT_TRUE (expirations[id] >= last);
+            last = expirations[id];
+        }
+        previous = now;
+    }
+
+    for (int i = 0; i < count; i++)
+        TEST_ASSERT_FALSE (pending[i]);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_empty);
+    RUN_TEST (test_fires_on_time);
+    RUN_TEST (test_same_expiration_in_order);
+    RUN_TEST (test_cancel);
+    RUN_TEST (test_random);
+
+    return UNITY_END ();
+}